@@ -9,17 +9,65 @@ LD_SRCS += \
 C_SRCS += \
 ../src/ESP32.c \
 ../src/main.c \
-../src/platform.c 
+../src/platform.c \
+../src/sysTimer.c \
+../src/pool.c \
+../src/capture.c \
+../src/command.c \
+../src/pwmSeq.c \
+../src/alarm.c \
+../src/decimate.c \
+../src/auxAcq.c \
+../src/profExport.c \
+../src/atFormat.c \
+../src/apScan.c \
+../src/crc.c \
+../src/spiFlash.c \
+../src/configStore.c \
+../src/dutyCycle.c \
+../src/stackCheck.c 
 
 OBJS += \
 ./src/ESP32.o \
 ./src/main.o \
-./src/platform.o 
+./src/platform.o \
+./src/sysTimer.o \
+./src/pool.o \
+./src/capture.o \
+./src/command.o \
+./src/pwmSeq.o \
+./src/alarm.o \
+./src/decimate.o \
+./src/auxAcq.o \
+./src/profExport.o \
+./src/atFormat.o \
+./src/apScan.o \
+./src/crc.o \
+./src/spiFlash.o \
+./src/configStore.o \
+./src/dutyCycle.o \
+./src/stackCheck.o 
 
 C_DEPS += \
 ./src/ESP32.d \
 ./src/main.d \
-./src/platform.d 
+./src/platform.d \
+./src/sysTimer.d \
+./src/pool.d \
+./src/capture.d \
+./src/command.d \
+./src/pwmSeq.d \
+./src/alarm.d \
+./src/decimate.d \
+./src/auxAcq.d \
+./src/profExport.d \
+./src/atFormat.d \
+./src/apScan.d \
+./src/crc.d \
+./src/spiFlash.d \
+./src/configStore.d \
+./src/dutyCycle.d \
+./src/stackCheck.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
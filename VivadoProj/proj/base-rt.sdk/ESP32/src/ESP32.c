@@ -15,9 +15,104 @@
 
 *******************************************************************************/
 
+#include <stdlib.h>
+#include <string.h>
 #include "ESP32.h"
+#include "sysTimer.h"
 
 static int bufferedUartSend(Uart * devicePtr, u8 * data, int length);
+ISR_INLINE void drainUartRx(u32 baseAddress);
+ISR_INLINE void serviceUart(Uart * devicePtr);
+#if USE_FAST_INTERRUPTS
+static void uartFastHandler(void) FAST_ISR;
+#endif
+
+    // Bytes from the ESP32 are queued here by the ISR and drained by
+    // the main loop, so the ISR never has to call into xil_printf
+static volatile u8 rxRing[ESP32_RX_RING_SIZE] FAST_BSS;
+static volatile u32 rxHead FAST_BSS;
+static volatile u32 rxTail FAST_BSS;
+static volatile u32 rxDropped FAST_BSS;
+static Uart * espDevice FAST_BSS;
+
+    // "+IPD,<len>:" (or "+IPD,<id>,<len>:" with CIPMUX=1) announces
+    // <len> bytes of TCP payload; scanForIPD follows the stream
+#define IPD_MATCH       0
+#define IPD_LENGTH      1
+#define IPD_PAYLOAD     2
+static const char ipdPrefix[] = AT_IPD_PREFIX;
+static TCPDataHandler tcpDataHandler;
+static u32 ipdState;
+static u32 ipdMatched;
+static u32 ipdLength;
+static void scanForIPD(const u8 * data, int count);
+
+    // Replies TCPsend paces itself on, picked out of everything outside
+    // +IPD payload, so data from the TCP peer cannot fake them
+#define LINK_PROMPT     0x01
+#define LINK_SEND_OK    0x02
+#define LINK_SEND_FAIL  0x04
+#define LINK_BUSY       0x08
+#define LINK_ERROR      0x10
+#define LINK_OK         0x20
+#define LINK_RECV       0x40
+#define LINK_NUMBERS    0x80    // a line of numbers, kept in linkNumbers
+#define LINK_READY      0x100
+#define LINK_GOT_IP     0x200
+#define LINK_LINE_MAX   40
+#define LINK_POLL_US    100
+#define LINK_MAX_NUMBERS 5
+
+typedef struct {
+    const char * text;
+    u32 length;         // compared; the '\0' too for a whole line
+    u32 event;
+} LinkReply;
+
+#define WHOLE_LINE(text)    text, sizeof(text)
+#define LINE_START(text)    text, sizeof(text) - 1
+
+static const LinkReply linkReplies[] = {
+    { WHOLE_LINE("SEND OK"), LINK_SEND_OK },
+    { WHOLE_LINE("SEND FAIL"), LINK_SEND_FAIL },
+    { LINE_START("busy "), LINK_BUSY },     // "busy p..." and "busy s..."
+    { WHOLE_LINE("ERROR"), LINK_ERROR },
+    { WHOLE_LINE("CLOSED"), LINK_ERROR },
+    { WHOLE_LINE("OK"), LINK_OK },
+    { LINE_START("Recv "), LINK_RECV },
+    { WHOLE_LINE("ready"), LINK_READY },
+    { WHOLE_LINE("WIFI GOT IP"), LINK_GOT_IP },
+};
+#define NUM_LINK_REPLIES (sizeof(linkReplies) / sizeof(linkReplies[0]))
+
+static u32 linkEvents;
+static char linkLine[LINK_LINE_MAX];
+static u32 linkLineLength;
+static ESP32LinkStats linkStats;
+static u32 lastSendTick;
+static u32 linkNumbers[LINK_MAX_NUMBERS];
+static u32 linkNumberCount;
+static void scanForLinkReply(u8 c);
+
+    // One AT+CIPSENDBUF segment in the send window
+#define SLOT_FREE       0
+#define SLOT_QUEUED     1   // with the ESP32, no result yet
+#define SLOT_FAILED     2   // SEND FAIL, to be sent again
+
+typedef struct {
+    u32 state;
+    u32 id;             // segment ID the handler is told
+    u32 segment;        // ESP32 segment ID of the last attempt
+    u32 queuedTick;
+    u32 attempts;
+    TCPSegmentHandler handler;
+    u32 length;
+    u8 data[AT_SEND_MAX];
+} SendSlot;
+
+static SendSlot sendWindow[ESP32_SEND_WINDOW];
+static u32 nextSegmentId = 1;
+static void segmentResult(u32 segment, int sent);
 
 int initATCtrl(u32 UART_DEVICE_ID, Uart * devicePtr, INTC * intPtr) {
     int Status;
@@ -34,9 +129,19 @@ int initATCtrl(u32 UART_DEVICE_ID, Uart * devicePtr, INTC * intPtr) {
         return XST_FAILURE;
 	}
 
+    espDevice = devicePtr;
+    rxHead = 0;
+    rxTail = 0;
+    rxDropped = 0;
+
+#if USE_FAST_INTERRUPTS
+    Status = XIntc_ConnectFastHandler(intPtr, UARTLITE_INT_IRQ_ID,
+               uartFastHandler);
+#else
     Status = XIntc_Connect(intPtr, UARTLITE_INT_IRQ_ID,
                (XInterruptHandler)XUartLite_InterruptHandler,
                (void *)devicePtr);
+#endif
     if (Status != XST_SUCCESS) {
         xil_printf("Could not Connect UART to  Interrupt Controller\n\r");
         return XST_FAILURE;
@@ -66,19 +171,273 @@ int initATCtrl(u32 UART_DEVICE_ID, Uart * devicePtr, INTC * intPtr) {
     return XST_SUCCESS;
 }
 
-void uartRecvHandler(void * CallBackRef, unsigned int EventData) {
+FAST_CODE void uartRecvHandler(void * CallBackRef, unsigned int EventData) {
 	Uart * devicePtr = (Uart *) CallBackRef;
-    char c;
-    while(!XUartLite_IsReceiveEmpty(devicePtr->RegBaseAddress)) {
-        c = XUartLite_RecvByte(devicePtr->RegBaseAddress);
-        xil_printf("%c", c);
+    drainUartRx(devicePtr->RegBaseAddress);
+}
+
+ISR_INLINE void drainUartRx(u32 baseAddress) {
+    u32 head = rxHead;
+    u8 c;
+    while(ISR_IN32(baseAddress + XUL_STATUS_REG_OFFSET) & XUL_SR_RX_FIFO_VALID_DATA) {
+        c = (u8)ISR_IN32(baseAddress + XUL_RX_FIFO_OFFSET);
+        if(head - rxTail < ESP32_RX_RING_SIZE) {
+            rxRing[head & (ESP32_RX_RING_SIZE - 1)] = c;
+            head++;
+        } else {
+            rxDropped++;
+        }
     }
+    rxHead = head;
 }
 
 void uartSendHandler(void * CallBackRef, unsigned int EventData) {
 	// DO NOTHING
 }
 
+    // Does the work of XUartLite_InterruptHandler without the stats,
+    // asserts and callbacks: drain the RX FIFO into the ring and refill
+    // the TX FIFO if XUartLite_Send left bytes behind
+ISR_INLINE void serviceUart(Uart * devicePtr) {
+    u32 base = devicePtr->RegBaseAddress;
+    u32 status = ISR_IN32(base + XUL_STATUS_REG_OFFSET);
+
+    if(status & XUL_SR_RX_FIFO_VALID_DATA) {
+        drainUartRx(base);
+    }
+
+    if((status & XUL_SR_TX_FIFO_EMPTY) && devicePtr->SendBuffer.RequestedBytes > 0) {
+        while(devicePtr->SendBuffer.RemainingBytes > 0 &&
+                !(ISR_IN32(base + XUL_STATUS_REG_OFFSET) & XUL_SR_TX_FIFO_FULL)) {
+            ISR_OUT32(base + XUL_TX_FIFO_OFFSET, *devicePtr->SendBuffer.NextBytePtr++);
+            devicePtr->SendBuffer.RemainingBytes--;
+        }
+        if(devicePtr->SendBuffer.RemainingBytes == 0) {
+            devicePtr->SendBuffer.RequestedBytes = 0;
+        }
+    }
+}
+
+#if USE_FAST_INTERRUPTS
+    // Vectored straight from the AXI INTC, no XIntc_InterruptHandler scan
+static void uartFastHandler(void) {
+    serviceUart(espDevice);
+}
+#endif
+
+FAST_CODE int readESP32Response(u8 * buf, int maxLength) {
+    u32 tail = rxTail;
+    u32 head = rxHead;
+    int count = 0;
+    while(tail != head && count < maxLength) {
+        buf[count++] = rxRing[tail & (ESP32_RX_RING_SIZE - 1)];
+        tail++;
+    }
+    rxTail = tail;
+    return count;
+}
+
+void echoESP32Responses(void) {
+    u8 chunk[32];
+    int count;
+    while((count = readESP32Response(chunk, sizeof(chunk))) > 0) {
+        for(int i = 0; i < count; i++) {
+            xil_printf("%c", chunk[i]);
+        }
+        scanForIPD(chunk, count);
+    }
+}
+
+void setTCPDataHandler(TCPDataHandler handler) {
+    tcpDataHandler = handler;
+}
+
+static void scanForIPD(const u8 * data, int count) {
+    int i = 0;
+    while(i < count) {
+        u8 c = data[i];
+        switch(ipdState) {
+        case IPD_MATCH:
+            scanForLinkReply(c);
+            if(c == ipdPrefix[ipdMatched]) {
+                ipdMatched++;
+                if(ipdPrefix[ipdMatched] == '\0') {
+                    ipdState = IPD_LENGTH;
+                    ipdLength = 0;
+                }
+            } else {
+                ipdMatched = (c == ipdPrefix[0]) ? 1 : 0;
+            }
+            i++;
+            break;
+        case IPD_LENGTH:
+                // The last number before ':' is the length
+            if(c >= '0' && c <= '9') {
+                ipdLength = ipdLength * 10 + (c - '0');
+            } else if(c == ',') {
+                ipdLength = 0;
+            } else if(c == ':' && ipdLength > 0) {
+                    // No line ending follows the payload, so the reply
+                    // after it would be read on the end of "+IPD,<len>:"
+                ipdState = IPD_PAYLOAD;
+                linkLineLength = 0;
+            } else {
+                ipdState = IPD_MATCH;
+                ipdMatched = 0;
+            }
+            i++;
+            break;
+        default: {
+            int run = count - i;
+            if((u32)run > ipdLength) {
+                run = ipdLength;
+            }
+            if(tcpDataHandler != NULL) {
+                tcpDataHandler(&data[i], run);
+            }
+            ipdLength -= run;
+            i += run;
+            if(ipdLength == 0) {
+                ipdState = IPD_MATCH;
+                ipdMatched = 0;
+            }
+            break;
+        }
+        }
+    }
+}
+
+    // "<segment>,SEND OK", "<segment>,SEND FAIL", or numbers answering
+    // AT+CIPSENDBUF, AT+CIPBUFSTATUS or AT+CIPCHECKSEQ
+static void scanLinkNumbers(void) {
+    char * cursor = linkLine;
+    u32 count = 0;
+    for(;;) {
+        char * end;
+        u32 value = strtoul(cursor, &end, 10);
+        if(end == cursor) {
+            break;
+        }
+        if(count < LINK_MAX_NUMBERS) {
+            linkNumbers[count++] = value;
+        }
+        if(*end != ',') {
+            if(*end == '\0') {
+                linkNumberCount = count;
+                linkEvents |= LINK_NUMBERS;
+            }
+            return;
+        }
+        cursor = end + 1;
+    }
+    if(count == 1 && strcmp(cursor, "SEND OK") == 0) {
+        segmentResult(linkNumbers[0], 1);
+    } else if(count == 1 && strcmp(cursor, "SEND FAIL") == 0) {
+        segmentResult(linkNumbers[0], 0);
+    }
+}
+
+static void scanForLinkReply(u8 c) {
+    if(c == '\r') {
+        return;
+    }
+    if(c == '\n') {
+        linkLine[linkLineLength] = '\0';
+        linkLineLength = 0;
+        if(linkLine[0] >= '0' && linkLine[0] <= '9') {
+            scanLinkNumbers();
+            return;
+        }
+        for(u32 i = 0; i < NUM_LINK_REPLIES; i++) {
+            if(strncmp(linkLine, linkReplies[i].text, linkReplies[i].length) == 0) {
+                linkEvents |= linkReplies[i].event;
+                break;
+            }
+        }
+        return;
+    }
+    if(linkLineLength < LINK_LINE_MAX - 1) {
+        linkLine[linkLineLength++] = c;
+    }
+        // The prompt is the only reply without a line ending
+    if(linkLineLength == 2 && linkLine[0] == '>' && linkLine[1] == ' ') {
+        linkEvents |= LINK_PROMPT;
+        linkLineLength = 0;
+    }
+}
+
+    // Drains the replies until one of events is in, up to useconds
+    //
+    // returns the events seen, 0 on timeout
+static u32 waitForLink(u32 events, unsigned int useconds) {
+    for(;;) {
+        echoESP32Responses();
+        if(linkEvents & events) {
+            return linkEvents & events;
+        }
+        if(useconds < LINK_POLL_US) {
+            return 0;
+        }
+        usleep(LINK_POLL_US);
+        useconds -= LINK_POLL_US;
+    }
+}
+
+void waitForESP32(unsigned int useconds) {
+    while(useconds >= 1000) {
+        usleep(1000);
+        echoESP32Responses();
+        useconds -= 1000;
+    }
+    usleep(useconds);
+    echoESP32Responses();
+}
+
+int waitForESP32Reply(ESP32LineHandler handler, void * context, unsigned int useconds) {
+    char line[ESP32_LINE_MAX];
+    u32 length = 0;
+    u8 chunk[32];
+    int count;
+    for(;;) {
+        while((count = readESP32Response(chunk, sizeof(chunk))) > 0) {
+            scanForIPD(chunk, count);
+            for(int i = 0; i < count; i++) {
+                xil_printf("%c", chunk[i]);
+                if(chunk[i] == '\r') {
+                    continue;
+                }
+                if(chunk[i] != '\n') {
+                        // Overlong lines are cut short, never overrun
+                    if(length < sizeof(line) - 1) {
+                        line[length++] = chunk[i];
+                    }
+                    continue;
+                }
+                line[length] = '\0';
+                length = 0;
+                if(strcmp(line, "OK") == 0) {
+                    return XST_SUCCESS;
+                }
+                if(strcmp(line, "ERROR") == 0 || strcmp(line, "FAIL") == 0) {
+                    return XST_FAILURE;
+                }
+                if(handler != NULL && line[0] != '\0') {
+                    handler(line, context);
+                }
+            }
+        }
+        if(useconds < 1000) {
+            return XST_FAILURE;
+        }
+        usleep(1000);
+        useconds -= 1000;
+    }
+}
+
+u32 getESP32RxDropped(void) {
+    return rxDropped;
+}
+
     // Xilinx AxiUart only supports sending 16 bytes at a time
     // For sending buffers longer than this, we need a helper function
 static int bufferedUartSend(Uart * devicePtr, u8 * data, int length) {
@@ -118,10 +477,22 @@ int checkVersionInfo(Uart * devicePtr) {
 	// Enters Deep Sleep mode for time in milliseconds
 int enterDeepSleep(Uart * devicePtr, unsigned int time) {
 	u8 tx_buf[20];
-	sprintf(tx_buf, "AT+GSLP=%d\0", time);
-	XUartLite_Send(devicePtr, tx_buf, strlen(tx_buf));
+	int length = formatDeepSleep(tx_buf, time);
+	linkEvents = 0;
+	bufferedUartSend(devicePtr, tx_buf, length);
 	sendNLCR(devicePtr);
-	return XST_SUCCESS;
+	u32 events = waitForLink(LINK_OK | LINK_ERROR | LINK_BUSY, ESP32_PROMPT_TIMEOUT_US);
+	    // Whatever comes after this is from the wake
+	linkEvents = 0;
+	return (events & LINK_OK) ? XST_SUCCESS : XST_FAILURE;
+}
+
+int waitForESP32Ready(unsigned int useconds) {
+    return waitForLink(LINK_READY, useconds) ? XST_SUCCESS : XST_FAILURE;
+}
+
+int waitForESP32Network(unsigned int useconds) {
+    return waitForLink(LINK_GOT_IP, useconds) ? XST_SUCCESS : XST_FAILURE;
 }
 
 int getWiFiMode(Uart * devicePtr) {
@@ -156,13 +527,9 @@ int getCurrentAP(Uart * devicePtr) {
     // Use BSSID if there are multiple APs with the same SSID.
     // If this is not the case, pass in NULL for bssid
 int setCurrentAP(Uart * devicePtr, char * ssid, char * pwd, char * bssid) {
-    u8 tx_buf[100];
-    sprintf(tx_buf, "AT+CWJAP=\"%s\",\"%s\"", ssid, pwd);
-    if(bssid != NULL) {
-        int cursor = strlen(tx_buf);
-        sprintf(tx_buf + cursor, ",\"%s\"");
-    }
-    XUartLite_Send(devicePtr, tx_buf, strlen(tx_buf));
+    u8 tx_buf[AT_MAX_COMMAND];
+    int length = formatJoinAP(tx_buf, ssid, pwd, bssid);
+    bufferedUartSend(devicePtr, tx_buf, length);
     sendNLCR(devicePtr);
     return XST_SUCCESS;
 }
@@ -172,13 +539,9 @@ int setCurrentAP(Uart * devicePtr, char * ssid, char * pwd, char * bssid) {
     // If SSID is specified, this function will print information
     // about the specific AP specified by SSID
 int listAvailableAPs(Uart * devicePtr, char * ssid) {
-    u8 tx_buf[100];
-    sprintf(tx_buf, "AT+CWLAP");
-    if(ssid != NULL) {
-        int cursor = strlen(tx_buf);
-        sprintf(tx_buf + cursor, "=\"%s\"", ssid);
-    }
-    XUartLite_Send(devicePtr, tx_buf, strlen(tx_buf));
+    u8 tx_buf[AT_MAX_COMMAND];
+    int length = formatListAPs(tx_buf, ssid);
+    bufferedUartSend(devicePtr, tx_buf, length);
     sendNLCR(devicePtr);
     return XST_SUCCESS;
 }
@@ -308,22 +671,286 @@ int  getConnectionStatus(Uart * devicePtr) {
 int establishTCPConnection(Uart * devicePtr, char * remoteIP,
      int remotePort, int TCP_KeepAlive) {
 
-    u8 tx_buf[200];
-    sprintf(tx_buf, "AT+CIPSTART=\"TCP\",\"%s\",%d,%d", remoteIP, remotePort, TCP_KeepAlive);
-    bufferedUartSend(devicePtr, tx_buf, strlen(tx_buf));
+    u8 tx_buf[AT_MAX_COMMAND];
+    int length = formatTCPStart(tx_buf, remoteIP, remotePort, TCP_KeepAlive);
+    linkEvents = 0;
+    bufferedUartSend(devicePtr, tx_buf, length);
     sendNLCR(devicePtr);
-    usleep(10000000);
-    return XST_SUCCESS;
+    u32 events = waitForLink(LINK_OK | LINK_ERROR, ESP32_CONNECT_TIMEOUT_US);
+    return (events & LINK_OK) ? XST_SUCCESS : XST_FAILURE;
 }
 
     // This assumes that the TCP connection has already
     // Been started with some TCP server
 int TCPsend(Uart * devicePtr, u8 * data, int length) {
     u8 tx_buf[50];
-    sprintf(tx_buf, "AT+CIPSEND=%d", length);
-    bufferedUartSend(devicePtr, tx_buf, strlen(tx_buf));
+    u32 backoff = ESP32_BACKOFF_US;
+    u32 events;
+
+    if(length <= 0 || length > AT_SEND_MAX) {
+        return XST_FAILURE;
+    }
+
+        // Hold back while SEND FAILs say the ESP32 cannot keep up
+    while(getTickCount() - lastSendTick < linkStats.gapMs * TICK_HZ / 1000) {
+        waitForESP32(1000);
+    }
+    lastSendTick = getTickCount();
+
+    int cmdLength = formatTCPSend(tx_buf, length);
+    for(int attempt = 0; attempt < ESP32_SEND_ATTEMPTS; attempt++) {
+        linkEvents = 0;
+        bufferedUartSend(devicePtr, tx_buf, cmdLength);
+        sendNLCR(devicePtr);
+        events = waitForLink(LINK_PROMPT | LINK_BUSY | LINK_ERROR, ESP32_PROMPT_TIMEOUT_US);
+
+        if(events & LINK_PROMPT) {
+            bufferedUartSend(devicePtr, data, length);
+            events = waitForLink(LINK_SEND_OK | LINK_SEND_FAIL | LINK_ERROR, ESP32_SEND_TIMEOUT_US);
+            if(events & LINK_SEND_OK) {
+                linkStats.sends++;
+                linkStats.bytes += length;
+                linkStats.gapMs -= (linkStats.gapMs + 7) / 8;
+                return XST_SUCCESS;
+            }
+            if(!(events & LINK_SEND_FAIL)) {
+                    // Without an answer there is no telling whether the
+                    // data went, so it is not sent twice
+                if(events == 0) {
+                    linkStats.timeouts++;
+                } else {
+                    linkStats.errors++;
+                }
+                return XST_FAILURE;
+            }
+            linkStats.sendFails++;
+            linkStats.gapMs = 2 * linkStats.gapMs + ESP32_GAP_STEP_MS;
+            if(linkStats.gapMs > ESP32_GAP_MAX_MS) {
+                linkStats.gapMs = ESP32_GAP_MAX_MS;
+            }
+        } else if(events & LINK_BUSY) {
+            linkStats.busy++;
+        } else {
+                // An error is no connection; a missing prompt may leave
+                // the ESP32 waiting for data, which a retry would feed
+            if(events == 0) {
+                linkStats.timeouts++;
+            } else {
+                linkStats.errors++;
+            }
+            return XST_FAILURE;
+        }
+
+        waitForESP32(backoff);
+        if(backoff < ESP32_BACKOFF_MAX_US) {
+            backoff *= 2;
+        }
+    }
+    linkStats.dropped++;
+    return XST_FAILURE;
+}
+
+    // Called by the reply scanner with a "<segment>,SEND ..." result
+static void segmentResult(u32 segment, int sent) {
+    for(u32 i = 0; i < ESP32_SEND_WINDOW; i++) {
+        SendSlot * slot = &sendWindow[i];
+        if(slot->state != SLOT_QUEUED || slot->segment != segment) {
+            continue;
+        }
+        if(!sent) {
+            linkStats.segmentFails++;
+            slot->state = SLOT_FAILED;
+            return;
+        }
+        linkStats.segmentsSent++;
+        linkStats.segmentBytes += slot->length;
+        slot->state = SLOT_FREE;
+        if(slot->handler != NULL) {
+            slot->handler(slot->id, XST_SUCCESS);
+        }
+        return;
+    }
+}
+
+static void segmentLost(SendSlot * slot) {
+    linkStats.lost++;
+    xil_printf("Segment %d lost after %d attempts\n\r", slot->id, slot->attempts);
+    slot->state = SLOT_FREE;
+    if(slot->handler != NULL) {
+        slot->handler(slot->id, XST_FAILURE);
+    }
+}
+
+    // Sends a command answered with a line of numbers and OK
+    //
+    // returns XST_SUCCESS if count numbers came back, now in linkNumbers
+static int queryESP32(Uart * devicePtr, u8 * command, int length, u32 count) {
+    linkEvents = 0;
+    linkNumberCount = 0;
+    bufferedUartSend(devicePtr, command, length);
     sendNLCR(devicePtr);
-    usleep(100000);
-    bufferedUartSend(devicePtr, data, length);
+    u32 events = waitForLink(LINK_OK | LINK_ERROR | LINK_BUSY, ESP32_PROMPT_TIMEOUT_US);
+    if(!(events & LINK_OK) || linkNumberCount != count) {
+        return XST_FAILURE;
+    }
     return XST_SUCCESS;
 }
+
+    // Hands the slot's data to the ESP32 as a new segment
+static int sendSegment(Uart * devicePtr, SendSlot * slot) {
+    u8 tx_buf[AT_MAX_COMMAND];
+    u32 backoff = ESP32_BACKOFF_US;
+    u32 events;
+
+    int cmdLength = formatTCPSendBuffered(tx_buf, slot->length);
+    for(int attempt = 0; attempt < ESP32_SEND_ATTEMPTS; attempt++) {
+        linkEvents = 0;
+        linkNumberCount = 0;
+        bufferedUartSend(devicePtr, tx_buf, cmdLength);
+        sendNLCR(devicePtr);
+        events = waitForLink(LINK_PROMPT | LINK_BUSY | LINK_ERROR, ESP32_PROMPT_TIMEOUT_US);
+
+        if(events & LINK_PROMPT) {
+                // "<segment>,<last sent OK>" comes ahead of the prompt.
+                // The ESP32 waits for the data either way
+            int numbered = linkNumberCount == 2;
+            slot->segment = linkNumbers[0];
+            slot->state = SLOT_QUEUED;
+            slot->queuedTick = getTickCount();
+            slot->attempts++;
+            bufferedUartSend(devicePtr, slot->data, slot->length);
+            events = waitForLink(LINK_RECV | LINK_ERROR, ESP32_PROMPT_TIMEOUT_US);
+            if(!numbered || !(events & LINK_RECV)) {
+                    // The data has gone out, but with no segment number
+                    // its result cannot be told: the handler hears it as
+                    // lost rather than the caller as not taken
+                linkStats.errors++;
+                segmentLost(slot);
+                return XST_SUCCESS;
+            }
+            linkStats.segments++;
+            return XST_SUCCESS;
+        }
+        if(!(events & LINK_BUSY)) {
+            if(events == 0) {
+                linkStats.timeouts++;
+            } else {
+                linkStats.errors++;
+            }
+            return XST_FAILURE;
+        }
+        linkStats.busy++;
+        waitForESP32(backoff);
+        if(backoff < ESP32_BACKOFF_MAX_US) {
+            backoff *= 2;
+        }
+    }
+    return XST_FAILURE;
+}
+
+    // Looks up a segment whose result has not come: still waiting in
+    // the ESP32's buffer, sent, or failed. One the ESP32 cannot tell
+    // about, e.g. after the connection dropped, is sent again
+static void checkSegment(Uart * devicePtr, SendSlot * slot) {
+    u8 tx_buf[AT_MAX_COMMAND];
+    linkStats.checks++;
+    slot->queuedTick = getTickCount();
+    if(queryESP32(devicePtr, (u8 *)AT_BUF_STATUS, strlen(AT_BUF_STATUS), 5) != XST_SUCCESS) {
+        if(slot->state == SLOT_QUEUED) {
+            slot->state = SLOT_FAILED;
+        }
+        return;
+    }
+        // Result came in meanwhile, or not handed to TCP yet
+    if(slot->state != SLOT_QUEUED || (s32)(slot->segment - linkNumbers[1]) > 0) {
+        return;
+    }
+    int length = formatCheckSegment(tx_buf, slot->segment);
+    if(queryESP32(devicePtr, tx_buf, length, 2) != XST_SUCCESS ||
+            linkNumbers[0] != slot->segment) {
+        if(slot->state == SLOT_QUEUED) {
+            slot->state = SLOT_FAILED;
+        }
+        return;
+    }
+    if(slot->state == SLOT_QUEUED) {
+        segmentResult(slot->segment, linkNumbers[1]);
+    }
+}
+
+void serviceTCPSendWindow(Uart * devicePtr) {
+    for(u32 i = 0; i < ESP32_SEND_WINDOW; i++) {
+        SendSlot * slot = &sendWindow[i];
+        if(slot->state == SLOT_FAILED) {
+            if(slot->attempts >= ESP32_SEGMENT_ATTEMPTS) {
+                segmentLost(slot);
+                continue;
+            }
+            linkStats.resends++;
+            if(sendSegment(devicePtr, slot) != XST_SUCCESS) {
+                segmentLost(slot);
+            }
+        } else if(slot->state == SLOT_QUEUED &&
+                getTickCount() - slot->queuedTick > ESP32_SEGMENT_CHECK_MS * TICK_HZ / 1000) {
+            checkSegment(devicePtr, slot);
+        }
+    }
+}
+
+int TCPsendBuffered(Uart * devicePtr, u8 * data, int length, TCPSegmentHandler handler) {
+    SendSlot * slot;
+
+    if(length <= 0 || length > AT_SEND_MAX) {
+        return XST_FAILURE;
+    }
+
+    for(u32 waited = 0; ; waited += 1000) {
+        for(slot = sendWindow; slot < &sendWindow[ESP32_SEND_WINDOW]; slot++) {
+            if(slot->state == SLOT_FREE) {
+                break;
+            }
+        }
+        if(slot < &sendWindow[ESP32_SEND_WINDOW]) {
+            break;
+        }
+        if(waited >= ESP32_SEND_TIMEOUT_US) {
+            linkStats.windowFull++;
+            return XST_FAILURE;
+        }
+        serviceTCPSendWindow(devicePtr);
+        waitForESP32(1000);
+    }
+
+    memcpy(slot->data, data, length);
+    slot->length = length;
+    slot->id = nextSegmentId++;
+    slot->attempts = 0;
+    slot->handler = handler;
+    return sendSegment(devicePtr, slot);
+}
+
+int isTCPSendWindowIdle(void) {
+    for(SendSlot * slot = sendWindow; slot < &sendWindow[ESP32_SEND_WINDOW]; slot++) {
+        if(slot->state != SLOT_FREE) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void getESP32LinkStats(ESP32LinkStats * stats) {
+    *stats = linkStats;
+}
+
+void printESP32LinkStats(void) {
+    xil_printf("Link: %d sends, %d bytes, %d SEND FAIL, %d busy, %d timeouts, %d errors, %d dropped, gap %d ms\n\r",
+        linkStats.sends, linkStats.bytes, linkStats.sendFails, linkStats.busy,
+        linkStats.timeouts, linkStats.errors, linkStats.dropped, linkStats.gapMs);
+    if(linkStats.segments == 0) {
+        return;
+    }
+    xil_printf("Window: %d segments, %d sent OK (%d bytes), %d SEND FAIL, %d resent, %d checked, %d lost, %d window full\n\r",
+        linkStats.segments, linkStats.segmentsSent, linkStats.segmentBytes,
+        linkStats.segmentFails, linkStats.resends, linkStats.checks, linkStats.lost,
+        linkStats.windowFull);
+}
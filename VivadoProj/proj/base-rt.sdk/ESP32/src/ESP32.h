@@ -27,6 +27,8 @@
 #include "xuartlite.h"
 #include "xil_exception.h"
 #include "xuartlite_l.h"
+#include "platform_config.h"
+#include "atFormat.h"
 #include <stdio.h>
 #include <unistd.h>
 
@@ -35,8 +37,82 @@
 #define INTC_DEVICE_ID          XPAR_INTC_0_DEVICE_ID
 #define UARTLITE_INT_IRQ_ID     XPAR_INTC_0_UARTLITE_1_VEC_ID
 
+    // Size of the receive ring filled by the UART ISR, must be a power of 2
+#define ESP32_RX_RING_SIZE      1024
+
+/***************************** SEND FLOW CONTROL ******************************/
+    // The UART Lite has no RTS/CTS, so TCPsend paces itself on the replies:
+    // the data goes out once the "> " prompt is in, and the next send only
+    // after SEND OK. A "busy" reply is retried after a backoff that doubles
+    // up to its maximum, a SEND FAIL resends the same data. Each SEND FAIL
+    // also widens a minimum gap between the starts of two sends, and each
+    // SEND OK narrows it again by an eighth
+#define ESP32_PROMPT_TIMEOUT_US 1000000
+#define ESP32_SEND_TIMEOUT_US   5000000
+#define ESP32_SEND_ATTEMPTS     5
+#define ESP32_BACKOFF_US        10000
+#define ESP32_BACKOFF_MAX_US    320000
+#define ESP32_GAP_STEP_MS       5
+#define ESP32_GAP_MAX_MS        1000
+
+/******************************** SEND WINDOW *********************************/
+    // TCPsendBuffered hands data to the ESP32 with AT+CIPSENDBUF and
+    // returns without waiting for its SEND OK. The ESP32 numbers each
+    // segment and later answers "<segment>,SEND OK" or "<segment>,SEND FAIL".
+    // Up to ESP32_SEND_WINDOW segments are out at once, each kept until
+    // its result is in. A SEND FAIL sends the segment again as a new one,
+    // up to ESP32_SEGMENT_ATTEMPTS times. A segment with no result after
+    // ESP32_SEGMENT_CHECK_MS is looked up with AT+CIPBUFSTATUS and
+    // AT+CIPCHECKSEQ, in case its result line was lost
+#define ESP32_SEND_WINDOW       8
+#define ESP32_SEGMENT_ATTEMPTS  3
+#define ESP32_SEGMENT_CHECK_MS  2000
+
+/******************************** DEEP SLEEP **********************************/
+    // The ESP32 comes out of a deep sleep through a reset: it prints
+    // "ready" once booted, then rejoins the access point it last joined
+    // and prints "WIFI GOT IP". The limits are on the replies, which
+    // usually come much sooner
+#define ESP32_READY_TIMEOUT_US  3000000
+#define ESP32_NETWORK_TIMEOUT_US 5000000
+    // Longest AT+CIPSTART may take to answer
+#define ESP32_CONNECT_TIMEOUT_US 10000000
+
+    // Longest reply line waitForESP32Reply keeps whole, '\0' included
+#define ESP32_LINE_MAX          128
+
 /***************************** TYPEDEFs ***************************/
 typedef XUartLite         	    Uart;
+
+    // Receives the payload of "+IPD" frames, see setTCPDataHandler
+typedef void (*TCPDataHandler)(const u8 * data, int length);
+
+    // Told the result of a segment, see TCPsendBuffered; status is
+    // XST_SUCCESS once the ESP32 has sent it, XST_FAILURE once it is lost
+typedef void (*TCPSegmentHandler)(u32 segment, int status);
+
+    // Receives each line of a reply, see waitForESP32Reply
+typedef void (*ESP32LineHandler)(const char * line, void * context);
+
+typedef struct {
+    u32 sends;          // sends answered SEND OK
+    u32 bytes;
+    u32 sendFails;      // SEND FAIL replies, each resent
+    u32 busy;           // busy replies to AT+CIPSEND, each retried
+    u32 timeouts;       // no prompt or no SEND OK in time
+    u32 errors;         // ERROR or CLOSED, e.g. no connection
+    u32 dropped;        // sends given up on after ESP32_SEND_ATTEMPTS
+    u32 gapMs;          // current minimum gap between sends
+        // TCPsendBuffered
+    u32 segments;       // segments handed to the ESP32, resends included
+    u32 segmentBytes;   // bytes of segments answered SEND OK
+    u32 segmentsSent;   // answered SEND OK
+    u32 segmentFails;   // answered SEND FAIL
+    u32 resends;
+    u32 checks;         // segments looked up with AT+CIPCHECKSEQ
+    u32 lost;           // given up on after ESP32_SEGMENT_ATTEMPTS
+    u32 windowFull;     // TCPsendBuffered calls that found no free slot
+} ESP32LinkStats;
 #define INTC                    XIntc
 #define INTC_HANDLER            XIntc_InterruptHandler
 
@@ -88,16 +164,36 @@ int resetESP32(Uart * devicePtr);
 int checkVersionInfo(Uart * devicePtr);
 
 /**
- * Attempts to put the ESP32 into sleep mode for the
- * amount of seconds specified by 'time'
+ * Attempts to put the ESP32 into deep sleep for the
+ * amount of milliseconds specified by 'time'. The TCP
+ * connection is closed, and the ESP32 wakes up through
+ * a reset once the time is up, see waitForESP32Ready
  *
  * Prints response of the device over the USB/UART port
  *
- * Returns an int that specifies success or failure
- * in regards to sending the command to the device
+ * returns XST_SUCCESS once the ESP32 has answered OK
+ * returns XST_FAILURE if it did not
  */
 int enterDeepSleep(Uart * devicePtr, unsigned int time);
 
+/**
+ * Waits up to useconds for the ESP32 to print "ready" after a reset or
+ * the end of a deep sleep begun with enterDeepSleep
+ *
+ * returns XST_SUCCESS once it is ready
+ * returns XST_FAILURE on timeout
+ */
+int waitForESP32Ready(unsigned int useconds);
+
+/**
+ * Waits up to useconds for the ESP32 to rejoin its access point by
+ * itself after waitForESP32Ready
+ *
+ * returns XST_SUCCESS once it has an IP address
+ * returns XST_FAILURE on timeout
+ */
+int waitForESP32Network(unsigned int useconds);
+
 
 /**
  * Simple function to aid in UART transactions
@@ -199,11 +295,12 @@ int getConnectionStatus(Uart * devicePtr);
  * network and that there is a server at the IPaddress and port number to
  * respond to the connection
  *
+ * Waits for the answer, up to ESP32_CONNECT_TIMEOUT_US
+ *
  * Prints the response of the device to the USB/UART port
  *
- * returns an int to specify success or failure
- * in sending the command to the device* remoteIP should be of the form "192.168.1.1"
-* remotePort can be passed directly as an integer
+ * returns XST_SUCCESS once the ESP32 has answered OK
+ * returns XST_FAILURE if the connection could not be made
  */
 int establishTCPConnection(Uart * devicePtr, char * remoteIP,
      int remotePort, int TCP_KeepAlive);
@@ -217,13 +314,59 @@ int establishTCPConnection(Uart * devicePtr, char * remoteIP,
 * respond to the connection. It also assumes that only one valid connection (TCP, SSL, UDP)
 * has already been established with a remote server
 *
+* Waits for the ESP32 to answer SEND OK, retrying busy and SEND FAIL
+* replies as described under SEND FLOW CONTROL, so at most AT_SEND_MAX
+* bytes are ever in the ESP32's hands
+*
 * Prints the response of the device to the USB/UART port
 *
-* returns an int to specify success or failure
-* in sending the command to the device
+* returns XST_SUCCESS once the ESP32 has answered SEND OK
+* returns XST_FAILURE if the data could not be sent
 */
 int TCPsend(Uart * devicePtr, u8 * data, int length);
 
+/**
+ * Queues length bytes of data, at most AT_SEND_MAX, as one AT+CIPSENDBUF
+ * segment, as described under SEND WINDOW. The data is copied, so the
+ * caller may reuse it as soon as this returns. Waits for a free slot
+ * when ESP32_SEND_WINDOW segments are out, but never for the SEND OK
+ *
+ * handler, unless NULL, is called with the segment's ID once its
+ * result is in. A resent segment keeps the ID it was first given.
+ * Runs from the main loop, never in the ISR, and may run before this
+ * returns, e.g. when the ESP32 took the data but gave no segment number
+ *
+ * Segments that are resent arrive after the ones queued behind them,
+ * so each should be a frame the TCP peer can take on its own
+ *
+ * returns XST_SUCCESS once the ESP32 has taken the data
+ * returns XST_FAILURE if it did not, handler is then not called
+ */
+int TCPsendBuffered(Uart * devicePtr, u8 * data, int length, TCPSegmentHandler handler);
+
+/**
+ * Resends failed segments, gives up on those out of attempts and looks
+ * up segments whose result is overdue. Called from the main loop;
+ * TCPsendBuffered also calls it while it waits for a free slot
+ */
+void serviceTCPSendWindow(Uart * devicePtr);
+
+/**
+ * Returns non-zero when no TCPsendBuffered segment is waiting for its
+ * result
+ */
+int isTCPSendWindowIdle(void);
+
+/**
+ * Copies the TCPsend and TCPsendBuffered counters
+ */
+void getESP32LinkStats(ESP32LinkStats * stats);
+
+/**
+ * Prints the TCPsend and TCPsendBuffered counters to the USB/UART port
+ */
+void printESP32LinkStats(void);
+
 
 
 /************************ AxiUartLite Control Functions ***********************/
@@ -231,4 +374,48 @@ int setupInterrupt(Uart * devicePtr, u32 interruptDeviceID, u32 interruptID);
 void uartRecvHandler(void * CallBackRef, unsigned int EventData);
 void uartSendHandler(void * CallBackRef, unsigned int EventData);
 
+/**
+ * Copies up to maxLength bytes that the ESP32 has sent out of the
+ * receive ring and into buf
+ *
+ * returns the number of bytes copied, 0 if nothing is pending
+ */
+int readESP32Response(u8 * buf, int maxLength);
+
+/**
+ * Prints everything the ESP32 has sent since the last call
+ * to the USB/UART port
+ */
+void echoESP32Responses(void);
+
+/**
+ * Busy-waits for useconds, printing the ESP32's responses to the
+ * USB/UART port as they arrive
+ */
+void waitForESP32(unsigned int useconds);
+
+/**
+ * Busy-waits for the reply to a command, up to useconds, printing it to
+ * the USB/UART port as it arrives. Every line before the final one is
+ * handed to handler, which may be NULL, without its line ending
+ *
+ * returns XST_SUCCESS once a line reads "OK"
+ * returns XST_FAILURE on "ERROR", "FAIL" or timeout
+ */
+int waitForESP32Reply(ESP32LineHandler handler, void * context, unsigned int useconds);
+
+/**
+ * Returns the number of received bytes dropped because the
+ * receive ring was full
+ */
+u32 getESP32RxDropped(void);
+
+/**
+ * Registers a function that is handed the payload of every "+IPD"
+ * frame, i.e. the data the TCP peer sent, as echoESP32Responses
+ * drains the receive ring. A frame may arrive in several pieces.
+ * Runs in the main loop, never in the ISR. Pass NULL to stop
+ */
+void setTCPDataHandler(TCPDataHandler handler);
+
 #endif  /* end of protection macro */
@@ -0,0 +1,349 @@
+/*******************************************************************************
+    XADC supply and temperature alarms, see alarm.h
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "alarm.h"
+#include "sysTimer.h"
+#include "pool.h"
+#include "command.h"
+#include "platform.h"
+
+    // The low alarm output bits match the "alarm went active" interrupts
+#define ALARM_MASK              ((1 << ALARM_COUNT) - 1)
+#define ALARM_IRQ_MASK          (XSM_IPIXR_OT_MASK | XSM_IPIXR_TEMP_MASK | \
+                                 XSM_IPIXR_VCCINT_MASK | XSM_IPIXR_VCCAUX_MASK)
+
+ISR_INLINE void serviceAlarmIrq(void);
+#if USE_FAST_INTERRUPTS
+static void alarmFastHandler(void) FAST_ISR;
+#else
+static void alarmHandler(void * CallBackRef);
+#endif
+static void alarmTick(void) FAST_CODE;
+static int alarmCommand(int argc, char ** argv, char * reply, int replySize);
+static int xadcCommand(int argc, char ** argv, char * reply, int replySize);
+
+static const char * const alarmNames[ALARM_COUNT] = {
+    "overtemp", "temp", "vccint", "vccaux"
+};
+
+    // Data register read for each alarm when stamping an event
+static const u16 alarmChannelOffset[ALARM_COUNT] FAST_DATA = {
+    XSM_TEMP_OFFSET, XSM_TEMP_OFFSET, XSM_VCCINT_OFFSET, XSM_VCCAUX_OFFSET
+};
+
+static XSysMon * xadc;
+static AlarmEvent queue[ALARM_QUEUE_LEN] FAST_BSS;
+static volatile u32 queueHead FAST_BSS;
+static volatile u32 queueTail FAST_BSS;
+static volatile u32 activeMask FAST_BSS;
+static u32 clearTicks[ALARM_COUNT] FAST_BSS;
+static volatile AlarmStats alarmStats FAST_BSS;
+static volatile XadcConversionHook conversionHook FAST_BSS;
+
+static u16 milliCToXadc(s32 milliC) {
+    return (u16)((((u32)(milliC + 273150) * 4096) / 503975) << 4);
+}
+
+static u16 milliVToXadc(u32 milliV) {
+    return (u16)(((milliV * 4096) / 3000) << 4);
+}
+
+    // Readings are 12 bit codes in the top of a 16 bit register
+s32 xadcToMilliC(u16 raw) {
+    return (s32)(((u32)(raw >> 4) * 503975) / 4096) - 273150;
+}
+
+u32 xadcToMilliV(u16 raw) {
+    return ((u32)(raw >> 4) * 3000) / 4096;
+}
+
+int initAlarms(XSysMon * xadcPtr, XIntc * intPtr) {
+    int Status;
+    XSysMon_Config * config = XSysMon_LookupConfig(XADC_DEVICE_ID);
+    if (config == NULL) {
+        xil_printf("Could not find XADC config\n\r");
+        return XST_FAILURE;
+    }
+    Status = XSysMon_CfgInitialize(xadcPtr, config, config->BaseAddress);
+    if (Status != XST_SUCCESS) {
+        xil_printf("Could not initialize XADC\n\r");
+        return XST_FAILURE;
+    }
+    xadc = xadcPtr;
+
+    XSysMon_SetSequencerMode(xadcPtr, XSM_SEQ_MODE_SAFE);
+    XSysMon_SetAlarmEnables(xadcPtr, 0);
+
+    setAlarmLimits(ALARM_TEMP, ALARM_TEMP_LOWER_MC, ALARM_TEMP_UPPER_MC);
+    setAlarmLimits(ALARM_VCCINT, ALARM_VCCINT_LOWER_MV, ALARM_VCCINT_UPPER_MV);
+    setAlarmLimits(ALARM_VCCAUX, ALARM_VCCAUX_LOWER_MV, ALARM_VCCAUX_UPPER_MV);
+
+    queueHead = 0;
+    queueTail = 0;
+    activeMask = 0;
+    memset((void *)&alarmStats, 0, sizeof(alarmStats));
+
+#if USE_FAST_INTERRUPTS
+    Status = XIntc_ConnectFastHandler(intPtr, XADC_INT_IRQ_ID,
+               alarmFastHandler);
+#else
+    Status = XIntc_Connect(intPtr, XADC_INT_IRQ_ID,
+               (XInterruptHandler)alarmHandler, (void *)xadcPtr);
+#endif
+    if (Status != XST_SUCCESS) {
+        xil_printf("Could not Connect XADC to Interrupt Controller\n\r");
+        return XST_FAILURE;
+    }
+
+    Status = addTickHook(alarmTick);
+    if (Status != XST_SUCCESS) {
+        xil_printf("Could not register alarm tick\n\r");
+        return XST_FAILURE;
+    }
+    Status = addCommand("alarm", alarmCommand);
+    if (Status != XST_SUCCESS) {
+        xil_printf("Could not register alarm command\n\r");
+        return XST_FAILURE;
+    }
+    Status = addCommand("xadc", xadcCommand);
+    if (Status != XST_SUCCESS) {
+        xil_printf("Could not register xadc command\n\r");
+        return XST_FAILURE;
+    }
+
+    XSysMon_SetAlarmEnables(xadcPtr, XSM_CFR1_OT_MASK | XSM_CFR1_ALM_TEMP_MASK |
+        XSM_CFR1_ALM_VCCINT_MASK | XSM_CFR1_ALM_VCCAUX_MASK);
+    startAlarmSequence();
+
+        // Drop edges latched before the thresholds were in place
+    XSysMon_IntrClear(xadcPtr, XSM_IPIXR_ALL_MASK);
+    XSysMon_IntrEnable(xadcPtr, ALARM_IRQ_MASK);
+    XSysMon_IntrGlobalEnable(xadcPtr);
+    XIntc_Enable(intPtr, XADC_INT_IRQ_ID);
+    return XST_SUCCESS;
+}
+
+void startAlarmSequence(void) {
+        // Channel enables can only be changed in safe mode
+    XSysMon_SetSequencerMode(xadc, XSM_SEQ_MODE_SAFE);
+    XSysMon_SetSeqChEnables(xadc, ALARM_SEQ_CHANNELS);
+    XSysMon_SetSequencerMode(xadc, XSM_SEQ_MODE_CONTINPASS);
+}
+
+void setXadcConversionHook(XadcConversionHook hook) {
+    conversionHook = hook;
+}
+
+int setAlarmLimits(u32 alarm, s32 lower, s32 upper) {
+    if(lower > upper) {
+        return XST_INVALID_PARAM;
+    }
+    if(alarm != ALARM_TEMP && lower < 0) {
+        return XST_INVALID_PARAM;
+    }
+    switch(alarm) {
+    case ALARM_TEMP:
+        XSysMon_SetAlarmThreshold(xadc, XSM_ATR_TEMP_LOWER, milliCToXadc(lower));
+        XSysMon_SetAlarmThreshold(xadc, XSM_ATR_TEMP_UPPER, milliCToXadc(upper));
+        break;
+    case ALARM_VCCINT:
+        XSysMon_SetAlarmThreshold(xadc, XSM_ATR_VCCINT_LOWER, milliVToXadc(lower));
+        XSysMon_SetAlarmThreshold(xadc, XSM_ATR_VCCINT_UPPER, milliVToXadc(upper));
+        break;
+    case ALARM_VCCAUX:
+        XSysMon_SetAlarmThreshold(xadc, XSM_ATR_VCCAUX_LOWER, milliVToXadc(lower));
+        XSysMon_SetAlarmThreshold(xadc, XSM_ATR_VCCAUX_UPPER, milliVToXadc(upper));
+        break;
+    default:
+        return XST_INVALID_PARAM;
+    }
+    return XST_SUCCESS;
+}
+
+    // Called with interrupts disabled, from either ISR
+ISR_INLINE void queueAlarmEvent(u32 alarm, u32 raised) {
+    alarmStats.events++;
+    if(queueHead - queueTail >= ALARM_QUEUE_LEN) {
+        alarmStats.overflows++;
+        return;
+    }
+    AlarmEvent * event = &queue[queueHead & (ALARM_QUEUE_LEN - 1)];
+    event->alarm = alarm;
+    event->raised = raised;
+    event->raw = ISR_IN32(XADC_BASEADDR + alarmChannelOffset[alarm]);
+    event->tick = getTickCount();
+    event->cycles = readCycles();
+    queueHead++;
+}
+
+ISR_INLINE void serviceAlarmIrq(void) {
+    u32 pending = ISR_IN32(XADC_BASEADDR + XSM_IPISR_OFFSET) &
+        ISR_IN32(XADC_BASEADDR + XSM_IPIER_OFFSET);
+
+        // Toggle-on-write, clears exactly the bits that were read
+    ISR_OUT32(XADC_BASEADDR + XSM_IPISR_OFFSET, pending);
+
+    if((pending & (XSM_IPIXR_EOC_MASK | XSM_IPIXR_EOS_MASK)) && conversionHook) {
+        conversionHook();
+    }
+
+    pending &= ALARM_MASK & ~activeMask;
+    if(pending == 0) {
+        return;
+    }
+        // Masked until alarmTick sees the output clear
+    ISR_OUT32(XADC_BASEADDR + XSM_IPIER_OFFSET,
+        ISR_IN32(XADC_BASEADDR + XSM_IPIER_OFFSET) & ~pending);
+    activeMask |= pending;
+    alarmStats.active = activeMask;
+
+    for(u32 i = 0; i < ALARM_COUNT; i++) {
+        if(pending & (1 << i)) {
+            clearTicks[i] = 0;
+            alarmStats.raised[i]++;
+            queueAlarmEvent(i, 1);
+        }
+    }
+}
+
+#if USE_FAST_INTERRUPTS
+static void alarmFastHandler(void) {
+    serviceAlarmIrq();
+}
+#else
+FAST_CODE static void alarmHandler(void * CallBackRef) {
+    serviceAlarmIrq();
+}
+#endif
+
+    // Nothing to do unless an alarm is active
+static void alarmTick(void) {
+    if(activeMask == 0) {
+        return;
+    }
+
+    u32 output = XSysMon_ReadReg(XADC_BASEADDR, XSM_AOR_OFFSET);
+    u32 cleared = 0;
+    for(u32 i = 0; i < ALARM_COUNT; i++) {
+        if(!(activeMask & (1 << i))) {
+            continue;
+        }
+        if(output & (1 << i)) {
+            clearTicks[i] = 0;
+        } else if(++clearTicks[i] >= ALARM_DEBOUNCE_TICKS) {
+            cleared |= 1 << i;
+            queueAlarmEvent(i, 0);
+        }
+    }
+    if(cleared == 0) {
+        return;
+    }
+
+    activeMask &= ~cleared;
+    alarmStats.active = activeMask;
+    XSysMon_WriteReg(XADC_BASEADDR, XSM_IPISR_OFFSET,
+        XSysMon_ReadReg(XADC_BASEADDR, XSM_IPISR_OFFSET) & cleared);
+    XSysMon_WriteReg(XADC_BASEADDR, XSM_IPIER_OFFSET,
+        XSysMon_ReadReg(XADC_BASEADDR, XSM_IPIER_OFFSET) | cleared);
+}
+
+static int formatAlarmEvent(char * buffer, int size, const AlarmEvent * event) {
+    const char * state = event->raised ? "raised" : "cleared";
+    if(event->alarm <= ALARM_TEMP) {
+        return snprintf(buffer, size, "ALARM %s %s %d mC tick %u cycle %u\r\n",
+            alarmNames[event->alarm], state, (int)xadcToMilliC(event->raw),
+            (unsigned)event->tick, (unsigned)event->cycles);
+    }
+    return snprintf(buffer, size, "ALARM %s %s %u mV tick %u cycle %u\r\n",
+        alarmNames[event->alarm], state, (unsigned)xadcToMilliV(event->raw),
+        (unsigned)event->tick, (unsigned)event->cycles);
+}
+
+int serviceAlarms(Uart * devicePtr) {
+    if(queueHead == queueTail) {
+        return 0;
+    }
+    char * message = poolAlloc(POOL_MEDIUM_SIZE);
+    if(message == NULL) {
+        return 0;
+    }
+
+        // As many events as fit, the rest go on the next call
+    int length = 0;
+    while(queueTail != queueHead) {
+        char line[64];
+        int lineLength = formatAlarmEvent(line, sizeof(line),
+            &queue[queueTail & (ALARM_QUEUE_LEN - 1)]);
+        if(length + lineLength >= POOL_MEDIUM_SIZE) {
+            break;
+        }
+        memcpy(message + length, line, lineLength);
+        length += lineLength;
+        queueTail++;
+        alarmStats.sent++;
+    }
+
+    TCPsend(devicePtr, (u8 *)message, length);
+    poolFree(message);
+    return 1;
+}
+
+void getAlarmStats(AlarmStats * stats) {
+    u32 msr = enter_critical();
+    memcpy(stats, (void *)&alarmStats, sizeof(AlarmStats));
+    exit_critical(msr);
+}
+
+    // alarm status
+    // alarm set temp|vccint|vccaux <lower> <upper>
+static int alarmCommand(int argc, char ** argv, char * reply, int replySize) {
+    if(argc == 2 && strcmp(argv[1], "status") == 0) {
+        AlarmStats stats;
+        getAlarmStats(&stats);
+        return snprintf(reply, replySize,
+            "OK active 0x%x raised %u/%u/%u/%u events %u overflows %u temp %d mC vccint %u mV vccaux %u mV\r\n",
+            (unsigned)stats.active, (unsigned)stats.raised[ALARM_OT],
+            (unsigned)stats.raised[ALARM_TEMP], (unsigned)stats.raised[ALARM_VCCINT],
+            (unsigned)stats.raised[ALARM_VCCAUX], (unsigned)stats.events,
+            (unsigned)stats.overflows,
+            (int)xadcToMilliC(XSysMon_GetAdcData(xadc, XSM_CH_TEMP)),
+            (unsigned)xadcToMilliV(XSysMon_GetAdcData(xadc, XSM_CH_VCCINT)),
+            (unsigned)xadcToMilliV(XSysMon_GetAdcData(xadc, XSM_CH_VCCAUX)));
+    }
+
+    if(argc == 5 && strcmp(argv[1], "set") == 0) {
+        u32 alarm;
+        for(alarm = ALARM_TEMP; alarm < ALARM_COUNT; alarm++) {
+            if(strcmp(argv[2], alarmNames[alarm]) == 0) {
+                break;
+            }
+        }
+        if(setAlarmLimits(alarm, strtol(argv[3], NULL, 0),
+                strtol(argv[4], NULL, 0)) != XST_SUCCESS) {
+            return snprintf(reply, replySize, "ERR bad alarm limits\r\n");
+        }
+        return snprintf(reply, replySize, "OK\r\n");
+    }
+
+    return snprintf(reply, replySize,
+        "ERR usage: alarm status | alarm set temp|vccint|vccaux <lower> <upper>\r\n");
+}
+
+    // xadc: latest reading of each supply monitor, with the lowest and
+    // highest seen since power on
+static int xadcCommand(int argc, char ** argv, char * reply, int replySize) {
+    return snprintf(reply, replySize,
+        "OK temp %d mC (%d..%d) vccint %u mV (%u..%u) vccaux %u mV (%u..%u)\r\n",
+        (int)xadcToMilliC(XSysMon_GetAdcData(xadc, XSM_CH_TEMP)),
+        (int)xadcToMilliC(XSysMon_GetMinMaxMeasurement(xadc, XSM_MIN_TEMP)),
+        (int)xadcToMilliC(XSysMon_GetMinMaxMeasurement(xadc, XSM_MAX_TEMP)),
+        (unsigned)xadcToMilliV(XSysMon_GetAdcData(xadc, XSM_CH_VCCINT)),
+        (unsigned)xadcToMilliV(XSysMon_GetMinMaxMeasurement(xadc, XSM_MIN_VCCINT)),
+        (unsigned)xadcToMilliV(XSysMon_GetMinMaxMeasurement(xadc, XSM_MAX_VCCINT)),
+        (unsigned)xadcToMilliV(XSysMon_GetAdcData(xadc, XSM_CH_VCCAUX)),
+        (unsigned)xadcToMilliV(XSysMon_GetMinMaxMeasurement(xadc, XSM_MIN_VCCAUX)),
+        (unsigned)xadcToMilliV(XSysMon_GetMinMaxMeasurement(xadc, XSM_MAX_VCCAUX)));
+}
@@ -0,0 +1,132 @@
+/*******************************************************************************
+    XADC supply and temperature alarms
+
+    The XADC compares every conversion against the thresholds programmed
+    here and raises its interrupt the moment an alarm output goes active,
+    so detection costs nothing until something is wrong. The ISR stamps
+    the event and queues it; the main loop sends queued events over the
+    TCP link ahead of any other traffic.
+
+    While an alarm is active its interrupt is masked, so a signal sitting
+    on the threshold cannot flood the CPU. The tick hook then watches the
+    alarm output and only reports the alarm cleared, and re-arms the
+    interrupt, once the output has stayed clear for ALARM_DEBOUNCE_TICKS.
+*******************************************************************************/
+
+#ifndef ALARM_H
+#define ALARM_H
+
+#include "xparameters.h"
+#include "xil_printf.h"
+#include "xil_types.h"
+#include "xstatus.h"
+#include "xintc.h"
+#include "xsysmon.h"
+#include "ESP32.h"
+#include "platform_config.h"
+
+/*************************** XILINX ARGUMENT MACROS ***************************/
+#define XADC_DEVICE_ID          XPAR_SYSMON_0_DEVICE_ID
+#define XADC_BASEADDR           XPAR_SYSMON_0_BASEADDR
+#define XADC_INT_IRQ_ID         XPAR_INTC_0_SYSMON_0_VEC_ID
+
+/***************************** ALARM CONFIGURATION ****************************/
+    // Temperature alarm raises above the upper limit and, unlike the
+    // supply alarms, clears only once below the lower one
+#define ALARM_TEMP_UPPER_MC     85000
+#define ALARM_TEMP_LOWER_MC     75000
+    // Supply alarms raise outside lower..upper; 1.0 V and 1.8 V +-5%
+#define ALARM_VCCINT_LOWER_MV   950
+#define ALARM_VCCINT_UPPER_MV   1050
+#define ALARM_VCCAUX_LOWER_MV   1710
+#define ALARM_VCCAUX_UPPER_MV   1890
+
+    // Ticks an alarm output must stay clear before it is reported cleared
+#define ALARM_DEBOUNCE_TICKS    100
+    // Events held between the ISR and serviceAlarms, a power of two
+#define ALARM_QUEUE_LEN         16
+
+    // Alarm numbers, in the bit order of the XADC alarm output register
+#define ALARM_OT                0
+#define ALARM_TEMP              1
+#define ALARM_VCCINT            2
+#define ALARM_VCCAUX            3
+#define ALARM_COUNT             4
+
+    // Sequence converted while no auxiliary acquisition is running
+#define ALARM_SEQ_CHANNELS      (XSM_SEQ_CH_CALIB | XSM_SEQ_CH_TEMP | \
+                                 XSM_SEQ_CH_VCCINT | XSM_SEQ_CH_VCCAUX)
+
+    // Called from the XADC ISR on end of conversion or end of sequence,
+    // whichever is enabled; see setXadcConversionHook
+typedef void (*XadcConversionHook)(void);
+
+typedef struct {
+    u8 alarm;
+    u8 raised;          // 1 when the alarm went active, 0 when it cleared
+    u16 raw;            // XADC reading of the alarm channel at the event
+    u32 tick;
+    u32 cycles;         // cycle counter at the event, see readCycles
+} AlarmEvent;
+
+typedef struct {
+    u32 active;         // bit per alarm number
+    u32 raised[ALARM_COUNT];
+    u32 events;
+    u32 overflows;      // events lost with the queue full
+    u32 sent;
+} AlarmStats;
+
+/**
+ * Puts the XADC sequencer on the temperature and supply channels,
+ * programs the alarm thresholds and enables the alarm interrupts. Adds
+ * the "alarm" and "xadc" commands to the command link
+ * initSysTimer must have been called first
+ *
+ * returns XST_SUCCESS in case of success
+ * returns XST_FAILURE in case of failure
+ */
+int initAlarms(XSysMon * xadcPtr, XIntc * intPtr);
+
+/**
+ * Puts the XADC sequencer back to continuously converting
+ * ALARM_SEQ_CHANNELS
+ */
+void startAlarmSequence(void);
+
+/**
+ * Registers the function the XADC ISR calls for conversion interrupts,
+ * or NULL for none. The XADC has a single interrupt line, shared with
+ * the alarms; the caller enables the EOC or EOS interrupt itself
+ */
+void setXadcConversionHook(XadcConversionHook hook);
+
+/**
+ * Changes the thresholds of ALARM_TEMP, ALARM_VCCINT or ALARM_VCCAUX,
+ * in millidegrees Celsius or millivolts
+ *
+ * returns XST_SUCCESS in case of success
+ * returns XST_INVALID_PARAM for any other alarm or lower > upper
+ */
+int setAlarmLimits(u32 alarm, s32 lower, s32 upper);
+
+/**
+ * Sends every queued alarm event over the TCP link in one message
+ * Call it first in the main loop so alarms go out before telemetry
+ *
+ * returns 1 if events were sent, 0 if there were none
+ */
+int serviceAlarms(Uart * devicePtr);
+
+/**
+ * Copies the alarm statistics
+ */
+void getAlarmStats(AlarmStats * stats);
+
+/**
+ * Converts XADC readings to millidegrees Celsius and millivolts
+ */
+s32 xadcToMilliC(u16 raw);
+u32 xadcToMilliV(u16 raw);
+
+#endif  /* end of protection macro */
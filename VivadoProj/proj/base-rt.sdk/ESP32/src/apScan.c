@@ -0,0 +1,189 @@
+/*******************************************************************************
+    Access point scan results and fast reconnect, see apScan.h
+*******************************************************************************/
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "apScan.h"
+#include "crc.h"
+#include "sysTimer.h"
+
+#define AP_CACHE_MAGIC          0x41504331  // "APC1"
+
+    // Last access point joined, checked by magic and CRC since nothing
+    // initializes it
+typedef struct {
+    u32 magic;
+    char ssid[AP_SSID_MAX];
+    char bssid[AP_BSSID_MAX];
+    u8 channel;
+    u32 crc;
+} ApCache;
+
+static ApCache apCache PERSIST_BSS;
+static ApTable scanTable;
+
+static const char cwlapPrefix[] = "+CWLAP:(";
+
+static u32 cacheCrc(void) {
+    return crc32(&apCache, offsetof(ApCache, crc));
+}
+
+static int cacheValid(void) {
+    return apCache.magic == AP_CACHE_MAGIC && apCache.crc == cacheCrc();
+}
+
+static void saveCache(const char * ssid, const ApInfo * ap) {
+    memset(&apCache, 0, sizeof(apCache));
+    strncpy(apCache.ssid, ssid, AP_SSID_MAX - 1);
+    strncpy(apCache.bssid, ap->bssid, AP_BSSID_MAX - 1);
+    apCache.channel = ap->channel;
+    apCache.magic = AP_CACHE_MAGIC;
+    apCache.crc = cacheCrc();
+}
+
+void forgetCachedAP(void) {
+    memset(&apCache, 0, sizeof(apCache));
+}
+
+    // Copies a quoted field, cursor on the opening quote, and returns the
+    // character after the closing quote or NULL
+static const char * parseQuoted(const char * cursor, char * out, u32 size) {
+    if(*cursor != '"') {
+        return NULL;
+    }
+    const char * end = strchr(cursor + 1, '"');
+    if(end == NULL || (u32)(end - cursor - 1) >= size) {
+        return NULL;
+    }
+    memcpy(out, cursor + 1, end - cursor - 1);
+    out[end - cursor - 1] = '\0';
+    return end + 1;
+}
+
+    // Parses a number followed by a comma or ')' and steps over both
+static const char * parseField(const char * cursor, long * value) {
+    char * end;
+    *value = strtol(cursor, &end, 10);
+    if(end == cursor || (*end != ',' && *end != ')')) {
+        return NULL;
+    }
+    return end + 1;
+}
+
+    // +CWLAP:(<ecn>,"<ssid>",<rssi>,"<mac>",<channel>[,...])
+int parseAPLine(const char * line, ApInfo * ap) {
+    long value;
+    const char * cursor = line;
+    if(strncmp(cursor, cwlapPrefix, sizeof(cwlapPrefix) - 1) != 0) {
+        return XST_FAILURE;
+    }
+    cursor += sizeof(cwlapPrefix) - 1;
+
+    if((cursor = parseField(cursor, &value)) == NULL) {
+        return XST_FAILURE;
+    }
+    ap->encryption = value;
+    if((cursor = parseQuoted(cursor, ap->ssid, AP_SSID_MAX)) == NULL || *cursor++ != ',') {
+        return XST_FAILURE;
+    }
+    if((cursor = parseField(cursor, &value)) == NULL) {
+        return XST_FAILURE;
+    }
+    ap->rssi = value;
+    if((cursor = parseQuoted(cursor, ap->bssid, AP_BSSID_MAX)) == NULL || *cursor++ != ',') {
+        return XST_FAILURE;
+    }
+    if(parseField(cursor, &value) == NULL) {
+        return XST_FAILURE;
+    }
+    ap->channel = value;
+    return XST_SUCCESS;
+}
+
+void addAP(ApTable * table, const ApInfo * ap) {
+    table->seen++;
+    u32 slot = table->count;
+    while(slot > 0 && table->aps[slot - 1].rssi < ap->rssi) {
+        slot--;
+    }
+    if(slot >= AP_TABLE_SIZE) {
+        return;
+    }
+    u32 last = table->count < AP_TABLE_SIZE ? table->count : AP_TABLE_SIZE - 1;
+    memmove(&table->aps[slot + 1], &table->aps[slot], (last - slot) * sizeof(ApInfo));
+    table->aps[slot] = *ap;
+    if(table->count < AP_TABLE_SIZE) {
+        table->count++;
+    }
+}
+
+static void scanLine(const char * line, void * context) {
+    ApInfo ap;
+    if(parseAPLine(line, &ap) == XST_SUCCESS) {
+        addAP((ApTable *)context, &ap);
+    }
+}
+
+int scanAPs(Uart * devicePtr, char * ssid, ApTable * table) {
+    table->count = 0;
+    table->seen = 0;
+    listAvailableAPs(devicePtr, ssid);
+    return waitForESP32Reply(scanLine, table, AP_SCAN_TIMEOUT_US);
+}
+
+void printAPTable(const ApTable * table) {
+    xil_printf("%d access points, %d kept\n\r", table->seen, table->count);
+    for(u32 i = 0; i < table->count; i++) {
+        const ApInfo * ap = &table->aps[i];
+        xil_printf("  %-32s %s ch %2d %4d dBm enc %d\n\r",
+            ap->ssid, ap->bssid, ap->channel, ap->rssi, ap->encryption);
+    }
+}
+
+static int joinAP(Uart * devicePtr, char * ssid, char * pwd, char * bssid) {
+    setCurrentAP(devicePtr, ssid, pwd, bssid);
+    return waitForESP32Reply(NULL, NULL, AP_JOIN_TIMEOUT_US);
+}
+
+static void printJoinTime(const char * how, u32 startTick) {
+    xil_printf("Joined %s (%s, channel %d) %s in %d ms\n\r", apCache.ssid,
+        apCache.bssid, apCache.channel, how,
+        (getTickCount() - startTick) * 1000 / TICK_HZ);
+}
+
+int connectToAP(Uart * devicePtr, char * ssid, char * pwd) {
+    u32 startTick = getTickCount();
+
+        // The ESP32 pinned to a BSSID does not need a scan of its own
+    if(cacheValid() && strcmp(apCache.ssid, ssid) == 0) {
+        if(joinAP(devicePtr, ssid, pwd, apCache.bssid) == XST_SUCCESS) {
+            printJoinTime("from cache", startTick);
+            return XST_SUCCESS;
+        }
+        xil_printf("Cached access point %s did not answer, scanning\n\r", apCache.bssid);
+        forgetCachedAP();
+    }
+
+    if(scanAPs(devicePtr, ssid, &scanTable) != XST_SUCCESS) {
+        xil_printf("Scan for %s failed\n\r", ssid);
+        return XST_FAILURE;
+    }
+    printAPTable(&scanTable);
+
+        // Strongest first, so the first that takes us is the best one
+    for(u32 i = 0; i < scanTable.count; i++) {
+        ApInfo * ap = &scanTable.aps[i];
+        if(strcmp(ap->ssid, ssid) != 0) {
+            continue;
+        }
+        if(joinAP(devicePtr, ssid, pwd, ap->bssid) == XST_SUCCESS) {
+            saveCache(ssid, ap);
+            printJoinTime("after a scan", startTick);
+            return XST_SUCCESS;
+        }
+    }
+    xil_printf("Could not join %s\n\r", ssid);
+    return XST_FAILURE;
+}
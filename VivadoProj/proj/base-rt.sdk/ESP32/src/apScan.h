@@ -0,0 +1,90 @@
+/*******************************************************************************
+    Access point scan results and fast reconnect
+
+    scanAPs runs AT+CWLAP and parses the "+CWLAP:" lines into a fixed size
+    table, strongest signal first, instead of letting them scroll past on
+    the USB/UART port.
+
+    connectToAP remembers the BSSID and channel of the last access point it
+    joined in PERSIST_BSS memory. After a processor reset it joins that
+    access point straight away with its BSSID pinned, which skips the
+    separate scan, and only falls back on scanning and picking the
+    strongest access point with the right SSID when that fails.
+*******************************************************************************/
+
+#ifndef APSCAN_H
+#define APSCAN_H
+
+#include "xil_printf.h"
+#include "xil_types.h"
+#include "xstatus.h"
+#include "ESP32.h"
+
+/***************************** SCAN CONFIGURATION *****************************/
+    // Access points kept per scan; the weakest are dropped beyond this
+#define AP_TABLE_SIZE           16
+
+#define AP_SSID_MAX             33      // 32 characters and '\0'
+#define AP_BSSID_MAX            18      // "xx:xx:xx:xx:xx:xx" and '\0'
+
+#define AP_SCAN_TIMEOUT_US      10000000
+#define AP_JOIN_TIMEOUT_US      20000000
+
+typedef struct {
+    char ssid[AP_SSID_MAX];
+    char bssid[AP_BSSID_MAX];
+    s8 rssi;            // dBm
+    u8 channel;
+    u8 encryption;      // as the ESP32 reports it, 0 open to 4 WPA/WPA2
+} ApInfo;
+
+typedef struct {
+    ApInfo aps[AP_TABLE_SIZE];  // strongest first
+    u32 count;
+    u32 seen;           // access points reported, dropped ones included
+} ApTable;
+
+/**
+ * Parses one "+CWLAP:(...)" line, without its line ending, into ap
+ *
+ * returns XST_SUCCESS in case of success
+ * returns XST_FAILURE if the line is not a well formed +CWLAP line
+ */
+int parseAPLine(const char * line, ApInfo * ap);
+
+/**
+ * Inserts ap into table in order of signal strength. When the table
+ * is full the weakest entry, which may be ap itself, is dropped
+ */
+void addAP(ApTable * table, const ApInfo * ap);
+
+/**
+ * Scans for access points, named ssid only if it is not NULL, and
+ * fills table with the results
+ *
+ * returns XST_SUCCESS in case of success
+ * returns XST_FAILURE if the ESP32 reports an error or does not answer
+ */
+int scanAPs(Uart * devicePtr, char * ssid, ApTable * table);
+
+/**
+ * Prints table to the USB/UART port
+ */
+void printAPTable(const ApTable * table);
+
+/**
+ * Joins ssid, through the cached access point if it belongs to ssid,
+ * otherwise through the strongest one a scan finds. Caches the access
+ * point joined
+ *
+ * returns XST_SUCCESS in case of success
+ * returns XST_FAILURE if no access point of ssid could be joined
+ */
+int connectToAP(Uart * devicePtr, char * ssid, char * pwd);
+
+/**
+ * Drops the cached access point, so the next connectToAP scans
+ */
+void forgetCachedAP(void);
+
+#endif  /* end of protection macro */
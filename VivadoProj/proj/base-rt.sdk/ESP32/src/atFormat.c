@@ -0,0 +1,74 @@
+/*******************************************************************************
+    AT command and reply formatters, see atFormat.h
+*******************************************************************************/
+
+#include <stdio.h>
+#include "atFormat.h"
+
+int formatTCPStart(char * buf, const char * remoteIP, int remotePort, int keepAlive) {
+    return sprintf(buf, "AT+CIPSTART=\"TCP\",\"%s\",%d,%d", remoteIP, remotePort, keepAlive);
+}
+
+int formatTCPSend(char * buf, int length) {
+    return sprintf(buf, "AT+CIPSEND=%d", length);
+}
+
+int formatTCPSendBuffered(char * buf, int length) {
+    return sprintf(buf, "AT+CIPSENDBUF=%d", length);
+}
+
+int formatCheckSegment(char * buf, unsigned int segment) {
+    return sprintf(buf, "AT+CIPCHECKSEQ=%u", segment);
+}
+
+    // A string parameter in quotes. The AT parser takes a comma, a quote
+    // or a backslash inside one only behind a backslash
+static int formatString(char * buf, const char * s) {
+    int length = 0;
+    buf[length++] = '"';
+    for(; *s != '\0'; s++) {
+        if(*s == ',' || *s == '"' || *s == '\\') {
+            buf[length++] = '\\';
+        }
+        buf[length++] = *s;
+    }
+    buf[length++] = '"';
+    buf[length] = '\0';
+    return length;
+}
+
+int formatJoinAP(char * buf, const char * ssid, const char * pwd, const char * bssid) {
+    int length = sprintf(buf, "AT+CWJAP=");
+    length += formatString(buf + length, ssid);
+    buf[length++] = ',';
+    length += formatString(buf + length, pwd);
+    if(bssid != NULL) {
+        length += sprintf(buf + length, ",\"%s\"", bssid);
+    }
+    return length;
+}
+
+int formatListAPs(char * buf, const char * ssid) {
+    int length = sprintf(buf, "AT+CWLAP");
+    if(ssid != NULL) {
+        buf[length++] = '=';
+        length += formatString(buf + length, ssid);
+    }
+    return length;
+}
+
+int formatDeepSleep(char * buf, unsigned int ms) {
+    return sprintf(buf, "AT+GSLP=%u", ms);
+}
+
+int formatRecvBytes(char * buf, int length) {
+    return sprintf(buf, "\r\nRecv %d bytes\r\n", length);
+}
+
+int formatSegmentResult(char * buf, unsigned int segment, int sent) {
+    return sprintf(buf, "%u,%s\r\n", segment, sent ? "SEND OK" : "SEND FAIL");
+}
+
+int formatIPDHeader(char * buf, int length) {
+    return sprintf(buf, "\r\n" AT_IPD_PREFIX "%d:", length);
+}
@@ -0,0 +1,103 @@
+/*******************************************************************************
+    Text of the AT exchanges on the ESP32 link
+
+    The commands ESP32.c sends for the TCP data path and the replies the
+    ESP32 AT firmware answers them with. Nothing in here touches the
+    hardware, so the host tools in ESP32_sim count the bytes on the wire
+    with exactly the strings the driver sends.
+
+    The formatters write a terminating '\0' and return the length without
+    it. Commands are formatted without the line ending, which the driver
+    sends separately (sendNLCR); AT_EOL_BYTES accounts for it.
+*******************************************************************************/
+
+#ifndef ATFORMAT_H
+#define ATFORMAT_H
+
+    // Line ending after every command
+#define AT_EOL                  "\r\n"
+#define AT_EOL_BYTES            2
+
+    // Replies to AT+CIPSEND, in the order they arrive
+#define AT_SEND_PROMPT          "\r\nOK\r\n> "
+#define AT_SEND_OK              "\r\nSEND OK\r\n"
+#define AT_SEND_FAIL            "\r\nSEND FAIL\r\n"
+    // Answer to a command while the last one is still being processed,
+    // and while the data of a CIPSEND is still going out
+#define AT_BUSY                 "busy p...\r\n"
+#define AT_BUSY_SENDING         "busy s...\r\n"
+
+    // Asks for the state of the AT+CIPSENDBUF segments. Answered
+    // "<next>,<last sent>,<last sent OK>,<buffer bytes free>,<queued>"
+#define AT_BUF_STATUS           "AT+CIPBUFSTATUS"
+
+    // Most data one AT+CIPSEND or AT+CIPSENDBUF can announce
+#define AT_SEND_MAX             2048
+
+    // Data from the TCP peer arrives as "+IPD,<length>:<data>"
+#define AT_IPD_PREFIX           "+IPD,"
+
+    // Longest line any of the formatters writes, '\0' included: an
+    // AT+CWJAP with a 32 character SSID and 64 character key, every
+    // character escaped, and a BSSID comes to 227
+#define AT_MAX_COMMAND          232
+
+/**
+ * AT+CIPSTART for a TCP connection to remoteIP:remotePort with a keep
+ * alive interval of keepAlive seconds
+ */
+int formatTCPStart(char * buf, const char * remoteIP, int remotePort, int keepAlive);
+
+/**
+ * AT+CIPSEND announcing length bytes of data
+ */
+int formatTCPSend(char * buf, int length);
+
+/**
+ * AT+CIPSENDBUF queuing length bytes of data as one segment. Answered
+ * "<segment>,<last segment sent OK>", OK and the "> " prompt
+ */
+int formatTCPSendBuffered(char * buf, int length);
+
+/**
+ * AT+CIPCHECKSEQ asking whether segment was sent. Answered
+ * "<segment>,<1 sent, 0 failed>"
+ */
+int formatCheckSegment(char * buf, unsigned int segment);
+
+/**
+ * AT+CWJAP joining ssid with password pwd. A bssid of the form
+ * "24:0a:c4:00:00:01" pins the access point, NULL lets the ESP32 pick.
+ * Commas, quotes and backslashes in ssid and pwd are escaped
+ */
+int formatJoinAP(char * buf, const char * ssid, const char * pwd, const char * bssid);
+
+/**
+ * AT+CWLAP listing every access point in range, or only those named
+ * ssid if it is not NULL, escaped as for formatJoinAP
+ */
+int formatListAPs(char * buf, const char * ssid);
+
+/**
+ * AT+GSLP for a deep sleep of ms milliseconds
+ */
+int formatDeepSleep(char * buf, unsigned int ms);
+
+/**
+ * "Recv <length> bytes" reply the ESP32 gives once the data of a
+ * CIPSEND has been taken in, line endings included
+ */
+int formatRecvBytes(char * buf, int length);
+
+/**
+ * "<segment>,SEND OK" or "<segment>,SEND FAIL" line with which the
+ * ESP32 reports the result of an AT+CIPSENDBUF segment
+ */
+int formatSegmentResult(char * buf, unsigned int segment, int sent);
+
+/**
+ * Header of a "+IPD" frame carrying length bytes, line ending included
+ */
+int formatIPDHeader(char * buf, int length);
+
+#endif  /* end of protection macro */
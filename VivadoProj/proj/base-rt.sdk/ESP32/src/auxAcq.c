@@ -0,0 +1,355 @@
+/*******************************************************************************
+    XADC auxiliary channel acquisition, see auxAcq.h
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "auxAcq.h"
+#include "alarm.h"
+#include "sysTimer.h"
+#include "command.h"
+#include "platform.h"
+
+typedef struct {
+    u16 samples[AUX_STREAMS][AUX_RAW_SAMPLES];
+    u32 firstTick;
+    u32 droppedBefore;
+} RawBlock;
+
+static void auxConversion(void) FAST_CODE;
+static int auxCommand(int argc, char ** argv, char * reply, int replySize);
+
+static XSysMon * xadc;
+
+    // Filled by the ISR, decimated by the main loop
+static RawBlock rawBlocks[AUX_RAW_BLOCKS];
+static volatile u32 rawFilled FAST_BSS;
+static volatile u32 rawDone FAST_BSS;
+static u32 fillCount FAST_BSS;
+static u32 droppedRun FAST_BSS;
+static volatile u32 running FAST_BSS;
+static u32 numStreams FAST_BSS;
+static u16 dataOffset[AUX_STREAMS] FAST_BSS;
+static volatile AuxAcqStats auxStats FAST_BSS;
+
+    // Main loop only
+static CicState cic[AUX_STREAMS];
+static FirState fir[AUX_STREAMS];
+static s32 cicOut[AUX_RAW_SAMPLES >> CIC_MIN_RATE_SHIFT];
+static AuxBlock staging[AUX_STREAMS];
+static u32 stagedDropped[AUX_STREAMS];
+static AuxBlock outBlocks[AUX_NUM_BLOCKS];
+static u32 outHead;
+static u32 outTail;
+static u32 outSequence;
+static u32 decimationShift;
+static u32 startTick;
+
+int initAuxAcq(XSysMon * xadcPtr) {
+    xadc = xadcPtr;
+    running = 0;
+    outHead = 0;
+    outTail = 0;
+    setXadcConversionHook(auxConversion);
+
+    if(addCommand("aux", auxCommand) != XST_SUCCESS) {
+        xil_printf("Could not register aux command\n\r");
+        return XST_FAILURE;
+    }
+    return XST_SUCCESS;
+}
+
+static int channelWired(u32 mode, u32 channel) {
+    if(mode == AUX_MODE_SIMUL) {
+        return channel < 8 && (AUX_CHANNELS_WIRED & (0x101 << channel)) == (0x101 << channel);
+    }
+    return channel < 16 && (AUX_CHANNELS_WIRED & (1 << channel));
+}
+
+int auxAcqStart(u32 mode, u32 channel, u32 rateShift) {
+    if(running) {
+        return XST_DEVICE_BUSY;
+    }
+    if((mode != AUX_MODE_SINGLE && mode != AUX_MODE_SIMUL) ||
+            !channelWired(mode, channel) ||
+            rateShift < CIC_MIN_RATE_SHIFT || rateShift > CIC_MAX_RATE_SHIFT) {
+        return XST_INVALID_PARAM;
+    }
+
+    numStreams = (mode == AUX_MODE_SIMUL) ? 2 : 1;
+    for(u32 s = 0; s < numStreams; s++) {
+        u32 vaux = channel + 8 * s;
+        dataOffset[s] = XSM_AUX00_OFFSET + 4 * vaux;
+        cicInit(&cic[s], rateShift);
+        firInit(&fir[s]);
+        staging[s].magic = AUX_MAGIC;
+        staging[s].channel = vaux;
+        staging[s].decimation = rateShift + 1;
+        staging[s].sampleCount = 0;
+        staging[s].reserved = 0;
+        stagedDropped[s] = 0;
+    }
+    decimationShift = rateShift;
+    rawFilled = 0;
+    rawDone = 0;
+    fillCount = 0;
+    droppedRun = 0;
+    memset((void *)&auxStats, 0, sizeof(auxStats));
+    auxStats.mode = mode;
+    auxStats.channel = channel;
+    startTick = getTickCount();
+
+    XSysMon_SetSequencerMode(xadc, XSM_SEQ_MODE_SAFE);
+    if(mode == AUX_MODE_SINGLE) {
+        XSysMon_SetSequencerMode(xadc, XSM_SEQ_MODE_SINGCHAN);
+        XSysMon_SetSingleChParams(xadc, XSM_CH_AUX_MIN + channel,
+            FALSE, FALSE, FALSE);
+    } else {
+            // Only VAUX 0 - 7 are enabled, each converts with its pair
+        XSysMon_SetSeqChEnables(xadc, ALARM_SEQ_CHANNELS |
+            (XSM_SEQ_CH_AUX00 << channel));
+        XSysMon_SetSequencerMode(xadc, XSM_SEQ_MODE_SIMUL);
+    }
+
+    running = 1;
+    auxStats.running = 1;
+        // The alarm ISR also rewrites the enable register
+    u32 msr = enter_critical();
+    XSysMon_IntrClear(xadc, XSM_IPIXR_EOC_MASK | XSM_IPIXR_EOS_MASK);
+    XSysMon_IntrEnable(xadc, (mode == AUX_MODE_SINGLE) ?
+        XSM_IPIXR_EOC_MASK : XSM_IPIXR_EOS_MASK);
+    exit_critical(msr);
+    return XST_SUCCESS;
+}
+
+void auxAcqStop(void) {
+    u32 msr = enter_critical();
+    XSysMon_IntrDisable(xadc, XSM_IPIXR_EOC_MASK | XSM_IPIXR_EOS_MASK);
+    exit_critical(msr);
+    running = 0;
+    auxStats.running = 0;
+    startAlarmSequence();
+}
+
+    // Called from the XADC ISR once per conversion (single channel) or
+    // once per sequence (simultaneous)
+static void auxConversion(void) {
+    if(!running) {
+        return;
+    }
+    if(fillCount == 0) {
+        if(rawFilled - rawDone >= AUX_RAW_BLOCKS) {
+            droppedRun++;
+            auxStats.rawDropped++;
+            return;
+        }
+        RawBlock * block = &rawBlocks[rawFilled & (AUX_RAW_BLOCKS - 1)];
+        block->firstTick = getTickCount();
+        block->droppedBefore = droppedRun;
+        droppedRun = 0;
+    }
+
+    RawBlock * block = &rawBlocks[rawFilled & (AUX_RAW_BLOCKS - 1)];
+    for(u32 s = 0; s < numStreams; s++) {
+        block->samples[s][fillCount] = XSysMon_ReadReg(XADC_BASEADDR, dataOffset[s]);
+    }
+    auxStats.rawSamples++;
+    if(++fillCount == AUX_RAW_SAMPLES) {
+        fillCount = 0;
+        rawFilled++;
+    }
+}
+
+static void queueBlock(AuxBlock * block) {
+    if(outHead - outTail >= AUX_NUM_BLOCKS) {
+        auxStats.blocksDropped++;
+        return;
+    }
+    block->sequence = outSequence++;
+    memcpy(&outBlocks[outHead & (AUX_NUM_BLOCKS - 1)], block, sizeof(AuxBlock));
+    outHead++;
+    auxStats.blocksQueued++;
+}
+
+    // Each raw block yields a whole number of outputs, and
+    // AUX_BLOCK_SAMPLES is a multiple of it, so a raw block never
+    // overruns the staging block
+static void decimateRawBlock(RawBlock * raw) {
+    for(u32 s = 0; s < numStreams; s++) {
+        AuxBlock * stage = &staging[s];
+        stagedDropped[s] += raw->droppedBefore;
+        if(stage->sampleCount == 0) {
+            stage->firstTick = raw->firstTick;
+            stage->droppedBefore = (stagedDropped[s] > 0xFFFF) ? 0xFFFF : stagedDropped[s];
+            stagedDropped[s] = 0;
+        }
+
+        u32 produced = cicDecimate(&cic[s], raw->samples[s], AUX_RAW_SAMPLES, cicOut);
+        stage->sampleCount += firDecimate(&fir[s], cicOut, produced,
+            &stage->samples[stage->sampleCount]);
+
+        if(stage->sampleCount >= AUX_BLOCK_SAMPLES) {
+            queueBlock(stage);
+            stage->sampleCount = 0;
+        }
+    }
+}
+
+AuxBlock * auxPeekBlock(void) {
+    if(outHead == outTail) {
+        return NULL;
+    }
+    return &outBlocks[outTail & (AUX_NUM_BLOCKS - 1)];
+}
+
+void auxReleaseBlock(void) {
+    if(outHead != outTail) {
+        outTail++;
+    }
+}
+
+    // Result of a block queued with TCPsendBuffered
+static void blockSent(u32 segment, int status) {
+    if(status == XST_SUCCESS) {
+        auxStats.blocksSent++;
+    } else {
+        auxStats.sendFailures++;
+    }
+}
+
+void decimateAuxAcq(void) {
+        // One raw block per call keeps the main loop responsive
+    if(rawDone != rawFilled) {
+        decimateRawBlock(&rawBlocks[rawDone & (AUX_RAW_BLOCKS - 1)]);
+        rawDone++;
+    }
+}
+
+int serviceAuxAcq(Uart * devicePtr) {
+    AuxBlock * block = auxPeekBlock();
+    if(block == NULL) {
+        return 0;
+    }
+        // The driver keeps a copy until the ESP32 has sent it, and
+        // resends it on a SEND FAIL
+    int status = TCPsendBuffered(devicePtr, (u8 *)block, sizeof(AuxBlock), blockSent);
+    if(status != XST_SUCCESS) {
+        auxStats.sendFailures++;
+    }
+    auxReleaseBlock();
+    return 1;
+}
+
+u32 getAuxBacklog(void) {
+    return outHead - outTail;
+}
+
+u32 getAuxBlockInterval(void) {
+    u32 samples = auxStats.rawSamples;
+    if(!running || samples == 0) {
+        return 0;
+    }
+        // Each stream yields one output per 2^(rate shift + 1) raw samples
+    u64 elapsedUs = ((u64)(getTickCount() - startTick) * 1000000) / TICK_HZ;
+    return (u32)((elapsedUs * (AUX_BLOCK_SAMPLES << (decimationShift + 1))) /
+        ((u64)samples * numStreams));
+}
+
+u32 auxAcqBurst(u32 channel, u16 * samples, u32 count) {
+    if(running || !channelWired(AUX_MODE_SINGLE, channel)) {
+        return 0;
+    }
+
+    XSysMon_SetSequencerMode(xadc, XSM_SEQ_MODE_SAFE);
+    XSysMon_SetSequencerMode(xadc, XSM_SEQ_MODE_SINGCHAN);
+    XSysMon_SetSingleChParams(xadc, XSM_CH_AUX_MIN + channel, FALSE, FALSE, FALSE);
+
+        // Start timing on a conversion boundary
+    XSysMon_IntrClear(xadc, XSM_IPIXR_EOC_MASK);
+    while(!(XSysMon_ReadReg(XADC_BASEADDR, XSM_IPISR_OFFSET) & XSM_IPIXR_EOC_MASK));
+    XSysMon_WriteReg(XADC_BASEADDR, XSM_IPISR_OFFSET, XSM_IPIXR_EOC_MASK);
+    u32 start = readCycles();
+
+    u16 offset = XSM_AUX00_OFFSET + 4 * channel;
+    for(u32 i = 0; i < count; i++) {
+        while(!(XSysMon_ReadReg(XADC_BASEADDR, XSM_IPISR_OFFSET) & XSM_IPIXR_EOC_MASK));
+        XSysMon_WriteReg(XADC_BASEADDR, XSM_IPISR_OFFSET, XSM_IPIXR_EOC_MASK);
+        samples[i] = XSysMon_ReadReg(XADC_BASEADDR, offset);
+    }
+    u32 cycles = readCycles() - start;
+
+    startAlarmSequence();
+    return cycles;
+}
+
+void getAuxAcqStats(AuxAcqStats * stats) {
+    u32 msr = enter_critical();
+    memcpy(stats, (void *)&auxStats, sizeof(AuxAcqStats));
+    exit_critical(msr);
+}
+
+    // Times the decimation kernels on a burst of real samples
+static int auxBench(u32 channel, char * reply, int replySize) {
+    static u16 benchIn[AUX_BENCH_SAMPLES];
+    static s32 benchMid[AUX_BENCH_SAMPLES >> CIC_MIN_RATE_SHIFT];
+    static u16 benchOut[AUX_BENCH_SAMPLES >> CIC_MIN_RATE_SHIFT];
+    CicState benchCic;
+    FirState benchFir;
+
+    u32 burstCycles = auxAcqBurst(channel, benchIn, AUX_BENCH_SAMPLES);
+    if(burstCycles == 0) {
+        return snprintf(reply, replySize, "ERR stop acquisition first, or bad channel\r\n");
+    }
+
+    cicInit(&benchCic, AUX_DEFAULT_RATE_SHIFT);
+    firInit(&benchFir);
+    u32 start = readCycles();
+    u32 cicCount = cicDecimate(&benchCic, benchIn, AUX_BENCH_SAMPLES, benchMid);
+    u32 cicCycles = readCycles() - start;
+    start = readCycles();
+    u32 firCount = firDecimate(&benchFir, benchMid, cicCount, benchOut);
+    u32 firCycles = readCycles() - start;
+
+    return snprintf(reply, replySize,
+        "OK burst %u samples %u cycles/sample cic %u cycles/input fir %u cycles/output last %u\r\n",
+        AUX_BENCH_SAMPLES, (unsigned)(burstCycles / AUX_BENCH_SAMPLES),
+        (unsigned)(cicCycles / AUX_BENCH_SAMPLES),
+        (unsigned)(firCount ? firCycles / firCount : 0),
+        (unsigned)(firCount ? benchOut[firCount - 1] : 0));
+}
+
+    // aux start single|simul <channel> [rate shift]
+    // aux stop | status
+    // aux bench <channel>
+static int auxCommand(int argc, char ** argv, char * reply, int replySize) {
+    if(argc >= 4 && argc <= 5 && strcmp(argv[1], "start") == 0) {
+        u32 mode = (strcmp(argv[2], "simul") == 0) ? AUX_MODE_SIMUL : AUX_MODE_SINGLE;
+        u32 rateShift = (argc == 5) ? strtoul(argv[4], NULL, 0) : AUX_DEFAULT_RATE_SHIFT;
+        int status = auxAcqStart(mode, strtoul(argv[3], NULL, 0), rateShift);
+        if(status == XST_DEVICE_BUSY) {
+            return snprintf(reply, replySize, "ERR already running\r\n");
+        } else if(status != XST_SUCCESS) {
+            return snprintf(reply, replySize, "ERR bad channel or rate\r\n");
+        }
+        return snprintf(reply, replySize, "OK\r\n");
+    }
+    if(argc == 2 && strcmp(argv[1], "stop") == 0) {
+        auxAcqStop();
+        return snprintf(reply, replySize, "OK\r\n");
+    }
+    if(argc == 2 && strcmp(argv[1], "status") == 0) {
+        AuxAcqStats stats;
+        getAuxAcqStats(&stats);
+        return snprintf(reply, replySize,
+            "OK running %u mode %u channel %u raw %u dropped %u queued %u lost %u sent %u failed %u\r\n",
+            (unsigned)stats.running, (unsigned)stats.mode, (unsigned)stats.channel,
+            (unsigned)stats.rawSamples, (unsigned)stats.rawDropped,
+            (unsigned)stats.blocksQueued, (unsigned)stats.blocksDropped,
+            (unsigned)stats.blocksSent, (unsigned)stats.sendFailures);
+    }
+    if(argc == 3 && strcmp(argv[1], "bench") == 0) {
+        return auxBench(strtoul(argv[2], NULL, 0), reply, replySize);
+    }
+    return snprintf(reply, replySize,
+        "ERR usage: aux start single|simul <ch> [shift] | stop | status | bench <ch>\r\n");
+}
@@ -0,0 +1,163 @@
+/*******************************************************************************
+    XADC auxiliary channel acquisition
+
+    Reads the auxiliary analog inputs on the Arty S7 analog header from the
+    XADC ISR into raw blocks in DDR. The main loop decimates each full raw
+    block (see decimate.h) into output blocks, which are queued for a
+    consumer in a ring in DDR; serviceAuxAcq uploads them over the ESP32
+    TCP link. Decimation carries on while the radio sleeps in duty-cycle
+    mode (see dutyCycle.h), and the ring holds the blocks until it wakes.
+
+    AUX_MODE_SINGLE converts one channel back to back, at the full XADC
+    rate, with an interrupt per conversion. The temperature and supply
+    channels are not converted meanwhile, so the alarms hold their state.
+    AUX_MODE_SIMUL converts channel n and n + 8 together as part of the
+    alarm sequence and reads both once per sequence, so the alarms keep
+    running at the cost of a lower rate.
+
+    When the main loop falls behind, whole raw blocks are dropped rather
+    than overwritten and the next output block of each stream says how
+    many raw samples were lost since the one before it.
+*******************************************************************************/
+
+#ifndef AUXACQ_H
+#define AUXACQ_H
+
+#include "xparameters.h"
+#include "xil_printf.h"
+#include "xil_types.h"
+#include "xstatus.h"
+#include "xsysmon.h"
+#include "ESP32.h"
+#include "decimate.h"
+#include "platform_config.h"
+
+/***************************** ACQUISITION CONFIGURATION **********************/
+#define AUX_MODE_SINGLE         0
+#define AUX_MODE_SIMUL          1
+
+    // VAUX pairs wired to the analog header in the block design
+#define AUX_CHANNELS_WIRED      0x0F0F
+
+#define AUX_STREAMS             2
+    // Raw samples per stream per raw block, a multiple of the largest
+    // total decimation
+#define AUX_RAW_SAMPLES         256
+    // Must be a power of 2
+#define AUX_RAW_BLOCKS          4
+
+#define AUX_BLOCK_SAMPLES       256
+    // Must be a power of 2; 1024 blocks take 528 KB. How long they last
+    // depends on the rate shift and on the conversion rate the ISR keeps
+    // up with, so the duty cycle measures it, see getAuxBlockInterval
+#define AUX_NUM_BLOCKS          1024
+#define AUX_DEFAULT_RATE_SHIFT  4
+
+    // Samples taken by auxAcqBurst for the "aux bench" command
+#define AUX_BENCH_SAMPLES       1024
+
+#define AUX_MAGIC               0x41555844  // "AUXD"
+
+/**
+ * Output block layout as sent on the wire, little-endian
+ */
+typedef struct {
+    u32 magic;
+    u32 sequence;       // increments by one per block, over both streams
+    u32 firstTick;      // tick count of the raw block the first sample came from
+    u8 channel;         // VAUX channel number
+    u8 decimation;      // log2 of the total rate change
+    u16 sampleCount;
+    u16 droppedBefore;  // raw samples lost since the previous block, saturating
+    u16 reserved;
+    u16 samples[AUX_BLOCK_SAMPLES];
+} AuxBlock;
+
+typedef struct {
+    u32 running;
+    u32 mode;
+    u32 channel;
+    u32 rawSamples;     // per stream, stored into raw blocks
+    u32 rawDropped;     // per stream, lost because no raw block was free
+    u32 blocksQueued;
+    u32 blocksDropped;  // output blocks lost with the consumer queue full
+    u32 blocksSent;     // answered SEND OK
+    u32 sendFailures;   // not taken by the ESP32, or lost after resends
+} AuxAcqStats;
+
+/**
+ * Registers with the XADC ISR and adds the "aux" command to the command
+ * link. Acquisition stays idle until auxAcqStart
+ * initAlarms must have been called first
+ *
+ * returns XST_SUCCESS in case of success
+ * returns XST_FAILURE in case of failure
+ */
+int initAuxAcq(XSysMon * xadcPtr);
+
+/**
+ * Starts acquisition in AUX_MODE_SINGLE on VAUX channel, or in
+ * AUX_MODE_SIMUL on VAUX channel and channel + 8, decimating by
+ * 2^rateShift in the CIC and by FIR_DECIMATION in the FIR
+ *
+ * returns XST_SUCCESS in case of success
+ * returns XST_INVALID_PARAM for an unwired channel or bad rateShift
+ * returns XST_DEVICE_BUSY if acquisition is already running
+ */
+int auxAcqStart(u32 mode, u32 channel, u32 rateShift);
+
+/**
+ * Stops acquisition and gives the XADC back to the alarm sequence.
+ * Decimated blocks already queued are kept
+ */
+void auxAcqStop(void);
+
+/**
+ * Decimates at most one full raw block into the output ring. Call from
+ * the main loop whether the link is up or not
+ */
+void decimateAuxAcq(void);
+
+/**
+ * Queues at most one output block for the open TCP connection with
+ * TCPsendBuffered. Call from the main loop, along with
+ * serviceTCPSendWindow
+ *
+ * returns 1 if a block was queued, 0 otherwise
+ */
+int serviceAuxAcq(Uart * devicePtr);
+
+/**
+ * Returns the number of output blocks not yet queued for upload
+ */
+u32 getAuxBacklog(void);
+
+/**
+ * Returns the average time between output blocks since auxAcqStart in
+ * us, from the raw samples stored so far, or 0 while stopped or before
+ * the first sample
+ */
+u32 getAuxBlockInterval(void);
+
+/**
+ * Consumer side of the output queue: returns the oldest decimated block,
+ * or NULL if there is none, and frees it once the consumer is done
+ */
+AuxBlock * auxPeekBlock(void);
+void auxReleaseBlock(void);
+
+/**
+ * Reads count conversions of VAUX channel by polling, with acquisition
+ * stopped, and returns the cycles taken. Meant for measuring the XADC
+ * rate and feeding the filter benchmark
+ *
+ * returns 0 if acquisition is running or the channel is not wired
+ */
+u32 auxAcqBurst(u32 channel, u16 * samples, u32 count);
+
+/**
+ * Copies the acquisition counters
+ */
+void getAuxAcqStats(AuxAcqStats * stats);
+
+#endif  /* end of protection macro */
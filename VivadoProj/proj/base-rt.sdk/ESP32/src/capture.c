@@ -0,0 +1,258 @@
+/*******************************************************************************
+    Streaming capture of an SPI ADC Pmod, see capture.h
+*******************************************************************************/
+
+#include <stdlib.h>
+#include "capture.h"
+#include "sysTimer.h"
+#include "command.h"
+#include "platform.h"
+
+#define BLOCK_MASK              (CAPTURE_NUM_BLOCKS - 1)
+
+#if CAPTURE_HAS_ADC
+static void captureTick(void) FAST_CODE;
+#endif
+static int rateCommand(int argc, char ** argv, char * reply, int replySize);
+
+    // The ISR is the only writer of filled and the main loop the only
+    // writer of sent, so the ring needs no locking: a block is owned by
+    // the ISR while filled - sent < CAPTURE_NUM_BLOCKS
+static CaptureBlock blocks[CAPTURE_NUM_BLOCKS];
+static volatile u32 filled FAST_BSS;
+static volatile u32 sent FAST_BSS;
+
+static volatile u32 capturing FAST_BSS;
+static u32 fillCount FAST_BSS;
+static u32 droppedRun FAST_BSS;
+    // Ticks skipped between samples, TICK_HZ / rate - 1
+static volatile u32 skipTicks FAST_BSS;
+#if CAPTURE_HAS_ADC
+    // Tick ISR only
+static u32 pending FAST_BSS;
+static u32 skipLeft FAST_BSS;
+#endif
+static volatile CaptureStats captureStats FAST_BSS;
+
+int initCapture(XSpi * spiPtr) {
+    int Status;
+#if CAPTURE_HAS_ADC
+    Status = XSpi_Initialize(spiPtr, CAPTURE_SPI_DEVICE_ID);
+    if (Status != XST_SUCCESS) {
+        xil_printf("Could not initialize SPI\n\r");
+        return XST_FAILURE;
+    }
+
+    Status = XSpi_SetOptions(spiPtr, CAPTURE_SPI_OPTIONS);
+    if (Status != XST_SUCCESS) {
+        xil_printf("Could not set SPI options\n\r");
+        return XST_FAILURE;
+    }
+    XSpi_SetSlaveSelect(spiPtr, 1);
+    XSpi_Start(spiPtr);
+    XSpi_IntrGlobalDisable(spiPtr);
+
+        // The ISR drives the FIFOs directly: leave the slave selected (the
+        // core only asserts it while shifting) and the transmitter running,
+        // so writing a frame to the FIFO starts a conversion
+    XSpi_SetSlaveSelectReg(spiPtr, spiPtr->SlaveSelectReg);
+    XSpi_SetControlReg(spiPtr,
+        XSpi_GetControlReg(spiPtr) & ~XSP_CR_TRANS_INHIBIT_MASK);
+
+    Status = addTickHook(captureTick);
+    if (Status != XST_SUCCESS) {
+        xil_printf("Could not register capture tick\n\r");
+        return XST_FAILURE;
+    }
+#else
+    xil_printf("No SPI controller for the ADC Pmod, capture is off\n\r");
+#endif
+    Status = addCommand("rate", rateCommand);
+    if (Status != XST_SUCCESS) {
+        xil_printf("Could not register rate command\n\r");
+        return XST_FAILURE;
+    }
+    return XST_SUCCESS;
+}
+
+int startCapture(void) {
+#if CAPTURE_HAS_ADC
+    u32 msr = enter_critical();
+        // Discard a frame left over from before stopCapture
+    while(!(XSpi_ReadReg(CAPTURE_SPI_BASEADDR, XSP_SR_OFFSET) & XSP_SR_RX_EMPTY_MASK)) {
+        XSpi_ReadReg(CAPTURE_SPI_BASEADDR, XSP_DRR_OFFSET);
+    }
+    pending = 0;
+    fillCount = 0;
+    droppedRun = 0;
+    skipLeft = 0;
+    captureStats.samples = 0;
+    captureStats.dropped = 0;
+    captureStats.backpressure = 0;
+    captureStats.missed = 0;
+    captureStats.startTick = getTickCount();
+    capturing = 1;
+    exit_critical(msr);
+    return XST_SUCCESS;
+#else
+    return XST_NO_FEATURE;
+#endif
+}
+
+void stopCapture(void) {
+    capturing = 0;
+}
+
+int isCapturing(void) {
+    return capturing;
+}
+
+int setCaptureRate(u32 hz) {
+    if(hz == 0 || hz > TICK_HZ) {
+        return XST_INVALID_PARAM;
+    }
+    skipTicks = TICK_HZ / hz - 1;
+    return XST_SUCCESS;
+}
+
+u32 getCaptureRate(void) {
+    return TICK_HZ / (skipTicks + 1);
+}
+
+    // Stores one sample into the block being filled, publishing the
+    // block to the main loop once it is full
+ISR_INLINE void storeSample(u16 sample) {
+    if(filled - sent >= CAPTURE_NUM_BLOCKS) {
+        if(droppedRun == 0) {
+            captureStats.backpressure++;
+        }
+        droppedRun++;
+        captureStats.dropped++;
+        return;
+    }
+
+    CaptureBlock * block = &blocks[filled & BLOCK_MASK];
+    if(fillCount == 0) {
+        block->magic = CAPTURE_MAGIC;
+        block->sequence = filled;
+        block->firstTick = getTickCount();
+        block->droppedBefore = (droppedRun > 0xFFFF) ? 0xFFFF : droppedRun;
+        droppedRun = 0;
+    }
+    block->samples[fillCount++] = sample;
+    captureStats.samples++;
+
+    if(fillCount == CAPTURE_BLOCK_SAMPLES) {
+        block->sampleCount = CAPTURE_BLOCK_SAMPLES;
+        fillCount = 0;
+        filled++;
+    }
+}
+
+#if CAPTURE_HAS_ADC
+static void captureTick(void) {
+    u32 base = CAPTURE_SPI_BASEADDR;
+
+    if(!capturing) {
+        return;
+    }
+    if(skipLeft > 0) {
+        skipLeft--;
+        return;
+    }
+    skipLeft = skipTicks;
+
+    if(pending) {
+        if(XSpi_ReadReg(base, XSP_SR_OFFSET) & XSP_SR_RX_EMPTY_MASK) {
+            captureStats.missed++;
+        } else {
+            u32 sample = 0;
+            for(int i = 0; i < CAPTURE_FRAME_BYTES; i++) {
+                sample = (sample << 8) | (XSpi_ReadReg(base, XSP_DRR_OFFSET) & 0xFF);
+            }
+            storeSample((u16)sample);
+        }
+    }
+
+        // Clock out the next frame; the result is collected next sample
+    for(int i = 0; i < CAPTURE_FRAME_BYTES; i++) {
+        XSpi_WriteReg(base, XSP_DTR_OFFSET, 0);
+    }
+    pending = 1;
+}
+#endif
+
+    // Result of a block queued with TCPsendBuffered
+static void blockSent(u32 segment, int status) {
+    if(status == XST_SUCCESS) {
+        captureStats.blocksSent++;
+        captureStats.bytesSent += sizeof(CaptureBlock);
+    } else {
+        captureStats.sendFailures++;
+    }
+}
+
+u32 getCaptureBacklog(void) {
+    return filled - sent;
+}
+
+int serviceCapture(Uart * devicePtr) {
+    if(sent == filled) {
+        return 0;
+    }
+
+        // The driver keeps a copy until the ESP32 has sent it, and
+        // resends it on a SEND FAIL
+    CaptureBlock * block = &blocks[sent & BLOCK_MASK];
+    int status = TCPsendBuffered(devicePtr, (u8 *)block, sizeof(CaptureBlock), blockSent);
+    if(status != XST_SUCCESS) {
+        captureStats.sendFailures++;
+    }
+
+        // A block the ESP32 did not take is not retried: holding it
+        // would stall capture
+    sent++;
+    return 1;
+}
+
+void getCaptureStats(CaptureStats * stats) {
+    u32 msr = enter_critical();
+    stats->samples = captureStats.samples;
+    stats->dropped = captureStats.dropped;
+    stats->backpressure = captureStats.backpressure;
+    stats->missed = captureStats.missed;
+    stats->blocksSent = captureStats.blocksSent;
+    stats->bytesSent = captureStats.bytesSent;
+    stats->sendFailures = captureStats.sendFailures;
+    stats->startTick = captureStats.startTick;
+    exit_critical(msr);
+}
+
+void printCaptureStats(void) {
+    CaptureStats stats;
+    getCaptureStats(&stats);
+    u32 elapsed = getTickCount() - stats.startTick;
+    if(elapsed == 0) {
+        elapsed = 1;
+    }
+    xil_printf("Capture: %d samples (%d/s), %d dropped in %d stalls, %d missed\n\r",
+        stats.samples, (u32)(((u64)stats.samples * TICK_HZ) / elapsed),
+        stats.dropped, stats.backpressure, stats.missed);
+    xil_printf("Upload: %d blocks, %d bytes (%d B/s), %d failed, %d waiting\n\r",
+        stats.blocksSent, stats.bytesSent,
+        (u32)(((u64)stats.bytesSent * TICK_HZ) / elapsed),
+        stats.sendFailures, filled - sent);
+}
+
+    // rate [<samples per second>]
+static int rateCommand(int argc, char ** argv, char * reply, int replySize) {
+    if(!CAPTURE_HAS_ADC) {
+        return snprintf(reply, replySize, "ERR no ADC on this bitstream, capture is off\r\n");
+    }
+    if(argc == 2 && setCaptureRate(strtoul(argv[1], NULL, 0)) != XST_SUCCESS) {
+        return snprintf(reply, replySize, "ERR rate must be 1 to %d\r\n", TICK_HZ);
+    } else if(argc > 2) {
+        return snprintf(reply, replySize, "ERR usage: rate [<hz>]\r\n");
+    }
+    return snprintf(reply, replySize, "OK rate %u Hz\r\n", (unsigned)getCaptureRate());
+}
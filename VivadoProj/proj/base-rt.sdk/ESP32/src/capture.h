@@ -0,0 +1,157 @@
+/*******************************************************************************
+    Streaming capture of an SPI ADC Pmod on an SPI controller of its own
+
+    Every system tick the ISR collects the conversion started on the
+    previous tick and starts the next one, so the ISR never waits on the
+    bus and the sample rate is the tick rate (TICK_HZ), or a whole fraction
+    of it set with setCaptureRate or the "rate" command. Samples are stored
+    into a ring of CAPTURE_NUM_BLOCKS blocks in DDR: the main loop uploads
+    full blocks over the ESP32 TCP link while the ISR fills the next one.
+    The ring is deep enough to hold the samples taken while the radio
+    sleeps in duty-cycle mode (see dutyCycle.h), which uploads them in one
+    burst when it wakes.
+
+    When the upload falls behind and no block is free the ISR drops
+    samples rather than overwrite a block that is still being sent. The
+    drops are counted, and the next block carries the number of samples
+    lost just before it so the collector can see the gap.
+
+    The ADC needs a controller other than axi_quad_spi_0. That one has a
+    single slave select, routed through STARTUPE2 to the configuration
+    flash (see spiFlash.h), so a conversion there would select the flash
+    and read its output back as samples. This bitstream has no second SPI
+    controller, so capture is built without hardware: initCapture only
+    registers the "rate" command and startCapture refuses. A bitstream
+    that adds a controller for the Pmod, axi_quad_spi_1, gets capture on it.
+*******************************************************************************/
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include "xparameters.h"
+#include "xil_printf.h"
+#include "xil_types.h"
+#include "xstatus.h"
+#include "xspi.h"
+#include "ESP32.h"
+#include "platform_config.h"
+
+/*************************** XILINX ARGUMENT MACROS ***************************/
+#if XPAR_XSPI_NUM_INSTANCES > 1
+#define CAPTURE_HAS_ADC         1
+#define CAPTURE_SPI_DEVICE_ID   XPAR_SPI_1_DEVICE_ID
+#define CAPTURE_SPI_BASEADDR    XPAR_SPI_1_BASEADDR
+#else
+#define CAPTURE_HAS_ADC         0
+#endif
+
+    // SPI mode of the ADC; CPOL = 1, CPHA = 1 suits the AD7476 family
+#define CAPTURE_SPI_OPTIONS     (XSP_MASTER_OPTION | XSP_CLK_ACTIVE_LOW_OPTION | \
+                                 XSP_CLK_PHASE_1_OPTION)
+
+    // Bytes clocked per conversion; each sample is stored as the raw
+    // big-endian frame read from the ADC
+#define CAPTURE_FRAME_BYTES     2
+
+/***************************** CAPTURE CONFIGURATION **************************/
+#define CAPTURE_BLOCK_SAMPLES   512
+    // Must be a power of 2; 64 blocks are about 33 s at 1 kHz
+#define CAPTURE_NUM_BLOCKS      64
+
+#define CAPTURE_MAGIC           0x43415054  // "CAPT"
+
+/**
+ * Block layout as sent on the wire, little-endian
+ */
+typedef struct {
+    u32 magic;
+    u32 sequence;       // increments by one per block
+    u32 firstTick;      // tick count of samples[0]
+    u16 sampleCount;
+    u16 droppedBefore;  // samples lost between the previous block and this one
+    u16 samples[CAPTURE_BLOCK_SAMPLES];
+} CaptureBlock;
+
+typedef struct {
+    u32 samples;        // samples stored into blocks
+    u32 dropped;        // samples lost because no block was free
+    u32 backpressure;   // times the ISR ran out of free blocks
+    u32 missed;         // ticks where the previous conversion had no data
+    u32 blocksSent;     // answered SEND OK
+    u32 bytesSent;
+    u32 sendFailures;   // not taken by the ESP32, or lost after resends
+    u32 startTick;
+} CaptureStats;
+
+/**
+ * Initializes the SPI controller for the ADC and registers the capture
+ * with the system tick and the "rate" command with the command link.
+ * Without CAPTURE_HAS_ADC only the command is registered, and it
+ * answers ERR.
+ * Capture stays idle until startCapture
+ * initSysTimer must have been called first
+ *
+ * returns XST_SUCCESS in case of success
+ * returns XST_FAILURE in case of failure
+ */
+int initCapture(XSpi * spiPtr);
+
+/**
+ * Starts sampling
+ *
+ * returns XST_SUCCESS in case of success
+ * returns XST_NO_FEATURE if the bitstream has no SPI controller for the ADC
+ */
+int startCapture(void);
+
+/**
+ * Stops sampling. The partly filled block is discarded; full blocks are
+ * still uploaded
+ */
+void stopCapture(void);
+
+/**
+ * Returns non-zero while sampling
+ */
+int isCapturing(void);
+
+/**
+ * Samples every TICK_HZ / hz ticks from the next sample on. Rates that do
+ * not divide TICK_HZ round up to the next one that does; blocks carry
+ * no rate, so the collector goes by the firstTick of successive blocks
+ *
+ * returns XST_SUCCESS in case of success
+ * returns XST_INVALID_PARAM if hz is 0 or above TICK_HZ
+ */
+int setCaptureRate(u32 hz);
+
+/**
+ * Returns the sample rate in samples per second
+ */
+u32 getCaptureRate(void);
+
+/**
+ * Returns the number of full blocks not yet queued for upload
+ */
+u32 getCaptureBacklog(void);
+
+/**
+ * Queues at most one full block for the open TCP connection with
+ * TCPsendBuffered and frees it for the ISR. Call this from the main
+ * loop as often as possible, along with serviceTCPSendWindow
+ *
+ * returns 1 if a block was queued, 0 otherwise
+ */
+int serviceCapture(Uart * devicePtr);
+
+/**
+ * Copies the capture counters
+ */
+void getCaptureStats(CaptureStats * stats);
+
+/**
+ * Prints throughput and drop counters to the USB/UART port
+ */
+void printCaptureStats(void);
+
+#endif  /* end of protection macro */
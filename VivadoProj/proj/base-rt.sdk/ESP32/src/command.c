@@ -0,0 +1,188 @@
+/*******************************************************************************
+    Text command link over the ESP32 TCP connection, see command.h
+*******************************************************************************/
+
+#include <string.h>
+#include "command.h"
+
+typedef struct {
+    const char * name;
+    CommandHandler handler;
+} Command;
+
+static Command commands[MAX_COMMANDS];
+static u32 numCommands;
+    // Open addressed table of index + 1 into commands, 0 for a free slot
+static u8 commandSlots[CMD_HASH_SIZE];
+
+static char lines[CMD_QUEUE_LINES][CMD_LINE_MAX];
+static u32 lineHead;
+static u32 lineTail;
+static u32 lineLength;
+static u32 lineOverflow;
+static u32 linesDropped;
+static u32 commandsRun;
+
+static int helpCommand(int argc, char ** argv, char * reply, int replySize);
+
+void initCommands(void) {
+    setTCPDataHandler(commandInput);
+    addCommand("help", helpCommand);
+}
+
+    // FNV-1a over the name
+static u32 hashName(const char * name) {
+    u32 hash = 2166136261u;
+    while(*name != '\0') {
+        hash ^= (u8)*name++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+    // Slot holding name, or the free slot it would go in. The table is
+    // never more than half full, so the probe always ends
+static u32 findSlot(const char * name) {
+    u32 slot = hashName(name) & (CMD_HASH_SIZE - 1);
+    while(commandSlots[slot] != 0 &&
+            strcmp(commands[commandSlots[slot] - 1].name, name) != 0) {
+        slot = (slot + 1) & (CMD_HASH_SIZE - 1);
+    }
+    return slot;
+}
+
+int addCommand(const char * name, CommandHandler handler) {
+    if(numCommands >= MAX_COMMANDS) {
+        return XST_FAILURE;
+    }
+    u32 slot = findSlot(name);
+    if(commandSlots[slot] != 0) {
+        return XST_FAILURE;
+    }
+    commands[numCommands].name = name;
+    commands[numCommands].handler = handler;
+    numCommands++;
+    commandSlots[slot] = numCommands;
+    return XST_SUCCESS;
+}
+
+    // help: the registered commands, in the order they were added
+static int helpCommand(int argc, char ** argv, char * reply, int replySize) {
+    int length = snprintf(reply, replySize, "OK");
+    for(u32 i = 0; i < numCommands && length < replySize; i++) {
+        length += snprintf(reply + length, replySize - length, " %s", commands[i].name);
+    }
+    if(length < replySize) {
+        length += snprintf(reply + length, replySize - length, "\r\n");
+    }
+    return length;
+}
+
+void commandInput(const u8 * data, int length) {
+    for(int i = 0; i < length; i++) {
+        char c = data[i];
+        if(lineHead - lineTail >= CMD_QUEUE_LINES) {
+                // No room to assemble into: drop until the end of the line,
+                // even if a line is taken off the queue before it comes
+            if(c == '\n') {
+                linesDropped++;
+                lineOverflow = 0;
+            } else {
+                lineOverflow = 1;
+            }
+            continue;
+        }
+
+        char * line = lines[lineHead & (CMD_QUEUE_LINES - 1)];
+        if(c == '\n') {
+            if(lineOverflow) {
+                linesDropped++;
+            } else if(lineLength > 0) {
+                line[lineLength] = '\0';
+                lineHead++;
+            }
+            lineLength = 0;
+            lineOverflow = 0;
+        } else if(c != '\r') {
+            if(lineLength < CMD_LINE_MAX - 1) {
+                line[lineLength++] = c;
+            } else {
+                lineOverflow = 1;
+            }
+        }
+    }
+}
+
+    // Splits line into words in place
+static int splitArgs(char * line, char ** argv) {
+    int argc = 0;
+    char * cursor = line;
+    while(*cursor != '\0' && argc < CMD_MAX_ARGS) {
+        while(*cursor == ' ' || *cursor == '\t') {
+            cursor++;
+        }
+        if(*cursor == '\0') {
+            break;
+        }
+        argv[argc++] = cursor;
+        while(*cursor != '\0' && *cursor != ' ' && *cursor != '\t') {
+            cursor++;
+        }
+        if(*cursor != '\0') {
+            *cursor++ = '\0';
+        }
+    }
+    return argc;
+}
+
+int serviceCommands(Uart * devicePtr) {
+    char * argv[CMD_MAX_ARGS];
+    int argc;
+    int length;
+
+    if(lineHead == lineTail) {
+        return 0;
+    }
+
+    char * line = lines[lineTail & (CMD_QUEUE_LINES - 1)];
+    char * reply = poolAlloc(CMD_REPLY_MAX);
+    if(reply == NULL) {
+            // Leave the line queued and try again next time round
+        return 0;
+    }
+
+    argc = splitArgs(line, argv);
+    length = 0;
+    if(argc > 0) {
+        u32 slot = commandSlots[findSlot(argv[0])];
+        if(slot != 0) {
+            length = commands[slot - 1].handler(argc, argv, reply, CMD_REPLY_MAX);
+            commandsRun++;
+        } else {
+            length = snprintf(reply, CMD_REPLY_MAX, "ERR unknown command %s\r\n", argv[0]);
+        }
+    }
+    lineTail++;
+
+    if(length >= CMD_REPLY_MAX) {
+        length = CMD_REPLY_MAX - 1;
+    }
+        // The whole reply goes out as one send, however many lines it has
+    if(length > 0) {
+        TCPsend(devicePtr, (u8 *)reply, length);
+    }
+    poolFree(reply);
+    return 1;
+}
+
+u32 getCommandsDropped(void) {
+    return linesDropped;
+}
+
+u32 getCommandsRun(void) {
+    return commandsRun;
+}
+
+u32 getCommandsQueued(void) {
+    return lineHead - lineTail;
+}
@@ -0,0 +1,88 @@
+/*******************************************************************************
+    Text command link over the ESP32 TCP connection
+
+    The TCP peer sends one command per line, e.g. "pwm start\n". Lines are
+    assembled from the +IPD payload as echoESP32Responses drains the
+    receive ring and are queued; serviceCommands runs one queued line from
+    the main loop, so a command never runs inside the receive path and is
+    free to send its reply with TCPsend.
+
+    Modules register their own commands with addCommand. The first word
+    of a line selects the command through a hash of the registered names,
+    so lookup does not grow with the number of commands, and the handler
+    gets the words as argc/argv like main() and writes its reply into a
+    pool buffer. The reply goes back in one send. "help" lists the
+    commands.
+*******************************************************************************/
+
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include "xil_printf.h"
+#include "xil_types.h"
+#include "xstatus.h"
+#include "ESP32.h"
+#include "pool.h"
+
+/***************************** COMMAND CONFIGURATION **************************/
+    // Room for "config set" with a 64 character WPA key
+#define CMD_LINE_MAX            160
+    // Lines waiting for serviceCommands, must be a power of 2
+#define CMD_QUEUE_LINES         4
+#define CMD_MAX_ARGS            12
+#define MAX_COMMANDS            24
+    // Name lookup table, a power of 2 at least twice MAX_COMMANDS
+#define CMD_HASH_SIZE           64
+    // Pool buffer for the reply, room for the "stats" dump
+#define CMD_REPLY_MAX           POOL_LARGE_SIZE
+
+/**
+ * Runs a command. argv[0] is the command name. The reply, if any, is
+ * written to reply as a string of at most replySize - 1 characters
+ *
+ * returns the length of the reply, 0 for none
+ */
+typedef int (*CommandHandler)(int argc, char ** argv, char * reply, int replySize);
+
+/**
+ * Starts feeding the TCP payload into the line assembler
+ */
+void initCommands(void);
+
+/**
+ * Registers a command under name, which must stay valid
+ *
+ * returns XST_SUCCESS in case of success
+ * returns XST_FAILURE if the table is full or name is taken
+ */
+int addCommand(const char * name, CommandHandler handler);
+
+/**
+ * Line assembler; registered as the TCP data handler by initCommands
+ */
+void commandInput(const u8 * data, int length);
+
+/**
+ * Runs at most one queued command line and sends its reply
+ *
+ * returns 1 if a command was run, 0 otherwise
+ */
+int serviceCommands(Uart * devicePtr);
+
+/**
+ * Returns the number of lines dropped because they were too long or
+ * the queue was full
+ */
+u32 getCommandsDropped(void);
+
+/**
+ * Returns the number of lines that ran a registered command
+ */
+u32 getCommandsRun(void);
+
+/**
+ * Returns the number of complete lines waiting for serviceCommands
+ */
+u32 getCommandsQueued(void);
+
+#endif  /* end of protection macro */
@@ -0,0 +1,314 @@
+/*******************************************************************************
+    Board settings kept in the configuration flash, see configStore.h
+*******************************************************************************/
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "configStore.h"
+#include "command.h"
+#include "crc.h"
+
+#define ERASED_WORD             0xFFFFFFFF
+#define KEEPALIVE_MAX           7200    // longest the AT firmware accepts
+
+    // One page of the store as it lies in flash
+typedef struct {
+    u32 magic;
+    u32 sequence;       // past every record written before it, never 0
+    u32 erases;         // carried forward, to show the wear
+    BoardConfig config;
+    u32 crc;            // over everything before it
+} ConfigRecord;
+
+    // A record must fit its page
+typedef char configRecordFits[(sizeof(ConfigRecord) <= CONFIG_SLOT_SIZE) ? 1 : -1];
+typedef char configRingFits[(CONFIG_NUM_SECTORS >= 2) ? 1 : -1];
+
+static int configCommand(int argc, char ** argv, char * reply, int replySize);
+
+static BoardConfig config;
+static int stored;
+static ConfigStoreStats storeStats;
+    // Highest sequence in flash, damaged records included
+static u32 lastSequence;
+
+    // Record being written and what is read back, kept off the stack
+static ConfigRecord record;
+static u32 readBack[sizeof(ConfigRecord) / sizeof(u32)];
+
+static u32 slotAddress(u32 slot) {
+    return CONFIG_BASE + slot * CONFIG_SLOT_SIZE;
+}
+
+static u32 recordCrc(const ConfigRecord * r) {
+    return crc32(r, offsetof(ConfigRecord, crc));
+}
+
+static void setDefaults(BoardConfig * c) {
+    memset(c, 0, sizeof(*c));
+    strcpy(c->host, CONFIG_DEFAULT_HOST);
+    c->port = CONFIG_DEFAULT_PORT;
+    c->keepAlive = CONFIG_DEFAULT_KEEPALIVE;
+}
+
+    // Sequences are compared as serial numbers, so the count can wrap:
+    // the records in the ring are never anywhere near 2^31 saves apart
+static int newer(u32 a, u32 b) {
+    return (s32)(a - b) > 0;
+}
+
+    // Finds the record with the highest sequence below ceiling, or of all
+    // if ceiling is 0, from the headers alone; the caller checks its CRC
+static int findNewest(u32 ceiling, u32 * slotOut, u32 * sequenceOut) {
+    u32 header[2];
+    int found = 0;
+    for(u32 slot = 0; slot < CONFIG_NUM_SLOTS; slot++) {
+        if(flashRead(slotAddress(slot), header, sizeof(header)) != XST_SUCCESS) {
+            return 0;
+        }
+        if(header[0] == CONFIG_MAGIC && header[1] != 0 &&
+                (ceiling == 0 || newer(ceiling, header[1])) &&
+                (!found || newer(header[1], *sequenceOut))) {
+            found = 1;
+            *slotOut = slot;
+            *sequenceOut = header[1];
+        }
+    }
+    return found;
+}
+
+    // Loads the newest record whose CRC holds, stepping back past
+    // damaged ones
+static int loadNewest(void) {
+    u32 ceiling = 0;
+        // No valid slot until findNewest finds one
+    u32 slot = (u32)-1;
+    u32 sequence = 0;
+    while(findNewest(ceiling, &slot, &sequence)) {
+        if(ceiling == 0) {
+            lastSequence = sequence;
+        }
+        if(flashRead(slotAddress(slot), &record, sizeof(record)) == XST_SUCCESS &&
+                record.crc == recordCrc(&record)) {
+            config = record.config;
+            config.ssid[CONFIG_SSID_MAX - 1] = '\0';
+            config.pwd[CONFIG_PWD_MAX - 1] = '\0';
+            config.host[CONFIG_HOST_MAX - 1] = '\0';
+            storeStats.sequence = sequence;
+            storeStats.slot = slot;
+            storeStats.erases = record.erases;
+            return 1;
+        }
+        xil_printf("Config record %d in slot %d is damaged\n\r", sequence, slot);
+        ceiling = sequence;
+    }
+    return 0;
+}
+
+static int slotBlank(u32 slot) {
+    if(flashRead(slotAddress(slot), readBack, sizeof(readBack)) != XST_SUCCESS) {
+        return 0;
+    }
+    for(u32 i = 0; i < sizeof(readBack) / sizeof(u32); i++) {
+        if(readBack[i] != ERASED_WORD) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+    // Writes record into the slot after the newest one. Slots a failed or
+    // interrupted save left dirty are passed over until the next erase.
+    // Each program takes a new sequence, so a damaged record never shares
+    // one with a good record that could be passed over for it
+static int writeRecord(void) {
+    u32 slot = (storeStats.sequence == 0) ? 0 : (storeStats.slot + 1) % CONFIG_NUM_SLOTS;
+
+    for(u32 tries = 0; tries < CONFIG_NUM_SLOTS; tries++) {
+        if(slot % CONFIG_SLOTS_PER_SECTOR == 0) {
+                // Come round to the newest record's own sector: every
+                // other slot has failed
+            if(storeStats.sequence != 0 &&
+                    slot / CONFIG_SLOTS_PER_SECTOR == storeStats.slot / CONFIG_SLOTS_PER_SECTOR) {
+                break;
+            }
+            if(flashEraseSector(slotAddress(slot)) != XST_SUCCESS) {
+                xil_printf("Could not erase config sector at %x\n\r", slotAddress(slot));
+                return XST_FAILURE;
+            }
+            storeStats.erases++;
+        } else if(!slotBlank(slot)) {
+            slot = (slot + 1) % CONFIG_NUM_SLOTS;
+            continue;
+        }
+
+        lastSequence = (lastSequence + 1 == 0) ? 1 : lastSequence + 1;
+        record.sequence = lastSequence;
+        record.erases = storeStats.erases;
+        record.crc = recordCrc(&record);
+        if(flashProgram(slotAddress(slot), &record, sizeof(record)) == XST_SUCCESS &&
+                flashRead(slotAddress(slot), readBack, sizeof(readBack)) == XST_SUCCESS &&
+                memcmp(readBack, &record, sizeof(record)) == 0) {
+            storeStats.sequence = record.sequence;
+            storeStats.slot = slot;
+            return XST_SUCCESS;
+        }
+        xil_printf("Config slot %d did not program\n\r", slot);
+        slot = (slot + 1) % CONFIG_NUM_SLOTS;
+    }
+    return XST_FAILURE;
+}
+
+int initConfigStore(void) {
+    u32 id;
+    setDefaults(&config);
+    memset(&storeStats, 0, sizeof(storeStats));
+    lastSequence = 0;
+
+    if(flashReadId(&id) == XST_SUCCESS && id != FLASH_JEDEC_ID) {
+        xil_printf("Unexpected flash ID %x\n\r", id);
+    }
+    stored = loadNewest();
+
+    if(stored) {
+        xil_printf("Config record %d from slot %d, %d erases: collector %s:%d\n\r",
+            storeStats.sequence, storeStats.slot, storeStats.erases,
+            config.host, config.port);
+    } else {
+        xil_printf("No stored config, collector %s:%d\n\r", config.host, config.port);
+    }
+
+    if(addCommand("config", configCommand) != XST_SUCCESS) {
+        xil_printf("Could not register config command\n\r");
+        return XST_FAILURE;
+    }
+    return XST_SUCCESS;
+}
+
+void getConfig(BoardConfig * c) {
+    *c = config;
+}
+
+int isConfigStored(void) {
+    return stored;
+}
+
+int saveConfig(const BoardConfig * c) {
+    memset(&record, 0, sizeof(record));
+    record.magic = CONFIG_MAGIC;
+    record.config = *c;
+    int status = writeRecord();
+    if(status != XST_SUCCESS) {
+        storeStats.saveFailures++;
+        return XST_FAILURE;
+    }
+    config = *c;
+    stored = 1;
+    storeStats.saves++;
+    return XST_SUCCESS;
+}
+
+int clearConfig(void) {
+    int status = XST_SUCCESS;
+    for(u32 sector = 0; sector < CONFIG_NUM_SECTORS; sector++) {
+        if(flashEraseSector(CONFIG_BASE + sector * FLASH_SECTOR_SIZE) != XST_SUCCESS) {
+            status = XST_FAILURE;
+            continue;
+        }
+        storeStats.erases++;
+    }
+
+    storeStats.sequence = 0;
+    storeStats.slot = 0;
+    lastSequence = 0;
+    stored = 0;
+    setDefaults(&config);
+    return status;
+}
+
+void getConfigStoreStats(ConfigStoreStats * stats) {
+    *stats = storeStats;
+}
+
+    // "-" stands for an empty string, which the command line cannot carry
+static int setString(char * field, u32 size, const char * value) {
+    if(strcmp(value, "-") == 0) {
+        value = "";
+    }
+    if(strlen(value) >= size) {
+        return XST_FAILURE;
+    }
+    memset(field, 0, size);
+    strcpy(field, value);
+    return XST_SUCCESS;
+}
+
+static int setNumber(u16 * field, const char * value, u32 min, u32 max) {
+    char * end;
+    u32 number = strtoul(value, &end, 10);
+    if(end == value || *end != '\0' || number < min || number > max) {
+        return XST_FAILURE;
+    }
+    *field = number;
+    return XST_SUCCESS;
+}
+
+static int setField(BoardConfig * c, const char * key, const char * value) {
+    if(strcmp(key, "ssid") == 0) {
+        return setString(c->ssid, CONFIG_SSID_MAX, value);
+    } else if(strcmp(key, "pwd") == 0) {
+        return setString(c->pwd, CONFIG_PWD_MAX, value);
+    } else if(strcmp(key, "host") == 0) {
+        if(strcmp(value, "-") == 0) {
+            return XST_FAILURE;
+        }
+        return setString(c->host, CONFIG_HOST_MAX, value);
+    } else if(strcmp(key, "port") == 0) {
+        return setNumber(&c->port, value, 1, 65535);
+    } else if(strcmp(key, "keepalive") == 0) {
+        return setNumber(&c->keepAlive, value, 0, KEEPALIVE_MAX);
+    }
+    return XST_FAILURE;
+}
+
+static int configCommand(int argc, char ** argv, char * reply, int replySize) {
+    if(argc < 2) {
+        return snprintf(reply, replySize, "ERR usage: config show|set|clear\r\n");
+    }
+
+    if(strcmp(argv[1], "show") == 0) {
+        return snprintf(reply, replySize,
+            "OK host %s port %u keepalive %u ssid %s pwd %s %s record %u slot %u erases %u saves %u failed %u\r\n",
+            config.host, config.port, config.keepAlive,
+            config.ssid[0] != '\0' ? config.ssid : "-",
+            config.pwd[0] != '\0' ? "set" : "-",
+            stored ? "stored" : "default",
+            storeStats.sequence, storeStats.slot, storeStats.erases,
+            storeStats.saves, storeStats.saveFailures);
+    } else if(strcmp(argv[1], "set") == 0) {
+        BoardConfig staged = config;
+        if(argc < 4 || argc % 2 != 0) {
+            return snprintf(reply, replySize,
+                "ERR usage: config set <key> <value> [<key> <value> ...]\r\n");
+        }
+        for(int i = 2; i < argc; i += 2) {
+            if(setField(&staged, argv[i], argv[i + 1]) != XST_SUCCESS) {
+                return snprintf(reply, replySize, "ERR bad %s\r\n", argv[i]);
+            }
+        }
+        if(saveConfig(&staged) != XST_SUCCESS) {
+            return snprintf(reply, replySize, "ERR config not saved\r\n");
+        }
+        return snprintf(reply, replySize, "OK record %u slot %u erases %u\r\n",
+            storeStats.sequence, storeStats.slot, storeStats.erases);
+    } else if(strcmp(argv[1], "clear") == 0) {
+        if(clearConfig() != XST_SUCCESS) {
+            return snprintf(reply, replySize, "ERR config not cleared\r\n");
+        }
+    } else {
+        return snprintf(reply, replySize, "ERR unknown config command %s\r\n", argv[1]);
+    }
+    return snprintf(reply, replySize, "OK\r\n");
+}
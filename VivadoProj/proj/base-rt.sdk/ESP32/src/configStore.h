@@ -0,0 +1,113 @@
+/*******************************************************************************
+    Board settings kept in the configuration flash
+
+    The Wi-Fi credentials and the collector's address are read from flash
+    once at boot, so a board moves to another network or collector with
+    the "config" command instead of a rebuild and reflash.
+
+    Each save appends a record to the next free page of a ring of
+    CONFIG_NUM_SECTORS sectors at the top of the flash, well clear of the
+    bitstream, instead of rewriting the same place. A sector is only erased
+    when the ring comes round to it, so every page takes one write per
+    CONFIG_NUM_SLOTS saves and each sector one erase. Records carry a
+    sequence number and a CRC, and at boot the valid record with the
+    newest sequence wins: a save cut short by a reset leaves the settings
+    before it in force. Sequences compare as serial numbers, so they may
+    wrap. The sector erased is never the one holding the newest record,
+    so there is always a good record in flash.
+
+    Commands over the TCP link:
+        config show
+        config set <key> <value> [<key> <value> ...]
+            keys ssid, pwd, host, port and keepalive; "-" empties ssid or
+            pwd. Values cannot hold spaces. Saved straight away, in
+            effect from the next boot
+        config clear
+            erases the store; the next boot uses the built in defaults
+*******************************************************************************/
+
+#ifndef CONFIGSTORE_H
+#define CONFIGSTORE_H
+
+#include "xil_printf.h"
+#include "xil_types.h"
+#include "xstatus.h"
+#include "spiFlash.h"
+
+/***************************** STORE CONFIGURATION ****************************/
+    // At least 2, so a sector can be erased with the newest record kept
+#define CONFIG_NUM_SECTORS      2
+#define CONFIG_BASE             (FLASH_SIZE - CONFIG_NUM_SECTORS * FLASH_SECTOR_SIZE)
+    // One record per page, so a record never straddles a program
+#define CONFIG_SLOT_SIZE        FLASH_PAGE_SIZE
+#define CONFIG_SLOTS_PER_SECTOR (FLASH_SECTOR_SIZE / CONFIG_SLOT_SIZE)
+#define CONFIG_NUM_SLOTS        (CONFIG_NUM_SECTORS * CONFIG_SLOTS_PER_SECTOR)
+
+#define CONFIG_MAGIC            0x43464731  // "CFG1"
+
+#define CONFIG_SSID_MAX         33      // 32 characters and '\0'
+#define CONFIG_PWD_MAX          65      // 64 character WPA key and '\0'
+#define CONFIG_HOST_MAX         64
+
+    // Used until a record has been saved
+#define CONFIG_DEFAULT_HOST     "192.168.1.101"
+#define CONFIG_DEFAULT_PORT     5005
+#define CONFIG_DEFAULT_KEEPALIVE 10
+
+typedef struct {
+    char ssid[CONFIG_SSID_MAX];     // empty keeps the ESP32's own choice
+    char pwd[CONFIG_PWD_MAX];
+    char host[CONFIG_HOST_MAX];     // collector IP address or name
+    u16 port;
+    u16 keepAlive;                  // TCP keep alive in s, 0 for none
+} BoardConfig;
+
+typedef struct {
+    u32 sequence;       // of the newest record, 0 if none
+    u32 slot;           // where it is
+    u32 erases;         // sector erases since the store was first used
+    u32 saves;          // records written since boot
+    u32 saveFailures;
+} ConfigStoreStats;
+
+/**
+ * Loads the newest valid record, or the defaults if there is none, and
+ * registers the config command. initSpiFlash must have been called first
+ *
+ * returns XST_SUCCESS in case of success
+ * returns XST_FAILURE if the command could not be registered
+ */
+int initConfigStore(void);
+
+/**
+ * Copies the stored settings, or the defaults if there are none
+ */
+void getConfig(BoardConfig * config);
+
+/**
+ * Returns non-zero if the settings came from flash
+ */
+int isConfigStored(void);
+
+/**
+ * Writes config as the newest record
+ *
+ * returns XST_SUCCESS in case of success
+ * returns XST_FAILURE if no page could be written
+ */
+int saveConfig(const BoardConfig * config);
+
+/**
+ * Erases every sector of the store and returns to the defaults
+ *
+ * returns XST_SUCCESS in case of success
+ * returns XST_FAILURE if a sector could not be erased
+ */
+int clearConfig(void);
+
+/**
+ * Copies the store counters
+ */
+void getConfigStoreStats(ConfigStoreStats * stats);
+
+#endif  /* end of protection macro */
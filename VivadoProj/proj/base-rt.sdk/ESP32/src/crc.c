@@ -0,0 +1,17 @@
+/*******************************************************************************
+    CRC-32, see crc.h
+*******************************************************************************/
+
+#include "crc.h"
+
+u32 crc32(const void * data, u32 length) {
+    const u8 * bytes = data;
+    u32 crc = 0xFFFFFFFF;
+    for(u32 i = 0; i < length; i++) {
+        crc ^= bytes[i];
+        for(int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
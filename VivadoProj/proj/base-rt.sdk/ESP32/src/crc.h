@@ -0,0 +1,17 @@
+/*******************************************************************************
+    CRC-32 (IEEE 802.3) over records kept in memory that nothing
+    initializes or in flash
+*******************************************************************************/
+
+#ifndef CRC_H
+#define CRC_H
+
+#include "xil_types.h"
+
+/**
+ * Returns the CRC-32 of length bytes at data, computed bitwise; the
+ * records it guards are a few hundred bytes at most
+ */
+u32 crc32(const void * data, u32 length);
+
+#endif  /* end of protection macro */
@@ -0,0 +1,102 @@
+/*******************************************************************************
+    Fixed-point decimation filters, see decimate.h
+*******************************************************************************/
+
+#include <string.h>
+#include "decimate.h"
+
+#define XADC_MID_SCALE          0x8000
+
+    // Compensates the droop of a third order CIC with rateShift >= 4 up to
+    // 0.16 of the CIC output rate (within 0.6 dB) and is at least 30 dB
+    // down over the band that aliases onto it when decimating by 2.
+    // Q15, symmetric, sums to 32768
+static const s16 firCoefficients[FIR_TAPS] FAST_DATA = {
+       -7,     0,    15,     3,     4,    -7,  -110,    -8,
+      204,    57,   248,   -59, -2391,  -593, 10228, 17600,
+    10228,  -593, -2391,   -59,   248,    57,   204,    -8,
+     -110,    -7,     4,     3,    15,     0,    -7
+};
+
+void cicInit(CicState * cic, u32 rateShift) {
+    memset(cic, 0, sizeof(CicState));
+    cic->rateShift = rateShift;
+}
+
+    // Integrators and combs wrap modulo 2^32, which cancels out as long as
+    // the output fits, so no saturation is needed
+u32 cicDecimate(CicState * cic, const u16 * in, u32 count, s32 * out) {
+    u32 i0 = cic->integrator[0];
+    u32 i1 = cic->integrator[1];
+    u32 i2 = cic->integrator[2];
+    u32 phase = cic->phase;
+    u32 rateMask = (1 << cic->rateShift) - 1;
+        // Gain is 2^(3 * rateShift); scale back to 16 bit register units
+    u32 outShift = CIC_ORDER * cic->rateShift - 4;
+    u32 produced = 0;
+
+    for(u32 n = 0; n < count; n++) {
+        i0 += (s32)(in[n] >> 4) - 2048;
+        i1 += i0;
+        i2 += i1;
+        if((++phase & rateMask) != 0) {
+            continue;
+        }
+
+        u32 c0 = i2 - cic->comb[0];
+        cic->comb[0] = i2;
+        u32 c1 = c0 - cic->comb[1];
+        cic->comb[1] = c0;
+        u32 c2 = c1 - cic->comb[2];
+        cic->comb[2] = c1;
+        out[produced++] = (s32)c2 >> outShift;
+    }
+
+    cic->integrator[0] = i0;
+    cic->integrator[1] = i1;
+    cic->integrator[2] = i2;
+    cic->phase = phase;
+    return produced;
+}
+
+void firInit(FirState * fir) {
+    memset(fir, 0, sizeof(FirState));
+}
+
+u32 firDecimate(FirState * fir, const s32 * in, u32 count, u16 * out) {
+    u32 index = fir->index;
+    u32 phase = fir->phase;
+    u32 produced = 0;
+
+    for(u32 n = 0; n < count; n++) {
+        fir->history[index] = in[n];
+        fir->history[index + FIR_TAPS] = in[n];
+        if(++index == FIR_TAPS) {
+            index = 0;
+        }
+        if(++phase < FIR_DECIMATION) {
+            continue;
+        }
+        phase = 0;
+
+            // Oldest sample first; fold the symmetric halves so each
+            // coefficient is multiplied once
+        const s32 * x = &fir->history[index];
+        s32 acc = firCoefficients[FIR_TAPS / 2] * x[FIR_TAPS / 2];
+        for(u32 k = 0; k < FIR_TAPS / 2; k++) {
+            acc += firCoefficients[k] * (x[k] + x[FIR_TAPS - 1 - k]);
+        }
+
+        s32 value = (acc >> 15) + XADC_MID_SCALE;
+        if(value < 0) {
+            value = 0;
+        } else if(value > 0xFFFF) {
+            value = 0xFFFF;
+        }
+        out[produced++] = (u16)value;
+    }
+
+    fir->index = index;
+    fir->phase = phase;
+    return produced;
+}
@@ -0,0 +1,75 @@
+/*******************************************************************************
+    Fixed-point decimation filters for XADC samples
+
+    A CIC decimator of order CIC_ORDER takes the sample rate down by
+    2^rateShift, then a FIR filter flattens the CIC passband droop and
+    decimates by a further 2. Everything is integer arithmetic, the
+    MicroBlaze has no FPU.
+
+    Samples are XADC data register values, the 12 bit conversion in the
+    top bits of 16. The CIC output is in the same units but centred on
+    zero (mid-scale subtracted) and keeps the extra resolution gained by
+    averaging in the low 4 bits; the FIR output is back in register form.
+*******************************************************************************/
+
+#ifndef DECIMATE_H
+#define DECIMATE_H
+
+#include "xil_types.h"
+#include "platform_config.h"
+
+#define CIC_ORDER               3
+    // Integrators are 32 bit: 12 + CIC_ORDER * rateShift must fit
+#define CIC_MIN_RATE_SHIFT      2
+#define CIC_MAX_RATE_SHIFT      6
+
+#define FIR_TAPS                31
+#define FIR_DECIMATION          2
+
+    // The application is built at -O0; the filter loops are compiled at
+    // -O2 and kept in BRAM since they run for every sample
+#define DECIMATE_KERNEL         FAST_CODE __attribute__((optimize("O2")))
+
+typedef struct {
+    u32 integrator[CIC_ORDER];
+    u32 comb[CIC_ORDER];
+    u32 rateShift;
+    u32 phase;
+} CicState;
+
+typedef struct {
+        // Each sample is stored twice, FIR_TAPS apart, so the newest
+        // FIR_TAPS samples are always contiguous
+    s32 history[2 * FIR_TAPS];
+    u32 index;
+    u32 phase;
+} FirState;
+
+/**
+ * Resets a CIC decimator for a rate change of 2^rateShift
+ */
+void cicInit(CicState * cic, u32 rateShift);
+
+/**
+ * Feeds count samples through the CIC decimator and writes one output per
+ * 2^rateShift inputs to out. State carries over between calls, so blocks
+ * need not be a multiple of the rate
+ *
+ * returns the number of outputs written
+ */
+u32 cicDecimate(CicState * cic, const u16 * in, u32 count, s32 * out) DECIMATE_KERNEL;
+
+/**
+ * Resets a FIR decimator
+ */
+void firInit(FirState * fir);
+
+/**
+ * Filters count CIC outputs and writes every FIR_DECIMATION-th result to
+ * out as an XADC register value
+ *
+ * returns the number of outputs written
+ */
+u32 firDecimate(FirState * fir, const s32 * in, u32 count, u16 * out) DECIMATE_KERNEL;
+
+#endif  /* end of protection macro */
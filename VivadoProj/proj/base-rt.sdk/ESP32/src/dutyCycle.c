@@ -0,0 +1,209 @@
+/*******************************************************************************
+    Duty-cycled telemetry, see dutyCycle.h
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "dutyCycle.h"
+#include "sysTimer.h"
+#include "command.h"
+#include "configStore.h"
+#include "apScan.h"
+
+#define TICKS_TO_MS(ticks)      ((u32)(((u64)(ticks) * 1000) / TICK_HZ))
+#define MS_TO_TICKS(ms)         ((u32)(((u64)(ms) * TICK_HZ) / 1000))
+
+static int dutyCommand(int argc, char ** argv, char * reply, int replySize);
+
+static DutyCycleStats dutyStats;
+static u32 wakeTick;            // end of the current sleep
+static u32 awakeTick;           // start of the current awake time
+static u32 awakeSamples;        // samples uploaded when it started
+static u32 lastActivity;
+static u32 lastCommandsRun;
+
+static u32 samplesUploaded(void) {
+    CaptureStats capture;
+    AuxAcqStats aux;
+    getCaptureStats(&capture);
+    getAuxAcqStats(&aux);
+    return capture.blocksSent * CAPTURE_BLOCK_SAMPLES + aux.blocksSent * AUX_BLOCK_SAMPLES;
+}
+
+    // Starts an awake time, at the end of a sleep or when duty cycling
+    // is switched on
+static void startAwake(u32 tick) {
+    awakeTick = tick;
+    awakeSamples = samplesUploaded();
+    lastActivity = getTickCount();
+    lastCommandsRun = getCommandsRun();
+}
+
+int initDutyCycle(void) {
+    memset(&dutyStats, 0, sizeof(dutyStats));
+    if(addCommand("duty", dutyCommand) != XST_SUCCESS) {
+        xil_printf("Could not register duty command\n\r");
+        return XST_FAILURE;
+    }
+    return XST_SUCCESS;
+}
+
+int setDutyCycle(u32 periodS) {
+    if(periodS > DUTY_MAX_PERIOD_S) {
+        return XST_INVALID_PARAM;
+    }
+    if(periodS != 0 && dutyStats.period == 0) {
+        startAwake(getTickCount());
+    }
+    dutyStats.period = periodS;
+    return XST_SUCCESS;
+}
+
+    // Sleep that ends the period begun at awakeTick, or sooner if the
+    // capture or XADC ring would reach its watermark first
+static u32 planSleep(u32 now) {
+    u32 awakeMs = TICKS_TO_MS(now - awakeTick);
+    u32 periodMs = dutyStats.period * 1000;
+    u32 sleepMs = (awakeMs < periodMs) ? periodMs - awakeMs : 0;
+
+    u32 backlog = getCaptureBacklog();
+    if(isCapturing() && backlog < DUTY_WATERMARK_BLOCKS) {
+        u32 fillMs = (u32)(((u64)(DUTY_WATERMARK_BLOCKS - backlog) *
+            CAPTURE_BLOCK_SAMPLES * 1000) / getCaptureRate());
+        if(fillMs < sleepMs) {
+            sleepMs = fillMs;
+        }
+    }
+
+    backlog = getAuxBacklog();
+    u32 interval = getAuxBlockInterval();
+    if(interval != 0 && backlog < DUTY_AUX_WATERMARK_BLOCKS) {
+        u32 fillMs = (u32)(((u64)(DUTY_AUX_WATERMARK_BLOCKS - backlog) * interval) / 1000);
+        if(fillMs < sleepMs) {
+            sleepMs = fillMs;
+        }
+    }
+    return (sleepMs < DUTY_MIN_SLEEP_MS) ? DUTY_MIN_SLEEP_MS : sleepMs;
+}
+
+static void sleepRadio(Uart * devicePtr) {
+    u32 now = getTickCount();
+    u32 sleepMs = planSleep(now);
+    if(enterDeepSleep(devicePtr, sleepMs) != XST_SUCCESS) {
+            // Still awake; try again once the link is quiet
+        lastActivity = now;
+        return;
+    }
+    wakeTick = getTickCount() + MS_TO_TICKS(sleepMs);
+    dutyStats.asleep = 1;
+    dutyStats.radioOnMs += TICKS_TO_MS(now - awakeTick);
+    dutyStats.radioOffMs += sleepMs;
+    dutyStats.samples += samplesUploaded() - awakeSamples;
+}
+
+static void wakeRadio(Uart * devicePtr) {
+    BoardConfig config;
+    getConfig(&config);
+
+    dutyStats.asleep = 0;
+    startAwake(wakeTick);
+    int status = waitForESP32Ready(ESP32_READY_TIMEOUT_US);
+    if(status == XST_SUCCESS && waitForESP32Network(ESP32_NETWORK_TIMEOUT_US) != XST_SUCCESS) {
+            // Without an ssid there is nothing to join with
+        status = XST_FAILURE;
+        if(config.ssid[0] != '\0') {
+            dutyStats.rejoins++;
+            status = connectToAP(devicePtr, config.ssid, config.pwd);
+        }
+    }
+    if(status == XST_SUCCESS) {
+        status = establishTCPConnection(devicePtr, config.host, config.port, config.keepAlive);
+    }
+
+    if(status != XST_SUCCESS) {
+        xil_printf("Wake failed, sleeping until the next period\n\r");
+        dutyStats.wakeFailures++;
+        sleepRadio(devicePtr);
+        return;
+    }
+    dutyStats.wakes++;
+    dutyStats.lastWakeMs = TICKS_TO_MS(getTickCount() - wakeTick);
+    lastActivity = getTickCount();
+}
+
+int serviceDutyCycle(Uart * devicePtr) {
+    u32 now = getTickCount();
+    if(dutyStats.asleep) {
+        if((s32)(now - wakeTick) < 0) {
+            return 0;
+        }
+        wakeRadio(devicePtr);
+        return !dutyStats.asleep;
+    }
+    if(dutyStats.period == 0) {
+        return 1;
+    }
+
+        // A command keeps the radio up for another DUTY_LINGER_MS. New
+        // capture and XADC blocks do not; at high rates they never stop
+        // coming
+    u32 commandsRun = getCommandsRun();
+    if(getCommandsQueued() > 0 || commandsRun != lastCommandsRun) {
+        lastCommandsRun = commandsRun;
+        lastActivity = now;
+        return 1;
+    }
+    if(now - lastActivity < MS_TO_TICKS(DUTY_LINGER_MS) ||
+            getCaptureBacklog() > 0 || getAuxBacklog() > 0 || !isTCPSendWindowIdle()) {
+        return 1;
+    }
+    sleepRadio(devicePtr);
+    return !dutyStats.asleep;
+}
+
+void getDutyCycleStats(DutyCycleStats * stats) {
+    memcpy(stats, &dutyStats, sizeof(*stats));
+}
+
+    // Radio on time per uploaded sample, in us
+static u32 onTimePerSample(void) {
+    if(dutyStats.samples == 0) {
+        return 0;
+    }
+    return (u32)(((u64)dutyStats.radioOnMs * 1000) / dutyStats.samples);
+}
+
+void printDutyCycleStats(void) {
+    if(dutyStats.period == 0 && dutyStats.wakes == 0 && dutyStats.wakeFailures == 0) {
+        return;
+    }
+    xil_printf("Duty: period %d s, %d wakes (last %d ms), %d failed, %d rejoins, radio on %d ms off %d ms, %d samples, %d us on per sample\n\r",
+        dutyStats.period, dutyStats.wakes, dutyStats.lastWakeMs,
+        dutyStats.wakeFailures, dutyStats.rejoins, dutyStats.radioOnMs,
+        dutyStats.radioOffMs, dutyStats.samples, onTimePerSample());
+}
+
+    // duty on <period s> | off | status
+static int dutyCommand(int argc, char ** argv, char * reply, int replySize) {
+    if(argc == 3 && strcmp(argv[1], "on") == 0) {
+        u32 periodS = strtoul(argv[2], NULL, 0);
+        if(periodS == 0 || setDutyCycle(periodS) != XST_SUCCESS) {
+            return snprintf(reply, replySize, "ERR period must be 1 to %d s\r\n", DUTY_MAX_PERIOD_S);
+        }
+        return snprintf(reply, replySize, "OK\r\n");
+    }
+    if(argc == 2 && strcmp(argv[1], "off") == 0) {
+        setDutyCycle(0);
+        return snprintf(reply, replySize, "OK\r\n");
+    }
+    if(argc == 2 && strcmp(argv[1], "status") == 0) {
+        return snprintf(reply, replySize,
+            "OK period %u wakes %u last %u ms failed %u rejoins %u on %u ms off %u ms samples %u on/sample %u us\r\n",
+            (unsigned)dutyStats.period, (unsigned)dutyStats.wakes,
+            (unsigned)dutyStats.lastWakeMs, (unsigned)dutyStats.wakeFailures,
+            (unsigned)dutyStats.rejoins, (unsigned)dutyStats.radioOnMs,
+            (unsigned)dutyStats.radioOffMs, (unsigned)dutyStats.samples,
+            (unsigned)onTimePerSample());
+    }
+    return snprintf(reply, replySize, "ERR usage: duty on <period s> | off | status\r\n");
+}
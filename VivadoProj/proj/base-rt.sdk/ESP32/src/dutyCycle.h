@@ -0,0 +1,114 @@
+/*******************************************************************************
+    Duty-cycled telemetry for boards on a power budget
+
+    The ESP32 radio is by far the largest load on the board. In duty-cycle
+    mode it spends most of its time in deep sleep while capture and XADC
+    acquisition carry on into their rings in DDR (see capture.h and
+    auxAcq.h). The ESP32 is woken once per period, or sooner if a ring
+    would otherwise fill past its watermark, DUTY_WATERMARK_BLOCKS or
+    DUTY_AUX_WATERMARK_BLOCKS, and the backlog goes out in one burst
+    through the send window.
+
+    Only the ESP32's own timer, set with AT+GSLP, can end a deep sleep;
+    nothing on the board can wake it early. The watermark is therefore
+    applied when the sleep is planned: the sleep is cut short to the time
+    a ring takes to fill to its watermark, at the capture sample rate or
+    at the XADC block rate measured since acquisition started. The blocks
+    above the watermark cover the time the wake takes.
+
+    Waking skips the fixed waits of the power on path. The driver waits
+    for the ESP32's "ready" and "WIFI GOT IP", joins through the cached
+    access point (see apScan.h) only if the ESP32 does not rejoin by
+    itself, and opens the TCP connection as soon as AT+CIPSTART answers.
+    The ESP32 goes back to sleep once the backlog is uploaded, every
+    segment's result is in and DUTY_LINGER_MS have passed since the wake
+    or the last command, which gives the collector time to send one.
+
+    While the radio sleeps, alarm events and profile snapshots wait for
+    the next wake, or are dropped as their queues fill, and the status
+    report is not sent.
+
+    Commands over the TCP link:
+        duty on <period s>
+            wake every period seconds, from the end of this wake on
+        duty off
+            keep the radio on
+        duty status
+            wakes, radio on and off time, and radio on time per sample
+*******************************************************************************/
+
+#ifndef DUTYCYCLE_H
+#define DUTYCYCLE_H
+
+#include "xil_printf.h"
+#include "xil_types.h"
+#include "xstatus.h"
+#include "ESP32.h"
+#include "capture.h"
+#include "auxAcq.h"
+
+/****************************** DUTY CYCLE CONFIGURATION **********************/
+    // Blocks each ring may hold before the radio has to be up
+#define DUTY_WATERMARK_BLOCKS   (CAPTURE_NUM_BLOCKS * 3 / 4)
+#define DUTY_AUX_WATERMARK_BLOCKS (AUX_NUM_BLOCKS * 3 / 4)
+#define DUTY_LINGER_MS          500
+#define DUTY_MIN_SLEEP_MS       1000
+#define DUTY_MAX_PERIOD_S       3600
+    // Period to run duty-cycled with from power on, in s; 0 keeps the
+    // radio on until the "duty" command says otherwise
+#ifndef DUTY_BOOT_PERIOD_S
+#define DUTY_BOOT_PERIOD_S      0
+#endif
+
+typedef struct {
+    u32 period;         // s, 0 while the radio stays on
+    u32 asleep;
+    u32 wakes;          // wakes that got the connection up
+    u32 wakeFailures;   // no ready, network or connection; slept again
+    u32 rejoins;        // wakes that had to join with connectToAP
+    u32 lastWakeMs;     // end of the last sleep to the connection being up
+    u32 radioOnMs;      // ESP32 awake, over completed duty cycles
+    u32 radioOffMs;     // ESP32 in deep sleep
+    u32 samples;        // capture and XADC, uploaded during those cycles
+} DutyCycleStats;
+
+/**
+ * Registers the "duty" command. Duty cycling stays off until
+ * setDutyCycle
+ *
+ * returns XST_SUCCESS in case of success
+ * returns XST_FAILURE if the command could not be registered
+ */
+int initDutyCycle(void);
+
+/**
+ * Wakes the radio every periodS seconds from now on, or keeps it on
+ * for a periodS of 0. The first sleep starts once the link is idle
+ *
+ * returns XST_SUCCESS in case of success
+ * returns XST_INVALID_PARAM if periodS is above DUTY_MAX_PERIOD_S
+ */
+int setDutyCycle(u32 periodS);
+
+/**
+ * Puts the ESP32 to sleep once the link is idle and wakes it and
+ * reconnects when the sleep is over. Call from the main loop, ahead of
+ * anything that uses the link
+ *
+ * returns non-zero while the TCP connection is up, 0 while the radio
+ * sleeps
+ */
+int serviceDutyCycle(Uart * devicePtr);
+
+/**
+ * Copies the duty cycle counters
+ */
+void getDutyCycleStats(DutyCycleStats * stats);
+
+/**
+ * Prints the duty cycle counters to the USB/UART port, if duty cycling
+ * has been used
+ */
+void printDutyCycleStats(void);
+
+#endif  /* end of protection macro */
@@ -1,21 +1,80 @@
 #include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
 #include "platform.h"
 #include "xil_printf.h"
 #include <unistd.h>
 #include "xgpio.h"
 #include "xil_io.h"
 #include "ESP32.h"
+#include "sysTimer.h"
+#include "pool.h"
+#include "capture.h"
+#include "command.h"
+#include "pwmSeq.h"
+#include "alarm.h"
+#include "auxAcq.h"
+#include "profExport.h"
+#include "apScan.h"
+#include "configStore.h"
+#include "dutyCycle.h"
+#include "stackCheck.h"
 
 /************ Function Definition ************/
 void populateStatus(char * status_msg, int led_value, int btn_value, int sw_value);
+static int ledCommand(int argc, char ** argv, char * reply, int replySize);
+static int switchCommand(int argc, char ** argv, char * reply, int replySize);
+static int statsCommand(int argc, char ** argv, char * reply, int replySize);
+ISR_INLINE void latchInputs(void);
+#if USE_FAST_INTERRUPTS
+static void inputFastHandler(void) FAST_ISR;
+#else
+static void inputHandler(void * CallBackRef);
+#endif
 
 /************ Global Variables ************/
-INTC intc;
-Uart ESP_32;
+INTC intc FAST_BSS;
+Uart ESP_32 FAST_BSS;
+XTmrCtr timer;
+XGpio LEDS, INS;
+XSpi adcSpi;
+XSpi flashSpi;
+XSysMon xadc;
+
+    // Updated by the input GPIO interrupt whenever a button or switch changes
+static volatile u32 btnState FAST_BSS;
+static volatile u32 swState FAST_BSS;
+    // LED value set with the "led" command, -1 while the status cycle
+    // counts on the LEDs
+static s32 ledOverride = -1;
+    // Status messages skipped for want of a pool buffer
+static u32 statusDropped;
+
+    // Printed to the USB/UART port with every status message. At 115200
+    // baud they take some 35 ms together, so queued commands are run
+    // between them rather than after all of them
+static void (* const consoleReports[])(void) = {
+    printIsrLatency, printPoolStats, printCaptureStats, printESP32LinkStats,
+    printDutyCycleStats,
+};
+#define NUM_CONSOLE_REPORTS     (sizeof(consoleReports) / sizeof(consoleReports[0]))
+
+    // Runs the commands that came in while the loop was busy elsewhere
+static void serviceLinkCommands(Uart * devicePtr) {
+    echoESP32Responses();
+    serviceCommands(devicePtr);
+}
 
 int main() {
 
     int status;
+    // Nothing below main has used the stack yet
+    paintStack();
+    // Must come next: copies the BRAM sections the ISRs run from
+    init_platform();
+    initPool();
+
     // Initializes UART for AT command control of ESP
     Uart * esp_device = &ESP_32;
 	status = initATCtrl(UARTLITE_DEVICE_ID, esp_device, &intc);
@@ -23,13 +82,13 @@ int main() {
     	xil_printf("Error setting up UART/Interrupt\n\r");
     	return XST_FAILURE;
     }
-
-
-    init_platform();
+    initCommands();
+    addCommand("led", ledCommand);
+    addCommand("sw", switchCommand);
+    addCommand("stats", statsCommand);
 
     xil_printf("Setting up GPIOS\n\r");
     XGpio_Config * led_config = XGpio_LookupConfig(XPAR_AXI_GPIO_LED_DEVICE_ID);
-    XGpio LEDS, INS;
     XGpio_CfgInitialize(&LEDS, led_config, XPAR_AXI_GPIO_LED_BASEADDR);
     XGpio_SetDataDirection(&LEDS, 1, 0);
 
@@ -37,45 +96,200 @@ int main() {
     XGpio_CfgInitialize(&INS, in_config, XPAR_AXI_GPIO_INPUT_BASEADDR);
     XGpio_SetDataDirection(&INS, 1, -1);
     XGpio_SetDataDirection(&INS, 2, -1);
+    latchInputs();
 
+#if USE_FAST_INTERRUPTS
+    status = XIntc_ConnectFastHandler(&intc, XPAR_INTC_0_GPIO_0_VEC_ID,
+               inputFastHandler);
+#else
+    status = XIntc_Connect(&intc, XPAR_INTC_0_GPIO_0_VEC_ID,
+               (XInterruptHandler)inputHandler, (void *)&INS);
+#endif
+    if(status != XST_SUCCESS) {
+    	xil_printf("Error connecting GPIO interrupt\n\r");
+    	return XST_FAILURE;
+    }
+    XGpio_InterruptEnable(&INS, XGPIO_IR_CH1_MASK | XGPIO_IR_CH2_MASK);
+    XGpio_InterruptGlobalEnable(&INS);
+    XIntc_Enable(&intc, XPAR_INTC_0_GPIO_0_VEC_ID);
 
+    status = initSysTimer(&timer, &intc, TICK_HZ);
+    if(status != XST_SUCCESS) {
+    	xil_printf("Error setting up timer\n\r");
+    	return XST_FAILURE;
+    }
+
+    status = initCapture(&adcSpi);
+    if(status != XST_SUCCESS) {
+    	xil_printf("Error setting up ADC capture\n\r");
+    	return XST_FAILURE;
+    }
+
+    status = initPwmSequencer();
+    if(status != XST_SUCCESS) {
+    	xil_printf("Error setting up PWM sequencer\n\r");
+    	return XST_FAILURE;
+    }
+
+    status = initAlarms(&xadc, &intc);
+    if(status != XST_SUCCESS) {
+    	xil_printf("Error setting up XADC alarms\n\r");
+    	return XST_FAILURE;
+    }
+
+    status = initAuxAcq(&xadc);
+    if(status != XST_SUCCESS) {
+    	xil_printf("Error setting up XADC acquisition\n\r");
+    	return XST_FAILURE;
+    }
+
+    status = initProfileExport(PROF_DEFAULT_PERIOD);
+    if(status != XST_SUCCESS) {
+    	xil_printf("Error setting up profile export\n\r");
+    	return XST_FAILURE;
+    }
+
+    status = initSpiFlash(&flashSpi);
+    if(status != XST_SUCCESS) {
+    	xil_printf("Error setting up config flash\n\r");
+    	return XST_FAILURE;
+    }
+
+    status = initConfigStore();
+    if(status != XST_SUCCESS) {
+    	xil_printf("Error setting up config store\n\r");
+    	return XST_FAILURE;
+    }
+    BoardConfig config;
+    getConfig(&config);
+
+    status = initDutyCycle();
+    if(status != XST_SUCCESS) {
+    	xil_printf("Error setting up duty cycling\n\r");
+    	return XST_FAILURE;
+    }
 
     // Reset the device
     xil_printf("Attempting to reset device\n\r");
     resetESP32(esp_device);
-    usleep(6000000);
+    waitForESP32(6000000);
     xil_printf("Reset Complete\n\n\r");
 
-    // Get Version Info for the AT firmware
-    checkVersionInfo(esp_device);
-    usleep(3000000);
+    // Get Version Info for the AT firmware; a board with stored
+    // settings has been brought up before and goes straight on
+    if(!isConfigStored()) {
+        checkVersionInfo(esp_device);
+        waitForESP32(3000000);
+    }
 
+        // An empty ssid relies on the ESP32 joining the network it was
+        // last configured for by itself
+    if(config.ssid[0] != '\0' && connectToAP(esp_device, config.ssid, config.pwd) != XST_SUCCESS) {
+        xil_printf("Continuing without joining %s\n\r", config.ssid);
+    }
 
-    char ip[] = "192.168.1.101";
-    xil_printf("Establishing TCP Connection at %s\n\r", ip);
-    establishTCPConnection(esp_device, ip, 5005, 10);
-    usleep(1000000);
-    char status_msg[512];
+    xil_printf("Establishing TCP Connection at %s:%d\n\r", config.host, config.port);
+    establishTCPConnection(esp_device, config.host, config.port, config.keepAlive);
+    char * status_msg;
     int btn_value, sw_value, led_value;
     led_value = 0;
+    int led_on = 0;
+    u32 next_toggle = getTickCount();
+    int link_up;
+    if(startCapture() != XST_SUCCESS) {
+        xil_printf("Capture not started\n\r");
+    }
+    setDutyCycle(DUTY_BOOT_PERIOD_S);
     while(1) {
-    	btn_value = Xil_In32(INS.BaseAddress);
-    	sw_value = Xil_In32(INS.BaseAddress + 8);
-    	populateStatus(status_msg, led_value, btn_value, sw_value);
-    	XGpio_DiscreteWrite(&LEDS, 1, led_value);
-		usleep(1000000);
-		XGpio_DiscreteWrite(&LEDS, 1, 0);
-		usleep(1000000);
+            // Nothing goes out while the radio sleeps in duty-cycle mode,
+            // but XADC blocks are still decimated into their ring.
+            // Alarm events go out first, ahead of anything else queued.
+            // Commands from the TCP peer are run as soon as they arrive,
+            // before the bulk data and again between its frames, so their
+            // round trip waits on at most one capture, XADC or profile
+            // frame; the status report runs on a one second LED on/off
+            // cycle
+        link_up = serviceDutyCycle(esp_device);
+        decimateAuxAcq();
+        if(link_up) {
+            if(serviceAlarms(esp_device)) {
+                continue;
+            }
+            serviceLinkCommands(esp_device);
+            serviceCapture(esp_device);
+            serviceTCPSendWindow(esp_device);
+            serviceLinkCommands(esp_device);
+            serviceAuxAcq(esp_device);
+            serviceLinkCommands(esp_device);
+            serviceProfileExport(esp_device);
+        }
+
+        if((s32)(getTickCount() - next_toggle) < 0) {
+            continue;
+        }
+        next_toggle += TICK_HZ;
+
+        if(!led_on) {
+            XGpio_DiscreteWrite(&LEDS, 1, (ledOverride >= 0) ? ledOverride : led_value);
+            led_on = 1;
+            continue;
+        }
+        if(ledOverride < 0) {
+            XGpio_DiscreteWrite(&LEDS, 1, 0);
+        }
+        led_on = 0;
+
+    	    // Without a buffer this cycle's status message is skipped, but
+    	    // the reports and commands below still run
+    	status_msg = poolAlloc(POOL_MEDIUM_SIZE);
+    	if(status_msg == NULL) {
+    		statusDropped++;
+    	} else {
+    		btn_value = btnState;
+    		sw_value = swState;
+    		populateStatus(status_msg, (ledOverride >= 0) ? ledOverride : led_value,
+    		    btn_value, sw_value);
+    	}
+		for(u32 i = 0; i < NUM_CONSOLE_REPORTS; i++) {
+			consoleReports[i]();
+			if(link_up) {
+				serviceLinkCommands(esp_device);
+			}
+		}
 		led_value = (led_value == 15) ? 0 : led_value + 1;
 
-        TCPsend(esp_device, status_msg, strlen(status_msg));
-        memset(status_msg, 0, 512);
+        if(status_msg != NULL) {
+            if(link_up) {
+                TCPsend(esp_device, status_msg, strlen(status_msg));
+            }
+            poolFree(status_msg);
+        }
     }
 
     cleanup_platform();
     return 0;
 }
 
+    // Reads both input channels and acknowledges the GPIO interrupt
+    // The ISR register is toggle-on-write, so writing back what was
+    // read clears exactly the bits that were set
+ISR_INLINE void latchInputs(void) {
+    u32 pending = ISR_IN32(XPAR_AXI_GPIO_INPUT_BASEADDR + XGPIO_ISR_OFFSET);
+    btnState = ISR_IN32(XPAR_AXI_GPIO_INPUT_BASEADDR + XGPIO_DATA_OFFSET);
+    swState = ISR_IN32(XPAR_AXI_GPIO_INPUT_BASEADDR + XGPIO_DATA2_OFFSET);
+    ISR_OUT32(XPAR_AXI_GPIO_INPUT_BASEADDR + XGPIO_ISR_OFFSET, pending);
+}
+
+#if USE_FAST_INTERRUPTS
+static void inputFastHandler(void) {
+    latchInputs();
+}
+#else
+FAST_CODE static void inputHandler(void * CallBackRef) {
+    latchInputs();
+}
+#endif
+
 /**
  *  Populates the status message buffer with information about the LEDS, buttons,
  *  and switches on the Arty S7. This message will attempt to clear the terminal
@@ -89,3 +303,101 @@ void populateStatus(char * status_msg, int led_value, int btn_value, int sw_valu
     cursor += sprintf(status_msg + cursor, "SW Values  --> SW0: %d\tSW1: %d\tSW2: %d\tSW3: %d\r\n",
         sw_value & 0x01, (sw_value & 0x02) >> 1, (sw_value & 0x04) >> 2, (sw_value & 0x08) >> 3);
 }
+
+    // led [<0-15>|auto]: holds the LEDs at a value, or hands them back
+    // to the status cycle
+static int ledCommand(int argc, char ** argv, char * reply, int replySize) {
+    if(argc == 2 && strcmp(argv[1], "auto") == 0) {
+        ledOverride = -1;
+    } else if(argc == 2) {
+        char * end;
+        u32 value = strtoul(argv[1], &end, 0);
+        if(*end != '\0' || value > 15) {
+            return snprintf(reply, replySize, "ERR led value must be 0 to 15\r\n");
+        }
+        ledOverride = value;
+        XGpio_DiscreteWrite(&LEDS, 1, value);
+    } else if(argc > 2) {
+        return snprintf(reply, replySize, "ERR usage: led [<0-15>|auto]\r\n");
+    }
+    if(ledOverride < 0) {
+        return snprintf(reply, replySize, "OK led auto\r\n");
+    }
+    return snprintf(reply, replySize, "OK led 0x%x\r\n", (unsigned)ledOverride);
+}
+
+    // sw: buttons and switches as last latched by the input interrupt
+static int switchCommand(int argc, char ** argv, char * reply, int replySize) {
+    return snprintf(reply, replySize, "OK btn 0x%x sw 0x%x\r\n",
+        (unsigned)btnState, (unsigned)swState);
+}
+
+    // Appends to a reply, stopping at its end
+static int appendReply(char * reply, int replySize, int length, const char * format, ...) {
+    va_list args;
+    if(length >= replySize - 1) {
+        return length;
+    }
+    va_start(args, format);
+    length += vsnprintf(reply + length, replySize - length, format, args);
+    va_end(args);
+    return length;
+}
+
+    // stats: the counters printed on the USB/UART port, as one reply
+static int statsCommand(int argc, char ** argv, char * reply, int replySize) {
+    CaptureStats capture;
+    ESP32LinkStats link;
+    IsrLatency latency;
+    PoolStats pool;
+    StackStats stack;
+
+    getCaptureStats(&capture);
+    getESP32LinkStats(&link);
+    getIsrLatency(&latency);
+    getStackStats(&stack);
+    u32 elapsed = getTickCount() - capture.startTick;
+    if(elapsed == 0) {
+        elapsed = 1;
+    }
+
+    int length = appendReply(reply, replySize, 0, "OK stats\r\n");
+    length = appendReply(reply, replySize, length,
+        "capture %u samples (%u/s) at %u Hz, %u dropped in %u stalls, %u missed\r\n",
+        (unsigned)capture.samples,
+        (unsigned)(((u64)capture.samples * TICK_HZ) / elapsed),
+        (unsigned)getCaptureRate(), (unsigned)capture.dropped,
+        (unsigned)capture.backpressure, (unsigned)capture.missed);
+    length = appendReply(reply, replySize, length,
+        "upload %u blocks, %u bytes, %u failed\r\n",
+        (unsigned)capture.blocksSent, (unsigned)capture.bytesSent,
+        (unsigned)capture.sendFailures);
+    length = appendReply(reply, replySize, length,
+        "link %u sends, %u bytes, %u SEND FAIL, %u busy, %u timeouts, %u errors, %u dropped\r\n",
+        (unsigned)link.sends, (unsigned)link.bytes, (unsigned)link.sendFails,
+        (unsigned)link.busy, (unsigned)link.timeouts, (unsigned)link.errors,
+        (unsigned)link.dropped);
+    length = appendReply(reply, replySize, length,
+        "window %u segments, %u sent OK, %u SEND FAIL, %u resent, %u lost, %u full\r\n",
+        (unsigned)link.segments, (unsigned)link.segmentsSent,
+        (unsigned)link.segmentFails, (unsigned)link.resends, (unsigned)link.lost,
+        (unsigned)link.windowFull);
+    for(u32 i = 0; i < POOL_NUM_CLASSES; i++) {
+        getPoolStats(i, &pool);
+        length = appendReply(reply, replySize, length,
+            "pool %u B %u/%u in use, high water %u, %u failed\r\n",
+            (unsigned)pool.blockSize, (unsigned)pool.inUse, (unsigned)pool.blockCount,
+            (unsigned)pool.highWater, (unsigned)pool.failures);
+    }
+    length = appendReply(reply, replySize, length,
+        "isr latency last %u min %u max %u cycles over %u ticks\r\n",
+        (unsigned)latency.last, (unsigned)latency.min, (unsigned)latency.max,
+        (unsigned)latency.count);
+    length = appendReply(reply, replySize, length,
+        "stack high water %u of %u bytes\r\n",
+        (unsigned)stack.highWater, (unsigned)stack.size);
+    return appendReply(reply, replySize, length,
+        "commands %u run, %u dropped, rx %u dropped, %u status messages dropped\r\n",
+        (unsigned)getCommandsRun(), (unsigned)getCommandsDropped(),
+        (unsigned)getESP32RxDropped(), (unsigned)statusDropped);
+}
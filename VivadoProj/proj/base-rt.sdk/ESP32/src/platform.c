@@ -32,6 +32,7 @@
 
 #include "xparameters.h"
 #include "xil_cache.h"
+#include "xil_types.h"
 
 #include "platform_config.h"
 
@@ -49,6 +50,30 @@
  #define UART_BAUD 9600
 #endif
 
+/* Section boundaries from lscript.ld */
+extern u32 __fast_text_start[], __fast_text_end[], __fast_text_load[];
+extern u32 __fast_data_start[], __fast_data_end[], __fast_data_load[];
+extern u32 __fast_bss_start[], __fast_bss_end[];
+
+/*
+ * Copies .fast_text and .fast_data from their load address in DDR to the
+ * LMB BRAM and zeroes .fast_bss. The BRAM is not cached, so no cache
+ * maintenance is needed once the copy is done
+ */
+void
+init_fast_sections()
+{
+    u32 *dst;
+    u32 *src;
+
+    for (dst = __fast_text_start, src = __fast_text_load; dst < __fast_text_end; )
+        *dst++ = *src++;
+    for (dst = __fast_data_start, src = __fast_data_load; dst < __fast_data_end; )
+        *dst++ = *src++;
+    for (dst = __fast_bss_start; dst < __fast_bss_end; )
+        *dst++ = 0;
+}
+
 void
 enable_caches()
 {
@@ -100,6 +125,7 @@ init_platform()
      */
     /* ps7_init();*/
     /* psu_init();*/
+    init_fast_sections();
     enable_caches();
     init_uart();
 }
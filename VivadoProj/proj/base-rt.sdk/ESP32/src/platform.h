@@ -34,8 +34,28 @@
 #define __PLATFORM_H_
 
 #include "platform_config.h"
+#include "xil_types.h"
+#include "mb_interface.h"
+
+#define MSR_IE_MASK     0x00000002
 
 void init_platform();
 void cleanup_platform();
 
+/*
+ * Masks interrupts and returns the previous MSR, so that critical sections
+ * nest and can be entered from ISRs as well as the main loop
+ */
+static inline u32 enter_critical()
+{
+    u32 msr = mfmsr();
+    mtmsr(msr & ~MSR_IE_MASK);
+    return msr;
+}
+
+static inline void exit_critical(u32 msr)
+{
+    mtmsr(msr);
+}
+
 #endif
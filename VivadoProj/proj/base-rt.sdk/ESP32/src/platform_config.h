@@ -1,4 +1,72 @@
 #ifndef __PLATFORM_CONFIG_H_
 #define __PLATFORM_CONFIG_H_
 
+/**
+ * Set to 1 to have the ESP32 UART, input GPIO and timer interrupts vectored
+ * directly by the AXI INTC (MicroBlaze fast interrupt mode). Set to 0 to fall
+ * back on XIntc_InterruptHandler, which scans the pending bits and calls
+ * through the vector table. The timer ISR records entry latency either way,
+ * so the two builds can be compared with printIsrLatency()
+ */
+#ifndef USE_FAST_INTERRUPTS
+#define USE_FAST_INTERRUPTS     1
+#endif
+
+/**
+ * Set to 1 to place code and data annotated with FAST_CODE, FAST_DATA and
+ * FAST_BSS in the LMB BRAM. Everything else lives in DDR behind the 8 KB
+ * caches. Set to 0 to leave the annotated objects in DDR as well
+ *
+ * .fast_text and .fast_data are loaded into DDR with the rest of the image
+ * and copied into BRAM by init_platform(), which must run before interrupts
+ * are enabled. .fast_bss is zeroed there too
+ */
+#ifndef USE_FAST_SECTIONS
+#define USE_FAST_SECTIONS       1
+#endif
+
+#if USE_FAST_SECTIONS
+#define FAST_CODE               __attribute__((section(".fast_text")))
+#define FAST_DATA               __attribute__((section(".fast_data")))
+#define FAST_BSS                __attribute__((section(".fast_bss")))
+#else
+#define FAST_CODE
+#define FAST_DATA
+#define FAST_BSS
+#endif
+
+/**
+ * Objects annotated with PERSIST_BSS live in .noinit, which is neither
+ * loaded nor zeroed, so they keep their contents across a processor reset
+ * but not a power cycle or reconfiguration. Whoever owns one must check
+ * it is valid before use
+ */
+#define PERSIST_BSS             __attribute__((section(".noinit")))
+
+/**
+ * Fast interrupt handlers are entered straight from the hardware vector and
+ * return with rtid, saving only the registers they use
+ */
+#define FAST_ISR                __attribute__((fast_interrupt)) FAST_CODE
+
+/**
+ * The application is built at -O0, where plain inline is ignored. Bodies
+ * shared between a fast handler and its normal-mode twin are forced inline
+ * so that the fast handler does not pay for a call and a full register save
+ */
+#define ISR_INLINE              static inline __attribute__((always_inline))
+
+/**
+ * Register accesses for fast handler bodies. Xil_In32 and Xil_Out32, and
+ * the driver ReadReg/WriteReg macros built on them, are static inline
+ * functions that -O0 emits out of line into each object's DDR .text, so a
+ * handler using them calls into DDR and saves every volatile register.
+ * These are a single lwi or swi. The host simulation (ESP32_sim) defines
+ * them first, to reach its device models
+ */
+#ifndef ISR_IN32
+#define ISR_IN32(addr)          (*(volatile u32 *)(UINTPTR)(addr))
+#define ISR_OUT32(addr, value)  (*(volatile u32 *)(UINTPTR)(addr) = (u32)(value))
+#endif
+
 #endif
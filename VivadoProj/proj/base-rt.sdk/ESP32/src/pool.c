@@ -0,0 +1,145 @@
+/*******************************************************************************
+    Fixed-block pool allocator, see pool.h
+*******************************************************************************/
+
+#include "pool.h"
+#include "platform.h"
+#include "xil_assert.h"
+
+#if POOL_SMALL_COUNT > 32 || POOL_MEDIUM_COUNT > 32 || POOL_LARGE_COUNT > 32
+#error "A pool class has more blocks than its free mask has bits"
+#endif
+
+#if POOL_IN_BRAM
+#define POOL_STORAGE            FAST_BSS
+#else
+#define POOL_STORAGE
+#endif
+
+    // A free block holds the link to the next free block in its first word
+typedef struct PoolBlock {
+    struct PoolBlock * next;
+} PoolBlock;
+
+typedef struct {
+    u8 * start;
+    u8 * end;
+    PoolBlock * freeList;
+    u32 freeMask;       // bit per block, set while it is free
+    PoolStats stats;
+} PoolClass;
+
+static u32 smallStorage[POOL_SMALL_SIZE * POOL_SMALL_COUNT / 4] POOL_STORAGE;
+static u32 mediumStorage[POOL_MEDIUM_SIZE * POOL_MEDIUM_COUNT / 4] POOL_STORAGE;
+static u32 largeStorage[POOL_LARGE_SIZE * POOL_LARGE_COUNT / 4] POOL_STORAGE;
+
+static PoolClass poolClasses[POOL_NUM_CLASSES] FAST_BSS;
+
+static void initClass(PoolClass * pool, u32 * storage, u32 blockSize, u32 blockCount) {
+    u8 * block = (u8 *)storage;
+    pool->start = block;
+    pool->end = block + blockSize * blockCount;
+    pool->freeList = NULL;
+    pool->freeMask = 0;
+        // Push in reverse so the first allocation gets the lowest address
+    for(int i = blockCount - 1; i >= 0; i--) {
+        PoolBlock * free = (PoolBlock *)(block + i * blockSize);
+        free->next = pool->freeList;
+        pool->freeList = free;
+        pool->freeMask |= 1U << i;
+    }
+    pool->stats.blockSize = blockSize;
+    pool->stats.blockCount = blockCount;
+    pool->stats.inUse = 0;
+    pool->stats.highWater = 0;
+    pool->stats.failures = 0;
+}
+
+void initPool(void) {
+    u32 msr = enter_critical();
+    initClass(&poolClasses[0], smallStorage, POOL_SMALL_SIZE, POOL_SMALL_COUNT);
+    initClass(&poolClasses[1], mediumStorage, POOL_MEDIUM_SIZE, POOL_MEDIUM_COUNT);
+    initClass(&poolClasses[2], largeStorage, POOL_LARGE_SIZE, POOL_LARGE_COUNT);
+    exit_critical(msr);
+}
+
+FAST_CODE void * poolAlloc(u32 size) {
+    PoolBlock * block = NULL;
+    PoolClass * firstFit = NULL;
+    u32 msr = enter_critical();
+        // Fall through to a larger class when the best fit is exhausted
+    for(int i = 0; i < POOL_NUM_CLASSES; i++) {
+        PoolClass * pool = &poolClasses[i];
+        if(size > pool->stats.blockSize) {
+            continue;
+        }
+        if(firstFit == NULL) {
+            firstFit = pool;
+        }
+        if(pool->freeList == NULL) {
+            continue;
+        }
+        block = pool->freeList;
+        pool->freeList = block->next;
+        pool->freeMask &= ~(1U << (((u8 *)block - pool->start) / pool->stats.blockSize));
+        pool->stats.inUse++;
+        if(pool->stats.inUse > pool->stats.highWater) {
+            pool->stats.highWater = pool->stats.inUse;
+        }
+        break;
+    }
+    if(block == NULL && firstFit != NULL) {
+        firstFit->stats.failures++;
+    }
+    exit_critical(msr);
+    return block;
+}
+
+FAST_CODE void poolFree(void * block) {
+    PoolClass * pool = NULL;
+    if(block == NULL) {
+        return;
+    }
+        // The class bounds never change after initPool
+    for(int i = 0; i < POOL_NUM_CLASSES && pool == NULL; i++) {
+        if((u8 *)block >= poolClasses[i].start && (u8 *)block < poolClasses[i].end) {
+            pool = &poolClasses[i];
+        }
+    }
+    Xil_AssertVoid(pool != NULL);
+    u32 offset = (u8 *)block - pool->start;
+    Xil_AssertVoid(offset % pool->stats.blockSize == 0);
+    u32 bit = 1U << (offset / pool->stats.blockSize);
+
+    u32 msr = enter_critical();
+    u32 wasFree = pool->freeMask & bit;
+    if(!wasFree) {
+        PoolBlock * free = (PoolBlock *)block;
+        free->next = pool->freeList;
+        pool->freeList = free;
+        pool->freeMask |= bit;
+        pool->stats.inUse--;
+    }
+    exit_critical(msr);
+    Xil_AssertVoid(!wasFree);
+}
+
+int getPoolStats(u32 classIndex, PoolStats * stats) {
+    if(classIndex >= POOL_NUM_CLASSES) {
+        return XST_FAILURE;
+    }
+    u32 msr = enter_critical();
+    *stats = poolClasses[classIndex].stats;
+    exit_critical(msr);
+    return XST_SUCCESS;
+}
+
+void printPoolStats(void) {
+    PoolStats stats;
+    for(u32 i = 0; i < POOL_NUM_CLASSES; i++) {
+        getPoolStats(i, &stats);
+        xil_printf("Pool %d B: %d/%d in use, high water %d, %d failed\n\r",
+            stats.blockSize, stats.inUse, stats.blockCount,
+            stats.highWater, stats.failures);
+    }
+}
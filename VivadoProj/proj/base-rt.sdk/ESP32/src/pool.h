@@ -0,0 +1,83 @@
+/*******************************************************************************
+    Fixed-block pool allocator for packet and command buffers
+
+    Blocks come in a few size classes, each carved out of its own static
+    array at startup. Allocation and free are O(1) pops and pushes on a
+    per-class free list, done with interrupts masked, so buffers can be
+    taken and returned from ISRs as well as the main loop. Nothing here
+    touches the newlib heap, which is only 2 KB.
+
+    Each class keeps a bit per block that is set while the block is free.
+    poolFree asserts (Xil_AssertVoid) on a pointer outside every class,
+    one that is not the start of a block, and a block that is already
+    free, and leaves the free lists alone in each case.
+*******************************************************************************/
+
+#ifndef POOL_H
+#define POOL_H
+
+#include "xil_printf.h"
+#include "xil_types.h"
+#include "xstatus.h"
+#include "platform_config.h"
+
+/****************************** POOL CONFIGURATION ****************************/
+    // Block sizes must be multiples of 4 and listed smallest first, and
+    // no class may have more than 32 blocks
+#define POOL_SMALL_SIZE         64
+#define POOL_SMALL_COUNT        32
+#define POOL_MEDIUM_SIZE        256
+#define POOL_MEDIUM_COUNT       16
+#define POOL_LARGE_SIZE         1024
+#define POOL_LARGE_COUNT        8
+
+#define POOL_NUM_CLASSES        3
+
+    // Set to 1 to carve the pools out of LMB BRAM instead of DDR
+#ifndef POOL_IN_BRAM
+#define POOL_IN_BRAM            0
+#endif
+
+typedef struct {
+    u32 blockSize;
+    u32 blockCount;
+    u32 inUse;
+    u32 highWater;
+    u32 failures;
+} PoolStats;
+
+/**
+ * Builds the free lists. Must be called before any other pool function,
+ * and before any ISR that allocates is enabled
+ */
+void initPool(void);
+
+/**
+ * Returns a block of at least size bytes from the smallest class that
+ * fits and has a free block, or NULL if none does
+ *
+ * Safe to call from an ISR
+ */
+void * poolAlloc(u32 size);
+
+/**
+ * Returns a block obtained from poolAlloc. Passing NULL does nothing.
+ * Asserts on anything else that poolAlloc did not return, or on a
+ * block freed twice
+ *
+ * Safe to call from an ISR
+ */
+void poolFree(void * block);
+
+/**
+ * Copies the usage statistics of size class classIndex
+ * returns XST_FAILURE if classIndex is out of range
+ */
+int getPoolStats(u32 classIndex, PoolStats * stats);
+
+/**
+ * Prints the usage statistics of every class to the USB/UART port
+ */
+void printPoolStats(void);
+
+#endif  /* end of protection macro */
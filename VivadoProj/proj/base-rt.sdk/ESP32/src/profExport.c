@@ -0,0 +1,427 @@
+/*******************************************************************************
+    Wireless export of gprof profiling data, see profExport.h
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "profExport.h"
+#include "command.h"
+#include "pool.h"
+#include "platform.h"
+#include "xil_exception.h"
+#if PROFILE_CALL_GRAPH
+#include "profile.h"
+#endif
+
+    // Every frame is built in one large pool block
+#define HIST_CHUNK_BINS \
+    ((POOL_LARGE_SIZE - sizeof(ProfFrameHeader) - sizeof(ProfHist)) / sizeof(u16))
+#define ARCS_PER_FRAME \
+    ((POOL_LARGE_SIZE - sizeof(ProfFrameHeader)) / sizeof(ProfArc))
+
+#define SEND_IDLE               0
+#define SEND_BEGIN              1
+#define SEND_HIST               2
+#define SEND_ARCS               3
+#define SEND_END                4
+
+typedef struct {
+    u32 lowpc;
+    u32 span;           // bytes covered by the bins
+    u32 binShift;
+    u32 totalBins;
+} ProfSection;
+
+extern u32 __fast_text_start[], __fast_text_end[];
+extern u32 __text_start[], __text_end[];
+
+static void profileTick(void) FAST_CODE;
+static int profCommand(int argc, char ** argv, char * reply, int replySize);
+
+static u16 hist[2][PROF_SECTIONS][PROF_MAX_BINS];
+
+    // The tick hook samples into hist[active]; active is swapped from the
+    // main loop only inside a critical section
+static ProfSection sections[PROF_SECTIONS] FAST_BSS;
+static volatile u32 active FAST_BSS;
+static volatile u32 sampling FAST_BSS;
+static volatile u32 samples FAST_BSS;
+static volatile u32 outside FAST_BSS;
+
+#if PROFILE_CALL_GRAPH
+static struct gmonparam gmon[2][PROF_SECTIONS];
+static struct fromstruct froms[2][PROF_SECTIONS][PROF_MAX_FROMS];
+static struct tostruct tos[2][PROF_SECTIONS][PROF_MAX_TOS];
+static u32 lastOverflows;
+#endif
+
+    // Main loop only
+static u32 period;
+static u32 periodStart;
+static u32 snapshot;
+static u32 retired;
+static u32 sendState;
+static u32 sendSection;
+static u32 sendBin;
+    // The frame queued last was a PROF_FRAME_BEGIN
+static u32 beginQueued;
+#if PROFILE_CALL_GRAPH
+static u32 sendFrom;
+static s32 sendLink;
+static u32 chainOpen;
+#endif
+static ProfBegin begin;
+static ProfEnd end;
+static ProfExportStats profStats;
+
+static void initSection(ProfSection * section, u32 lowpc, u32 highpc) {
+    u32 shift = PROF_MIN_BIN_SHIFT;
+    while(((highpc - lowpc + (1 << shift) - 1) >> shift) > PROF_MAX_BINS) {
+        shift++;
+    }
+    section->lowpc = lowpc;
+    section->binShift = shift;
+    section->totalBins = (highpc - lowpc + (1 << shift) - 1) >> shift;
+    section->span = section->totalBins << shift;
+}
+
+#if PROFILE_CALL_GRAPH
+    // Empties the call-graph tables of buffer buf
+static void resetGmon(u32 buf) {
+    for(u32 s = 0; s < PROF_SECTIONS; s++) {
+        struct gmonparam * p = &gmon[buf][s];
+        p->state = GMON_PROF_ON;
+        p->kcount = hist[buf][s];
+        p->kcountsize = sections[s].totalBins;
+        p->froms = froms[buf][s];
+        p->fromssize = 0;
+        p->tos = &tos[buf][s][PROF_MAX_TOS];
+        p->tossize = 0;
+        p->lowpc = sections[s].lowpc;
+        p->highpc = sections[s].lowpc + sections[s].span;
+        p->textsize = sections[s].span;
+    }
+}
+#endif
+
+int initProfileExport(u32 periodTicks) {
+    initSection(&sections[0], (u32)__fast_text_start, (u32)__fast_text_end);
+    initSection(&sections[1], (u32)__text_start, (u32)__text_end);
+    for(u32 s = 0; s < PROF_SECTIONS; s++) {
+        profStats.binShift[s] = sections[s].binShift;
+    }
+    active = 0;
+    sendState = SEND_IDLE;
+
+#if PROFILE_CALL_GRAPH
+        // Left alone if a debugger has already set up the tables
+    if(_gmonparam == GMONPARAM_UNSET) {
+        resetGmon(0);
+        resetGmon(1);
+        profile_cg_max_froms = PROF_MAX_FROMS;
+        profile_cg_max_tos = PROF_MAX_TOS;
+            // The BSP profile timer is not running, the tick samples instead
+        profile_cg_pause_timer = 0;
+        u32 msr = enter_critical();
+        _gmonparam = gmon[active];
+        n_gmon_sections = PROF_SECTIONS;
+        profile_cg_reset();
+        exit_critical(msr);
+        profStats.callGraph = 1;
+    }
+#endif
+
+    if(addTickHook(profileTick) != XST_SUCCESS) {
+        xil_printf("Could not register profiling tick\n\r");
+        return XST_FAILURE;
+    }
+    if(addCommand("prof", profCommand) != XST_SUCCESS) {
+        xil_printf("Could not register prof command\n\r");
+        return XST_FAILURE;
+    }
+    setProfileExportPeriod(periodTicks);
+    return XST_SUCCESS;
+}
+
+void setProfileExportPeriod(u32 periodTicks) {
+        // Once sampling stops the active histograms can be cleared
+        // without racing the tick hook
+    sampling = 0;
+    memset(hist[active], 0, sizeof(hist[active]));
+#if PROFILE_CALL_GRAPH
+    if(profStats.callGraph) {
+        u32 msr = enter_critical();
+        resetGmon(active);
+        profile_cg_reset();
+        lastOverflows = profile_cg_overflows;
+        exit_critical(msr);
+    }
+#endif
+    samples = 0;
+    outside = 0;
+    period = periodTicks;
+    periodStart = getTickCount();
+    profStats.period = periodTicks;
+    sampling = (periodTicks != 0);
+}
+
+static void profileTick(void) {
+    if(!sampling) {
+        return;
+    }
+    u32 pc = getTickPC();
+    for(u32 s = 0; s < PROF_SECTIONS; s++) {
+        u32 offset = pc - sections[s].lowpc;
+        if(offset < sections[s].span) {
+            u16 * bin = &hist[active][s][offset >> sections[s].binShift];
+            if(*bin != 0xFFFF) {
+                (*bin)++;
+            }
+            samples++;
+            return;
+        }
+    }
+    outside++;
+}
+
+    // Swaps in the cleared buffers and sets up sending of the retired ones
+static void takeSnapshot(void) {
+    u32 now = getTickCount();
+
+    u32 msr = enter_critical();
+    retired = active;
+    active = retired ^ 1;
+    begin.samples = samples;
+    begin.outside = outside;
+    samples = 0;
+    outside = 0;
+#if PROFILE_CALL_GRAPH
+    if(profStats.callGraph) {
+        _gmonparam = gmon[active];
+        profile_cg_reset();
+    }
+    end.overflows = profile_cg_overflows - lastOverflows;
+    lastOverflows = profile_cg_overflows;
+#else
+    end.overflows = 0;
+#endif
+    exit_critical(msr);
+
+    begin.profRate = TICK_HZ;
+    begin.firstTick = periodStart;
+    begin.ticks = now - periodStart;
+    begin.sections = PROF_SECTIONS;
+    begin.callGraph = profStats.callGraph;
+    end.arcs = 0;
+    periodStart = now;
+
+    snapshot++;
+    profStats.snapshots = snapshot;
+    sendState = SEND_BEGIN;
+    sendSection = 0;
+    sendBin = 0;
+#if PROFILE_CALL_GRAPH
+    sendFrom = 0;
+    chainOpen = 0;
+#endif
+}
+
+    // Fills the payload with the next chunk of the current section that
+    // has samples, clearing it for reuse. Looks at one chunk per call
+    // to bound the time spent on empty ones
+static u32 nextHistChunk(ProfFrameHeader * header, u8 * payload) {
+    ProfSection * section = &sections[sendSection];
+    if(sendBin >= section->totalBins) {
+        sendSection++;
+        sendBin = 0;
+        return 0;
+    }
+
+    u16 * bins = &hist[retired][sendSection][sendBin];
+    u32 count = section->totalBins - sendBin;
+    if(count > HIST_CHUNK_BINS) {
+        count = HIST_CHUNK_BINS;
+    }
+    u32 first = sendBin;
+    sendBin += count;
+
+    u32 i = 0;
+    while(i < count && bins[i] == 0) {
+        i++;
+    }
+    if(i == count) {
+        return 0;
+    }
+
+    ProfHist * chunk = (ProfHist *)payload;
+    chunk->lowpc = section->lowpc;
+    chunk->highpc = section->lowpc + section->span;
+    chunk->totalBins = section->totalBins;
+    chunk->firstBin = first;
+    memcpy(chunk + 1, bins, count * sizeof(u16));
+    memset(bins, 0, count * sizeof(u16));
+
+    header->type = PROF_FRAME_HIST;
+    header->section = sendSection;
+    return sizeof(ProfHist) + count * sizeof(u16);
+}
+
+#if PROFILE_CALL_GRAPH
+    // Fills the payload with the next arcs of the current section by
+    // walking each from entry's chain of tos entries, then empties the
+    // section's tables once the last arc has been copied
+static u32 nextArcs(ProfFrameHeader * header, u8 * payload) {
+    struct gmonparam * p = &gmon[retired][sendSection];
+    ProfArc * arcs = (ProfArc *)payload;
+    u32 n = 0;
+
+    while(n < ARCS_PER_FRAME && sendFrom < p->fromssize) {
+        if(!chainOpen) {
+            sendLink = p->froms[sendFrom].link;
+            chainOpen = 1;
+        }
+        if(sendLink == -1) {
+            sendFrom++;
+            chainOpen = 0;
+            continue;
+        }
+            // tos grows downwards, a link counts from the oldest entry
+        struct tostruct * to = &p->tos[(s32)p->tossize - sendLink - 1];
+        arcs[n].frompc = p->froms[sendFrom].frompc;
+        arcs[n].selfpc = to->selfpc;
+        arcs[n].count = to->count;
+        n++;
+        sendLink = to->link;
+    }
+
+    if(sendFrom >= p->fromssize) {
+        p->fromssize = 0;
+        p->tos = &tos[retired][sendSection][PROF_MAX_TOS];
+        p->tossize = 0;
+        sendSection++;
+        sendFrom = 0;
+        chainOpen = 0;
+    }
+    if(n == 0) {
+        return 0;
+    }
+    end.arcs += n;
+    header->type = PROF_FRAME_ARCS;
+    header->section = sendSection;
+    return n * sizeof(ProfArc);
+}
+#endif
+
+    // Advances the snapshot state machine by one step
+    // returns the payload length of the frame built, or 0 for none
+static u32 nextFrame(ProfFrameHeader * header, u8 * payload) {
+    switch(sendState) {
+    case SEND_BEGIN:
+        header->type = PROF_FRAME_BEGIN;
+        memcpy(payload, &begin, sizeof(ProfBegin));
+        sendState = SEND_HIST;
+        return sizeof(ProfBegin);
+    case SEND_HIST:
+        if(sendSection < PROF_SECTIONS) {
+            return nextHistChunk(header, payload);
+        }
+        sendSection = 0;
+        sendState = profStats.callGraph ? SEND_ARCS : SEND_END;
+        return 0;
+#if PROFILE_CALL_GRAPH
+    case SEND_ARCS:
+        if(sendSection < PROF_SECTIONS) {
+            return nextArcs(header, payload);
+        }
+        sendState = SEND_END;
+        return 0;
+#endif
+    default:
+        header->type = PROF_FRAME_END;
+        memcpy(payload, &end, sizeof(ProfEnd));
+        sendState = SEND_IDLE;
+        return sizeof(ProfEnd);
+    }
+}
+
+    // Result of a frame queued with TCPsendBuffered
+static void frameSent(u32 segment, int status) {
+    if(status == XST_SUCCESS) {
+        profStats.framesSent++;
+    } else {
+        profStats.sendFailures++;
+    }
+}
+
+int serviceProfileExport(Uart * devicePtr) {
+    if(sendState == SEND_IDLE) {
+        if(period == 0 || (s32)(getTickCount() - periodStart) < (s32)period) {
+            return 0;
+        }
+        takeSnapshot();
+    }
+
+        // A frame resent after a SEND FAIL arrives behind those queued
+        // after it. HIST and ARCS frames may come in any order, but
+        // the collector needs BEGIN ahead of them and END after them, so
+        // BEGIN, the frame after it and END wait for the window to drain
+    if((sendState == SEND_BEGIN || sendState == SEND_END || beginQueued) &&
+            !isTCPSendWindowIdle()) {
+        return 0;
+    }
+
+    u8 * frame = poolAlloc(POOL_LARGE_SIZE);
+    if(frame == NULL) {
+        return 0;
+    }
+    ProfFrameHeader * header = (ProfFrameHeader *)frame;
+    header->magic = PROF_MAGIC;
+    header->snapshot = snapshot;
+    header->section = 0;
+    u32 length = nextFrame(header, frame + sizeof(ProfFrameHeader));
+    if(length == 0) {
+        poolFree(frame);
+        return 0;
+    }
+    header->length = length;
+
+    beginQueued = header->type == PROF_FRAME_BEGIN;
+    int status = TCPsendBuffered(devicePtr, frame, sizeof(ProfFrameHeader) + length, frameSent);
+    if(status != XST_SUCCESS) {
+        profStats.sendFailures++;
+    }
+    poolFree(frame);
+    return 1;
+}
+
+void getProfileExportStats(ProfExportStats * stats) {
+    memcpy(stats, &profStats, sizeof(ProfExportStats));
+}
+
+    // prof period <seconds> | stop | status
+static int profCommand(int argc, char ** argv, char * reply, int replySize) {
+    if(argc == 3 && strcmp(argv[1], "period") == 0) {
+        u32 seconds = strtoul(argv[2], NULL, 0);
+        if(seconds == 0) {
+            return snprintf(reply, replySize, "ERR bad period\r\n");
+        }
+        setProfileExportPeriod(seconds * TICK_HZ);
+        return snprintf(reply, replySize, "OK\r\n");
+    }
+    if(argc == 2 && strcmp(argv[1], "stop") == 0) {
+        setProfileExportPeriod(0);
+        return snprintf(reply, replySize, "OK\r\n");
+    }
+    if(argc == 2 && strcmp(argv[1], "status") == 0) {
+        ProfExportStats stats;
+        getProfileExportStats(&stats);
+        return snprintf(reply, replySize,
+            "OK period %u snapshots %u frames %u failed %u callgraph %u shift %u %u\r\n",
+            (unsigned)stats.period, (unsigned)stats.snapshots,
+            (unsigned)stats.framesSent, (unsigned)stats.sendFailures,
+            (unsigned)stats.callGraph,
+            (unsigned)stats.binShift[0], (unsigned)stats.binShift[1]);
+    }
+    return snprintf(reply, replySize,
+        "ERR usage: prof period <seconds> | stop | status\r\n");
+}
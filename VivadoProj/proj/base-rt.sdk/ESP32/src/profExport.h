@@ -0,0 +1,146 @@
+/*******************************************************************************
+    Wireless export of gprof profiling data
+
+    The tick ISR samples the interrupted PC into a histogram per text
+    section: .fast_text in BRAM and .text in DDR. Every period the
+    histograms are swapped for a cleared pair, and the retired pair is
+    streamed over the ESP32 TCP link as a snapshot, one frame per
+    serviceProfileExport call, so the main loop is never held up for long.
+    The host collector in server.py turns each snapshot into a gmon.out
+    file for gprof.
+
+    With PROFILE_CALL_GRAPH set, the application must be built with -pg.
+    The call-graph tables mcount records into are then owned by this
+    module and double buffered the same way, so each snapshot also carries
+    the arcs seen during its period. A debugger that has set up
+    _gmonparam keeps ownership, and snapshots carry histograms only.
+
+    Snapshot layout: one PROF_FRAME_BEGIN, then PROF_FRAME_HIST for every
+    chunk of a section that has at least one sample, then PROF_FRAME_ARCS
+    if there is a call graph, then PROF_FRAME_END. Chunks not sent are
+    all zero. Frames go out through the ESP32 send window, so HIST and
+    ARCS frames resent after a SEND FAIL may come out of order, but
+    never ahead of their BEGIN or behind their END.
+*******************************************************************************/
+
+#ifndef PROFEXPORT_H
+#define PROFEXPORT_H
+
+#include "xil_printf.h"
+#include "xil_types.h"
+#include "xstatus.h"
+#include "ESP32.h"
+#include "sysTimer.h"
+#include "platform_config.h"
+
+/****************************** PROFILE CONFIGURATION *************************/
+    // Set to 1 when the application is built with -pg against a BSP
+    // with software profiling enabled
+#ifndef PROFILE_CALL_GRAPH
+#define PROFILE_CALL_GRAPH      0
+#endif
+
+    // .fast_text and .text
+#define PROF_SECTIONS           2
+    // Bins per section. Sections too large for 16 byte bins get
+    // wider ones, a power of 2 each
+#define PROF_MAX_BINS           8192
+#define PROF_MIN_BIN_SHIFT      4
+    // Call-graph table sizes per section, see profile.h
+#define PROF_MAX_FROMS          1024
+#define PROF_MAX_TOS            2048
+
+#define PROF_DEFAULT_PERIOD     (10 * TICK_HZ)
+
+#define PROF_MAGIC              0x464F5250  // "PROF"
+
+#define PROF_FRAME_BEGIN        0
+#define PROF_FRAME_HIST         1
+#define PROF_FRAME_ARCS         2
+#define PROF_FRAME_END          3
+
+/**
+ * Frame header as sent on the wire, little-endian. length bytes of
+ * payload follow
+ */
+typedef struct {
+    u32 magic;
+    u32 snapshot;       // increments by one per snapshot
+    u16 type;           // PROF_FRAME_*
+    u16 section;        // PROF_FRAME_HIST and PROF_FRAME_ARCS only
+    u32 length;
+} ProfFrameHeader;
+
+typedef struct {
+    u32 profRate;       // histogram samples per second
+    u32 firstTick;      // tick count when the period started
+    u32 ticks;          // length of the period
+    u32 samples;        // PCs that fell into a section
+    u32 outside;        // PCs that did not
+    u16 sections;
+    u16 callGraph;      // 1 if PROF_FRAME_ARCS frames follow
+} ProfBegin;
+
+    // Followed by the u16 counts of bins firstBin onwards
+typedef struct {
+    u32 lowpc;
+    u32 highpc;         // lowpc plus totalBins bins
+    u32 totalBins;
+    u32 firstBin;
+} ProfHist;
+
+    // PROF_FRAME_ARCS payload is an array of these
+typedef struct {
+    u32 frompc;
+    u32 selfpc;
+    u32 count;
+} ProfArc;
+
+typedef struct {
+    u32 arcs;
+    u32 overflows;      // profile_cg_overflows during the period
+} ProfEnd;
+
+typedef struct {
+    u32 period;         // ticks, 0 when stopped
+    u32 snapshots;
+    u32 framesSent;     // answered SEND OK
+    u32 sendFailures;   // not taken by the ESP32, or lost after resends
+    u32 callGraph;
+    u32 binShift[PROF_SECTIONS];
+} ProfExportStats;
+
+/**
+ * Sizes the histograms from the linker section bounds, takes over the
+ * call-graph tables if built with PROFILE_CALL_GRAPH, registers the tick
+ * hook and adds the "prof" command to the command link. Exports every
+ * period ticks, or not at all if period is 0
+ * initSysTimer must have been called first
+ *
+ * returns XST_SUCCESS in case of success
+ * returns XST_FAILURE in case of failure
+ */
+int initProfileExport(u32 period);
+
+/**
+ * Clears the histograms and starts a new period of the given length
+ * in ticks. A period of 0 stops sampling and exporting; a snapshot
+ * being sent is finished either way
+ */
+void setProfileExportPeriod(u32 period);
+
+/**
+ * Takes a snapshot when the period is over and queues at most one
+ * frame of it for the open TCP connection with TCPsendBuffered. Call
+ * from the main loop, along with serviceTCPSendWindow
+ *
+ * returns 1 if a frame was queued, 0 otherwise
+ */
+int serviceProfileExport(Uart * devicePtr);
+
+/**
+ * Copies the export counters
+ */
+void getProfileExportStats(ProfExportStats * stats);
+
+#endif  /* end of protection macro */
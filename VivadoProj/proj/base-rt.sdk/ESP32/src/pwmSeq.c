@@ -0,0 +1,270 @@
+/*******************************************************************************
+    Multi-channel PWM waveform sequencer, see pwmSeq.h
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "pwmSeq.h"
+#include "platform.h"
+#include "sysTimer.h"
+#include "command.h"
+
+typedef struct {
+    PwmFrame frames[PWM_SEQ_MAX_FRAMES];
+    u32 count;
+    u32 ticksPerFrame;
+    u32 loop;
+} PwmBank;
+
+static void pwmSeqTick(void) FAST_CODE;
+static int pwmCommand(int argc, char ** argv, char * reply, int replySize);
+
+static PwmBank banks[2];
+
+    // Owned by the ISR once playing; changed from the main loop only
+    // inside a critical section
+static PwmBank * volatile front FAST_BSS;
+static volatile u32 playing FAST_BSS;
+static volatile u32 swapPending FAST_BSS;
+static volatile u32 passes FAST_BSS;
+static u32 frameIndex FAST_BSS;
+static u32 ticksLeft FAST_BSS;
+static PWM_Shadow shadow FAST_BSS;
+static volatile u32 regWrites FAST_BSS;
+
+    // Last duty cycles loaded into the back bank, the start of a ramp
+static u32 lastDuty[PWM_NUM_CHANNELS];
+
+static PwmBank * backBank(void) {
+    return (front == &banks[0]) ? &banks[1] : &banks[0];
+}
+
+int initPwmSequencer(void) {
+    u32 off[PWM_NUM_CHANNELS] = { 0 };
+
+    if(PWM_Shadow_Init(&shadow, PWM_BASEADDR, PWM_NUM_CHANNELS) != XST_SUCCESS) {
+        xil_printf("Could not read PWM registers\n\r");
+        return XST_FAILURE;
+    }
+    PWM_Update(&shadow, PWM_PERIOD_CLOCKS, off, PWM_COMMIT_RESTART);
+    PWM_Enable(PWM_BASEADDR);
+
+    front = &banks[0];
+    banks[0].count = 0;
+    banks[1].count = 0;
+
+    if(addTickHook(pwmSeqTick) != XST_SUCCESS) {
+        xil_printf("Could not register PWM sequencer tick\n\r");
+        return XST_FAILURE;
+    }
+    if(addCommand("pwm", pwmCommand) != XST_SUCCESS) {
+        xil_printf("Could not register pwm command\n\r");
+        return XST_FAILURE;
+    }
+    return XST_SUCCESS;
+}
+
+static void pwmSeqTick(void) {
+    if(!playing || --ticksLeft > 0) {
+        return;
+    }
+
+    PwmBank * bank = front;
+        // Channels held from the last frame are not rewritten, and the
+        // rest are latched together at the next PWM period boundary
+    regWrites += PWM_Update(&shadow, PWM_PERIOD_CLOCKS,
+            bank->frames[frameIndex].duty, PWM_COMMIT_BOUNDARY);
+    ticksLeft = bank->ticksPerFrame;
+
+    if(++frameIndex < bank->count) {
+        return;
+    }
+    frameIndex = 0;
+    passes++;
+    if(swapPending) {
+        front = (bank == &banks[0]) ? &banks[1] : &banks[0];
+        ticksLeft = front->ticksPerFrame;
+        swapPending = 0;
+    } else if(!bank->loop) {
+        playing = 0;
+    }
+}
+
+int pwmSeqClear(void) {
+    if(swapPending) {
+        return XST_DEVICE_BUSY;
+    }
+    backBank()->count = 0;
+    memset(lastDuty, 0, sizeof(lastDuty));
+    return XST_SUCCESS;
+}
+
+int pwmSeqAddFrame(const u32 * duty) {
+    if(swapPending) {
+        return XST_DEVICE_BUSY;
+    }
+    PwmBank * bank = backBank();
+    if(bank->count >= PWM_SEQ_MAX_FRAMES) {
+        return XST_FAILURE;
+    }
+
+    PwmFrame * frame = &bank->frames[bank->count];
+    for(int i = 0; i < PWM_NUM_CHANNELS; i++) {
+        u32 d = (duty[i] > PWM_DUTY_FULL_SCALE) ? PWM_DUTY_FULL_SCALE : duty[i];
+        frame->duty[i] = (u32)(((u64)PWM_PERIOD_CLOCKS * d) / PWM_DUTY_FULL_SCALE);
+        lastDuty[i] = d;
+    }
+    bank->count++;
+    return XST_SUCCESS;
+}
+
+int pwmSeqAddRamp(const u32 * target, u32 count) {
+    u32 from[PWM_NUM_CHANNELS];
+    u32 duty[PWM_NUM_CHANNELS];
+    memcpy(from, lastDuty, sizeof(from));
+
+    for(u32 k = 1; k <= count; k++) {
+        for(int i = 0; i < PWM_NUM_CHANNELS; i++) {
+            s32 delta = (s32)target[i] - (s32)from[i];
+            duty[i] = (u32)((s32)from[i] + (delta * (s32)k) / (s32)count);
+        }
+        int status = pwmSeqAddFrame(duty);
+        if(status != XST_SUCCESS) {
+            return status;
+        }
+    }
+    return XST_SUCCESS;
+}
+
+int pwmSeqCommit(u32 ticksPerFrame, u32 loop) {
+    if(swapPending) {
+        return XST_DEVICE_BUSY;
+    }
+    PwmBank * bank = backBank();
+    if(bank->count == 0 || ticksPerFrame == 0) {
+        return XST_FAILURE;
+    }
+    bank->ticksPerFrame = ticksPerFrame;
+    bank->loop = loop;
+
+    u32 msr = enter_critical();
+    if(playing) {
+        swapPending = 1;
+    } else {
+        front = bank;
+        frameIndex = 0;
+        ticksLeft = 1;
+        playing = 1;
+    }
+    exit_critical(msr);
+    return XST_SUCCESS;
+}
+
+void pwmSeqStart(void) {
+    if(front->count == 0) {
+        return;
+    }
+    u32 msr = enter_critical();
+    frameIndex = 0;
+    ticksLeft = 1;
+    playing = 1;
+    exit_critical(msr);
+}
+
+void pwmSeqStop(void) {
+    u32 msr = enter_critical();
+    playing = 0;
+    swapPending = 0;
+    exit_critical(msr);
+}
+
+int pwmSetDuty(u32 channel, u32 duty) {
+    u32 regs[PWM_NUM_CHANNELS];
+    if(channel >= PWM_NUM_CHANNELS) {
+        return XST_FAILURE;
+    }
+    if(duty > PWM_DUTY_FULL_SCALE) {
+        duty = PWM_DUTY_FULL_SCALE;
+    }
+        // PWM_Update runs with interrupts off, as its doc asks, so a
+        // sequence started meanwhile cannot swap banks part way through
+    u32 msr = enter_critical();
+    if(playing) {
+        exit_critical(msr);
+        return XST_DEVICE_BUSY;
+    }
+    memcpy(regs, shadow.Duty, sizeof(regs));
+    regs[channel] = (u32)(((u64)PWM_PERIOD_CLOCKS * duty) / PWM_DUTY_FULL_SCALE);
+    PWM_Update(&shadow, PWM_PERIOD_CLOCKS, regs, PWM_COMMIT_BOUNDARY);
+    exit_critical(msr);
+    return XST_SUCCESS;
+}
+
+void getPwmSeqStatus(PwmSeqStatus * status) {
+    u32 msr = enter_critical();
+    status->playing = playing;
+    status->frameIndex = frameIndex;
+    status->frameCount = front->count;
+    status->ticksPerFrame = front->ticksPerFrame;
+    status->loop = front->loop;
+    status->passes = passes;
+    status->swapPending = swapPending;
+    status->backFrames = backBank()->count;
+    status->regWrites = regWrites;
+    exit_critical(msr);
+}
+
+    // pwm start | stop | clear | status
+    // pwm frame <d0> .. <d5>
+    // pwm ramp <d0> .. <d5> <frames>
+    // pwm commit <ticks per frame> <loop>
+    // pwm duty <channel> <duty>
+static int pwmCommand(int argc, char ** argv, char * reply, int replySize) {
+    u32 duty[PWM_NUM_CHANNELS];
+    int status = XST_SUCCESS;
+
+    if(argc < 2) {
+        return snprintf(reply, replySize, "ERR usage: pwm start|stop|clear|status|frame|ramp|commit|duty\r\n");
+    }
+
+    if(strcmp(argv[1], "start") == 0) {
+        pwmSeqStart();
+    } else if(strcmp(argv[1], "stop") == 0) {
+        pwmSeqStop();
+    } else if(strcmp(argv[1], "clear") == 0) {
+        status = pwmSeqClear();
+    } else if(strcmp(argv[1], "status") == 0) {
+        PwmSeqStatus seq;
+        getPwmSeqStatus(&seq);
+        return snprintf(reply, replySize,
+            "OK playing %d frame %d/%d ticks %d loop %d passes %d pending %d back %d writes %d\r\n",
+            seq.playing, seq.frameIndex, seq.frameCount, seq.ticksPerFrame,
+            seq.loop, seq.passes, seq.swapPending, seq.backFrames, seq.regWrites);
+    } else if(strcmp(argv[1], "frame") == 0 && argc == 2 + PWM_NUM_CHANNELS) {
+        for(int i = 0; i < PWM_NUM_CHANNELS; i++) {
+            duty[i] = strtoul(argv[2 + i], NULL, 0);
+        }
+        status = pwmSeqAddFrame(duty);
+    } else if(strcmp(argv[1], "ramp") == 0 && argc == 3 + PWM_NUM_CHANNELS) {
+        for(int i = 0; i < PWM_NUM_CHANNELS; i++) {
+            duty[i] = strtoul(argv[2 + i], NULL, 0);
+        }
+        status = pwmSeqAddRamp(duty, strtoul(argv[2 + PWM_NUM_CHANNELS], NULL, 0));
+    } else if(strcmp(argv[1], "commit") == 0 && argc == 4) {
+        status = pwmSeqCommit(strtoul(argv[2], NULL, 0), strtoul(argv[3], NULL, 0));
+    } else if(strcmp(argv[1], "duty") == 0 && argc == 4) {
+        status = pwmSetDuty(strtoul(argv[2], NULL, 0), strtoul(argv[3], NULL, 0));
+        if(status == XST_DEVICE_BUSY) {
+            return snprintf(reply, replySize, "ERR busy, sequence playing\r\n");
+        }
+    } else {
+        return snprintf(reply, replySize, "ERR bad pwm command\r\n");
+    }
+
+    if(status == XST_DEVICE_BUSY) {
+        return snprintf(reply, replySize, "ERR busy, commit pending\r\n");
+    } else if(status != XST_SUCCESS) {
+        return snprintf(reply, replySize, "ERR pwm %s failed\r\n", argv[1]);
+    }
+    return snprintf(reply, replySize, "OK\r\n");
+}
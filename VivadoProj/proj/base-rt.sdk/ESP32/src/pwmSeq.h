@@ -0,0 +1,125 @@
+/*******************************************************************************
+    Multi-channel PWM waveform sequencer
+
+    Plays a list of frames, one duty cycle per PWM channel, from the system
+    tick ISR. Frames are converted to PWM register values when they are
+    loaded, so the ISR only hands them to PWM_Update, which writes the
+    channels that changed and lets the core latch them together at the
+    next period boundary.
+
+    There are two frame banks. The ISR plays the front bank while the main
+    loop (or the "pwm" command over the TCP link) loads the back bank;
+    pwmSeqCommit hands the back bank over at the end of the current pass,
+    so a new waveform never starts half way through the old one.
+*******************************************************************************/
+
+#ifndef PWMSEQ_H
+#define PWMSEQ_H
+
+#include "xparameters.h"
+#include "xil_printf.h"
+#include "xil_types.h"
+#include "xstatus.h"
+#include "PWM.h"
+#include "platform_config.h"
+
+/*************************** XILINX ARGUMENT MACROS ***************************/
+#define PWM_BASEADDR            XPAR_PWM_0_PWM_AXI_BASEADDR
+    // NUM_PWM of the PWM_v1_0 instance in the block design
+#define PWM_NUM_CHANNELS        6
+
+/***************************** SEQUENCER CONFIGURATION ************************/
+    // 1 kHz PWM from the 100 MHz AXI clock
+#define PWM_PERIOD_CLOCKS       100000
+#define PWM_SEQ_MAX_FRAMES      256
+    // Duty cycles are given in thousandths of the period
+#define PWM_DUTY_FULL_SCALE     1000
+
+typedef struct {
+    u32 duty[PWM_NUM_CHANNELS];     // PWM register values, in clocks
+} PwmFrame;
+
+typedef struct {
+    u32 playing;
+    u32 frameIndex;
+    u32 frameCount;
+    u32 ticksPerFrame;
+    u32 loop;
+    u32 passes;         // completed passes over the front bank
+    u32 swapPending;
+    u32 backFrames;     // frames loaded into the back bank so far
+    u32 regWrites;      // PWM registers written by the ISR
+} PwmSeqStatus;
+
+/**
+ * Sets the PWM period, enables the PWM core, registers the sequencer with
+ * the system tick and adds the "pwm" command to the command link
+ * initSysTimer must have been called first
+ *
+ * returns XST_SUCCESS in case of success
+ * returns XST_FAILURE in case of failure
+ */
+int initPwmSequencer(void);
+
+/**
+ * Empties the back bank so a new sequence can be loaded
+ *
+ * returns XST_SUCCESS in case of success
+ * returns XST_DEVICE_BUSY if the back bank is committed but not yet playing
+ */
+int pwmSeqClear(void);
+
+/**
+ * Appends one frame to the back bank. duty holds PWM_NUM_CHANNELS values
+ * from 0 to PWM_DUTY_FULL_SCALE
+ *
+ * returns XST_SUCCESS in case of success
+ * returns XST_DEVICE_BUSY if the back bank is committed but not yet playing
+ * returns XST_FAILURE if the back bank is full
+ */
+int pwmSeqAddFrame(const u32 * duty);
+
+/**
+ * Appends frames fading linearly from the last frame loaded (or all off)
+ * to target, over count frames
+ *
+ * returns as for pwmSeqAddFrame
+ */
+int pwmSeqAddRamp(const u32 * target, u32 count);
+
+/**
+ * Hands the back bank to the ISR. Each frame is held for ticksPerFrame
+ * ticks; with loop set the sequence repeats until something else is
+ * committed, otherwise playback stops after the last frame. If nothing
+ * is playing the new sequence starts at once, otherwise at the end of
+ * the current pass
+ *
+ * returns XST_SUCCESS in case of success
+ * returns XST_FAILURE if the back bank is empty or ticksPerFrame is 0
+ * returns XST_DEVICE_BUSY if a commit is already pending
+ */
+int pwmSeqCommit(u32 ticksPerFrame, u32 loop);
+
+/**
+ * Starts playback of the front bank from its first frame, or stops it
+ * leaving the outputs at their last values
+ */
+void pwmSeqStart(void);
+void pwmSeqStop(void);
+
+/**
+ * Sets one channel to duty, from 0 to PWM_DUTY_FULL_SCALE, at the next
+ * PWM period boundary. The other channels keep their values
+ *
+ * returns XST_SUCCESS in case of success
+ * returns XST_FAILURE if channel does not exist
+ * returns XST_DEVICE_BUSY while a sequence is playing
+ */
+int pwmSetDuty(u32 channel, u32 duty);
+
+/**
+ * Copies the sequencer state
+ */
+void getPwmSeqStatus(PwmSeqStatus * status);
+
+#endif  /* end of protection macro */
@@ -0,0 +1,170 @@
+/*******************************************************************************
+    Configuration flash on axi_quad_spi_0, see spiFlash.h
+*******************************************************************************/
+
+#include "spiFlash.h"
+#include "sysTimer.h"
+
+#define SLAVE_SELECT            0xFFFFFFFE  // slave 0, active low
+#define SLAVE_NONE              0xFFFFFFFF
+
+static u32 savedControl;
+static u32 savedSlaveSelect;
+
+int initSpiFlash(XSpi * spiPtr) {
+    int Status;
+    Status = XSpi_Initialize(spiPtr, FLASH_SPI_DEVICE_ID);
+    if (Status != XST_SUCCESS) {
+        xil_printf("Could not initialize SPI\n\r");
+        return XST_FAILURE;
+    }
+
+    Status = XSpi_SetOptions(spiPtr, FLASH_SPI_OPTIONS);
+    if (Status != XST_SUCCESS) {
+        xil_printf("Could not set SPI options\n\r");
+        return XST_FAILURE;
+    }
+    XSpi_Start(spiPtr);
+    XSpi_IntrGlobalDisable(spiPtr);
+    return XST_SUCCESS;
+}
+
+    // Selects the flash, keeping it selected until endCommand
+static void beginCommand(void) {
+    u32 base = FLASH_SPI_BASEADDR;
+    savedControl = XSpi_ReadReg(base, XSP_CR_OFFSET);
+    savedSlaveSelect = XSpi_ReadReg(base, XSP_SSR_OFFSET);
+    XSpi_WriteReg(base, XSP_CR_OFFSET, savedControl | XSP_CR_MANUAL_SS_MASK |
+        XSP_CR_TRANS_INHIBIT_MASK | XSP_CR_RXFIFO_RESET_MASK);
+    XSpi_WriteReg(base, XSP_SSR_OFFSET, SLAVE_SELECT);
+}
+
+static void endCommand(void) {
+    u32 base = FLASH_SPI_BASEADDR;
+    XSpi_WriteReg(base, XSP_SSR_OFFSET, SLAVE_NONE);
+    XSpi_WriteReg(base, XSP_CR_OFFSET, savedControl);
+    XSpi_WriteReg(base, XSP_SSR_OFFSET, savedSlaveSelect);
+}
+
+    // Clocks length bytes out of tx, zeros if it is NULL, and what comes
+    // back into rx unless it is NULL, one FIFO load at a time
+static void transfer(const u8 * tx, u8 * rx, u32 length) {
+    u32 base = FLASH_SPI_BASEADDR;
+    while(length > 0) {
+        u32 count = (length < FLASH_FIFO_DEPTH) ? length : FLASH_FIFO_DEPTH;
+        u32 control = XSpi_ReadReg(base, XSP_CR_OFFSET);
+
+            // Fill the FIFO with the transmitter held, so the load goes
+            // out back to back
+        XSpi_WriteReg(base, XSP_CR_OFFSET, control | XSP_CR_TRANS_INHIBIT_MASK);
+        for(u32 i = 0; i < count; i++) {
+            XSpi_WriteReg(base, XSP_DTR_OFFSET, (tx != NULL) ? tx[i] : 0);
+        }
+        XSpi_WriteReg(base, XSP_CR_OFFSET, control & ~XSP_CR_TRANS_INHIBIT_MASK);
+
+        for(u32 i = 0; i < count; i++) {
+            while(XSpi_ReadReg(base, XSP_SR_OFFSET) & XSP_SR_RX_EMPTY_MASK);
+            u8 byte = XSpi_ReadReg(base, XSP_DRR_OFFSET);
+            if(rx != NULL) {
+                rx[i] = byte;
+            }
+        }
+
+        if(tx != NULL) {
+            tx += count;
+        }
+        if(rx != NULL) {
+            rx += count;
+        }
+        length -= count;
+    }
+}
+
+    // One command: header is the command byte and any address, followed
+    // by length bytes of data each way
+static void flashCommand(const u8 * header, u32 headerLength,
+        const u8 * tx, u8 * rx, u32 length) {
+    beginCommand();
+    transfer(header, NULL, headerLength);
+    if(length > 0) {
+        transfer(tx, rx, length);
+    }
+    endCommand();
+}
+
+static void simpleCommand(u8 command) {
+    flashCommand(&command, 1, NULL, NULL, 0);
+}
+
+static u8 readStatus(void) {
+    u8 command = FLASH_CMD_READ_STATUS;
+    u8 status;
+    flashCommand(&command, 1, NULL, &status, 1);
+    return status;
+}
+
+static void addressHeader(u8 * header, u8 command, u32 address) {
+    header[0] = command;
+    header[1] = (u8)(address >> 16);
+    header[2] = (u8)(address >> 8);
+    header[3] = (u8)address;
+}
+
+    // Waits for a program or erase to finish and checks its outcome. The
+    // error bits stay set until cleared, and block further writes
+static int waitReady(u32 timeoutMs, u8 errorMask) {
+    u32 startTick = getTickCount();
+    u8 status;
+    while((status = readStatus()) & FLASH_SR_WIP) {
+        if(getTickCount() - startTick > timeoutMs * TICK_HZ / 1000) {
+            xil_printf("Flash still busy after %d ms\n\r", timeoutMs);
+            return XST_FAILURE;
+        }
+    }
+    if(status & errorMask) {
+        simpleCommand(FLASH_CMD_CLEAR_STATUS);
+        return XST_FAILURE;
+    }
+    return XST_SUCCESS;
+}
+
+int flashReadId(u32 * id) {
+    u8 command = FLASH_CMD_READ_ID;
+    u8 bytes[3];
+    flashCommand(&command, 1, NULL, bytes, sizeof(bytes));
+    *id = ((u32)bytes[0] << 16) | ((u32)bytes[1] << 8) | bytes[2];
+    return XST_SUCCESS;
+}
+
+int flashRead(u32 address, void * buf, u32 length) {
+    u8 header[4];
+    if(address >= FLASH_SIZE || length > FLASH_SIZE - address) {
+        return XST_FAILURE;
+    }
+    addressHeader(header, FLASH_CMD_READ, address);
+    flashCommand(header, sizeof(header), NULL, buf, length);
+    return XST_SUCCESS;
+}
+
+int flashProgram(u32 address, const void * buf, u32 length) {
+    u8 header[4];
+    if(address >= FLASH_SIZE || length == 0 ||
+            (address % FLASH_PAGE_SIZE) + length > FLASH_PAGE_SIZE) {
+        return XST_FAILURE;
+    }
+    simpleCommand(FLASH_CMD_WRITE_ENABLE);
+    addressHeader(header, FLASH_CMD_PAGE_PROGRAM, address);
+    flashCommand(header, sizeof(header), buf, NULL, length);
+    return waitReady(FLASH_PROGRAM_TIMEOUT_MS, FLASH_SR_P_ERR);
+}
+
+int flashEraseSector(u32 address) {
+    u8 header[4];
+    if(address >= FLASH_SIZE) {
+        return XST_FAILURE;
+    }
+    simpleCommand(FLASH_CMD_WRITE_ENABLE);
+    addressHeader(header, FLASH_CMD_SECTOR_ERASE, address & ~(FLASH_SECTOR_SIZE - 1));
+    flashCommand(header, sizeof(header), NULL, NULL, 0);
+    return waitReady(FLASH_ERASE_TIMEOUT_MS, FLASH_SR_E_ERR);
+}
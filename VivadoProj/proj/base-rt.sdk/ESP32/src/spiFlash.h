@@ -0,0 +1,105 @@
+/*******************************************************************************
+    Configuration flash on axi_quad_spi_0
+
+    The Arty S7 loads its bitstream from a 16 MB Spansion S25FL128S; the
+    space above the bitstream is free for the application. The flash is
+    read, programmed and erased with the plain single line commands, which
+    the core passes through in quad mode as well.
+
+    The flash is the core's only slave: it has one slave select, which
+    STARTUPE2 routes to the flash, so nothing else may use the core.
+    initSpiFlash sets it up in SPI mode 3 (CPOL = 1, CPHA = 1). The
+    functions below drive it at register level in manual slave select
+    mode, which keeps the flash selected for a whole command however many
+    FIFO loads it takes.
+
+    Program and erase poll the status register until done: a page takes
+    typically 0.25 ms and a 64 KB sector 130 ms, at most 2.6 s.
+*******************************************************************************/
+
+#ifndef SPIFLASH_H
+#define SPIFLASH_H
+
+#include "xparameters.h"
+#include "xil_printf.h"
+#include "xil_types.h"
+#include "xstatus.h"
+#include "xspi.h"
+#include "xspi_l.h"
+
+/*************************** XILINX ARGUMENT MACROS ***************************/
+#define FLASH_SPI_DEVICE_ID     XPAR_SPI_0_DEVICE_ID
+#define FLASH_SPI_BASEADDR      XPAR_SPI_0_BASEADDR
+#define FLASH_FIFO_DEPTH        XPAR_SPI_0_FIFO_DEPTH
+
+/***************************** FLASH GEOMETRY *********************************/
+#define FLASH_SIZE              0x1000000
+#define FLASH_SECTOR_SIZE       0x10000
+#define FLASH_PAGE_SIZE         256
+
+    // Manufacturer, memory type and capacity bytes of READ ID
+#define FLASH_JEDEC_ID          0x012018
+
+/****************************** FLASH COMMANDS ********************************/
+#define FLASH_CMD_READ          0x03
+#define FLASH_CMD_PAGE_PROGRAM  0x02
+#define FLASH_CMD_SECTOR_ERASE  0xD8
+#define FLASH_CMD_WRITE_ENABLE  0x06
+#define FLASH_CMD_READ_STATUS   0x05
+#define FLASH_CMD_CLEAR_STATUS  0x30
+#define FLASH_CMD_READ_ID       0x9F
+
+#define FLASH_SR_WIP            0x01    // program or erase in progress
+#define FLASH_SR_WEL            0x02    // write enable latch
+#define FLASH_SR_E_ERR          0x20
+#define FLASH_SR_P_ERR          0x40
+
+#define FLASH_PROGRAM_TIMEOUT_MS    5
+#define FLASH_ERASE_TIMEOUT_MS      3000
+
+#define FLASH_SPI_OPTIONS       (XSP_MASTER_OPTION | XSP_CLK_ACTIVE_LOW_OPTION | \
+                                 XSP_CLK_PHASE_1_OPTION | XSP_MANUAL_SSELECT_OPTION)
+
+/**
+ * Initializes axi_quad_spi_0 for the flash, with its interrupt off
+ *
+ * returns XST_SUCCESS in case of success
+ * returns XST_FAILURE in case of failure
+ */
+int initSpiFlash(XSpi * spiPtr);
+
+/**
+ * Reads the JEDEC ID, manufacturer in bits 23..16
+ *
+ * returns XST_SUCCESS in case of success
+ */
+int flashReadId(u32 * id);
+
+/**
+ * Reads length bytes from address on
+ *
+ * returns XST_SUCCESS in case of success
+ * returns XST_FAILURE if the range is not inside the flash
+ */
+int flashRead(u32 address, void * buf, u32 length);
+
+/**
+ * Programs length bytes at address, which must not run over the end of
+ * its page. Programming only clears bits, so the bytes must have been
+ * erased before
+ *
+ * returns XST_SUCCESS in case of success
+ * returns XST_FAILURE if the range crosses a page or the flash reports
+ * a program error or timeout
+ */
+int flashProgram(u32 address, const void * buf, u32 length);
+
+/**
+ * Erases the FLASH_SECTOR_SIZE sector address lies in to all ones
+ *
+ * returns XST_SUCCESS in case of success
+ * returns XST_FAILURE if the flash reports an erase error or timeout
+ */
+int flashEraseSector(u32 address);
+
+#endif  /* end of protection macro */
@@ -0,0 +1,30 @@
+/*******************************************************************************
+    Stack high water mark, see stackCheck.h
+*******************************************************************************/
+
+#include "stackCheck.h"
+
+#define STACK_PAINT             0xA5A5A5A5U
+    // Left alone below paintStack's frame address, for its own locals
+    // where the frame pointer sits above them and for what the compiler
+    // may keep past the stack pointer
+#define STACK_PAINT_MARGIN      64
+
+    // lscript.ld; the stack grows down from _stack
+extern u32 _stack_end[], _stack[];
+
+void paintStack(void) {
+    u32 * top = (u32 *)((u8 *)__builtin_frame_address(0) - STACK_PAINT_MARGIN);
+    for(u32 * word = _stack_end; word < top; word++) {
+        *word = STACK_PAINT;
+    }
+}
+
+void getStackStats(StackStats * stats) {
+    u32 * word = _stack_end;
+    while(word < _stack && *word == STACK_PAINT) {
+        word++;
+    }
+    stats->size = (u8 *)_stack - (u8 *)_stack_end;
+    stats->highWater = (u8 *)_stack - (u8 *)word;
+}
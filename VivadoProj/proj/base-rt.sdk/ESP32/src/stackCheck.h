@@ -0,0 +1,33 @@
+/*******************************************************************************
+    Stack high water mark
+
+    The one stack, from _stack_end up to _stack in lscript.ld, is shared
+    by main and every ISR. paintStack fills the part below the caller
+    with a pattern at boot; the lowest word no longer holding it marks
+    the deepest the stack has gone since.
+*******************************************************************************/
+
+#ifndef STACK_CHECK_H
+#define STACK_CHECK_H
+
+#include "xil_types.h"
+
+typedef struct {
+    u32 size;           // bytes from _stack_end to _stack
+    u32 highWater;      // bytes used at most, counted down from _stack
+} StackStats;
+
+/**
+ * Fills the stack below the caller's frame with the pattern. Call first
+ * thing in main, before interrupts are enabled
+ */
+void paintStack(void);
+
+/**
+ * Scans the painted part for the high water mark. Takes a word read for
+ * every word of stack that has never been used, so call it for reports,
+ * not from the ISR
+ */
+void getStackStats(StackStats * stats);
+
+#endif  /* end of protection macro */
@@ -0,0 +1,153 @@
+/*******************************************************************************
+    System timer built on axi_timer_0, see sysTimer.h
+*******************************************************************************/
+
+#include "sysTimer.h"
+#include "platform.h"
+
+ISR_INLINE void serviceTick(void);
+#if USE_FAST_INTERRUPTS
+static void tickFastHandler(void) FAST_ISR;
+#else
+static void tickHandler(void * CallBackRef);
+#endif
+
+static volatile u32 tickCount FAST_BSS;
+static volatile IsrLatency isrLatency FAST_BSS;
+static u32 tickReload FAST_BSS;
+static TickHook tickHooks[MAX_TICK_HOOKS] FAST_BSS;
+static volatile u32 numTickHooks FAST_BSS;
+static u32 tickPC FAST_BSS;
+
+int initSysTimer(XTmrCtr * timerPtr, XIntc * intPtr, u32 tickHz) {
+    int Status;
+    Status = XTmrCtr_Initialize(timerPtr, TIMER_DEVICE_ID);
+    if (Status != XST_SUCCESS) {
+        xil_printf("Could not initialize timer\n\r");
+        return XST_FAILURE;
+    }
+
+    XTmrCtr_SetOptions(timerPtr, CYCLE_COUNTER, XTC_AUTO_RELOAD_OPTION);
+    XTmrCtr_SetResetValue(timerPtr, CYCLE_COUNTER, 0);
+    XTmrCtr_Start(timerPtr, CYCLE_COUNTER);
+
+    tickCount = 0;
+    tickReload = TIMER_CLOCK_HZ / tickHz - 1;
+    resetIsrLatency();
+
+#if USE_FAST_INTERRUPTS
+    Status = XIntc_ConnectFastHandler(intPtr, TIMER_INT_IRQ_ID,
+               tickFastHandler);
+#else
+    Status = XIntc_Connect(intPtr, TIMER_INT_IRQ_ID,
+               (XInterruptHandler)tickHandler, (void *)timerPtr);
+#endif
+    if (Status != XST_SUCCESS) {
+        xil_printf("Could not Connect timer to Interrupt Controller\n\r");
+        return XST_FAILURE;
+    }
+
+        // Down counting with auto reload, so the counter value on ISR
+        // entry is tickReload minus the cycles spent getting there
+    XTmrCtr_SetOptions(timerPtr, TICK_COUNTER,
+        XTC_INT_MODE_OPTION | XTC_AUTO_RELOAD_OPTION | XTC_DOWN_COUNT_OPTION);
+    XTmrCtr_SetResetValue(timerPtr, TICK_COUNTER, tickReload);
+    XTmrCtr_Start(timerPtr, TICK_COUNTER);
+
+    XIntc_Enable(intPtr, TIMER_INT_IRQ_ID);
+    return XST_SUCCESS;
+}
+
+ISR_INLINE void serviceTick(void) {
+        // r14 holds the address the interrupt returns to in both the
+        // fast and the normal handler; nothing before here touches it
+#ifdef __MICROBLAZE__
+    __asm__ volatile ("or %0, r0, r14" : "=r"(tickPC));
+#else
+        // Host simulation build (ESP32_sim), there is no r14 to sample
+    tickPC = 0;
+#endif
+    u32 elapsed = tickReload - ISR_IN32(TIMER_REG(TICK_COUNTER, XTC_TCR_OFFSET));
+    u32 csr = ISR_IN32(TIMER_REG(TICK_COUNTER, XTC_TCSR_OFFSET));
+
+        // Interrupt flag is cleared by writing it back as a 1
+    ISR_OUT32(TIMER_REG(TICK_COUNTER, XTC_TCSR_OFFSET), csr | XTC_CSR_INT_OCCURED_MASK);
+
+    isrLatency.last = elapsed;
+    if(elapsed < isrLatency.min) {
+        isrLatency.min = elapsed;
+    }
+    if(elapsed > isrLatency.max) {
+        isrLatency.max = elapsed;
+    }
+    isrLatency.total += elapsed;
+    isrLatency.count++;
+    tickCount++;
+
+    for(u32 i = 0; i < numTickHooks; i++) {
+        tickHooks[i]();
+    }
+}
+
+#if USE_FAST_INTERRUPTS
+static void tickFastHandler(void) {
+    serviceTick();
+}
+#else
+FAST_CODE static void tickHandler(void * CallBackRef) {
+    serviceTick();
+}
+#endif
+
+int addTickHook(TickHook hook) {
+    if(numTickHooks >= MAX_TICK_HOOKS) {
+        return XST_FAILURE;
+    }
+        // Store the hook before publishing the count so the ISR
+        // never calls an empty slot
+    tickHooks[numTickHooks] = hook;
+    numTickHooks++;
+    return XST_SUCCESS;
+}
+
+FAST_CODE u32 getTickCount(void) {
+    return tickCount;
+}
+
+FAST_CODE u32 getTickPC(void) {
+    return tickPC;
+}
+
+void getIsrLatency(IsrLatency * latency) {
+    u32 msr = enter_critical();
+    latency->last = isrLatency.last;
+    latency->min = isrLatency.min;
+    latency->max = isrLatency.max;
+    latency->count = isrLatency.count;
+    latency->total = isrLatency.total;
+    exit_critical(msr);
+}
+
+void resetIsrLatency(void) {
+    u32 msr = enter_critical();
+    isrLatency.last = 0;
+    isrLatency.min = 0xFFFFFFFF;
+    isrLatency.max = 0;
+    isrLatency.count = 0;
+    isrLatency.total = 0;
+    exit_critical(msr);
+}
+
+void printIsrLatency(void) {
+    IsrLatency latency;
+    getIsrLatency(&latency);
+    if(latency.count == 0) {
+        xil_printf("ISR latency: no ticks yet\n\r");
+        return;
+    }
+    xil_printf("ISR latency (%s, %s): last %d min %d max %d avg %d cycles over %d ticks\n\r",
+        USE_FAST_INTERRUPTS ? "fast" : "normal",
+        USE_FAST_SECTIONS ? "BRAM" : "DDR",
+        latency.last, latency.min, latency.max,
+        (u32)(latency.total / latency.count), latency.count);
+}
@@ -0,0 +1,98 @@
+/*******************************************************************************
+    System timer built on axi_timer_0. Counter 1 free-runs at the CPU clock
+    and serves as a cycle counter for timing measurements. Counter 0 generates
+    a periodic tick interrupt whose handler measures its own entry latency:
+    the counter reloads at the moment the interrupt is raised, so the value
+    read on entry tells how many cycles the dispatch took.
+*******************************************************************************/
+
+#ifndef SYSTIMER_H
+#define SYSTIMER_H
+
+#include "xparameters.h"
+#include "xil_printf.h"
+#include "xil_types.h"
+#include "xstatus.h"
+#include "xintc.h"
+#include "xtmrctr.h"
+#include "platform_config.h"
+
+/*************************** XILINX ARGUMENT MACROS ***************************/
+#define TIMER_DEVICE_ID         XPAR_TMRCTR_0_DEVICE_ID
+#define TIMER_BASEADDR          XPAR_TMRCTR_0_BASEADDR
+#define TIMER_INT_IRQ_ID        XPAR_INTC_0_TMRCTR_0_VEC_ID
+#define TIMER_CLOCK_HZ          XPAR_TMRCTR_0_CLOCK_FREQ_HZ
+
+#define TICK_COUNTER            0
+#define CYCLE_COUNTER           1
+
+#define TICK_HZ                 1000
+
+    // Address of a register of one of the two counters
+#define TIMER_REG(counter, offset) \
+    (TIMER_BASEADDR + (counter) * XTC_TIMER_COUNTER_OFFSET + (offset))
+
+    // Functions run from the tick ISR, see addTickHook
+#define MAX_TICK_HOOKS          4
+
+/**
+ * Reads the free running cycle counter. The AXI timer is clocked
+ * from the same 100 MHz clock as the MicroBlaze, so one count is
+ * one CPU cycle. Differences are correct across a wrap
+ */
+#define readCycles() \
+    ISR_IN32(TIMER_REG(CYCLE_COUNTER, XTC_TCR_OFFSET))
+
+typedef void (*TickHook)(void);
+
+typedef struct {
+    u32 last;
+    u32 min;
+    u32 max;
+    u32 count;
+    u64 total;
+} IsrLatency;
+
+/**
+ * Starts the cycle counter and the tick interrupt at tickHz
+ * The interrupt controller must already be initialized and started
+ * (see initATCtrl)
+ *
+ * returns XST_SUCCESS in case of success
+ * returns XST_FAILURE in case of failure
+ */
+int initSysTimer(XTmrCtr * timerPtr, XIntc * intPtr, u32 tickHz);
+
+/**
+ * Registers a function to be called from the tick ISR, after the tick
+ * count has been updated. Hooks run in registration order with
+ * interrupts disabled, so they must be short; put them in FAST_CODE
+ *
+ * returns XST_SUCCESS in case of success
+ * returns XST_FAILURE if MAX_TICK_HOOKS are already registered
+ */
+int addTickHook(TickHook hook);
+
+/**
+ * Returns the number of ticks since initSysTimer
+ */
+u32 getTickCount(void) FAST_CODE;
+
+/**
+ * Returns the address of the instruction the tick interrupt
+ * returns to. Only meaningful when called from a tick hook
+ */
+u32 getTickPC(void) FAST_CODE;
+
+/**
+ * Copies the tick ISR entry latency statistics, in CPU cycles
+ */
+void getIsrLatency(IsrLatency * latency);
+void resetIsrLatency(void);
+
+/**
+ * Prints the tick ISR entry latency statistics to the USB/UART port
+ */
+void printIsrLatency(void);
+
+#endif  /* end of protection macro */
@@ -11,6 +11,13 @@
 #define PWM_AXI_PERIOD_REG_OFFSET 8
 #define PWM_AXI_DUTY_REG_OFFSET 64
 
+	// The duty registers occupy word addresses 0x10 - 0x1F
+#define PWM_MAX_CHANNELS 16
+
+	// Commit modes for PWM_Update
+#define PWM_COMMIT_BOUNDARY 0
+#define PWM_COMMIT_RESTART 1
+
 
 /**************************** Type Definitions *****************************/
 /**
@@ -53,6 +60,21 @@
 #define PWM_mReadReg(BaseAddress, RegOffset) \
     Xil_In32((BaseAddress) + (RegOffset))
 
+/**
+ *
+ * RAM copy of the period and duty registers of one PWM core, used by
+ * PWM_Update to skip registers that already hold the requested value.
+ * Writes made with PWM_Set_Period or PWM_Set_Duty bypass the shadow;
+ * call PWM_Shadow_Init again after mixing the two.
+ *
+ */
+typedef struct {
+	u32 BaseAddr;
+	u32 NumChannels;
+	u32 Period;
+	u32 Duty[PWM_MAX_CHANNELS];
+} PWM_Shadow;
+
 /************************** Function Prototypes ****************************/
 /**
  *
@@ -82,4 +104,45 @@ u32 PWM_Get_Duty(u32 baseAddr, u32 pwmIndex);
 void PWM_Enable(u32 baseAddr);
 void PWM_Disable(u32 baseAddr);
 
+/**
+ *
+ * Load the shadow from the period and duty registers of the core.
+ *
+ * @param   Shadow is the shadow to initialize.
+ * @param   baseAddr is the base address of the PWM instance.
+ * @param   numChannels is NUM_PWM of the instance, at most PWM_MAX_CHANNELS.
+ *
+ * @return
+ *    - XST_SUCCESS if the shadow was loaded
+ *    - XST_INVALID_PARAM if numChannels is out of range
+ *
+ */
+int PWM_Shadow_Init(PWM_Shadow *Shadow, u32 baseAddr, u32 numChannels);
+
+/**
+ *
+ * Set the period and every duty cycle of a PWM core as one update. Only
+ * registers whose value differs from the shadow are written.
+ *
+ * The core copies the period and duty registers into its counters at the
+ * end of each period, so with PWM_COMMIT_BOUNDARY the new values take
+ * effect together at the next period boundary, provided the writes do not
+ * straddle one. The writes are a few bus cycles long; call with interrupts
+ * disabled (or from an ISR) so they cannot be stretched.
+ *
+ * With PWM_COMMIT_RESTART the core is disabled, the changed registers are
+ * written and the core is enabled again, so the new values start together
+ * with a fresh period. The period running at the time is cut short. The
+ * core is left enabled.
+ *
+ * @param   Shadow is the shadow of the core to update.
+ * @param   period is the new period in clocks.
+ * @param   duty holds Shadow->NumChannels duty cycles in clocks.
+ * @param   mode is PWM_COMMIT_BOUNDARY or PWM_COMMIT_RESTART.
+ *
+ * @return  The number of period and duty registers written.
+ *
+ */
+u32 PWM_Update(PWM_Shadow *Shadow, u32 period, const u32 *duty, u32 mode);
+
 #endif // PWM_H
@@ -107,6 +107,45 @@ struct gmonparam {
 extern struct gmonparam *_gmonparam;
 extern s32 n_gmon_sections;
 
+/*
+ * mcount finds call-graph arcs through open-addressing hash tables on
+ * (frompc, selfpc) and on frompc, held in a fixed arena of
+ * 2^PROFILE_CG_HASH_BITS entries each. The froms/tos tables above keep
+ * their layout, so gmon.out is generated as before. A table is treated
+ * as full at 3/4 occupancy; from then on new entries fall back to the
+ * linear search and are counted in profile_cg_overflows.
+ */
+#ifndef PROFILE_CG_HASH_BITS
+#define PROFILE_CG_HASH_BITS	11U
+#endif
+#define PROFILE_CG_HASH_SIZE	(1U << PROFILE_CG_HASH_BITS)
+
+extern u32 profile_cg_overflows;	/* entries not hashed, table full */
+extern u32 profile_cg_collisions;	/* extra probes past the home slot */
+
+/*
+ * Sizes of the froms and tos arrays when the application provides
+ * _gmonparam itself rather than a debugger; arcs that do not fit are
+ * dropped and counted in profile_cg_overflows. 0 means no limit.
+ */
+extern u32 profile_cg_max_froms;
+extern u32 profile_cg_max_tos;
+
+/*
+ * mcount stops the profile timer while it runs so its own cost is not
+ * sampled. Clear this when that timer is not the one in profile_config.h.
+ */
+extern u32 profile_cg_pause_timer;
+
+/*
+ * Forgets every hashed arc in O(1). Call with interrupts disabled after
+ * pointing _gmonparam at emptied froms/tos tables.
+ */
+void profile_cg_reset(void);
+
+/* _gmonparam until a debugger or the application sets it up */
+#define GMONPARAM_UNSET		((struct gmonparam *)0xffffffffU)
+
 /*
  * Possible states of profiling.
  */
@@ -51,9 +51,17 @@
 *
 *****************************************************************************/
 
+#ifndef XIL_MEM_H		/* prevent circular inclusions */
+#define XIL_MEM_H		/* by using protection macros */
+
+#include "xil_types.h"
+
 /************************** Function Prototypes *****************************/
 
 void Xil_MemCpy(void* dst, const void* src, u32 cnt);
+void Xil_MemSet(void* dst, s32 val, u32 cnt);
 /**
 * @} End of "addtogroup common_mem_operation_api".
-*/
\ No newline at end of file
+*/
+
+#endif /* end of protection macro */
@@ -75,6 +75,27 @@
 * This test uses the provided patters as the test value for memory.
 * If zero is provided as the pattern the test uses '0xDEADBEEF".
 *
+* <h2>Fast memory test</h2>
+*
+* Xil_TestMemFast32() runs the same subtests over large regions such as the
+* whole DDR. Memory is written and read in cache-line sized blocks, the
+* patterns are generated incrementally instead of per word, and a block is
+* only checked word by word once it is known to contain an error. Every
+* write pass is flushed out of the D-cache before the following read pass,
+* or the D-cache can be bypassed altogether with XIL_TESTMEM_FAST_NOCACHE.
+* Two subtests are only available in the fast test:
+*
+*  - XIL_TESTMEM_ADDRINADDR: Also known as the address-in-address test.
+* Each location holds its own address.
+*
+*  - XIL_TESTMEM_MOVINV: Moving inversions. The region is filled with the
+* pattern, then read and inverted in ascending order, then read and
+* restored in descending order, and finally verified.
+*
+* In the fast test XIL_TESTMEM_WALKONES and XIL_TESTMEM_WALKZEROS walk the
+* bit across the whole region, one position per word, instead of over the
+* first 32 words only.
+*
 * @warning
 * The tests are <b>DESTRUCTIVE</b>. Run before any initialized memory spaces
 * have been set up.
@@ -135,8 +156,40 @@ extern "C" {
 #define XIL_TESTMEM_INVERSEADDR     0x04U
 #define XIL_TESTMEM_FIXEDPATTERN    0x05U
 #define XIL_TESTMEM_MAXTEST         XIL_TESTMEM_FIXEDPATTERN
+#define XIL_TESTMEM_ADDRINADDR      0x06U
+#define XIL_TESTMEM_MOVINV          0x07U
+#define XIL_TESTMEM_FAST_MAXTEST    XIL_TESTMEM_MOVINV
+/* @} */
+
+/** @name Fast memory test options
+ * @{
+ */
+#define XIL_TESTMEM_FAST_NOCACHE    0x01U	/**< Disable the D-cache while testing */
 /* @} */
 
+/**
+ * Words tested between two calls of the progress callback
+ */
+#define XIL_TESTMEM_FAST_CHUNK      0x40000U
+
+/**
+ * Progress callback of Xil_TestMemFast32(). It is called after every
+ * XIL_TESTMEM_FAST_CHUNK words of a pass, and once more at the end of the
+ * pass. Pass counts up from 0 across all subtests that are run, Done is the
+ * number of words of the pass completed out of Words.
+ */
+typedef void (*Xil_TestMemProgress)(u8 Subtest, u32 Pass, u32 Done, u32 Words);
+
+/**
+ * Describes the first mismatch found by Xil_TestMemFast32()
+ */
+typedef struct {
+	u32 *Addr;		/**< Failing location */
+	u32 Expected;		/**< Value written */
+	u32 Actual;		/**< Value read back */
+	u8 Subtest;		/**< Subtest that failed */
+} XTestMemFault;
+
 /***************** Macros (Inline Functions) Definitions *********************/
 
 
@@ -147,6 +200,9 @@ extern "C" {
 extern s32 Xil_TestMem32(u32 *Addr, u32 Words, u32 Pattern, u8 Subtest);
 extern s32 Xil_TestMem16(u16 *Addr, u32 Words, u16 Pattern, u8 Subtest);
 extern s32 Xil_TestMem8(u8 *Addr, u32 Words, u8 Pattern, u8 Subtest);
+extern s32 Xil_TestMemFast32(u32 *Addr, u32 Words, u32 Pattern, u8 Subtest,
+			u32 Options, Xil_TestMemProgress Progress,
+			XTestMemFault *Fault);
 
 #ifdef __cplusplus
 }
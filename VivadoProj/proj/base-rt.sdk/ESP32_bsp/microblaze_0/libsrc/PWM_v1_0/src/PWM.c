@@ -35,3 +35,63 @@ void PWM_Disable(u32 baseAddr)
 {
 	Xil_Out32(baseAddr + PWM_AXI_CTRL_REG_OFFSET, 0);
 }
+
+int PWM_Shadow_Init(PWM_Shadow *Shadow, u32 baseAddr, u32 numChannels)
+{
+	u32 i;
+
+	if (numChannels == 0 || numChannels > PWM_MAX_CHANNELS) {
+		return XST_INVALID_PARAM;
+	}
+
+	Shadow->BaseAddr = baseAddr;
+	Shadow->NumChannels = numChannels;
+	Shadow->Period = PWM_Get_Period(baseAddr);
+	for (i = 0; i < numChannels; i++) {
+		Shadow->Duty[i] = PWM_Get_Duty(baseAddr, i);
+	}
+	return XST_SUCCESS;
+}
+
+u32 PWM_Update(PWM_Shadow *Shadow, u32 period, const u32 *duty, u32 mode)
+{
+	u32 baseAddr = Shadow->BaseAddr;
+	u32 writes = 0;
+	u32 i;
+
+	/*
+	 * Nothing changed, leave the core running
+	 */
+	if (period == Shadow->Period) {
+		for (i = 0; i < Shadow->NumChannels; i++) {
+			if (duty[i] != Shadow->Duty[i]) {
+				break;
+			}
+		}
+		if (i == Shadow->NumChannels) {
+			return 0;
+		}
+	}
+
+	if (mode == PWM_COMMIT_RESTART) {
+		Xil_Out32(baseAddr + PWM_AXI_CTRL_REG_OFFSET, 0);
+	}
+
+	for (i = 0; i < Shadow->NumChannels; i++) {
+		if (duty[i] != Shadow->Duty[i]) {
+			Xil_Out32(baseAddr + PWM_AXI_DUTY_REG_OFFSET + (4*i), duty[i]);
+			Shadow->Duty[i] = duty[i];
+			writes++;
+		}
+	}
+	if (period != Shadow->Period) {
+		Xil_Out32(baseAddr + PWM_AXI_PERIOD_REG_OFFSET, period);
+		Shadow->Period = period;
+		writes++;
+	}
+
+	if (mode == PWM_COMMIT_RESTART) {
+		Xil_Out32(baseAddr + PWM_AXI_CTRL_REG_OFFSET, 1);
+	}
+	return writes;
+}
@@ -120,6 +120,12 @@
 static void StubStatusHandler(void *CallBackRef, u32 StatusEvent,
 				unsigned int ByteCount);
 
+static void PolledWrite(XSpi *InstancePtr, u8 *SendBufPtr,
+			unsigned int Count);
+static void PolledRead(XSpi *InstancePtr, u8 *RecvBufPtr,
+			unsigned int Count);
+static void StartSegment(XSpi *InstancePtr, u32 ControlReg);
+
 void XSpi_Abort(XSpi *InstancePtr);
 
 /************************** Variable Definitions *****************************/
@@ -190,6 +196,8 @@ int XSpi_CfgInitialize(XSpi *InstancePtr, XSpi_Config *Config,
 	InstancePtr->RecvBufferPtr = NULL;
 	InstancePtr->RequestedBytes = 0;
 	InstancePtr->RemainingBytes = 0;
+	InstancePtr->SegmentPtr = NULL;
+	InstancePtr->SegmentsLeft = 0;
 	InstancePtr->BaseAddr = EffectiveAddr;
 	InstancePtr->HasFifos = Config->HasFifos;
 	InstancePtr->SlaveOnly = Config->SlaveOnly;
@@ -201,6 +209,7 @@ int XSpi_CfgInitialize(XSpi *InstancePtr, XSpi_Config *Config,
 	}
 
 	InstancePtr->SpiMode = Config->SpiMode;
+	InstancePtr->FifoDepth = Config->FifoDepth;
 
 	InstancePtr->FlashBaseAddr = Config->AxiFullBaseAddress;
 	InstancePtr->XipMode = Config->XipMode;
@@ -845,6 +854,276 @@ int XSpi_Transfer(XSpi *InstancePtr, u8 *SendBufPtr,
 	return XST_SUCCESS;
 }
 
+/*****************************************************************************/
+/**
+*
+* Transfers the specified data on the SPI bus as a master, polling the device
+* until the whole buffer has been sent and received. This is the bulk transfer
+* path for buffers much larger than the FIFO; short transfers can keep using
+* XSpi_Transfer().
+*
+* Unlike the polled mode of XSpi_Transfer(), the transmitter is never
+* inhibited between FIFO loads and the status register is not read after
+* every data register access:
+*  - The transmit FIFO is filled up to its depth before the transfer starts.
+*  - After that, the Rx FIFO occupancy register tells how many words have
+*    been shifted out since the last look. Those words are drained and the
+*    same number is written to the transmit FIFO, while the words still
+*    queued in it keep the bus busy.
+*  - The copy loops are selected once per transfer from the data width, so
+*    they contain no per-word width tests.
+* Words in flight never exceed the FIFO depth, so the receive FIFO cannot
+* overrun.
+*
+* The buffers follow the same rules as for XSpi_Transfer(). ByteCount must be
+* a multiple of the data width. The device interrupts are masked for the
+* duration of the transfer and restored on return.
+*
+* @param	InstancePtr is a pointer to the XSpi instance to be worked on.
+* @param	SendBufPtr is a pointer to a buffer of data which is to be sent.
+*		This buffer must not be NULL.
+* @param	RecvBufPtr is a pointer to a buffer which will be filled with
+*		received data. This argument can be NULL if the caller does not
+*		wish to receive data.
+* @param	ByteCount contains the number of bytes to send/receive.
+*
+* @return
+*		- XST_SUCCESS if the whole buffer has been transferred.
+*		- XST_DEVICE_IS_STOPPED if the device must be started before
+*		transferring data.
+*		- XST_DEVICE_BUSY indicates that a data transfer is already in
+*		progress.
+*		- XST_SPI_NOT_MASTER if the device is not configured as a
+*		master.
+*		- XST_SPI_NO_SLAVE indicates a slave has not yet been selected.
+*
+* @note
+*
+* This function is not thread-safe.
+*
+******************************************************************************/
+int XSpi_TransferPolled(XSpi *InstancePtr, u8 *SendBufPtr,
+			u8 *RecvBufPtr, unsigned int ByteCount)
+{
+	u32 ControlReg;
+	u32 GlobalIntrReg;
+	u32 StatusReg;
+	unsigned int Width;
+	unsigned int Words;
+	unsigned int Sent;
+	unsigned int Received;
+	unsigned int Count;
+
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(SendBufPtr != NULL);
+	Xil_AssertNonvoid(ByteCount > 0);
+	Xil_AssertNonvoid((ByteCount % (InstancePtr->DataWidth >> 3)) == 0);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	if (InstancePtr->IsStarted != XIL_COMPONENT_IS_STARTED) {
+		return XST_DEVICE_IS_STOPPED;
+	}
+
+	if (InstancePtr->IsBusy) {
+		return XST_DEVICE_BUSY;
+	}
+
+	ControlReg = XSpi_GetControlReg(InstancePtr);
+	if ((ControlReg & XSP_CR_MASTER_MODE_MASK) == 0) {
+		return XST_SPI_NOT_MASTER;
+	}
+
+	if (((ControlReg & XSP_CR_LOOPBACK_MASK) == 0) &&
+		(InstancePtr->SlaveSelectReg == InstancePtr->SlaveSelectMask)) {
+		return XST_SPI_NO_SLAVE;
+	}
+
+	/*
+	 * Keep the interrupt handler out of the way while the device is
+	 * being polled.
+	 */
+	GlobalIntrReg = XSpi_IsIntrGlobalEnabled(InstancePtr);
+	XSpi_IntrGlobalDisable(InstancePtr);
+
+	InstancePtr->IsBusy = TRUE;
+	InstancePtr->RequestedBytes = ByteCount;
+
+	Width = InstancePtr->DataWidth >> 3;
+	Words = ByteCount / Width;
+
+	/*
+	 * Prime the transmit FIFO while the transmitter is inhibited.
+	 */
+	Sent = InstancePtr->FifoDepth;
+	if (Sent == 0) {
+		Sent = 1;
+	}
+	if (Sent > Words) {
+		Sent = Words;
+	}
+	XSpi_SetControlReg(InstancePtr, ControlReg | XSP_CR_TRANS_INHIBIT_MASK);
+	PolledWrite(InstancePtr, SendBufPtr, Sent);
+
+	XSpi_SetSlaveSelectReg(InstancePtr, InstancePtr->SlaveSelectReg);
+	XSpi_SetControlReg(InstancePtr, ControlReg & ~XSP_CR_TRANS_INHIBIT_MASK);
+
+	Received = 0;
+	while (Received < Words) {
+		StatusReg = XSpi_GetStatusReg(InstancePtr);
+		if ((StatusReg & XSP_SR_RX_EMPTY_MASK) != 0) {
+			continue;
+		}
+
+		/*
+		 * The occupancy register holds the number of words in the
+		 * Rx FIFO minus one, and is only valid when it is not empty.
+		 */
+		if (InstancePtr->FifoDepth != 0) {
+			Count = XSpi_ReadReg(InstancePtr->BaseAddr,
+						XSP_RFO_OFFSET) + 1;
+		} else {
+			Count = 1;
+		}
+
+		PolledRead(InstancePtr, (RecvBufPtr == NULL) ? NULL :
+				RecvBufPtr + (Received * Width), Count);
+		Received += Count;
+
+		/*
+		 * Every word received freed a slot in the transmit FIFO. The
+		 * words still queued keep the bus busy while this runs.
+		 */
+		if (Sent < Words) {
+			unsigned int Refill = Words - Sent;
+			if (Refill > Count) {
+				Refill = Count;
+			}
+			PolledWrite(InstancePtr, SendBufPtr + (Sent * Width),
+					Refill);
+			Sent += Refill;
+		}
+	}
+
+	ControlReg = XSpi_GetControlReg(InstancePtr);
+	XSpi_SetControlReg(InstancePtr, ControlReg | XSP_CR_TRANS_INHIBIT_MASK);
+	XSpi_SetSlaveSelectReg(InstancePtr, InstancePtr->SlaveSelectMask);
+
+	InstancePtr->Stats.BytesTransferred += ByteCount;
+	InstancePtr->RemainingBytes = 0;
+	InstancePtr->IsBusy = FALSE;
+
+	if (GlobalIntrReg == TRUE) {
+		XSpi_IntrGlobalEnable(InstancePtr);
+	}
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+*
+* Transfers a list of segments on the SPI bus as a master, back to back, from
+* the interrupt service routine. This is meant for devices where one
+* operation is made of several phases, such as command, address and data:
+* each phase is a segment pointing straight at the caller's buffers, and the
+* whole list costs one call and one completion callback.
+*
+* Each segment starts once the previous one has been completely received. If
+* KeepSelected is clear the slave is deselected at the end of the segment and
+* selected again when the next one starts, otherwise it stays selected so the
+* next segment continues the same bus transaction. The slave is always
+* deselected after the last segment. Holding the slave select between FIFO
+* loads requires the XSP_MANUAL_SSELECT_OPTION option.
+*
+* The status handler is called once with XST_SPI_TRANSFER_DONE and the total
+* number of bytes when the whole list is done, or with an error event as for
+* XSpi_Transfer().
+*
+* @param	InstancePtr is a pointer to the XSpi instance to be worked on.
+* @param	SegmentPtr is the first entry of an array of segments. The
+*		array and the buffers it points to must remain valid until the
+*		list completes.
+* @param	NumSegments is the number of entries in the array.
+*
+* @return
+*		- XST_SUCCESS if the list has been started.
+*		- XST_DEVICE_IS_STOPPED if the device must be started before
+*		transferring data.
+*		- XST_DEVICE_BUSY indicates that a data transfer is already in
+*		progress.
+*		- XST_NOT_INTERRUPT if the device global interrupt is disabled,
+*		lists are only run in interrupt mode.
+*		- XST_SPI_NOT_MASTER if the device is not configured as a
+*		master.
+*		- XST_SPI_NO_SLAVE indicates a slave has not yet been selected.
+*
+* @note
+*
+* This function is not thread-safe.
+*
+******************************************************************************/
+int XSpi_TransferList(XSpi *InstancePtr, XSpi_Segment *SegmentPtr,
+			unsigned int NumSegments)
+{
+	u32 ControlReg;
+	unsigned int Index;
+	unsigned int TotalBytes = 0;
+
+	Xil_AssertNonvoid(InstancePtr != NULL);
+	Xil_AssertNonvoid(SegmentPtr != NULL);
+	Xil_AssertNonvoid(NumSegments > 0);
+	Xil_AssertNonvoid(InstancePtr->IsReady == XIL_COMPONENT_IS_READY);
+
+	for (Index = 0; Index < NumSegments; Index++) {
+		Xil_AssertNonvoid(SegmentPtr[Index].SendBufPtr != NULL);
+		Xil_AssertNonvoid(SegmentPtr[Index].ByteCount > 0);
+		Xil_AssertNonvoid((SegmentPtr[Index].ByteCount %
+				(InstancePtr->DataWidth >> 3)) == 0);
+		TotalBytes += SegmentPtr[Index].ByteCount;
+	}
+
+	if (InstancePtr->IsStarted != XIL_COMPONENT_IS_STARTED) {
+		return XST_DEVICE_IS_STOPPED;
+	}
+
+	if (InstancePtr->IsBusy) {
+		return XST_DEVICE_BUSY;
+	}
+
+	if (XSpi_IsIntrGlobalEnabled(InstancePtr) != TRUE) {
+		return XST_NOT_INTERRUPT;
+	}
+
+	/*
+	 * Enter a critical section until the first segment is loaded.
+	 */
+	XSpi_IntrGlobalDisable(InstancePtr);
+
+	ControlReg = XSpi_GetControlReg(InstancePtr);
+	if ((ControlReg & XSP_CR_MASTER_MODE_MASK) == 0) {
+		XSpi_IntrGlobalEnable(InstancePtr);
+		return XST_SPI_NOT_MASTER;
+	}
+
+	if (((ControlReg & XSP_CR_LOOPBACK_MASK) == 0) &&
+		(InstancePtr->SlaveSelectReg == InstancePtr->SlaveSelectMask)) {
+		XSpi_IntrGlobalEnable(InstancePtr);
+		return XST_SPI_NO_SLAVE;
+	}
+
+	InstancePtr->IsBusy = TRUE;
+	InstancePtr->RequestedBytes = TotalBytes;
+	InstancePtr->SegmentPtr = SegmentPtr;
+	InstancePtr->SegmentsLeft = NumSegments;
+
+	StartSegment(InstancePtr, ControlReg & ~XSP_CR_TRANS_INHIBIT_MASK);
+
+	XSpi_IntrEnable(InstancePtr, XSP_INTR_TX_EMPTY_MASK);
+	XSpi_IntrGlobalEnable(InstancePtr);
+
+	return XST_SUCCESS;
+}
+
 /*****************************************************************************/
 /**
 *
@@ -1248,6 +1527,18 @@ void XSpi_InterruptHandler(void *InstancePtr)
 			 * any longer.
 			 */
 			XSpi_SetControlReg(SpiPtr, ControlReg);
+		} else if (SpiPtr->SegmentsLeft > 0) {
+			/*
+			 * The current segment of a transaction list is done,
+			 * all of its data has been received. End the bus
+			 * transaction unless the segment asked to keep the
+			 * slave selected, then start the next segment.
+			 */
+			if (!(SpiPtr->SegmentPtr - 1)->KeepSelected) {
+				XSpi_SetSlaveSelectReg(SpiPtr,
+						SpiPtr->SlaveSelectMask);
+			}
+			StartSegment(SpiPtr, ControlReg);
 		} else {
 
 			/*
@@ -1387,7 +1678,137 @@ void XSpi_Abort(XSpi *InstancePtr)
 
 	InstancePtr->RemainingBytes = 0;
 	InstancePtr->RequestedBytes = 0;
+	InstancePtr->SegmentsLeft = 0;
 	InstancePtr->IsBusy = FALSE;
 }
 
 /** @} */
+
+/*****************************************************************************/
+/**
+*
+* Writes Count words of the instance data width from a buffer to the transmit
+* FIFO, with one loop per width so there is no test per word.
+*
+* @param	InstancePtr is a pointer to the XSpi instance to be worked on.
+* @param	SendBufPtr is the first byte to send.
+* @param	Count is the number of words to write.
+*
+* @return	None.
+*
+* @note		The caller guarantees there is room for Count words.
+*
+******************************************************************************/
+static void PolledWrite(XSpi *InstancePtr, u8 *SendBufPtr,
+			unsigned int Count)
+{
+	UINTPTR Dtr = InstancePtr->BaseAddr + XSP_DTR_OFFSET;
+	unsigned int Index;
+
+	if (InstancePtr->DataWidth == XSP_DATAWIDTH_BYTE) {
+		for (Index = 0; Index < Count; Index++) {
+			XSpi_Out32(Dtr, SendBufPtr[Index]);
+		}
+	} else if (InstancePtr->DataWidth == XSP_DATAWIDTH_HALF_WORD) {
+		u16 *BufPtr = (u16 *)SendBufPtr;
+		for (Index = 0; Index < Count; Index++) {
+			XSpi_Out32(Dtr, BufPtr[Index]);
+		}
+	} else {
+		u32 *BufPtr = (u32 *)SendBufPtr;
+		for (Index = 0; Index < Count; Index++) {
+			XSpi_Out32(Dtr, BufPtr[Index]);
+		}
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Reads Count words of the instance data width from the receive FIFO into a
+* buffer, or discards them if the buffer is NULL, with one loop per width so
+* there is no test per word.
+*
+* @param	InstancePtr is a pointer to the XSpi instance to be worked on.
+* @param	RecvBufPtr is where the first byte is stored, or NULL.
+* @param	Count is the number of words to read.
+*
+* @return	None.
+*
+* @note		The caller guarantees Count words are in the FIFO.
+*
+******************************************************************************/
+static void PolledRead(XSpi *InstancePtr, u8 *RecvBufPtr,
+			unsigned int Count)
+{
+	UINTPTR Drr = InstancePtr->BaseAddr + XSP_DRR_OFFSET;
+	unsigned int Index;
+
+	if (RecvBufPtr == NULL) {
+		for (Index = 0; Index < Count; Index++) {
+			(void)XSpi_In32(Drr);
+		}
+	} else if (InstancePtr->DataWidth == XSP_DATAWIDTH_BYTE) {
+		for (Index = 0; Index < Count; Index++) {
+			RecvBufPtr[Index] = (u8)XSpi_In32(Drr);
+		}
+	} else if (InstancePtr->DataWidth == XSP_DATAWIDTH_HALF_WORD) {
+		u16 *BufPtr = (u16 *)RecvBufPtr;
+		for (Index = 0; Index < Count; Index++) {
+			BufPtr[Index] = (u16)XSpi_In32(Drr);
+		}
+	} else {
+		u32 *BufPtr = (u32 *)RecvBufPtr;
+		for (Index = 0; Index < Count; Index++) {
+			BufPtr[Index] = XSpi_In32(Drr);
+		}
+	}
+}
+
+/*****************************************************************************/
+/**
+*
+* Starts the next segment of a transaction list: points the transfer state at
+* its buffers, loads the first FIFO worth of data while the transmitter is
+* inhibited, selects the slave and releases the transmitter. The rest of the
+* segment is sent by the interrupt handler as for XSpi_Transfer().
+*
+* @param	InstancePtr is a pointer to the XSpi instance to be worked on.
+* @param	ControlReg is the control register value to run with, the
+*		transmitter must not be inhibited in it.
+*
+* @return	None.
+*
+* @note		Called with the transmit FIFO empty and the device interrupt
+*		masked or from the interrupt handler.
+*
+******************************************************************************/
+static void StartSegment(XSpi *InstancePtr, u32 ControlReg)
+{
+	XSpi_Segment *SegmentPtr = InstancePtr->SegmentPtr;
+	unsigned int Width = InstancePtr->DataWidth >> 3;
+	unsigned int Count;
+
+	InstancePtr->SegmentPtr++;
+	InstancePtr->SegmentsLeft--;
+
+	InstancePtr->SendBufferPtr = SegmentPtr->SendBufPtr;
+	InstancePtr->RecvBufferPtr = SegmentPtr->RecvBufPtr;
+	InstancePtr->RemainingBytes = SegmentPtr->ByteCount;
+
+	XSpi_SetControlReg(InstancePtr, ControlReg | XSP_CR_TRANS_INHIBIT_MASK);
+
+	Count = InstancePtr->FifoDepth;
+	if (Count == 0) {
+		Count = 1;
+	}
+	if (Count > (InstancePtr->RemainingBytes / Width)) {
+		Count = InstancePtr->RemainingBytes / Width;
+	}
+	PolledWrite(InstancePtr, InstancePtr->SendBufferPtr, Count);
+	InstancePtr->SendBufferPtr += Count * Width;
+	InstancePtr->RemainingBytes -= Count * Width;
+
+	XSpi_SetSlaveSelectReg(InstancePtr, InstancePtr->SlaveSelectReg);
+	XSpi_SetControlReg(InstancePtr, ControlReg);
+}
@@ -394,6 +394,20 @@ typedef struct {
 	u32 NumInterrupts;	/**< Number of transmit/receive interrupts */
 } XSpi_Stats;
 
+/**
+ * One segment of a transaction list passed to XSpi_TransferList(). The
+ * buffers follow the same rules as for XSpi_Transfer() and are used in
+ * place, they must stay valid until the list completes.
+ */
+typedef struct {
+	u8 *SendBufPtr;		/**< Data to send, must not be NULL */
+	u8 *RecvBufPtr;		/**< Buffer for received data, or NULL */
+	unsigned int ByteCount;	/**< Bytes to send/receive */
+	u8 KeepSelected;	/**< Leave the slave selected after this
+				  *  segment, so the next one continues the
+				  *  same bus transaction */
+} XSpi_Segment;
+
 /**
  * This typedef contains configuration information for the device.
  */
@@ -410,6 +424,7 @@ typedef struct {
 					the device */
 	u8 XipMode;             /**< 0 if Non-XIP, 1 if XIP Mode */
 	u8 Use_Startup;		/**< 1 if Starup block is used in h/w */
+	u16 FifoDepth;		/**< Depth of the Tx and Rx FIFOs, 0 if none */
 } XSpi_Config;
 
 /**
@@ -440,6 +455,10 @@ typedef struct {
 	void *StatusRef;	/**< Callback reference for status handler */
 	u32 FlashBaseAddr;    	/**< Used in XIP Mode */
 	u8 XipMode;             /**< 0 if Non-XIP, 1 if XIP Mode */
+	u16 FifoDepth;		/**< Depth of the Tx and Rx FIFOs, 0 if none */
+
+	XSpi_Segment *SegmentPtr; /**< Next segment of a list (state) */
+	unsigned int SegmentsLeft; /**< Segments not yet started (state) */
 } XSpi;
 
 /***************** Macros (Inline Functions) Definitions *********************/
@@ -822,6 +841,10 @@ u32 XSpi_GetSlaveSelect(XSpi *InstancePtr);
 
 int XSpi_Transfer(XSpi *InstancePtr, u8 *SendBufPtr, u8 *RecvBufPtr,
 		  unsigned int ByteCount);
+int XSpi_TransferPolled(XSpi *InstancePtr, u8 *SendBufPtr, u8 *RecvBufPtr,
+			unsigned int ByteCount);
+int XSpi_TransferList(XSpi *InstancePtr, XSpi_Segment *SegmentPtr,
+			unsigned int NumSegments);
 
 void XSpi_SetStatusHandler(XSpi *InstancePtr, void *CallBackRef,
 			   XSpi_StatusHandler FuncPtr);
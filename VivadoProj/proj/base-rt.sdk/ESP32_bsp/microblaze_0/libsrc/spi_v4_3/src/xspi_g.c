@@ -57,7 +57,8 @@ XSpi_Config XSpi_ConfigTable[] =
 		XPAR_SPI_0_TYPE_OF_AXI4_INTERFACE,
 		XPAR_SPI_0_AXI4_BASEADDR,
 		XPAR_SPI_0_XIP_MODE,
-		XPAR_SPI_0_USE_STARTUP
+		XPAR_SPI_0_USE_STARTUP,
+		XPAR_SPI_0_FIFO_DEPTH
 	}
 };
 
@@ -54,6 +54,88 @@ s32 searchpc(const struct fromstruct *froms, s32 fromssize, u32 frompc );
 
 /*extern struct gmonparam *_gmonparam, */
 
+#ifndef PROFILE_NO_FUNCPTR
+/*
+ * Hash arena. A slot is in use only if its generation matches cggen, so
+ * bumping cggen empties both tables at once. froms indices are stored
+ * plus one.
+ */
+struct arcslot {
+	u32 frompc;
+	u32 selfpc;
+	struct tostruct *to;
+	u32 gen;
+};
+
+struct fromslot {
+	u32 frompc;
+	u32 index;
+	u32 gen;
+};
+
+static struct arcslot arcslots[PROFILE_CG_HASH_SIZE];
+static struct fromslot fromslots[PROFILE_CG_HASH_SIZE];
+static u32 arcsused;
+static u32 fromsused;
+static u32 cggen = 1U;
+
+u32 profile_cg_overflows = 0U;
+u32 profile_cg_collisions = 0U;
+u32 profile_cg_max_froms = 0U;
+u32 profile_cg_max_tos = 0U;
+u32 profile_cg_pause_timer = 1U;
+
+#define PROFILE_CG_HASH_MASK	(PROFILE_CG_HASH_SIZE - 1U)
+#define PROFILE_CG_HASH_FULL	((PROFILE_CG_HASH_SIZE / 4U) * 3U)
+
+static inline u32 cghash(u32 frompc, u32 selfpc)
+{
+	/* Instructions are word aligned, drop the two zero bits */
+	u32 h = ((frompc >> 2U) * 0x9E3779B1U) ^ ((selfpc >> 2U) * 0x85EBCA6BU);
+	return (h ^ (h >> 15U)) & PROFILE_CG_HASH_MASK;
+}
+
+/*
+ * Returns the arc slot for (frompc, selfpc): the one holding it, or the
+ * empty slot where it belongs.
+ */
+static struct arcslot *findarc(u32 frompc, u32 selfpc)
+{
+	u32 i = cghash(frompc, selfpc);
+
+	while ((arcslots[i].gen == cggen) &&
+	       ((arcslots[i].frompc != frompc) || (arcslots[i].selfpc != selfpc))) {
+		profile_cg_collisions++;
+		i = (i + 1U) & PROFILE_CG_HASH_MASK;
+	}
+	return &arcslots[i];
+}
+
+static struct fromslot *findfrom(u32 frompc)
+{
+	u32 i = cghash(frompc, 0U);
+
+	while ((fromslots[i].gen == cggen) && (fromslots[i].frompc != frompc)) {
+		profile_cg_collisions++;
+		i = (i + 1U) & PROFILE_CG_HASH_MASK;
+	}
+	return &fromslots[i];
+}
+
+void profile_cg_reset(void)
+{
+	cggen++;
+	/* Slots written before a wrap would look current again */
+	if (cggen == 0U) {
+		(void)memset(arcslots, 0, sizeof(arcslots));
+		(void)memset(fromslots, 0, sizeof(fromslots));
+		cggen = 1U;
+	}
+	arcsused = 0U;
+	fromsused = 0U;
+}
+#endif		/* PROFILE_NO_FUNCPTR */
+
 #ifdef PROFILE_NO_FUNCPTR
 s32 searchpc(const struct fromto_struct *cgtable, s32 cgtable_size, u32 frompc )
 {
@@ -92,8 +174,19 @@ void mcount( u32 frompc, u32 selfpc )
 	register struct gmonparam *p = NULL;
 	register s32 toindex, fromindex;
 	s32 j;
+#ifndef PROFILE_NO_FUNCPTR
+	struct arcslot *arc;
+	struct fromslot *from;
+#endif
+
+	/* No debugger and no application arena, nothing to record into */
+	if (_gmonparam == GMONPARAM_UNSET) {
+		return;
+	}
 
-	disable_timer();
+	if (profile_cg_pause_timer != 0U) {
+		disable_timer();
+	}
 
 	/*print("CG: "), putnum(frompc), print("->"), putnum(selfpc), print("\r\n") ,
 	 * check that frompcindex is a reasonable pc value.
@@ -122,17 +215,45 @@ void mcount( u32 frompc, u32 selfpc )
 	}
 	p->cgtable[fromindex].count++ ;
 #else
-	fromindex = (s32)searchpc( p->froms, ((s32)p->fromssize), frompc ) ;
+	/*
+	 * Common case: the arc has been seen before
+	 */
+	arc = findarc(frompc, selfpc);
+	if (arc->gen == cggen) {
+		arc->to->count++ ;
+		goto done ;
+	}
+
+	from = findfrom(frompc);
+	if (from->gen == cggen) {
+		fromindex = ((s32)from->index) - 1 ;
+	} else if (fromsused < PROFILE_CG_HASH_FULL) {
+		/* Every from PC is hashed until the table fills, so this is new */
+		fromindex = -1 ;
+	} else {
+		fromindex = (s32)searchpc( p->froms, ((s32)p->fromssize), frompc ) ;
+	}
+
 	if( fromindex == -1 ) {
+		/* A from PC with no room for its arc would only waste a slot */
+		if (((profile_cg_max_froms != 0U) && (p->fromssize >= profile_cg_max_froms)) ||
+			((profile_cg_max_tos != 0U) && (p->tossize >= profile_cg_max_tos))) {
+			goto overflow ;
+		}
 		fromindex = (s32)p->fromssize ;
 		p->fromssize++ ;
-		/*if( fromindex >= N_FROMS ) {
-		* print("Error : From PC table overflow\r\n")
-		* goto overflow
-		*}*/
 		p->froms[fromindex].frompc = frompc ;
 		p->froms[fromindex].link = -1 ;
-	}else {
+		if (fromsused < PROFILE_CG_HASH_FULL) {
+			from->frompc = frompc ;
+			from->index = ((u32)fromindex) + 1U ;
+			from->gen = cggen ;
+			fromsused++ ;
+		} else {
+			profile_cg_overflows++ ;
+		}
+	} else if (arcsused >= PROFILE_CG_HASH_FULL) {
+		/* Arcs added since the table filled are only on the link chain */
 		toindex = ((s32)(p->froms[fromindex].link));
 		while(toindex != -1) {
 			toindex = (((s32)p->tossize) - toindex)-1 ;
@@ -145,25 +266,41 @@ void mcount( u32 frompc, u32 selfpc )
 	}
 
 	/*if( toindex == -1 ) { */
+	if ((profile_cg_max_tos != 0U) && (p->tossize >= profile_cg_max_tos)) {
+		goto overflow ;
+	}
 	p->tos-- ;
 	p->tossize++ ;
-	/* if( toindex >= N_TOS ) {
-	* print("Error : To PC table overflow\r\n")
-	* goto overflow
-	*} */
 	p->tos[0].selfpc = selfpc ;
 	p->tos[0].count = 1 ;
 	p->tos[0].link = p->froms[fromindex].link ;
 	p->froms[fromindex].link = ((s32)(p->tossize))-((s32)1);
+
+	/* tos grows downwards, so existing entries never move */
+	if (arcsused < PROFILE_CG_HASH_FULL) {
+		arc->frompc = frompc ;
+		arc->selfpc = selfpc ;
+		arc->to = &p->tos[0] ;
+		arc->gen = cggen ;
+		arcsused++ ;
+	} else {
+		profile_cg_overflows++ ;
+	}
 #endif
 
  done:
-	p->state = GMON_PROF_ON;
+	if (p != NULL) {
+		p->state = GMON_PROF_ON;
+	}
 	goto enable_timer_label ;
- /* overflow: */
-	/*p->state = GMON_PROF_ERROR */
+#ifndef PROFILE_NO_FUNCPTR
+ overflow:
+	profile_cg_overflows++ ;
+#endif
  enable_timer_label:
-	enable_timer();
+	if (profile_cg_pause_timer != 0U) {
+		enable_timer();
+	}
 	return ;
 }
 
@@ -51,11 +51,39 @@
 
 #include "xil_types.h"
 
+/************************** Constant Definitions ****************************/
+
+/*
+ * Below this many bytes the head/tail handling costs more than it saves,
+ * so the copy is done a byte at a time
+ */
+#define XIL_MEM_SMALL_COPY	16U
+
+#define XIL_MEM_WORD_MASK	3U
+
+/*
+ * Shift-merge helpers. A destination word is built from the top of the
+ * previous aligned source word and the bottom of the next one; which end
+ * is the "top" depends on the byte order
+ */
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define XIL_MEM_MERGE(Prev, Next, Shift) \
+	(((Prev) << (Shift)) | ((Next) >> (32U - (Shift))))
+#else
+#define XIL_MEM_MERGE(Prev, Next, Shift) \
+	(((Prev) >> (Shift)) | ((Next) << (32U - (Shift))))
+#endif
+
 /***************** Inline Functions Definitions ********************/
 /*****************************************************************************/
 /**
 * @brief       This  function copies memory from once location to other.
 *
+* The destination is brought to word alignment a byte at a time. If the
+* source is then word aligned too, words are copied eight per iteration;
+* otherwise aligned source words are read and shifted together so that no
+* unaligned access is ever issued. Trailing bytes are copied one at a time.
+*
 * @param       dst: pointer pointing to destination memory
 *
 * @param       src: pointer pointing to source memory
@@ -65,19 +93,145 @@
 *****************************************************************************/
 void Xil_MemCpy(void* dst, const void* src, u32 cnt)
 {
-	char *d = (char*)(void *)dst;
-	const char *s = src;
+	u8 *d = (u8 *)dst;
+	const u8 *s = (const u8 *)src;
+	u32 *dw;
+	const u32 *sw;
+	u32 Offset;
+	u32 Shift;
+	u32 Prev;
+	u32 Next;
+
+	if (cnt >= XIL_MEM_SMALL_COPY) {
+		while (((UINTPTR)d & XIL_MEM_WORD_MASK) != 0U) {
+			*d = *s;
+			d++;
+			s++;
+			cnt--;
+		}
+
+		dw = (u32 *)(void *)d;
+		Offset = (UINTPTR)s & XIL_MEM_WORD_MASK;
 
-	while (cnt >= sizeof (int)) {
-		*(int*)d = *(int*)s;
-		d += sizeof (int);
-		s += sizeof (int);
-		cnt -= sizeof (int);
+		if (Offset == 0U) {
+			sw = (const u32 *)(const void *)s;
+			while (cnt >= 32U) {
+				dw[0] = sw[0];
+				dw[1] = sw[1];
+				dw[2] = sw[2];
+				dw[3] = sw[3];
+				dw[4] = sw[4];
+				dw[5] = sw[5];
+				dw[6] = sw[6];
+				dw[7] = sw[7];
+				dw += 8;
+				sw += 8;
+				cnt -= 32U;
+			}
+			while (cnt >= 4U) {
+				*dw = *sw;
+				dw++;
+				sw++;
+				cnt -= 4U;
+			}
+			s = (const u8 *)(const void *)sw;
+		} else {
+			/*
+			 * Every aligned word read here holds at least one byte
+			 * that is part of the copy, so nothing past the end of
+			 * the source buffer is touched
+			 */
+			Shift = Offset * 8U;
+			sw = (const u32 *)(const void *)(s - Offset);
+			Prev = *sw;
+			sw++;
+			while (cnt >= 16U) {
+				Next = sw[0];
+				dw[0] = XIL_MEM_MERGE(Prev, Next, Shift);
+				Prev = sw[1];
+				dw[1] = XIL_MEM_MERGE(Next, Prev, Shift);
+				Next = sw[2];
+				dw[2] = XIL_MEM_MERGE(Prev, Next, Shift);
+				Prev = sw[3];
+				dw[3] = XIL_MEM_MERGE(Next, Prev, Shift);
+				dw += 4;
+				sw += 4;
+				cnt -= 16U;
+			}
+			while (cnt >= 4U) {
+				Next = *sw;
+				*dw = XIL_MEM_MERGE(Prev, Next, Shift);
+				Prev = Next;
+				dw++;
+				sw++;
+				cnt -= 4U;
+			}
+			s = (const u8 *)(const void *)sw - 4U + Offset;
+		}
+		d = (u8 *)(void *)dw;
 	}
-	while ((cnt) > 0U){
+
+	while (cnt > 0U) {
 		*d = *s;
-		d += 1U;
-		s += 1U;
-		cnt -= 1U;
+		d++;
+		s++;
+		cnt--;
+	}
+}
+
+/*****************************************************************************/
+/**
+* @brief       This function fills memory with a byte value.
+*
+* The destination is brought to word alignment a byte at a time, filled
+* eight words per iteration, and the remaining bytes are set one at a time.
+*
+* @param       dst: pointer pointing to destination memory
+*
+* @param       val: value whose low byte is written to every location
+*
+* @param       cnt: 32 bit length of bytes to be set
+*
+*****************************************************************************/
+void Xil_MemSet(void* dst, s32 val, u32 cnt)
+{
+	u8 *d = (u8 *)dst;
+	u8 Byte = (u8)val;
+	u32 Word;
+	u32 *dw;
+
+	if (cnt >= XIL_MEM_SMALL_COPY) {
+		while (((UINTPTR)d & XIL_MEM_WORD_MASK) != 0U) {
+			*d = Byte;
+			d++;
+			cnt--;
+		}
+
+		Word = (u32)Byte * 0x01010101U;
+		dw = (u32 *)(void *)d;
+		while (cnt >= 32U) {
+			dw[0] = Word;
+			dw[1] = Word;
+			dw[2] = Word;
+			dw[3] = Word;
+			dw[4] = Word;
+			dw[5] = Word;
+			dw[6] = Word;
+			dw[7] = Word;
+			dw += 8;
+			cnt -= 32U;
+		}
+		while (cnt >= 4U) {
+			*dw = Word;
+			dw++;
+			cnt -= 4U;
+		}
+		d = (u8 *)(void *)dw;
+	}
+
+	while (cnt > 0U) {
+		*d = Byte;
+		d++;
+		cnt--;
 	}
 }
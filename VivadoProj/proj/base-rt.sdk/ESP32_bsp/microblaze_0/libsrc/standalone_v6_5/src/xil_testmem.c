@@ -50,8 +50,17 @@
 #include "xil_testmem.h"
 #include "xil_io.h"
 #include "xil_assert.h"
+#include "xil_cache.h"
 
 /************************** Constant Definitions ****************************/
+
+/*
+ * Operations of one pass of the fast test
+ */
+#define FAST_FILL		0U	/* write the generated pattern */
+#define FAST_VERIFY		1U	/* check the generated pattern */
+#define FAST_INVERT_UP		2U	/* check constant, write inverse, ascending */
+#define FAST_INVERT_DOWN	3U	/* check constant, write inverse, descending */
 /************************** Function Prototypes *****************************/
 
 static u32 RotateLeft(u32 Input, u8 Width);
@@ -62,6 +71,9 @@ static u32 RotateLeft(u32 Input, u8 Width);
 static u32 RotateRight(u32 Input, u8 Width);
 #endif /* ROTATE_RIGHT */
 
+static s32 FastPass(u32 *Addr, u32 Words, u32 Op, u32 Val, u32 Rot,
+			u32 Step, u8 Subtest, u32 Pass, u32 Options,
+			Xil_TestMemProgress Progress, XTestMemFault *Fault);
 
 /*****************************************************************************/
 /**
@@ -769,6 +781,129 @@ End_Label:
 }
 
 
+/*****************************************************************************/
+/**
+*
+* @brief    Perform a fast destructive 32-bit wide memory test over a large
+*           region. See the fast memory test description in xil_testmem.h.
+*
+* @param    Addr: pointer to the region of memory to be tested.
+* @param    Words: length of the block.
+* @param    Pattern: constant used for the fixed pattern and moving
+*           inversions tests, if 0, 0xDEADBEEF is used.
+* @param    Subtest: test type selected, up to XIL_TESTMEM_FAST_MAXTEST.
+*           XIL_TESTMEM_ALLMEMTESTS runs every subtest in turn.
+* @param    Options: XIL_TESTMEM_FAST_NOCACHE to disable the D-cache for
+*           the duration of the test, 0 otherwise.
+* @param    Progress: called as the test advances, may be NULL.
+* @param    Fault: filled in with the first mismatch, may be NULL.
+*
+* @return
+*           - 0 is returned for a pass
+*           - -1 is returned for a failure
+*
+* @note
+* With XIL_TESTMEM_FAST_NOCACHE the D-cache is enabled again on return,
+* whatever its state was on entry.
+*
+*****************************************************************************/
+s32 Xil_TestMemFast32(u32 *Addr, u32 Words, u32 Pattern, u8 Subtest,
+			u32 Options, Xil_TestMemProgress Progress,
+			XTestMemFault *Fault)
+{
+	u8 Test;
+	u32 Pass = 0U;
+	u32 Start;
+	u32 Rot;
+	u32 Step;
+	u32 Fixed;
+	s32 Status = 0;
+
+	Xil_AssertNonvoid(Words != (u32)0);
+	Xil_AssertNonvoid(Subtest <= (u8)XIL_TESTMEM_FAST_MAXTEST);
+	Xil_AssertNonvoid(Addr != NULL);
+
+	if (Pattern == (u32)0) {
+		Fixed = 0xDEADBEEFU;
+	}
+	else {
+		Fixed = Pattern;
+	}
+
+	if ((Options & XIL_TESTMEM_FAST_NOCACHE) != 0U) {
+		Xil_DCacheDisable();
+	}
+
+	for (Test = 1U; Test <= (u8)XIL_TESTMEM_FAST_MAXTEST; Test++) {
+		if ((Subtest != XIL_TESTMEM_ALLMEMTESTS) && (Subtest != Test)) {
+			continue;
+		}
+
+		/*
+		 * Every pattern is generated as Next = RotateLeft(Val, Rot) + Step
+		 */
+		Rot = 0U;
+		Step = 0U;
+		switch (Test) {
+		case XIL_TESTMEM_INCREMENT:
+			Start = XIL_TESTMEM_INIT_VALUE;
+			Step = 1U;
+			break;
+		case XIL_TESTMEM_WALKONES:
+			Start = 1U;
+			Rot = 1U;
+			break;
+		case XIL_TESTMEM_WALKZEROS:
+			Start = ~1U;
+			Rot = 1U;
+			break;
+		case XIL_TESTMEM_INVERSEADDR:
+			Start = (u32) (~((INTPTR) Addr));
+			Step = (u32)0 - (u32)sizeof(u32);
+			break;
+		case XIL_TESTMEM_ADDRINADDR:
+			Start = (u32) ((INTPTR) Addr);
+			Step = (u32)sizeof(u32);
+			break;
+		default:
+			Start = Fixed;
+			break;
+		}
+
+		Status = FastPass(Addr, Words, FAST_FILL, Start, Rot, Step, Test,
+				Pass, Options, Progress, Fault);
+		Pass++;
+
+		if ((Status == 0) && (Test == XIL_TESTMEM_MOVINV)) {
+			Status = FastPass(Addr, Words, FAST_INVERT_UP, Fixed, 0U, 0U,
+					Test, Pass, Options, Progress, Fault);
+			Pass++;
+			if (Status == 0) {
+				Status = FastPass(Addr, Words, FAST_INVERT_DOWN, ~Fixed,
+						0U, 0U, Test, Pass, Options, Progress,
+						Fault);
+				Pass++;
+			}
+		}
+
+		if (Status == 0) {
+			Status = FastPass(Addr, Words, FAST_VERIFY, Start, Rot, Step,
+					Test, Pass, Options, Progress, Fault);
+			Pass++;
+		}
+
+		if (Status != 0) {
+			break;
+		}
+	}
+
+	if ((Options & XIL_TESTMEM_FAST_NOCACHE) != 0U) {
+		Xil_DCacheEnable();
+	}
+
+	return Status;
+}
+
 /*****************************************************************************/
 /**
 *
@@ -866,3 +1001,216 @@ static u32 RotateRight(u32 Input, u8 Width)
 
 }
 #endif /* ROTATE_RIGHT */
+
+
+/*****************************************************************************/
+/**
+*
+* @brief    Next value of an incrementally generated fast test pattern.
+*
+*****************************************************************************/
+static INLINE u32 FastNext(u32 Val, u32 Rot, u32 Step)
+{
+	return ((Val << Rot) | (Val >> ((32U - Rot) & 31U))) + Step;
+}
+
+/*****************************************************************************/
+/**
+*
+* @brief    Record a fast test mismatch.
+*
+*****************************************************************************/
+static s32 FastFault(XTestMemFault *Fault, u32 *Addr, u32 Expected,
+			u8 Subtest)
+{
+	if (Fault != NULL) {
+		Fault->Addr = Addr;
+		Fault->Expected = Expected;
+		Fault->Actual = *Addr;
+		Fault->Subtest = Subtest;
+	}
+	return -1;
+}
+
+/*****************************************************************************/
+/**
+*
+* @brief    Fill a chunk with a generated pattern, four words (one cache
+*           line) at a time.
+*
+* @return   The pattern value for the word following the chunk.
+*
+*****************************************************************************/
+static u32 FastFill(u32 *Addr, u32 Words, u32 Val, u32 Rot, u32 Step)
+{
+	u32 *End = Addr + (Words & ~3U);
+	u32 V0;
+	u32 V1;
+	u32 V2;
+	u32 V3;
+
+	while (Addr < End) {
+		V0 = Val;
+		V1 = FastNext(V0, Rot, Step);
+		V2 = FastNext(V1, Rot, Step);
+		V3 = FastNext(V2, Rot, Step);
+		Addr[0] = V0;
+		Addr[1] = V1;
+		Addr[2] = V2;
+		Addr[3] = V3;
+		Val = FastNext(V3, Rot, Step);
+		Addr += 4;
+	}
+
+	End = Addr + (Words & 3U);
+	while (Addr < End) {
+		*Addr = Val;
+		Val = FastNext(Val, Rot, Step);
+		Addr++;
+	}
+
+	return Val;
+}
+
+/*****************************************************************************/
+/**
+*
+* @brief    Check a chunk against a generated pattern. The differences of a
+*           whole line are merged so there is one branch per four words.
+*
+* @return   0 if the chunk matches, -1 otherwise. *ValPtr is advanced to
+*           the pattern value for the word following the chunk.
+*
+*****************************************************************************/
+static s32 FastVerify(u32 *Addr, u32 Words, u32 *ValPtr, u32 Rot, u32 Step,
+			u8 Subtest, XTestMemFault *Fault)
+{
+	u32 *End = Addr + (Words & ~3U);
+	u32 Val = *ValPtr;
+	u32 V[4];
+	u32 Diff;
+	u32 I;
+
+	while (Addr < End) {
+		V[0] = Val;
+		V[1] = FastNext(V[0], Rot, Step);
+		V[2] = FastNext(V[1], Rot, Step);
+		V[3] = FastNext(V[2], Rot, Step);
+		Diff = (Addr[0] ^ V[0]) | (Addr[1] ^ V[1]) |
+		       (Addr[2] ^ V[2]) | (Addr[3] ^ V[3]);
+		if (Diff != 0U) {
+			for (I = 0U; I < 4U; I++) {
+				if (Addr[I] != V[I]) {
+					return FastFault(Fault, &Addr[I], V[I],
+							Subtest);
+				}
+			}
+		}
+		Val = FastNext(V[3], Rot, Step);
+		Addr += 4;
+	}
+
+	End = Addr + (Words & 3U);
+	while (Addr < End) {
+		if (*Addr != Val) {
+			return FastFault(Fault, Addr, Val, Subtest);
+		}
+		Val = FastNext(Val, Rot, Step);
+		Addr++;
+	}
+
+	*ValPtr = Val;
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* @brief    Moving inversions step over a chunk: check that every word holds
+*           Val and replace it with ~Val, in ascending or descending order.
+*
+* @return   0 if the chunk matched, -1 otherwise.
+*
+*****************************************************************************/
+static s32 FastInvert(u32 *Addr, u32 Words, u32 Val, u32 Descending,
+			u8 Subtest, XTestMemFault *Fault)
+{
+	u32 Inv = ~Val;
+	u32 I;
+
+	if (Descending == 0U) {
+		for (I = 0U; I < Words; I++) {
+			if (Addr[I] != Val) {
+				return FastFault(Fault, &Addr[I], Val, Subtest);
+			}
+			Addr[I] = Inv;
+		}
+	}
+	else {
+		for (I = Words; I > 0U; I--) {
+			if (Addr[I - 1U] != Val) {
+				return FastFault(Fault, &Addr[I - 1U], Val,
+						Subtest);
+			}
+			Addr[I - 1U] = Inv;
+		}
+	}
+
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+*
+* @brief    Run one pass of the fast test over the whole region, in chunks
+*           of XIL_TESTMEM_FAST_CHUNK words with a progress call after each.
+*           Passes that write are flushed out of the D-cache so the next
+*           pass reads the memory itself.
+*
+* @return   0 if the pass succeeded, -1 otherwise.
+*
+*****************************************************************************/
+static s32 FastPass(u32 *Addr, u32 Words, u32 Op, u32 Val, u32 Rot,
+			u32 Step, u8 Subtest, u32 Pass, u32 Options,
+			Xil_TestMemProgress Progress, XTestMemFault *Fault)
+{
+	u32 Done = 0U;
+	u32 Count;
+	s32 Status = 0;
+
+	while ((Done < Words) && (Status == 0)) {
+		Count = Words - Done;
+		if (Count > XIL_TESTMEM_FAST_CHUNK) {
+			Count = XIL_TESTMEM_FAST_CHUNK;
+		}
+
+		switch (Op) {
+		case FAST_FILL:
+			Val = FastFill(Addr + Done, Count, Val, Rot, Step);
+			break;
+		case FAST_VERIFY:
+			Status = FastVerify(Addr + Done, Count, &Val, Rot, Step,
+					Subtest, Fault);
+			break;
+		case FAST_INVERT_UP:
+			Status = FastInvert(Addr + Done, Count, Val, 0U,
+					Subtest, Fault);
+			break;
+		default:
+			Status = FastInvert(Addr + (Words - Done - Count), Count,
+					Val, 1U, Subtest, Fault);
+			break;
+		}
+
+		Done += Count;
+		if ((Status == 0) && (Progress != NULL)) {
+			Progress(Subtest, Pass, Done, Words);
+		}
+	}
+
+	if ((Op != FAST_VERIFY) && ((Options & XIL_TESTMEM_FAST_NOCACHE) == 0U)) {
+		Xil_DCacheFlush();
+	}
+
+	return Status;
+}
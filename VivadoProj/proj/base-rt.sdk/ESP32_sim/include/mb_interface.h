@@ -0,0 +1,31 @@
+/*******************************************************************************
+    Host simulation stand-in for the BSP mb_interface.h
+
+    Only the MSR accessors the application uses are provided. They act on
+    the simulated MSR, so masking IE holds off the simulated interrupts
+    exactly as it does on the MicroBlaze.
+*******************************************************************************/
+
+#ifndef _MICROBLAZE_INTERFACE_H_
+#define _MICROBLAZE_INTERFACE_H_
+
+#include "xil_types.h"
+
+u32 simMfmsr(void);
+void simMtmsr(u32 value);
+
+#define mfmsr()                         simMfmsr()
+#define mtmsr(v)                        simMtmsr(v)
+
+void microblaze_enable_interrupts(void);
+void microblaze_disable_interrupts(void);
+
+/* The data cache calls behind xil_cache.h. The host has no cache; only
+ * the unit tests that need them define these */
+void microblaze_enable_dcache(void);
+void microblaze_disable_dcache(void);
+void microblaze_flush_dcache(void);
+void microblaze_invalidate_dcache(void);
+void microblaze_flush_cache_ext(void);
+
+#endif /* _MICROBLAZE_INTERFACE_H_ */
@@ -0,0 +1,72 @@
+/*******************************************************************************
+    Host simulation stand-in for the BSP xil_io.h
+
+    Found ahead of the BSP include directory by the ESP32_sim build. Register
+    accesses go to the device models through the simulated bus instead of
+    dereferencing the address, everything else matches the MicroBlaze
+    little-endian definitions.
+*******************************************************************************/
+
+#ifndef XIL_IO_H
+#define XIL_IO_H
+
+#include "xil_types.h"
+#include "xil_printf.h"
+
+#define INLINE inline
+
+#define INST_SYNC
+#define DATA_SYNC
+#define SYNCHRONIZE_IO
+
+u8 Xil_In8(UINTPTR Addr);
+u16 Xil_In16(UINTPTR Addr);
+u32 Xil_In32(UINTPTR Addr);
+void Xil_Out8(UINTPTR Addr, u8 Value);
+void Xil_Out16(UINTPTR Addr, u16 Value);
+void Xil_Out32(UINTPTR Addr, u32 Value);
+
+static inline u16 Xil_EndianSwap16(u16 Data)
+{
+	return (u16)((Data >> 8) | (Data << 8));
+}
+
+static inline u32 Xil_EndianSwap32(u32 Data)
+{
+	return __builtin_bswap32(Data);
+}
+
+	/* Direct register accesses of the fast handlers, see platform_config.h */
+#define ISR_IN32(addr)		Xil_In32((UINTPTR)(addr))
+#define ISR_OUT32(addr, value)	Xil_Out32((UINTPTR)(addr), (u32)(value))
+
+#define Xil_In16LE	Xil_In16
+#define Xil_In32LE	Xil_In32
+#define Xil_Out16LE	Xil_Out16
+#define Xil_Out32LE	Xil_Out32
+#define Xil_Htons	Xil_EndianSwap16
+#define Xil_Htonl	Xil_EndianSwap32
+#define Xil_Ntohs	Xil_EndianSwap16
+#define Xil_Ntohl	Xil_EndianSwap32
+
+static inline u16 Xil_In16BE(UINTPTR Addr)
+{
+	return Xil_EndianSwap16(Xil_In16(Addr));
+}
+
+static inline u32 Xil_In32BE(UINTPTR Addr)
+{
+	return Xil_EndianSwap32(Xil_In32(Addr));
+}
+
+static inline void Xil_Out16BE(UINTPTR Addr, u16 Value)
+{
+	Xil_Out16(Addr, Xil_EndianSwap16(Value));
+}
+
+static inline void Xil_Out32BE(UINTPTR Addr, u32 Value)
+{
+	Xil_Out32(Addr, Xil_EndianSwap32(Value));
+}
+
+#endif /* end of protection macro */
@@ -0,0 +1,169 @@
+/*******************************************************************************
+    Host simulation of the Arty S7 board for the ESP32 application
+
+    The application and the Xilinx drivers are compiled for the host
+    unchanged. Their register accesses reach the device models below
+    through xil_io.h, and the MSR accessors in mb_interface.h act on a
+    simulated MSR.
+
+    Two threads share the models:
+        The CPU thread runs the application. It is the only one that
+        touches application state, and interrupts are delivered to it
+        with SIGUSR1, so ISRs preempt the main loop as on the MicroBlaze.
+        The hardware thread runs everything with timing: the timer,
+        shifting UART bytes at the configured baud rate, XADC conversions
+        and the ESP32 emulator with its sockets.
+    simLock serialises the models between the two.
+
+    Time is virtual: nanoseconds since reset, advancing with the host's
+    monotonic clock times the time scale. Device timing is computed from
+    scheduled event times, never from when the host got round to them, so
+    link-level figures do not depend on host load.
+*******************************************************************************/
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include "xil_types.h"
+
+typedef u64 SimTime;
+
+#define SIM_NEVER               UINT64_MAX
+#define SIM_NS_PER_CYCLE        10          // 100 MHz AXI clock
+#define SIM_NS_PER_SEC          1000000000ULL
+#define SIM_MSR_IE              0x00000002
+
+#define SIM_MAX_DEVICES         16
+#define SIM_MAX_INPUT_STEPS     32
+
+typedef struct SimDevice SimDevice;
+
+/**
+ * A peripheral on the simulated bus. read and write are called with
+ * simLock held, from either thread. run is called by the hardware thread
+ * with simLock held once due has passed; it handles every event up to now
+ * and moves due on. A device with a file descriptor has readable called
+ * when it polls readable
+ */
+struct SimDevice {
+    const char * name;
+    u32 base;
+    u32 size;
+    u32 (*read)(SimDevice * dev, u32 offset);
+    void (*write)(SimDevice * dev, u32 offset, u32 value);
+    void (*run)(SimDevice * dev, SimTime now);
+    void (*readable)(SimDevice * dev, SimTime now);
+    SimTime due;
+    int fd;
+};
+
+typedef struct {
+    SimTime at;
+    u32 buttons;
+    u32 switches;
+} SimInputStep;
+
+typedef struct {
+    const char * serverHost;
+    u32 serverPort;
+    double duration;            // virtual seconds, 0 runs until killed
+    double timeScale;
+    int quiet;
+    const char * script;
+    u32 turnaroundUs;           // ESP32 command processing time
+    u32 wifiLatencyUs;          // one way between the ESP32 and the server
+    u32 espBufferBytes;         // ESP32 TCP send buffer, 0 for no limit
+    u32 wifiRate;               // bytes/s draining it, 0 for no limit
+    u32 segmentFail;            // every Nth CIPSENDBUF segment fails, 0 none
+    u32 forgetAp;               // every Nth deep sleep loses the AP, 0 none
+    const char * inject;        // command sent as if from the server
+    u32 injectPeriodMs;
+    const char * flashImage;    // file backing the configuration flash
+    SimInputStep inputs[SIM_MAX_INPUT_STEPS];
+    u32 numInputs;
+} SimOptions;
+
+extern SimOptions simOptions;
+extern pthread_mutex_t simLock;
+
+/****************************** CORE ******************************************/
+SimTime simNow(void);
+void simRegister(SimDevice * dev);
+    // Makes the hardware thread look at due times and descriptors again
+void simKick(void);
+    // Starts the hardware thread; call from the thread that runs the
+    // application, which becomes the CPU thread
+int simStart(void);
+    // Called by the hardware thread once the duration is over. Reports
+    // and ends the process
+void simFinish(void);
+
+/****************************** INTERRUPTS ************************************/
+void simSetIrq(u32 line, int level);
+void simPulseIrq(u32 line);
+    // Called by the INTC model when its output goes from low to high
+void simCpuInterrupt(void);
+
+/****************************** DEVICES ***************************************/
+void simInitIntc(void);
+    // Lowest numbered pending source, -1 if none. *vector is the handler
+    // address for a fast mode source, 0 for a normal mode one
+int simIntcAcknowledge(u32 * vector);
+    // Level sources latch again once a fast mode handler returns
+void simIntcFastDone(void);
+int simIntcOutput(void);
+
+typedef struct SimUart SimUart;
+typedef void (*SimLineOut)(void * peer, u8 byte, SimTime when);
+SimUart * simInitUart(const char * name, u32 base, u32 irq, u32 baud,
+    SimLineOut lineOut, void * peer);
+    // A byte from the far end finished arriving at when
+void simUartReceive(SimUart * uart, u8 byte, SimTime when);
+SimTime simUartByteTime(SimUart * uart);
+void simReportUart(SimUart * uart);
+
+void simInitTimer(void);
+void simInitGpio(void);
+void simInitSpi(void);
+    // Makes the SPI model a core with another data width, FIFO depth (0
+    // for none) and SPI mode, shifting a word every nsPerWord of virtual
+    // time (0 for at once). simInitSpi sets up the board's core
+void simSpiConfigure(u32 width, u32 fifoDepth, u32 spiMode, u32 nsPerWord);
+typedef struct {
+    u32 words;                  // words shifted
+    u32 overruns;               // words lost to a full Rx FIFO
+    u32 badAccesses;            // reads of an empty Rx FIFO, writes to a
+                                // full Tx FIFO, occupancy reads without FIFOs
+    u32 rxHighWater;            // most words the Rx FIFO has held
+    u32 selects;                // times the flash was selected
+} SimSpiStats;
+    // Counts since the last simSpiConfigure
+void simSpiGetStats(SimSpiStats * stats);
+    // The flash on the SPI bus; image may be NULL for an erased one
+void simInitFlash(const char * image);
+void simFlashSelect(int selected);
+u8 simFlashShift(u8 mosi);
+    // The contents, for tests to read and damage, and the erases of a
+    // 64 KB sector
+u8 * simFlashMemory(void);
+u32 simFlashErases(u32 sector);
+void simReportFlash(void);
+void simInitXadc(void);
+void simInitPwm(void);
+typedef struct {
+    u32 offset;
+    u32 value;
+} SimPwmWrite;
+    // Records the PWM writes from now on into trace, the first size of
+    // them; simPwmTraced returns how many have been made since
+void simPwmTrace(SimPwmWrite * trace, u32 size);
+u32 simPwmTraced(void);
+
+void simInitEsp32(SimUart ** uartOut);
+void simReportEsp32(void);
+    // Non-zero once the emulator has forwarded payload to the server
+int simEsp32Delivered(void);
+
+#endif  /* end of protection macro */
@@ -0,0 +1,389 @@
+/*******************************************************************************
+    Simulated bus, CPU interrupt delivery and the hardware thread, see sim.h
+*******************************************************************************/
+
+#include <errno.h>
+#include <poll.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include "sim.h"
+#include "xil_io.h"
+#include "xil_exception.h"
+#include "mb_interface.h"
+
+pthread_mutex_t simLock = PTHREAD_MUTEX_INITIALIZER;
+
+static SimDevice * devices[SIM_MAX_DEVICES];
+static u32 numDevices;
+static struct timespec startTime;
+static int kickFd = -1;
+static pthread_t cpuThread;
+static pthread_t hardwareThread;
+
+    // The CPU thread and its signal handler are the only users of these
+static volatile u32 msr;
+static volatile sig_atomic_t inBus;
+static volatile sig_atomic_t inIsr;
+static Xil_ExceptionHandler intHandler;
+static void * intHandlerData;
+
+static void takeInterrupts(void);
+
+    // The CPU thread polls status registers in tight loops. With few host
+    // cores that starves the hardware thread of both simLock and the
+    // processor, so bus accesses step aside while it is waiting for the
+    // lock or has events overdue
+static volatile int hardwareWaiting;
+static volatile SimTime hardwareNext = SIM_NEVER;
+
+static void lockForHardware(void) {
+    __atomic_store_n(&hardwareWaiting, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_lock(&simLock);
+    __atomic_store_n(&hardwareWaiting, 0, __ATOMIC_SEQ_CST);
+}
+
+static void lockForCpu(void) {
+    if(__atomic_load_n(&hardwareWaiting, __ATOMIC_SEQ_CST) || simNow() >= hardwareNext) {
+        sched_yield();
+    }
+    pthread_mutex_lock(&simLock);
+}
+
+SimTime simNow(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double elapsed = (double)(now.tv_sec - startTime.tv_sec) * SIM_NS_PER_SEC +
+        (double)(now.tv_nsec - startTime.tv_nsec);
+    return (SimTime)(elapsed * simOptions.timeScale);
+}
+
+void simRegister(SimDevice * dev) {
+    if(numDevices >= SIM_MAX_DEVICES) {
+        fprintf(stderr, "sim: too many devices\n");
+        exit(1);
+    }
+    if(dev->run == NULL) {
+        dev->due = SIM_NEVER;
+    }
+    devices[numDevices++] = dev;
+}
+
+void simKick(void) {
+    u64 one = 1;
+    if(kickFd >= 0 && write(kickFd, &one, sizeof(one)) < 0) {
+        perror("sim: kick");
+    }
+}
+
+/****************************** BUS *******************************************/
+
+static SimDevice * findDevice(u32 addr) {
+    for(u32 i = 0; i < numDevices; i++) {
+        if(addr - devices[i]->base < devices[i]->size) {
+            return devices[i];
+        }
+    }
+    return NULL;
+}
+
+static void unmapped(const char * access, u32 addr) {
+    static u32 reported;
+    if(reported < 8) {
+        fprintf(stderr, "sim: %s of unmapped address 0x%08x\n", access, addr);
+        reported++;
+    }
+}
+
+    // inBus is set before the lock is taken and cleared after it is
+    // released, so the signal handler never takes simLock while this
+    // thread holds it. Interrupts raised meanwhile are taken on the way out
+static u32 busRead(u32 addr) {
+    u32 value = 0;
+    inBus = 1;
+    lockForCpu();
+    SimDevice * dev = findDevice(addr);
+    if(dev != NULL && dev->read != NULL) {
+        value = dev->read(dev, (addr - dev->base) & ~3U);
+    } else {
+        unmapped("read", addr);
+    }
+    pthread_mutex_unlock(&simLock);
+    inBus = 0;
+    takeInterrupts();
+    return value;
+}
+
+static void busWrite(u32 addr, u32 value) {
+    inBus = 1;
+    lockForCpu();
+    SimDevice * dev = findDevice(addr);
+    if(dev != NULL && dev->write != NULL) {
+        dev->write(dev, (addr - dev->base) & ~3U, value);
+    } else {
+        unmapped("write", addr);
+    }
+    pthread_mutex_unlock(&simLock);
+    inBus = 0;
+    takeInterrupts();
+}
+
+u8 Xil_In8(UINTPTR Addr) {
+    return (u8)(busRead((u32)Addr) >> (8 * (Addr & 3)));
+}
+
+u16 Xil_In16(UINTPTR Addr) {
+    return (u16)(busRead((u32)Addr) >> (8 * (Addr & 2)));
+}
+
+u32 Xil_In32(UINTPTR Addr) {
+    return busRead((u32)Addr);
+}
+
+    // The peripherals decode 32 bit registers only; narrower writes are
+    // zero extended the way the AXI Lite slaves see them
+void Xil_Out8(UINTPTR Addr, u8 Value) {
+    busWrite((u32)Addr, Value);
+}
+
+void Xil_Out16(UINTPTR Addr, u16 Value) {
+    busWrite((u32)Addr, Value);
+}
+
+void Xil_Out32(UINTPTR Addr, u32 Value) {
+    busWrite((u32)Addr, Value);
+}
+
+/****************************** CPU *******************************************/
+
+    // Interrupts are taken between bus accesses, or from the signal
+    // handler when the main loop is doing anything else. Taking one clears
+    // IE until the handler returns, as the MicroBlaze does up to rtid
+static void takeInterrupts(void) {
+    while(simIntcOutput() && (msr & SIM_MSR_IE) && !inBus && !inIsr) {
+        u32 vector;
+            // inIsr keeps the signal handler out from here on
+        inIsr = 1;
+        pthread_mutex_lock(&simLock);
+        int id = simIntcAcknowledge(&vector);
+        pthread_mutex_unlock(&simLock);
+        if(id < 0) {
+            inIsr = 0;
+            return;
+        }
+
+        msr &= ~SIM_MSR_IE;
+        if(vector != 0) {
+            ((void (*)(void))(UINTPTR)vector)();
+            pthread_mutex_lock(&simLock);
+            simIntcFastDone();
+            pthread_mutex_unlock(&simLock);
+        } else if(intHandler != NULL) {
+            intHandler(intHandlerData);
+        }
+        msr |= SIM_MSR_IE;
+        inIsr = 0;
+    }
+}
+
+static void interruptSignal(int sig) {
+    int savedErrno = errno;
+    (void)sig;
+    takeInterrupts();
+    errno = savedErrno;
+}
+
+void simCpuInterrupt(void) {
+    if(!pthread_equal(pthread_self(), cpuThread)) {
+        pthread_kill(cpuThread, SIGUSR1);
+    }
+}
+
+u32 simMfmsr(void) {
+    return msr;
+}
+
+void simMtmsr(u32 value) {
+    msr = value;
+    takeInterrupts();
+}
+
+void microblaze_enable_interrupts(void) {
+    simMtmsr(msr | SIM_MSR_IE);
+}
+
+void microblaze_disable_interrupts(void) {
+    msr &= ~SIM_MSR_IE;
+}
+
+void Xil_ExceptionInit(void) {
+}
+
+void Xil_ExceptionRegisterHandler(u32 Id, Xil_ExceptionHandler Handler, void * Data) {
+    if(Id == XIL_EXCEPTION_ID_INT) {
+        intHandler = Handler;
+        intHandlerData = Data;
+    }
+}
+
+void Xil_ExceptionRemoveHandler(u32 Id) {
+    if(Id == XIL_EXCEPTION_ID_INT) {
+        intHandler = NULL;
+    }
+}
+
+void Xil_ExceptionEnable(void) {
+    microblaze_enable_interrupts();
+}
+
+void Xil_ExceptionDisable(void) {
+    microblaze_disable_interrupts();
+}
+
+    // The BSP busy-waits; here the CPU thread sleeps in virtual time and
+    // takes interrupts meanwhile
+int usleep(useconds_t useconds) {
+    SimTime until = simNow() + (SimTime)useconds * 1000;
+    for(;;) {
+        SimTime now = simNow();
+        if(now >= until) {
+            return 0;
+        }
+        double wait = (double)(until - now) / simOptions.timeScale;
+        struct timespec ts = {
+            (time_t)(wait / SIM_NS_PER_SEC), (long)((u64)wait % SIM_NS_PER_SEC)
+        };
+        nanosleep(&ts, NULL);
+    }
+}
+
+unsigned int sleep(unsigned int seconds) {
+    while(seconds-- > 0) {
+        usleep(1000000);
+    }
+    return 0;
+}
+
+    // platform.c is not built; there are no caches or BRAM sections to
+    // set up on the host
+void init_platform() {
+}
+
+void cleanup_platform() {
+}
+
+/****************************** HARDWARE THREAD *******************************/
+
+static void * hardwareMain(void * arg) {
+    SimTime end = (SimTime)(simOptions.duration * SIM_NS_PER_SEC);
+    struct pollfd fds[SIM_MAX_DEVICES + 1];
+    SimDevice * fdDevices[SIM_MAX_DEVICES + 1];
+    (void)arg;
+
+    for(;;) {
+        lockForHardware();
+        SimTime now = simNow();
+        SimTime next = SIM_NEVER;
+            // A device's events can schedule another's, such as a UART
+            // byte reaching the ESP32 emulator, so go round until none are due
+        int ran;
+        do {
+            ran = 0;
+            for(u32 i = 0; i < numDevices; i++) {
+                if(devices[i]->due <= now) {
+                    devices[i]->run(devices[i], now);
+                    ran = 1;
+                }
+            }
+        } while(ran);
+        for(u32 i = 0; i < numDevices; i++) {
+            if(devices[i]->due < next) {
+                next = devices[i]->due;
+            }
+        }
+        hardwareNext = next;
+        u32 numFds = 1;
+        fds[0].fd = kickFd;
+        fds[0].events = POLLIN;
+        for(u32 i = 0; i < numDevices; i++) {
+            if(devices[i]->fd >= 0) {
+                fds[numFds].fd = devices[i]->fd;
+                fds[numFds].events = POLLIN;
+                fdDevices[numFds] = devices[i];
+                numFds++;
+            }
+        }
+        pthread_mutex_unlock(&simLock);
+
+        if(end != 0 && now >= end) {
+            simFinish();
+        }
+        if(end != 0 && next > end) {
+            next = end;
+        }
+
+        struct timespec timeout;
+        struct timespec * timeoutPtr = NULL;
+        if(next != SIM_NEVER) {
+            double wait = next > now ? (double)(next - now) / simOptions.timeScale : 0;
+            timeout.tv_sec = (time_t)(wait / SIM_NS_PER_SEC);
+            timeout.tv_nsec = (long)((u64)wait % SIM_NS_PER_SEC);
+            timeoutPtr = &timeout;
+        }
+        int ready = ppoll(fds, numFds, timeoutPtr, NULL);
+        if(ready <= 0) {
+            continue;
+        }
+        if(fds[0].revents & POLLIN) {
+            u64 count;
+            if(read(kickFd, &count, sizeof(count)) < 0) {
+                perror("sim: kick");
+            }
+        }
+        lockForHardware();
+        now = simNow();
+        for(u32 i = 1; i < numFds; i++) {
+            if(fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                fdDevices[i]->readable(fdDevices[i], now);
+            }
+        }
+        pthread_mutex_unlock(&simLock);
+    }
+    return NULL;
+}
+
+int simStart(void) {
+    struct sigaction action;
+    sigset_t mask;
+
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+    kickFd = eventfd(0, EFD_NONBLOCK);
+    if(kickFd < 0) {
+        perror("sim: eventfd");
+        return -1;
+    }
+    cpuThread = pthread_self();
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = interruptSignal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGUSR1, &action, NULL);
+
+        // Only the CPU thread takes interrupts
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+    int status = pthread_create(&hardwareThread, NULL, hardwareMain, NULL);
+    pthread_sigmask(SIG_UNBLOCK, &mask, NULL);
+    if(status != 0) {
+        fprintf(stderr, "sim: cannot start hardware thread\n");
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,915 @@
+/*******************************************************************************
+    ESP32 AT firmware emulator on the far end of axi_uartlite_1
+
+    Assembles AT command lines from the bytes the UART model shifts out and
+    answers them over the same line at the baud rate, after a configurable
+    turnaround. TCP commands open a real socket to the --server address,
+    whatever address the firmware asks for, so the collector sees the
+    firmware's traffic as it would from a board on the network. Payload
+    reaches the server and data from the server reaches the board after
+    the configured one-way Wi-Fi latency.
+
+    A --script file overrides or adds replies, one per line:
+        <command prefix> TAB <delay in us> TAB <reply>
+    with \r and \n escapes in the reply. The first entry whose prefix
+    starts the command line wins.
+
+    With --inject, the command is delivered as if it came from the server
+    every period, and the first payload starting with "OK" or "ERR" sent
+    back after it times the round trip.
+
+    With --esp-buffer, sent data waits in a send buffer of that size that
+    drains towards the server at --wifi-rate bytes per second, as on a
+    slow Wi-Fi link. A CIPSEND whose data does not fit is answered
+    SEND FAIL and its data is lost; the server gets the data at once
+    either way. A command that arrives within the turnaround of the one
+    before it is answered "busy p...", one that arrives between the data
+    of a CIPSEND and its SEND OK "busy s...".
+
+    AT+CIPSENDBUF segments go through the same send buffer, but the next
+    command may follow as soon as "Recv" is out. One that does not fit
+    is answered "busy p...". Each segment is answered "<segment>,SEND OK"
+    once the buffer has drained past it. With --segment-fail N every Nth
+    segment is answered SEND FAIL instead and its data is lost.
+    AT+CIPBUFSTATUS and AT+CIPCHECKSEQ answer from the last
+    ESP_MAX_SEGMENTS segments; the numbering starts again with every
+    AT+CIPSTART.
+
+    The access points in range are a fixed list. A scan, AT+CWLAP or an
+    AT+CWJAP without a BSSID, takes ESP_SCAN_US; joining takes
+    ESP_ASSOC_US on top.
+
+    AT+GSLP puts the ESP32 into deep sleep; it answers nothing until the
+    sleep is over and it comes out through a reset. After every reset it
+    rejoins the last access point joined by itself, ESP_ASSOC_US after
+    "ready", and reports "WIFI CONNECTED" and "WIFI GOT IP". Until then
+    AT+CIPSTART is answered "no ip". With --forget-ap N every Nth wake
+    from deep sleep comes up with no access point to rejoin, as when the
+    one it was on has gone, until an AT+CWJAP joins one again.
+*******************************************************************************/
+
+#include <errno.h>
+#include <netdb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include "sim.h"
+#include "xparameters.h"
+#include "atFormat.h"
+
+#define ESP_LINE_MAX            512
+#define ESP_TX_QUEUE_SIZE       65536
+#define ESP_MAX_ACTIONS         256
+#define ESP_MAX_SCRIPT          64
+#define ESP_RECV_MAX            1460
+#define ESP_MAX_INJECTS         64
+#define ESP_MAX_SEGMENTS        256
+#define ESP_BOOT_US             300000
+#define ESP_SCAN_US             2000000
+#define ESP_ASSOC_US            300000
+
+#define ACT_TEXT                0   // queue text on the line
+#define ACT_READY               1   // boot finished
+#define ACT_SEND                2   // payload reaches the server
+#define ACT_INJECT              3   // --inject period
+#define ACT_WAKE                4   // deep sleep over
+#define ACT_JOINED              5   // rejoined after a reset
+
+typedef struct {
+    SimTime at;
+    u32 type;
+    u32 length;
+    u8 * data;
+} EspAction;
+
+typedef struct {
+    char match[64];
+    u32 delayUs;
+    char * reply;
+    u32 length;
+} EspScript;
+
+typedef struct {
+    const char * ssid;
+    const char * bssid;
+    int rssi;
+    int channel;
+    int encryption;
+} EspAp;
+
+static const EspAp espAps[] = {
+    { "simnet", "24:0a:c4:00:00:01", -52, 6, 3 },
+    { "simnet", "24:0a:c4:00:00:02", -71, 11, 3 },
+    { "neighbour", "24:0a:c4:00:00:03", -80, 1, 4 },
+};
+#define ESP_NUM_APS             (sizeof(espAps) / sizeof(espAps[0]))
+
+typedef struct {
+    u64 count;
+    SimTime total;
+    SimTime min;
+    SimTime max;
+} EspLatency;
+
+typedef struct {
+    SimDevice dev;
+    SimUart * uart;
+
+        // Bytes on their way to the FPGA
+    u8 txQueue[ESP_TX_QUEUE_SIZE];
+    u32 txHead;
+    u32 txCount;
+    SimTime txDone;         // when the byte at txHead has arrived
+    SimTime lineFree;       // when the last byte sent had arrived
+
+    EspAction actions[ESP_MAX_ACTIONS];
+    u32 numActions;
+
+    char line[ESP_LINE_MAX];
+    u32 lineLength;
+    int echo;
+    int joined;             // index into espAps, -1 for none
+    int savedAp;            // rejoined after a reset, -1 for none
+    int booting;
+    int sleeping;
+    SimTime sleepStart;
+
+    int sock;
+    u8 payload[AT_SEND_MAX];
+    u32 sendLength;         // bytes expected in data mode, 0 in command mode
+    u32 sendReceived;
+    SimTime processing;     // until the last command has been answered
+    int sendBusy;           // from CIPSEND until SEND OK
+    SimTime sendStarted;
+    u32 sendSegment;        // segment the data mode is for, 0 for CIPSEND
+    u32 nextSegment;
+        // When each recent segment left the send buffer and how it went
+    SimTime segmentDone[ESP_MAX_SEGMENTS];
+    u8 segmentSent[ESP_MAX_SEGMENTS];
+    double buffered;        // bytes in the send buffer at bufferedAt
+    SimTime bufferedAt;
+    double bufferPeak;
+
+    EspScript script[ESP_MAX_SCRIPT];
+    u32 numScript;
+
+    SimTime injected[ESP_MAX_INJECTS];
+    u32 injectHead;
+    u32 injectCount;
+
+    u64 commands;
+    u64 sends;
+    u64 sendBytes;
+    u64 busyReplies;
+    u64 sendFails;
+    u64 segments;
+    u64 segmentFails;
+    u64 errors;
+    u64 ipdBytes;
+    u64 injects;
+    u64 deepSleeps;
+    u64 forgets;            // wakes with the access point forgotten
+    SimTime asleep;         // over completed deep sleeps
+    EspLatency sendLatency;
+    EspLatency commandRtt;
+} Esp32;
+
+static Esp32 esp;
+
+static void updateDue(void);
+
+static void latency(EspLatency * l, SimTime value) {
+    if(l->count == 0 || value < l->min) {
+        l->min = value;
+    }
+    if(value > l->max) {
+        l->max = value;
+    }
+    l->total += value;
+    l->count++;
+}
+
+static SimTime us(u32 microseconds) {
+    return (SimTime)microseconds * 1000;
+}
+
+/****************************** LINE TO THE FPGA ******************************/
+
+static void queueBytes(const u8 * data, u32 length, SimTime at) {
+    if(esp.txCount == 0) {
+        esp.txDone = (at > esp.lineFree ? at : esp.lineFree) + simUartByteTime(esp.uart);
+    }
+    for(u32 i = 0; i < length && esp.txCount < ESP_TX_QUEUE_SIZE; i++) {
+        esp.txQueue[(esp.txHead + esp.txCount) % ESP_TX_QUEUE_SIZE] = data[i];
+        esp.txCount++;
+    }
+}
+
+static void queueText(const char * text, SimTime at) {
+    queueBytes((const u8 *)text, strlen(text), at);
+}
+
+static void schedule(SimTime at, u32 type, const void * data, u32 length) {
+    if(esp.numActions == ESP_MAX_ACTIONS) {
+        fprintf(stderr, "sim: ESP32 action queue full\n");
+        return;
+    }
+    u32 i = esp.numActions++;
+        // Kept in time order, equal times in the order scheduled
+    while(i > 0 && esp.actions[i - 1].at > at) {
+        esp.actions[i] = esp.actions[i - 1];
+        i--;
+    }
+    esp.actions[i].at = at;
+    esp.actions[i].type = type;
+    esp.actions[i].length = length;
+    esp.actions[i].data = NULL;
+    if(length > 0) {
+        esp.actions[i].data = malloc(length);
+        memcpy(esp.actions[i].data, data, length);
+    }
+}
+
+static void reply(const char * text, SimTime at) {
+    schedule(at, ACT_TEXT, text, strlen(text));
+}
+
+/****************************** SOCKET ****************************************/
+
+static void closeSocket(void) {
+    if(esp.sock >= 0) {
+        close(esp.sock);
+        esp.sock = -1;
+        esp.dev.fd = -1;
+    }
+}
+
+static int openSocket(void) {
+    struct addrinfo hints;
+    struct addrinfo * result;
+    char port[16];
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    snprintf(port, sizeof(port), "%u", simOptions.serverPort);
+    if(getaddrinfo(simOptions.serverHost, port, &hints, &result) != 0) {
+        return -1;
+    }
+    int sock = -1;
+    for(struct addrinfo * a = result; a != NULL; a = a->ai_next) {
+        sock = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if(sock < 0) {
+            continue;
+        }
+        if(connect(sock, a->ai_addr, a->ai_addrlen) == 0) {
+            break;
+        }
+        close(sock);
+        sock = -1;
+    }
+    freeaddrinfo(result);
+    if(sock >= 0) {
+        int one = 1;
+        setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return sock;
+}
+
+    // Empties the send buffer up to at
+static void drainBuffer(SimTime at) {
+    if(simOptions.wifiRate == 0) {
+        esp.buffered = 0;
+    } else if(at > esp.bufferedAt) {
+        esp.buffered -= (double)simOptions.wifiRate * (at - esp.bufferedAt) / SIM_NS_PER_SEC;
+    }
+    if(esp.buffered < 0) {
+        esp.buffered = 0;
+    }
+    if(at > esp.bufferedAt) {
+        esp.bufferedAt = at;
+    }
+}
+
+static int bufferFits(u32 length, SimTime at) {
+    drainBuffer(at);
+    return simOptions.espBufferBytes == 0 || esp.buffered + length <= simOptions.espBufferBytes;
+}
+
+    // Takes length bytes into the send buffer if they fit
+static int bufferPayload(u32 length, SimTime at) {
+    if(simOptions.espBufferBytes == 0) {
+        return 1;
+    }
+    if(!bufferFits(length, at)) {
+        return 0;
+    }
+    esp.buffered += length;
+    if(esp.buffered > esp.bufferPeak) {
+        esp.bufferPeak = esp.buffered;
+    }
+    return 1;
+}
+
+static void sendPayload(SimTime at) {
+    if(esp.sock >= 0 && !bufferPayload(esp.sendReceived, at)) {
+        reply(AT_SEND_FAIL, at);
+        esp.sendFails++;
+    } else if(esp.sock < 0 || send(esp.sock, esp.payload, esp.sendReceived, MSG_NOSIGNAL) < 0) {
+        closeSocket();
+        reply(AT_SEND_FAIL, at);
+        esp.errors++;
+    } else {
+        reply(AT_SEND_OK, at);
+        esp.sends++;
+        esp.sendBytes += esp.sendReceived;
+        latency(&esp.sendLatency, at - esp.sendStarted);
+
+        int isReply = (esp.sendReceived >= 2 && memcmp(esp.payload, "OK", 2) == 0) ||
+            (esp.sendReceived >= 3 && memcmp(esp.payload, "ERR", 3) == 0);
+        if(isReply && esp.injectCount > 0) {
+            latency(&esp.commandRtt, at - esp.injected[esp.injectHead]);
+            esp.injectHead = (esp.injectHead + 1) % ESP_MAX_INJECTS;
+            esp.injectCount--;
+        }
+    }
+    esp.sendBusy = 0;
+    esp.sendLength = 0;
+}
+
+    // The data of an AT+CIPSENDBUF is in; it reaches the server at once
+    // and is reported sent once the buffer has drained past it
+static void queueSegment(SimTime at) {
+    char buf[32];
+    u32 segment = esp.sendSegment;
+    int sent = simOptions.segmentFail == 0 || segment % simOptions.segmentFail != 0;
+    esp.sendSegment = 0;
+    esp.segments++;
+
+    drainBuffer(at);
+    esp.buffered += esp.sendReceived;
+    if(esp.buffered > esp.bufferPeak) {
+        esp.bufferPeak = esp.buffered;
+    }
+    SimTime done = at + us(simOptions.wifiLatencyUs);
+    if(simOptions.wifiRate > 0) {
+        done += (SimTime)(esp.buffered * SIM_NS_PER_SEC / simOptions.wifiRate);
+    }
+
+    if(sent && (esp.sock < 0 || send(esp.sock, esp.payload, esp.sendReceived, MSG_NOSIGNAL) < 0)) {
+        closeSocket();
+        esp.errors++;
+        sent = 0;
+    }
+    if(sent) {
+        esp.sendBytes += esp.sendReceived;
+        latency(&esp.sendLatency, done - esp.sendStarted);
+    } else {
+        esp.segmentFails++;
+    }
+    esp.segmentDone[segment % ESP_MAX_SEGMENTS] = done;
+    esp.segmentSent[segment % ESP_MAX_SEGMENTS] = sent;
+    formatSegmentResult(buf, segment, sent);
+    reply(buf, done);
+}
+
+    // Last segment out of the send buffer by when, and the last of
+    // those that was sent, 0 for none
+static void lastSegments(SimTime when, u32 * out, u32 * sent) {
+    *out = 0;
+    *sent = 0;
+    for(u32 segment = esp.nextSegment - 1; segment > 0 && segment < esp.nextSegment &&
+            segment + ESP_MAX_SEGMENTS >= esp.nextSegment; segment--) {
+        if(esp.segmentDone[segment % ESP_MAX_SEGMENTS] > when) {
+            continue;
+        }
+        if(*out == 0) {
+            *out = segment;
+        }
+        if(esp.segmentSent[segment % ESP_MAX_SEGMENTS]) {
+            *sent = segment;
+            return;
+        }
+    }
+}
+
+static void espReadable(SimDevice * dev, SimTime now) {
+    u8 data[ESP_RECV_MAX];
+    char header[32];
+    (void)dev;
+    ssize_t count = recv(esp.sock, data, sizeof(data), MSG_DONTWAIT);
+    if(count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return;
+    }
+    SimTime at = now + us(simOptions.wifiLatencyUs);
+    if(count <= 0) {
+        closeSocket();
+        reply("CLOSED\r\n", at);
+        updateDue();
+        return;
+    }
+    int length = formatIPDHeader(header, (int)count);
+    schedule(at, ACT_TEXT, header, length);
+    schedule(at, ACT_TEXT, data, count);
+    esp.ipdBytes += count;
+    updateDue();
+}
+
+/****************************** COMMANDS **************************************/
+
+static char * unescape(const char * text, u32 * length) {
+    char * out = malloc(strlen(text) + 1);
+    u32 n = 0;
+    for(const char * c = text; *c != '\0'; c++) {
+        if(c[0] == '\\' && c[1] == 'r') {
+            out[n++] = '\r';
+            c++;
+        } else if(c[0] == '\\' && c[1] == 'n') {
+            out[n++] = '\n';
+            c++;
+        } else {
+            out[n++] = *c;
+        }
+    }
+    *length = n;
+    return out;
+}
+
+static void loadScript(const char * path) {
+    char buf[1024];
+    FILE * f = fopen(path, "r");
+    if(f == NULL) {
+        perror(path);
+        exit(1);
+    }
+    while(fgets(buf, sizeof(buf), f) != NULL && esp.numScript < ESP_MAX_SCRIPT) {
+        buf[strcspn(buf, "\r\n")] = '\0';
+        if(buf[0] == '#' || buf[0] == '\0') {
+            continue;
+        }
+        char * delay = strchr(buf, '\t');
+        char * text = delay ? strchr(delay + 1, '\t') : NULL;
+        if(text == NULL) {
+            fprintf(stderr, "%s: expected command, delay and reply: %s\n", path, buf);
+            exit(1);
+        }
+        *delay++ = '\0';
+        *text++ = '\0';
+        EspScript * entry = &esp.script[esp.numScript++];
+        snprintf(entry->match, sizeof(entry->match), "%s", buf);
+        entry->delayUs = strtoul(delay, NULL, 0);
+        entry->reply = unescape(text, &entry->length);
+    }
+    fclose(f);
+}
+
+static int runScript(const char * line, SimTime when) {
+    for(u32 i = 0; i < esp.numScript; i++) {
+        EspScript * entry = &esp.script[i];
+        if(strncmp(line, entry->match, strlen(entry->match)) == 0) {
+            schedule(when + us(entry->delayUs), ACT_TEXT, entry->reply, entry->length);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void reset(SimTime at) {
+    closeSocket();
+    esp.sendLength = 0;
+    esp.sendBusy = 0;
+    esp.lineLength = 0;
+    esp.echo = 1;
+    esp.booting = 1;
+    esp.joined = -1;
+    schedule(at + us(ESP_BOOT_US), ACT_READY, NULL, 0);
+    if(esp.savedAp >= 0) {
+        schedule(at + us(ESP_BOOT_US + ESP_ASSOC_US), ACT_JOINED, NULL, 0);
+    }
+}
+
+    // Copies the quoted string parameter at p to out, dropping the
+    // backslash before an escaped character. Returns what follows the
+    // closing quote, or NULL if there is none or out is too short
+static const char * parseString(const char * p, char * out, u32 size) {
+    u32 length = 0;
+    if(*p++ != '"') {
+        return NULL;
+    }
+    while(*p != '"') {
+        if(*p == '\\' && p[1] != '\0') {
+            p++;
+        }
+        if(*p == '\0' || length == size - 1) {
+            return NULL;
+        }
+        out[length++] = *p++;
+    }
+    out[length] = '\0';
+    return p + 1;
+}
+
+    // AT+CWLAP[="<ssid>"]
+static void listAPs(const char * line, SimTime at) {
+    char ssid[33] = "";
+    char buf[128];
+    if(line[8] == '=' && parseString(line + 9, ssid, sizeof(ssid)) == NULL) {
+        ssid[0] = '\0';
+    }
+    at += us(ESP_SCAN_US);
+    for(u32 i = 0; i < ESP_NUM_APS; i++) {
+        const EspAp * ap = &espAps[i];
+        if(ssid[0] == '\0' || strcmp(ssid, ap->ssid) == 0) {
+            snprintf(buf, sizeof(buf), "+CWLAP:(%d,\"%s\",%d,\"%s\",%d)\r\n",
+                ap->encryption, ap->ssid, ap->rssi, ap->bssid, ap->channel);
+            reply(buf, at);
+        }
+    }
+    reply("\r\nOK\r\n", at);
+}
+
+    // AT+CWJAP="<ssid>","<pwd>"[,"<bssid>"]; with the BSSID pinned
+    // there is no scan, without it the strongest access point is taken
+static void joinAP(const char * line, SimTime at) {
+    char ssid[33];
+    char pwd[65];
+    char bssid[18];
+    const char * p = parseString(line + 9, ssid, sizeof(ssid));
+    int fields = 0;
+    if(p != NULL && *p == ',' && (p = parseString(p + 1, pwd, sizeof(pwd))) != NULL) {
+        fields = (*p == ',' && parseString(p + 1, bssid, sizeof(bssid)) != NULL) ? 3 : 2;
+    }
+    if(fields < 2) {
+        reply("\r\nERROR\r\n", at);
+        esp.errors++;
+        return;
+    }
+    int found = -1;
+    for(u32 i = 0; i < ESP_NUM_APS && found < 0; i++) {
+        if(strcmp(ssid, espAps[i].ssid) == 0 &&
+                (fields < 3 || strcmp(bssid, espAps[i].bssid) == 0)) {
+            found = i;
+        }
+    }
+    if(fields < 3) {
+        at += us(ESP_SCAN_US);
+    }
+    if(found < 0) {
+        if(fields == 3) {
+            at += us(ESP_SCAN_US);
+        }
+        esp.joined = -1;
+        reply("+CWJAP:3\r\n\r\nFAIL\r\n", at);
+        esp.errors++;
+        return;
+    }
+    esp.joined = found;
+    esp.savedAp = found;
+    reply("WIFI CONNECTED\r\nWIFI GOT IP\r\n\r\nOK\r\n", at + us(ESP_ASSOC_US));
+}
+
+static void command(const char * line, SimTime when) {
+    SimTime at = when + us(simOptions.turnaroundUs);
+    char buf[256];
+
+    esp.commands++;
+    if(esp.echo) {
+        snprintf(buf, sizeof(buf), "%s\r\n", line);
+        reply(buf, when);
+    }
+    if(esp.sendBusy || when < esp.processing) {
+        reply(esp.sendBusy ? AT_BUSY_SENDING : AT_BUSY, at);
+        esp.busyReplies++;
+        return;
+    }
+    esp.processing = at;
+    if(runScript(line, when)) {
+        return;
+    }
+
+    if(strcmp(line, "AT") == 0) {
+        reply("\r\nOK\r\n", at);
+    } else if(strcmp(line, "ATE0") == 0 || strcmp(line, "ATE1") == 0) {
+        esp.echo = line[3] == '1';
+        reply("\r\nOK\r\n", at);
+    } else if(strcmp(line, "AT+RST") == 0) {
+        reply("\r\nOK\r\n", at);
+        reset(at);
+    } else if(strcmp(line, "AT+GMR") == 0) {
+        reply("AT version:1.1.0.0(simulated)\r\nSDK version:v2.0\r\n"
+            "compile time:ESP32_sim\r\n\r\nOK\r\n", at);
+    } else if(strncmp(line, "AT+GSLP=", 8) == 0) {
+            // Wakes up through a reset, like the real part
+        u32 ms = strtoul(line + 8, NULL, 10);
+        snprintf(buf, sizeof(buf), "%u\r\n\r\nOK\r\n", ms);
+        reply(buf, at);
+        closeSocket();
+        esp.sleeping = 1;
+        esp.sleepStart = at;
+        esp.deepSleeps++;
+        schedule(at + (SimTime)ms * 1000000, ACT_WAKE, NULL, 0);
+    } else if(strcmp(line, "AT+CWMODE?") == 0) {
+        reply("+CWMODE:1\r\n\r\nOK\r\n", at);
+    } else if(strcmp(line, "AT+CWMODE=?") == 0) {
+        reply("+CWMODE:(0-3)\r\n\r\nOK\r\n", at);
+    } else if(strncmp(line, "AT+CWMODE=", 10) == 0 || strncmp(line, "AT+CWDHCP=", 10) == 0) {
+        reply("\r\nOK\r\n", at);
+    } else if(strcmp(line, "AT+CWJAP?") == 0) {
+        if(esp.joined < 0) {
+            reply("No AP\r\n\r\nOK\r\n", at);
+        } else {
+            const EspAp * ap = &espAps[esp.joined];
+            snprintf(buf, sizeof(buf), "+CWJAP:\"%s\",\"%s\",%d,%d\r\n\r\nOK\r\n",
+                ap->ssid, ap->bssid, ap->channel, ap->rssi);
+            reply(buf, at);
+        }
+    } else if(strncmp(line, "AT+CWJAP=", 9) == 0) {
+        joinAP(line, at);
+    } else if(strncmp(line, "AT+CWLAP", 8) == 0) {
+        listAPs(line, at);
+    } else if(strcmp(line, "AT+CIFSR") == 0) {
+        reply("+CIFSR:STAIP,\"192.168.1.50\"\r\n"
+            "+CIFSR:STAMAC,\"24:0a:c4:00:00:50\"\r\n\r\nOK\r\n", at);
+    } else if(strcmp(line, "AT+CIPSTATUS") == 0) {
+        reply(esp.sock >= 0 ? "STATUS:3\r\n\r\nOK\r\n" : "STATUS:4\r\n\r\nOK\r\n", at);
+    } else if(strncmp(line, "AT+CIPSTART=", 12) == 0) {
+        if(esp.sock >= 0) {
+            reply("ALREADY CONNECTED\r\n\r\nERROR\r\n", at);
+            return;
+        }
+        if(esp.joined < 0) {
+            reply("no ip\r\n\r\nERROR\r\n", at);
+            esp.errors++;
+            return;
+        }
+        esp.sock = openSocket();
+        if(esp.sock < 0) {
+            reply("\r\nERROR\r\nCLOSED\r\n", at);
+            esp.errors++;
+            return;
+        }
+        esp.dev.fd = esp.sock;
+        esp.nextSegment = 1;
+        reply("CONNECT\r\n\r\nOK\r\n", at + us(2 * simOptions.wifiLatencyUs));
+    } else if(strcmp(line, "AT+CIPCLOSE") == 0) {
+        closeSocket();
+        reply("CLOSED\r\n\r\nOK\r\n", at);
+    } else if(strncmp(line, "AT+CIPSEND=", 11) == 0) {
+        u32 length = strtoul(line + 11, NULL, 10);
+        if(esp.sock < 0) {
+            reply("link is not valid\r\n\r\nERROR\r\n", at);
+            esp.errors++;
+        } else if(length == 0 || length > AT_SEND_MAX) {
+            reply("\r\nERROR\r\n", at);
+            esp.errors++;
+        } else {
+            reply(AT_SEND_PROMPT, at);
+            esp.sendLength = length;
+            esp.sendReceived = 0;
+            esp.sendBusy = 1;
+            esp.sendStarted = when;
+        }
+    } else if(strncmp(line, "AT+CIPSENDBUF=", 14) == 0) {
+        u32 length = strtoul(line + 14, NULL, 10);
+        u32 out, sent;
+        if(esp.sock < 0) {
+            reply("link is not valid\r\n\r\nERROR\r\n", at);
+            esp.errors++;
+        } else if(length == 0 || length > AT_SEND_MAX) {
+            reply("\r\nERROR\r\n", at);
+            esp.errors++;
+        } else if(!bufferFits(length, when)) {
+            reply(AT_BUSY, at);
+            esp.busyReplies++;
+        } else {
+            lastSegments(when, &out, &sent);
+            snprintf(buf, sizeof(buf), "%u,%u\r\n" AT_SEND_PROMPT, esp.nextSegment, sent);
+            reply(buf, at);
+            esp.sendLength = length;
+            esp.sendReceived = 0;
+            esp.sendSegment = esp.nextSegment++;
+            esp.sendStarted = when;
+        }
+    } else if(strcmp(line, AT_BUF_STATUS) == 0) {
+        u32 out, sent;
+        lastSegments(when, &out, &sent);
+        u32 queued = esp.nextSegment > 0 ? esp.nextSegment - 1 - out : 0;
+        drainBuffer(when);
+        snprintf(buf, sizeof(buf), "%u,%u,%u,%u,%u\r\n\r\nOK\r\n", esp.nextSegment, out, sent,
+            simOptions.espBufferBytes > 0 ? simOptions.espBufferBytes - (u32)esp.buffered : AT_SEND_MAX,
+            queued);
+        reply(buf, at);
+    } else if(strncmp(line, "AT+CIPCHECKSEQ=", 15) == 0) {
+        u32 segment = strtoul(line + 15, NULL, 10);
+        if(segment == 0 || segment >= esp.nextSegment ||
+                segment + ESP_MAX_SEGMENTS < esp.nextSegment ||
+                esp.segmentDone[segment % ESP_MAX_SEGMENTS] > when) {
+            reply("\r\nERROR\r\n", at);
+            esp.errors++;
+        } else {
+            snprintf(buf, sizeof(buf), "%u,%d\r\n\r\nOK\r\n", segment,
+                esp.segmentSent[segment % ESP_MAX_SEGMENTS]);
+            reply(buf, at);
+        }
+    } else {
+        reply("\r\nERROR\r\n", at);
+        esp.errors++;
+    }
+}
+
+    // A byte from the FPGA has finished arriving
+static void espLineIn(void * peer, u8 byte, SimTime when) {
+    (void)peer;
+    if(esp.booting || esp.sleeping) {
+        return;
+    }
+    if(esp.sendLength > 0) {
+        esp.payload[esp.sendReceived++] = byte;
+        if(esp.sendReceived == esp.sendLength) {
+            char buf[32];
+            SimTime at = when + us(simOptions.turnaroundUs);
+            formatRecvBytes(buf, esp.sendLength);
+            reply(buf, at);
+            esp.sendLength = 0;
+            if(esp.sendSegment != 0) {
+                queueSegment(at);
+            } else {
+                schedule(at + us(simOptions.wifiLatencyUs), ACT_SEND, NULL, 0);
+            }
+            updateDue();
+        }
+        return;
+    }
+    if(byte == '\n') {
+        if(esp.lineLength > 0 && esp.line[esp.lineLength - 1] == '\r') {
+            esp.lineLength--;
+        }
+        esp.line[esp.lineLength] = '\0';
+        if(esp.lineLength > 0) {
+            command(esp.line, when);
+        }
+        esp.lineLength = 0;
+    } else if(esp.lineLength < ESP_LINE_MAX - 1) {
+        esp.line[esp.lineLength++] = byte;
+    }
+    updateDue();
+}
+
+/****************************** EVENTS ****************************************/
+
+static void runAction(EspAction * action) {
+    char buf[ESP_LINE_MAX];
+    switch(action->type) {
+    case ACT_TEXT:
+        queueBytes(action->data, action->length, action->at);
+        break;
+    case ACT_READY:
+        esp.booting = 0;
+        queueText("\r\nets Jun  8 2016 00:22:57\r\n\r\nrst:0x1 (POWERON_RESET)\r\n", action->at);
+        queueText("\r\nready\r\n", action->at);
+        break;
+    case ACT_WAKE:
+        esp.sleeping = 0;
+        esp.asleep += action->at - esp.sleepStart;
+        if(simOptions.forgetAp != 0 && esp.deepSleeps % simOptions.forgetAp == 0) {
+            esp.savedAp = -1;
+            esp.forgets++;
+        }
+        reset(action->at);
+        break;
+    case ACT_JOINED:
+        if(!esp.booting && !esp.sleeping && esp.joined < 0) {
+            esp.joined = esp.savedAp;
+            queueText("WIFI CONNECTED\r\nWIFI GOT IP\r\n", action->at);
+        }
+        break;
+    case ACT_SEND:
+        sendPayload(action->at);
+        break;
+    case ACT_INJECT:
+        if(esp.sock >= 0 && !esp.booting && !esp.sleeping && esp.injectCount < ESP_MAX_INJECTS) {
+            int length = snprintf(buf, sizeof(buf), "%s\n", simOptions.inject);
+            char header[32];
+            formatIPDHeader(header, length);
+            queueText(header, action->at);
+            queueBytes((u8 *)buf, length, action->at);
+            esp.injected[(esp.injectHead + esp.injectCount) % ESP_MAX_INJECTS] = action->at;
+            esp.injectCount++;
+            esp.injects++;
+        }
+        schedule(action->at + (SimTime)simOptions.injectPeriodMs * 1000000, ACT_INJECT, NULL, 0);
+        break;
+    default:
+        break;
+    }
+    free(action->data);
+}
+
+static void updateDue(void) {
+    esp.dev.due = SIM_NEVER;
+    if(esp.numActions > 0) {
+        esp.dev.due = esp.actions[0].at;
+    }
+    if(esp.txCount > 0 && esp.txDone < esp.dev.due) {
+        esp.dev.due = esp.txDone;
+    }
+}
+
+    // Actions and byte arrivals are handled in time order
+static void espRun(SimDevice * dev, SimTime now) {
+    SimTime byteTime = simUartByteTime(esp.uart);
+    (void)dev;
+    for(;;) {
+        SimTime nextAction = esp.numActions > 0 ? esp.actions[0].at : SIM_NEVER;
+        SimTime nextByte = esp.txCount > 0 ? esp.txDone : SIM_NEVER;
+        if(nextAction <= nextByte && nextAction <= now) {
+            EspAction action = esp.actions[0];
+            esp.numActions--;
+            memmove(&esp.actions[0], &esp.actions[1], esp.numActions * sizeof(EspAction));
+            runAction(&action);
+        } else if(nextByte <= now) {
+            simUartReceive(esp.uart, esp.txQueue[esp.txHead], esp.txDone);
+            esp.lineFree = esp.txDone;
+            esp.txHead = (esp.txHead + 1) % ESP_TX_QUEUE_SIZE;
+            esp.txCount--;
+                // A late pass must not burst the backlog into the UART's
+                // FIFO faster than the line could, so the line slips instead
+            if(esp.txCount > 0) {
+                esp.txDone = (esp.txDone > now ? esp.txDone : now) + byteTime;
+            }
+        } else {
+            break;
+        }
+    }
+    updateDue();
+}
+
+void simInitEsp32(SimUart ** uartOut) {
+    esp.dev.name = "esp32";
+    esp.dev.run = espRun;
+    esp.dev.readable = espReadable;
+    esp.dev.fd = -1;
+    esp.sock = -1;
+    esp.echo = 1;
+    esp.joined = 0;
+    esp.savedAp = 0;
+    esp.uart = simInitUart("uart esp32", XPAR_UARTLITE_1_BASEADDR,
+        XPAR_INTC_0_UARTLITE_1_VEC_ID, XPAR_UARTLITE_1_BAUDRATE, espLineIn, &esp);
+    if(simOptions.script != NULL) {
+        loadScript(simOptions.script);
+    }
+    if(simOptions.inject != NULL && simOptions.injectPeriodMs > 0) {
+        schedule((SimTime)simOptions.injectPeriodMs * 1000000, ACT_INJECT, NULL, 0);
+    }
+    simRegister(&esp.dev);
+    updateDue();
+    *uartOut = esp.uart;
+}
+
+int simEsp32Delivered(void) {
+    return esp.sendBytes > 0;
+}
+
+static void printLatency(const char * name, EspLatency * l) {
+    if(l->count == 0) {
+        printf("%s: none\n", name);
+        return;
+    }
+    printf("%s: %llu, avg %.3f ms, min %.3f ms, max %.3f ms\n", name,
+        (unsigned long long)l->count, (double)l->total / l->count / 1e6,
+        (double)l->min / 1e6, (double)l->max / 1e6);
+}
+
+void simReportEsp32(void) {
+    double seconds = (double)simNow() / SIM_NS_PER_SEC;
+    printf("esp32: %llu commands, %llu errors, %llu busy replies, %llu bytes from the server\n",
+        (unsigned long long)esp.commands, (unsigned long long)esp.errors,
+        (unsigned long long)esp.busyReplies, (unsigned long long)esp.ipdBytes);
+    printf("esp32: %llu sends, %llu payload bytes, %.1f bytes/s\n",
+        (unsigned long long)esp.sends, (unsigned long long)esp.sendBytes,
+        seconds > 0 ? esp.sendBytes / seconds : 0.0);
+    printLatency("CIPSEND to SEND OK", &esp.sendLatency);
+    if(esp.segments > 0) {
+        printf("esp32: %llu CIPSENDBUF segments, %llu answered SEND FAIL\n",
+            (unsigned long long)esp.segments, (unsigned long long)esp.segmentFails);
+    }
+    if(simOptions.espBufferBytes > 0) {
+        printf("esp32: %llu SEND FAIL, send buffer peak %.0f of %u bytes, drained at %u bytes/s\n",
+            (unsigned long long)esp.sendFails, esp.bufferPeak,
+            simOptions.espBufferBytes, simOptions.wifiRate);
+    }
+    if(esp.deepSleeps > 0) {
+        SimTime asleep = esp.asleep + (esp.sleeping ? simNow() - esp.sleepStart : 0);
+        double awake = seconds - (double)asleep / SIM_NS_PER_SEC;
+        printf("esp32: %llu deep sleeps, awake %.1f s of %.1f s (%.1f%%), %llu woke without an AP\n",
+            (unsigned long long)esp.deepSleeps, awake, seconds,
+            seconds > 0 ? 100 * awake / seconds : 0.0, (unsigned long long)esp.forgets);
+    }
+    if(simOptions.inject != NULL) {
+        printf("injected \"%s\": %llu\n", simOptions.inject, (unsigned long long)esp.injects);
+        printLatency("command round trip", &esp.commandRtt);
+    }
+}
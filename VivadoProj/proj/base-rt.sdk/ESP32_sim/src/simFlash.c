@@ -0,0 +1,220 @@
+/*******************************************************************************
+    S25FL128S configuration flash behind the AXI Quad SPI model
+
+    Answers the single line commands spiFlash.c uses: READ, PAGE PROGRAM,
+    64 KB SECTOR ERASE, WRITE ENABLE, READ STATUS, CLEAR STATUS and READ
+    ID. Programming only clears bits and erasing sets a sector to ones, as
+    on the part. A program or erase needs the write enable latch, clears
+    it, and keeps WIP set for its typical time, during which any command
+    but READ STATUS is ignored. Program and erase take effect when the
+    slave is deselected, and a page program wraps within its page.
+
+    With --flash-image the contents are loaded from that file and every
+    program and erase is written back to it, so a run can pick up what the
+    last one stored; a missing or short file reads as erased. Without it
+    the flash starts erased. The erase count of each sector is kept for
+    the report, which shows whether the erases were spread out.
+*******************************************************************************/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "sim.h"
+#include "spiFlash.h"
+
+#define FLASH_SECTORS           (FLASH_SIZE / FLASH_SECTOR_SIZE)
+#define FLASH_PROGRAM_NS        250000ULL
+#define FLASH_ERASE_NS          130000000ULL
+
+static struct {
+    u8 * mem;
+    int fd;
+    int selected;
+    u8 command;
+    u32 index;                  // bytes in since the slave was selected
+    u32 address;
+    int wel;
+    SimTime busyUntil;
+    u8 page[FLASH_PAGE_SIZE];
+    u8 pageWritten[FLASH_PAGE_SIZE];
+    u32 erases[FLASH_SECTORS];
+    u64 reads;
+    u64 programs;
+    u64 ignored;
+} flash = { .fd = -1 };
+
+static int busy(void) {
+    return simNow() < flash.busyUntil;
+}
+
+static void writeBack(u32 address, u32 length) {
+    if(flash.fd >= 0 && pwrite(flash.fd, flash.mem + address, length, address) != (ssize_t)length) {
+        perror("sim: flash image");
+    }
+}
+
+static void programPage(void) {
+    u32 base = flash.address & ~(FLASH_PAGE_SIZE - 1);
+    for(u32 i = 0; i < FLASH_PAGE_SIZE; i++) {
+        if(flash.pageWritten[i]) {
+            flash.mem[base + i] &= flash.page[i];
+        }
+    }
+    writeBack(base, FLASH_PAGE_SIZE);
+    flash.programs++;
+    flash.busyUntil = simNow() + FLASH_PROGRAM_NS;
+}
+
+static void eraseSector(void) {
+    u32 base = flash.address & ~(FLASH_SECTOR_SIZE - 1);
+    memset(flash.mem + base, 0xFF, FLASH_SECTOR_SIZE);
+    writeBack(base, FLASH_SECTOR_SIZE);
+    flash.erases[base / FLASH_SECTOR_SIZE]++;
+    flash.busyUntil = simNow() + FLASH_ERASE_NS;
+}
+
+    // Commands act when the slave is deselected
+static void endCommand(void) {
+    if(flash.index == 0) {
+        return;
+    }
+    if(busy() && flash.command != FLASH_CMD_READ_STATUS) {
+        flash.ignored++;
+        return;
+    }
+    switch(flash.command) {
+    case FLASH_CMD_WRITE_ENABLE:
+        flash.wel = 1;
+        break;
+    case FLASH_CMD_PAGE_PROGRAM:
+        if(flash.wel && flash.index > 4) {
+            programPage();
+        }
+        flash.wel = 0;
+        break;
+    case FLASH_CMD_SECTOR_ERASE:
+        if(flash.wel && flash.index == 4) {
+            eraseSector();
+        }
+        flash.wel = 0;
+        break;
+    default:
+        break;
+    }
+}
+
+void simFlashSelect(int selected) {
+    if(selected == flash.selected) {
+        return;
+    }
+    if(!selected) {
+        endCommand();
+    }
+    flash.selected = selected;
+    flash.index = 0;
+}
+
+u8 simFlashShift(u8 mosi) {
+    u32 index = flash.index++;
+    if(index == 0) {
+        flash.command = mosi;
+        flash.address = 0;
+        memset(flash.pageWritten, 0, sizeof(flash.pageWritten));
+        return 0xFF;
+    }
+    if(flash.command == FLASH_CMD_READ_STATUS) {
+        return (busy() ? FLASH_SR_WIP : 0) | (flash.wel ? FLASH_SR_WEL : 0);
+    }
+    if(busy()) {
+        return 0xFF;
+    }
+    if(flash.command == FLASH_CMD_READ_ID) {
+        return (index <= 3) ? (u8)(FLASH_JEDEC_ID >> (8 * (3 - index))) : 0xFF;
+    }
+    if(flash.command != FLASH_CMD_READ && flash.command != FLASH_CMD_PAGE_PROGRAM &&
+            flash.command != FLASH_CMD_SECTOR_ERASE) {
+        return 0xFF;
+    }
+    if(index <= 3) {
+        flash.address = ((flash.address << 8) | mosi) & (FLASH_SIZE - 1);
+        return 0xFF;
+    }
+
+    u32 offset = index - 4;
+    if(flash.command == FLASH_CMD_READ) {
+        if(offset == 0) {
+            flash.reads++;
+        }
+        return flash.mem[(flash.address + offset) & (FLASH_SIZE - 1)];
+    }
+    if(flash.command == FLASH_CMD_PAGE_PROGRAM) {
+        u32 column = (flash.address + offset) & (FLASH_PAGE_SIZE - 1);
+        flash.page[column] = mosi;
+        flash.pageWritten[column] = 1;
+    }
+    return 0xFF;
+}
+
+void simInitFlash(const char * image) {
+    flash.mem = malloc(FLASH_SIZE);
+    if(flash.mem == NULL) {
+        fprintf(stderr, "sim: no memory for the flash\n");
+        exit(1);
+    }
+    memset(flash.mem, 0xFF, FLASH_SIZE);
+    if(image == NULL) {
+        return;
+    }
+
+    flash.fd = open(image, O_RDWR | O_CREAT, 0644);
+    if(flash.fd < 0) {
+        perror(image);
+        exit(2);
+    }
+    ssize_t length = pread(flash.fd, flash.mem, FLASH_SIZE, 0);
+    if(length < 0) {
+        perror(image);
+        exit(2);
+    }
+    if(length < FLASH_SIZE) {
+        memset(flash.mem + length, 0xFF, FLASH_SIZE - length);
+    }
+}
+
+u8 * simFlashMemory(void) {
+    return flash.mem;
+}
+
+u32 simFlashErases(u32 sector) {
+    return flash.erases[sector];
+}
+
+void simReportFlash(void) {
+    u32 sectors = 0;
+    u32 total = 0;
+    u32 least = 0;
+    u32 most = 0;
+    for(u32 i = 0; i < FLASH_SECTORS; i++) {
+        if(flash.erases[i] == 0) {
+            continue;
+        }
+        if(sectors == 0 || flash.erases[i] < least) {
+            least = flash.erases[i];
+        }
+        if(flash.erases[i] > most) {
+            most = flash.erases[i];
+        }
+        sectors++;
+        total += flash.erases[i];
+    }
+    if(flash.reads == 0 && flash.programs == 0 && total == 0) {
+        return;
+    }
+    printf("flash: %llu reads, %llu page programs, %u erases over %u sectors "
+        "(%u to %u each), %llu commands while busy\n",
+        (unsigned long long)flash.reads, (unsigned long long)flash.programs,
+        total, sectors, least, most, (unsigned long long)flash.ignored);
+}
@@ -0,0 +1,134 @@
+/*******************************************************************************
+    AXI GPIO models for the buttons and switches and for the LEDs
+
+    The input GPIO has the buttons on channel 1 and the switches on
+    channel 2. Their levels follow the --input steps in virtual time, and a
+    change on a channel sets its bit in the toggle-on-write interrupt
+    status register. The interrupt line is level.
+*******************************************************************************/
+
+#include "sim.h"
+#include "xparameters.h"
+#include "xgpio_l.h"
+
+typedef struct {
+    SimDevice dev;
+    int irq;            // -1 without an interrupt
+    u32 in[2];
+    u32 out[2];
+    u32 tri[2];
+    u32 gie;
+    u32 isr;
+    u32 ier;
+    u32 nextStep;
+    u64 outputWrites;
+} SimGpio;
+
+static void updateGpioIrq(SimGpio * gpio) {
+    if(gpio->irq >= 0) {
+        simSetIrq(gpio->irq, (gpio->gie & XGPIO_GIE_GINTR_ENABLE_MASK) &&
+            (gpio->isr & gpio->ier));
+    }
+}
+
+static void setInputs(SimGpio * gpio, u32 channel, u32 value) {
+    if(gpio->in[channel] != value) {
+        gpio->in[channel] = value;
+        gpio->isr |= 1U << channel;
+    }
+}
+
+static void gpioRun(SimDevice * dev, SimTime now) {
+    SimGpio * gpio = (SimGpio *)dev;
+    while(gpio->nextStep < simOptions.numInputs &&
+            simOptions.inputs[gpio->nextStep].at <= now) {
+        SimInputStep * step = &simOptions.inputs[gpio->nextStep++];
+        setInputs(gpio, 0, step->buttons);
+        setInputs(gpio, 1, step->switches);
+    }
+    dev->due = gpio->nextStep < simOptions.numInputs ?
+        simOptions.inputs[gpio->nextStep].at : SIM_NEVER;
+    updateGpioIrq(gpio);
+}
+
+static u32 gpioRead(SimDevice * dev, u32 offset) {
+    SimGpio * gpio = (SimGpio *)dev;
+    switch(offset) {
+    case XGPIO_DATA_OFFSET:
+    case XGPIO_DATA2_OFFSET: {
+        u32 ch = offset / XGPIO_CHAN_OFFSET;
+        return (gpio->in[ch] & gpio->tri[ch]) | (gpio->out[ch] & ~gpio->tri[ch]);
+    }
+    case XGPIO_TRI_OFFSET:
+    case XGPIO_TRI2_OFFSET:
+        return gpio->tri[offset / XGPIO_CHAN_OFFSET];
+    case XGPIO_GIE_OFFSET:
+        return gpio->gie;
+    case XGPIO_ISR_OFFSET:
+        return gpio->isr;
+    case XGPIO_IER_OFFSET:
+        return gpio->ier;
+    default:
+        return 0;
+    }
+}
+
+static void gpioWrite(SimDevice * dev, u32 offset, u32 value) {
+    SimGpio * gpio = (SimGpio *)dev;
+    switch(offset) {
+    case XGPIO_DATA_OFFSET:
+    case XGPIO_DATA2_OFFSET:
+        gpio->out[offset / XGPIO_CHAN_OFFSET] = value;
+        gpio->outputWrites++;
+        break;
+    case XGPIO_TRI_OFFSET:
+    case XGPIO_TRI2_OFFSET:
+        gpio->tri[offset / XGPIO_CHAN_OFFSET] = value;
+        break;
+    case XGPIO_GIE_OFFSET:
+        gpio->gie = value & XGPIO_GIE_GINTR_ENABLE_MASK;
+        break;
+    case XGPIO_ISR_OFFSET:
+        gpio->isr ^= value & 3;
+        break;
+    case XGPIO_IER_OFFSET:
+        gpio->ier = value & 3;
+        break;
+    default:
+        break;
+    }
+    updateGpioIrq(gpio);
+}
+
+static SimGpio inputGpio = {
+    .dev = {
+        .name = "gpio input",
+        .base = XPAR_AXI_GPIO_INPUT_BASEADDR,
+        .size = 0x10000,
+        .read = gpioRead,
+        .write = gpioWrite,
+        .run = gpioRun,
+        .fd = -1,
+    },
+    .irq = XPAR_INTC_0_GPIO_0_VEC_ID,
+    .tri = { 0xFFFFFFFFU, 0xFFFFFFFFU },
+};
+
+static SimGpio ledGpio = {
+    .dev = {
+        .name = "gpio led",
+        .base = XPAR_AXI_GPIO_LED_BASEADDR,
+        .size = 0x10000,
+        .read = gpioRead,
+        .write = gpioWrite,
+        .fd = -1,
+    },
+    .irq = -1,
+    .tri = { 0xFFFFFFFFU, 0xFFFFFFFFU },
+};
+
+void simInitGpio(void) {
+    inputGpio.dev.due = 0;
+    simRegister(&inputGpio.dev);
+    simRegister(&ledGpio.dev);
+}
@@ -0,0 +1,166 @@
+/*******************************************************************************
+    AXI INTC model
+
+    Registers as in xintc_l.h. Sources are edge or level triggered per
+    XPAR_INTC_0_KIND_OF_INTR: an edge source latches into ISR on a rising
+    edge of its line, a level source latches whenever its line is high,
+    including straight after an acknowledge. Sources with their IMR bit
+    set are vectored to the handler address in their IVAR.
+*******************************************************************************/
+
+#include "sim.h"
+#include "xparameters.h"
+#include "xintc_l.h"
+
+#define INTC_SOURCES            32
+
+static u32 isr;
+static u32 ier;
+static u32 mer;
+static u32 imr;
+static u32 ilr;
+static u32 ivar[INTC_SOURCES];
+static u32 lines;
+static volatile int output;
+
+static const u32 edgeSources = XPAR_INTC_0_KIND_OF_INTR;
+
+static void updateOutput(void) {
+    int level = (mer & XIN_INT_MASTER_ENABLE_MASK) && (isr & ier) != 0;
+    if(level && !output) {
+        output = 1;
+        simCpuInterrupt();
+    } else {
+        output = level;
+    }
+}
+
+static void relatchLevels(void) {
+    isr |= lines & ~edgeSources;
+}
+
+void simSetIrq(u32 line, int level) {
+    u32 bit = 1U << line;
+    if(level) {
+        if(!(lines & bit) || !(edgeSources & bit)) {
+            isr |= bit;
+        }
+        lines |= bit;
+    } else {
+        lines &= ~bit;
+    }
+    updateOutput();
+}
+
+void simPulseIrq(u32 line) {
+    simSetIrq(line, 1);
+    simSetIrq(line, 0);
+}
+
+int simIntcOutput(void) {
+    return output;
+}
+
+int simIntcAcknowledge(u32 * vector) {
+    u32 pending = isr & ier;
+    if(!(mer & XIN_INT_MASTER_ENABLE_MASK) || pending == 0) {
+        return -1;
+    }
+    int id = __builtin_ctz(pending);
+    *vector = 0;
+    if(imr & (1U << id)) {
+            // Fast mode acknowledges as the vector is fetched, so an edge
+            // arriving while the handler runs is latched again
+        *vector = ivar[id];
+        isr &= ~(1U << id);
+        updateOutput();
+    }
+    return id;
+}
+
+void simIntcFastDone(void) {
+    relatchLevels();
+    updateOutput();
+}
+
+static u32 intcRead(SimDevice * dev, u32 offset) {
+    (void)dev;
+    switch(offset) {
+    case XIN_ISR_OFFSET:
+        return isr;
+    case XIN_IPR_OFFSET:
+        return isr & ier;
+    case XIN_IER_OFFSET:
+        return ier;
+    case XIN_IVR_OFFSET: {
+        u32 pending = isr & ier;
+        return pending ? (u32)__builtin_ctz(pending) : 0xFFFFFFFFU;
+    }
+    case XIN_MER_OFFSET:
+        return mer;
+    case XIN_IMR_OFFSET:
+        return imr;
+    case XIN_ILR_OFFSET:
+        return ilr;
+    default:
+        if(offset >= XIN_IVAR_OFFSET && offset < XIN_IVAR_OFFSET + 4 * INTC_SOURCES) {
+            return ivar[(offset - XIN_IVAR_OFFSET) / 4];
+        }
+        return 0;
+    }
+}
+
+static void intcWrite(SimDevice * dev, u32 offset, u32 value) {
+    (void)dev;
+    switch(offset) {
+    case XIN_ISR_OFFSET:
+            // Software interrupts can only be generated once the hardware
+            // enable is set
+        if(!(mer & XIN_INT_HARDWARE_ENABLE_MASK)) {
+            isr = value;
+        }
+        break;
+    case XIN_IER_OFFSET:
+        ier = value;
+        break;
+    case XIN_IAR_OFFSET:
+        isr &= ~value;
+        relatchLevels();
+        break;
+    case XIN_SIE_OFFSET:
+        ier |= value;
+        break;
+    case XIN_CIE_OFFSET:
+        ier &= ~value;
+        break;
+    case XIN_MER_OFFSET:
+            // HIE cannot be cleared once set
+        mer = (mer & XIN_INT_HARDWARE_ENABLE_MASK) | value;
+        break;
+    case XIN_IMR_OFFSET:
+        imr = value;
+        break;
+    case XIN_ILR_OFFSET:
+        ilr = value;
+        break;
+    default:
+        if(offset >= XIN_IVAR_OFFSET && offset < XIN_IVAR_OFFSET + 4 * INTC_SOURCES) {
+            ivar[(offset - XIN_IVAR_OFFSET) / 4] = value;
+        }
+        break;
+    }
+    updateOutput();
+}
+
+static SimDevice intcDevice = {
+    .name = "intc",
+    .base = XPAR_INTC_0_BASEADDR,
+    .size = 0x10000,
+    .read = intcRead,
+    .write = intcWrite,
+    .fd = -1,
+};
+
+void simInitIntc(void) {
+    simRegister(&intcDevice);
+}
@@ -0,0 +1,192 @@
+/*******************************************************************************
+    Entry point of the board simulator
+
+    Builds the board out of the device models, starts the hardware thread
+    and runs the application's main() on this thread. When the duration is
+    up, prints what went over the links and exits with 0 if the firmware
+    got payload through to the server, 1 otherwise.
+
+    main() runs on simStack, which the Makefile links as lscript.ld's
+    _stack_end and _stack, so stackCheck.c paints and scans it as on the
+    board. Interrupts, taken on this thread, land on it too.
+*******************************************************************************/
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include "sim.h"
+#include "xparameters.h"
+
+    // The application's main, renamed by the build
+int appMain(void);
+
+SimOptions simOptions = {
+    .serverHost = "127.0.0.1",
+    .serverPort = 5005,
+    .duration = 30.0,
+    .timeScale = 1.0,
+    .turnaroundUs = 1000,
+    .wifiLatencyUs = 5000,
+    .injectPeriodMs = 1000,
+};
+
+static SimUart * consoleUart;
+static SimUart * espUart;
+
+    // Host code needs far more stack than the MicroBlaze build, see the
+    // Makefile for its size
+u8 simStack[SIM_STACK_SIZE] __attribute__((aligned(16)));
+static ucontext_t hostContext;
+static ucontext_t appContext;
+static int appStatus;
+
+static const char usage[] =
+    "usage: %s [options]\n"
+    "  --server HOST:PORT      where TCP connections go (127.0.0.1:5005)\n"
+    "  --duration S            virtual seconds to run, 0 for ever (30)\n"
+    "  --time-scale X          virtual seconds per real second (1)\n"
+    "  --quiet                 drop the console UART output\n"
+    "  --script FILE           ESP32 reply overrides, see simEsp32.c\n"
+    "  --turnaround-us N       ESP32 command processing time (1000)\n"
+    "  --wifi-latency-us N     one way ESP32 to server latency (5000)\n"
+    "  --esp-buffer N          ESP32 TCP send buffer in bytes, 0 unlimited (0)\n"
+    "  --wifi-rate N           bytes/s the send buffer drains at (0)\n"
+    "  --segment-fail N        answer every Nth CIPSENDBUF segment SEND FAIL (0)\n"
+    "  --forget-ap N           forget the access point on every Nth wake (0)\n"
+    "  --inject CMD            command sent as if from the server\n"
+    "  --inject-period-ms N    how often CMD is sent (1000)\n"
+    "  --input MS,BTN,SW       button and switch levels from MS on, repeatable\n"
+    "  --flash-image FILE      keep the configuration flash in FILE\n";
+
+static void consoleOut(void * peer, u8 byte, SimTime when) {
+    (void)peer;
+    (void)when;
+    if(!simOptions.quiet) {
+        putchar(byte);
+        if(byte == '\n') {
+            fflush(stdout);
+        }
+    }
+}
+
+static void parseServer(const char * arg) {
+    static char host[256];
+    const char * colon = strrchr(arg, ':');
+    if(colon == NULL) {
+        snprintf(host, sizeof(host), "%s", arg);
+    } else {
+        snprintf(host, sizeof(host), "%.*s", (int)(colon - arg), arg);
+        simOptions.serverPort = strtoul(colon + 1, NULL, 10);
+    }
+    simOptions.serverHost = host;
+}
+
+static void parseInput(const char * arg, const char * prog) {
+    unsigned ms, buttons, switches;
+    if(simOptions.numInputs == SIM_MAX_INPUT_STEPS ||
+            sscanf(arg, "%u,%i,%i", &ms, &buttons, &switches) != 3) {
+        fprintf(stderr, usage, prog);
+        exit(2);
+    }
+    SimInputStep * step = &simOptions.inputs[simOptions.numInputs++];
+    step->at = (SimTime)ms * 1000000;
+    step->buttons = buttons;
+    step->switches = switches;
+}
+
+static void parseOptions(int argc, char ** argv) {
+    static const struct option options[] = {
+        { "server", required_argument, NULL, 's' },
+        { "duration", required_argument, NULL, 'd' },
+        { "time-scale", required_argument, NULL, 't' },
+        { "quiet", no_argument, NULL, 'q' },
+        { "script", required_argument, NULL, 'f' },
+        { "turnaround-us", required_argument, NULL, 'a' },
+        { "wifi-latency-us", required_argument, NULL, 'w' },
+        { "esp-buffer", required_argument, NULL, 'b' },
+        { "wifi-rate", required_argument, NULL, 'r' },
+        { "segment-fail", required_argument, NULL, 'S' },
+        { "forget-ap", required_argument, NULL, 'A' },
+        { "inject", required_argument, NULL, 'i' },
+        { "inject-period-ms", required_argument, NULL, 'p' },
+        { "input", required_argument, NULL, 'n' },
+        { "flash-image", required_argument, NULL, 'F' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    int opt;
+    while((opt = getopt_long(argc, argv, "", options, NULL)) != -1) {
+        switch(opt) {
+        case 's': parseServer(optarg); break;
+        case 'd': simOptions.duration = atof(optarg); break;
+        case 't': simOptions.timeScale = atof(optarg); break;
+        case 'q': simOptions.quiet = 1; break;
+        case 'f': simOptions.script = optarg; break;
+        case 'a': simOptions.turnaroundUs = strtoul(optarg, NULL, 10); break;
+        case 'w': simOptions.wifiLatencyUs = strtoul(optarg, NULL, 10); break;
+        case 'b': simOptions.espBufferBytes = strtoul(optarg, NULL, 10); break;
+        case 'r': simOptions.wifiRate = strtoul(optarg, NULL, 10); break;
+        case 'S': simOptions.segmentFail = strtoul(optarg, NULL, 10); break;
+        case 'A': simOptions.forgetAp = strtoul(optarg, NULL, 10); break;
+        case 'i': simOptions.inject = optarg; break;
+        case 'p': simOptions.injectPeriodMs = strtoul(optarg, NULL, 10); break;
+        case 'n': parseInput(optarg, argv[0]); break;
+        case 'F': simOptions.flashImage = optarg; break;
+        default:
+            fprintf(stderr, usage, argv[0]);
+            exit(opt == 'h' ? 0 : 2);
+        }
+    }
+    if(optind != argc || simOptions.timeScale <= 0) {
+        fprintf(stderr, usage, argv[0]);
+        exit(2);
+    }
+}
+
+static void runApp(void) {
+    appStatus = appMain();
+}
+
+void simFinish(void) {
+    pthread_mutex_lock(&simLock);
+    fflush(stdout);
+    printf("\n--- %.3f s simulated, time scale %g ---\n",
+        (double)simNow() / SIM_NS_PER_SEC, simOptions.timeScale);
+    simReportUart(consoleUart);
+    simReportUart(espUart);
+    simReportEsp32();
+    simReportFlash();
+    int delivered = simEsp32Delivered();
+    fflush(stdout);
+    _exit(delivered ? 0 : 1);
+}
+
+int main(int argc, char ** argv) {
+    parseOptions(argc, argv);
+
+    simInitIntc();
+    simInitTimer();
+    simInitGpio();
+    simInitSpi();
+    simInitXadc();
+    simInitPwm();
+    consoleUart = simInitUart("uart console", XPAR_UARTLITE_0_BASEADDR,
+        XPAR_INTC_0_UARTLITE_0_VEC_ID, XPAR_UARTLITE_0_BAUDRATE, consoleOut, NULL);
+    simInitEsp32(&espUart);
+
+    if(simStart() != 0) {
+        return 1;
+    }
+    getcontext(&appContext);
+    appContext.uc_stack.ss_sp = simStack;
+    appContext.uc_stack.ss_size = sizeof(simStack);
+    appContext.uc_link = &hostContext;
+    makecontext(&appContext, runApp, 0);
+    swapcontext(&hostContext, &appContext);
+    fprintf(stderr, "sim: application returned %d\n", appStatus);
+    simFinish();
+    return 0;
+}
@@ -0,0 +1,56 @@
+/*******************************************************************************
+    PWM IP model: plain registers, nothing is driven
+
+    The unit tests can record the writes made to it with simPwmTrace, to
+    check what PWM_Update writes and in which order.
+*******************************************************************************/
+
+#include "sim.h"
+#include "xparameters.h"
+
+#define PWM_REGS                64
+
+static u32 regs[PWM_REGS];
+static SimPwmWrite * trace;
+static u32 traceSize;
+static u32 traced;
+
+static u32 pwmRead(SimDevice * dev, u32 offset) {
+    (void)dev;
+    return offset / 4 < PWM_REGS ? regs[offset / 4] : 0;
+}
+
+static void pwmWrite(SimDevice * dev, u32 offset, u32 value) {
+    (void)dev;
+    if(offset / 4 < PWM_REGS) {
+        regs[offset / 4] = value;
+    }
+    if(traced < traceSize) {
+        trace[traced].offset = offset;
+        trace[traced].value = value;
+    }
+    traced++;
+}
+
+static SimDevice pwmDevice = {
+    .name = "pwm",
+    .base = XPAR_PWM_0_PWM_AXI_BASEADDR,
+    .size = 0x10000,
+    .read = pwmRead,
+    .write = pwmWrite,
+    .fd = -1,
+};
+
+void simInitPwm(void) {
+    simRegister(&pwmDevice);
+}
+
+void simPwmTrace(SimPwmWrite * to, u32 size) {
+    trace = to;
+    traceSize = size;
+    traced = 0;
+}
+
+u32 simPwmTraced(void) {
+    return traced;
+}
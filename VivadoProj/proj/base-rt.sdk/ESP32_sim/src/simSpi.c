@@ -0,0 +1,295 @@
+/*******************************************************************************
+    AXI Quad SPI model of axi_quad_spi_0, with the configuration flash on
+    its only slave select, as on the board
+
+    By default the model is the board's core: 8 bit words, 256 deep FIFOs,
+    quad mode, and transfers complete as soon as they are started. The
+    unit tests reconfigure it with simSpiConfigure as a core built with
+    another width, FIFO depth or mode, and with a shift time per word, so
+    the driver sees the FIFOs fill and drain between its register
+    accesses. A core without FIFOs has a single data register each way
+    and no occupancy registers.
+
+    Of the interrupt status bits, Tx empty is set when the last word in
+    the Tx FIFO has been shifted out, which XSpi_Transfer polls for with
+    interrupts off, and Rx overrun when a word is lost. The interrupt line
+    follows them at each register access, which is exact for the board's
+    core as it shifts at once; spiFlash.c runs the core with interrupts
+    off, the unit tests drive XSpi_InterruptHandler from it.
+
+    In manual slave select mode the flash model in simFlash.c is selected
+    while bit 0 of the slave select register is low. Otherwise the core
+    selects it while it is shifting without a break. With the flash
+    deselected the data line floats high and the core reads ones. The
+    loopback bit only connects the shift register to itself in standard
+    mode; in dual and quad mode it has no effect, as documented for the
+    core (PG153).
+*******************************************************************************/
+
+#include <string.h>
+#include "sim.h"
+#include "xparameters.h"
+#include "xspi_l.h"
+
+#define SPI_MAX_FIFO            256
+
+static struct {
+    u32 width;
+    u32 depth;
+    u32 mode;
+    u32 nsPerWord;
+} config;
+
+static u32 cr;
+static u32 ssr;
+static u32 dgier;
+static u32 iisr;
+static u32 iier;
+static u32 rx[SPI_MAX_FIFO];
+static u32 rxHead;
+static u32 rxCount;
+static u32 tx[SPI_MAX_FIFO];
+static u32 txHead;
+static u32 txCount;
+
+static int shifting;            // a word is in the shift register
+static u32 shiftWord;
+static SimTime shiftEnd;
+static SimTime lastAccess;
+static int autoSelected;
+static int selected;            // the flash's slave select, as driven
+
+static SimSpiStats stats;
+
+static u32 fifoSize(void) {
+    return config.depth ? config.depth : 1;
+}
+
+static u32 wordMask(void) {
+    return config.width == 32 ? 0xFFFFFFFFU : (1U << config.width) - 1;
+}
+
+static void spiReset(void) {
+    cr = XSP_CR_TRANS_INHIBIT_MASK | XSP_CR_MANUAL_SS_MASK;
+    ssr = 0xFFFFFFFFU;
+    dgier = 0;
+    iisr = 0;
+    iier = 0;
+    rxCount = 0;
+    txCount = 0;
+    shifting = 0;
+    autoSelected = 0;
+}
+
+static int transferring(void) {
+    return (cr & XSP_CR_ENABLE_MASK) && (cr & XSP_CR_MASTER_MODE_MASK) &&
+        !(cr & XSP_CR_TRANS_INHIBIT_MASK);
+}
+
+static int flashSelected(void) {
+    if(ssr & 1) {
+        return 0;
+    }
+    return (cr & XSP_CR_MANUAL_SS_MASK) ? 1 : autoSelected;
+}
+
+static void selectFlash(int sel) {
+    if(sel && !selected) {
+        stats.selects++;
+    }
+    selected = sel;
+    simFlashSelect(sel);
+}
+
+    // One word out and one in, most significant byte first
+static u32 exchange(u32 mosi) {
+    if((cr & XSP_CR_LOOPBACK_MASK) && config.mode == XSP_STANDARD_MODE) {
+        return mosi;
+    }
+    u32 miso = 0;
+    for(int shift = config.width - 8; shift >= 0; shift -= 8) {
+        u8 byte = flashSelected() ? simFlashShift((u8)(mosi >> shift)) : 0xFF;
+        miso |= (u32)byte << shift;
+    }
+    return miso;
+}
+
+static void receive(u32 word) {
+    if(rxCount == fifoSize()) {
+        iisr |= XSP_INTR_RX_OVERRUN_MASK;
+        stats.overruns++;
+        return;
+    }
+    rx[(rxHead + rxCount) % SPI_MAX_FIFO] = word & wordMask();
+    rxCount++;
+    if(rxCount > stats.rxHighWater) {
+        stats.rxHighWater = rxCount;
+    }
+}
+
+    // Runs the shifter up to now. A word starts when the previous one
+    // ends, or at the last access if the shifter stopped before it: any
+    // word in the FIFO now was written no later than that
+static void shiftOut(void) {
+    SimTime now = simNow();
+    for(;;) {
+        if(shifting) {
+            if(config.nsPerWord && now < shiftEnd) {
+                break;
+            }
+            receive(exchange(shiftWord));
+            stats.words++;
+            shifting = 0;
+            if(txCount == 0) {
+                iisr |= XSP_INTR_TX_EMPTY_MASK;
+            }
+        }
+        if(txCount == 0 || !transferring()) {
+            break;
+        }
+        if(!(cr & XSP_CR_MANUAL_SS_MASK) && !autoSelected && !(ssr & 1)) {
+            autoSelected = 1;
+            selectFlash(1);
+        }
+        shiftWord = tx[txHead];
+        txHead = (txHead + 1) % SPI_MAX_FIFO;
+        txCount--;
+        SimTime start = shiftEnd > lastAccess ? shiftEnd : lastAccess;
+        shiftEnd = start + config.nsPerWord;
+        shifting = 1;
+    }
+    if(!shifting && autoSelected) {
+        autoSelected = 0;
+        selectFlash(0);
+    }
+    lastAccess = now;
+    simSetIrq(XPAR_INTC_0_SPI_0_VEC_ID, (dgier & XSP_GINTR_ENABLE_MASK) && (iisr & iier));
+}
+
+static u32 spiRead(SimDevice * dev, u32 offset) {
+    (void)dev;
+    shiftOut();
+    switch(offset) {
+    case XSP_CR_OFFSET:
+        return cr;
+    case XSP_SR_OFFSET: {
+        u32 sr = 0;
+        if(rxCount == 0) {
+            sr |= XSP_SR_RX_EMPTY_MASK;
+        }
+        if(rxCount == fifoSize()) {
+            sr |= XSP_SR_RX_FULL_MASK;
+        }
+        if(txCount == 0) {
+            sr |= XSP_SR_TX_EMPTY_MASK;
+        }
+        if(txCount == fifoSize()) {
+            sr |= XSP_SR_TX_FULL_MASK;
+        }
+        return sr;
+    }
+    case XSP_DRR_OFFSET: {
+        if(rxCount == 0) {
+            stats.badAccesses++;
+            return 0;
+        }
+        u32 value = rx[rxHead];
+        rxHead = (rxHead + 1) % SPI_MAX_FIFO;
+        rxCount--;
+        return value;
+    }
+    case XSP_SSR_OFFSET:
+        return ssr;
+    case XSP_TFO_OFFSET:
+    case XSP_RFO_OFFSET: {
+        u32 count = offset == XSP_TFO_OFFSET ? txCount : rxCount;
+        if(config.depth == 0) {
+            stats.badAccesses++;
+        }
+        return count ? count - 1 : 0;
+    }
+    case XSP_DGIER_OFFSET:
+        return dgier;
+    case XSP_IISR_OFFSET:
+        return iisr;
+    case XSP_IIER_OFFSET:
+        return iier;
+    default:
+        return 0;
+    }
+}
+
+static void spiWrite(SimDevice * dev, u32 offset, u32 value) {
+    (void)dev;
+    shiftOut();
+    switch(offset) {
+    case XSP_SRR_OFFSET:
+        if(value == XSP_SRR_RESET_MASK) {
+            spiReset();
+        }
+        break;
+    case XSP_CR_OFFSET:
+        if(value & XSP_CR_TXFIFO_RESET_MASK) {
+            txCount = 0;
+        }
+        if(value & XSP_CR_RXFIFO_RESET_MASK) {
+            rxCount = 0;
+        }
+        cr = value & ~(XSP_CR_TXFIFO_RESET_MASK | XSP_CR_RXFIFO_RESET_MASK);
+        break;
+    case XSP_DTR_OFFSET:
+        if(txCount == fifoSize()) {
+            stats.badAccesses++;
+            break;
+        }
+        tx[(txHead + txCount) % SPI_MAX_FIFO] = value & wordMask();
+        txCount++;
+        break;
+    case XSP_SSR_OFFSET:
+        ssr = value;
+        break;
+    case XSP_DGIER_OFFSET:
+        dgier = value;
+        break;
+    case XSP_IISR_OFFSET:
+        iisr ^= value;
+        break;
+    case XSP_IIER_OFFSET:
+        iier = value;
+        break;
+    default:
+        break;
+    }
+    shiftOut();
+    selectFlash(flashSelected());
+}
+
+static SimDevice spiDevice = {
+    .name = "spi",
+    .base = XPAR_SPI_0_BASEADDR,
+    .size = 0x10000,
+    .read = spiRead,
+    .write = spiWrite,
+    .fd = -1,
+};
+
+void simSpiConfigure(u32 width, u32 fifoDepth, u32 spiMode, u32 nsPerWord) {
+    config.width = width;
+    config.depth = fifoDepth;
+    config.mode = spiMode;
+    config.nsPerWord = nsPerWord;
+    spiReset();
+    selectFlash(0);
+    memset(&stats, 0, sizeof(stats));
+}
+
+void simSpiGetStats(SimSpiStats * s) {
+    *s = stats;
+}
+
+void simInitSpi(void) {
+    simInitFlash(simOptions.flashImage);
+    simSpiConfigure(XPAR_SPI_0_NUM_TRANSFER_BITS, XPAR_SPI_0_FIFO_DEPTH,
+        XPAR_SPI_0_SPI_MODE, 0);
+    simRegister(&spiDevice);
+}
@@ -0,0 +1,162 @@
+/*******************************************************************************
+    AXI Timer model
+
+    Both counters in generate mode, counting one per AXI clock. The counter
+    register is worked out from virtual time when read; the hardware thread
+    only wakes up for roll overs, which set T0INT and reload from TLR with
+    ARHT set, or hold the counter without. The interrupt line is level,
+    high while any counter has T0INT and ENIT set.
+*******************************************************************************/
+
+#include "sim.h"
+#include "xparameters.h"
+#include "xtmrctr_l.h"
+
+typedef struct {
+    u32 tcsr;
+    u32 tlr;
+    u32 value;          // when stopped, or when started
+    SimTime started;
+    int running;
+} TimerCounter;
+
+static TimerCounter counters[XTC_DEVICE_TIMER_COUNT];
+
+static u32 counterValue(TimerCounter * c, SimTime now) {
+    if(!c->running) {
+        return c->value;
+    }
+    u32 cycles = (u32)((now - c->started) / SIM_NS_PER_CYCLE);
+    return (c->tcsr & XTC_CSR_DOWN_COUNT_MASK) ? c->value - cycles : c->value + cycles;
+}
+
+    // Time at which the counter passes its terminal count
+static SimTime rollover(TimerCounter * c) {
+    u64 cycles = (c->tcsr & XTC_CSR_DOWN_COUNT_MASK) ?
+        (u64)c->value + 1 : 0x100000000ULL - c->value;
+    return c->started + cycles * SIM_NS_PER_CYCLE;
+}
+
+static void startCounter(TimerCounter * c, u32 value, SimTime at) {
+    c->value = value;
+    c->started = at;
+    c->running = 1;
+}
+
+static void stopCounter(TimerCounter * c, SimTime now) {
+    c->value = counterValue(c, now);
+    c->running = 0;
+}
+
+static void updateTimer(SimDevice * dev) {
+    int irq = 0;
+    dev->due = SIM_NEVER;
+    for(int i = 0; i < XTC_DEVICE_TIMER_COUNT; i++) {
+        TimerCounter * c = &counters[i];
+        if(c->running && rollover(c) < dev->due) {
+            dev->due = rollover(c);
+        }
+        if((c->tcsr & XTC_CSR_INT_OCCURED_MASK) && (c->tcsr & XTC_CSR_ENABLE_INT_MASK)) {
+            irq = 1;
+        }
+    }
+    simSetIrq(XPAR_INTC_0_TMRCTR_0_VEC_ID, irq);
+}
+
+static void timerRun(SimDevice * dev, SimTime now) {
+    for(int i = 0; i < XTC_DEVICE_TIMER_COUNT; i++) {
+        TimerCounter * c = &counters[i];
+        while(c->running && rollover(c) <= now) {
+            SimTime at = rollover(c);
+            c->tcsr |= XTC_CSR_INT_OCCURED_MASK;
+            if(c->tcsr & XTC_CSR_AUTO_RELOAD_MASK) {
+                startCounter(c, c->tlr, at);
+            } else {
+                c->value = (c->tcsr & XTC_CSR_DOWN_COUNT_MASK) ? 0 : 0xFFFFFFFFU;
+                c->running = 0;
+            }
+        }
+    }
+    updateTimer(dev);
+}
+
+static u32 timerRead(SimDevice * dev, u32 offset) {
+    (void)dev;
+    u32 index = offset / XTC_TIMER_COUNTER_OFFSET;
+    if(index >= XTC_DEVICE_TIMER_COUNT) {
+        return 0;
+    }
+    TimerCounter * c = &counters[index];
+    switch(offset % XTC_TIMER_COUNTER_OFFSET) {
+    case XTC_TCSR_OFFSET:
+        return c->tcsr;
+    case XTC_TLR_OFFSET:
+        return c->tlr;
+    case XTC_TCR_OFFSET:
+        return counterValue(c, simNow());
+    default:
+        return 0;
+    }
+}
+
+static void writeTcsr(TimerCounter * c, u32 value, SimTime now) {
+        // T0INT clears when written with a 1
+    u32 interrupt = c->tcsr & XTC_CSR_INT_OCCURED_MASK & ~value;
+    c->tcsr = (value & ~(XTC_CSR_INT_OCCURED_MASK | XTC_CSR_ENABLE_ALL_MASK)) | interrupt;
+
+    if(c->tcsr & XTC_CSR_LOAD_MASK) {
+        c->value = c->tlr;
+        c->running = 0;
+    } else if(!(c->tcsr & XTC_CSR_ENABLE_TMR_MASK)) {
+        if(c->running) {
+            stopCounter(c, now);
+        }
+    } else if(!c->running) {
+        startCounter(c, c->value, now);
+    }
+}
+
+static void timerWrite(SimDevice * dev, u32 offset, u32 value) {
+    u32 index = offset / XTC_TIMER_COUNTER_OFFSET;
+    SimTime now = simNow();
+    if(index >= XTC_DEVICE_TIMER_COUNT) {
+        return;
+    }
+    TimerCounter * c = &counters[index];
+    switch(offset % XTC_TIMER_COUNTER_OFFSET) {
+    case XTC_TCSR_OFFSET:
+        writeTcsr(c, value, now);
+            // ENALL starts both counters at once
+        if(value & XTC_CSR_ENABLE_ALL_MASK) {
+            for(int i = 0; i < XTC_DEVICE_TIMER_COUNT; i++) {
+                writeTcsr(&counters[i], counters[i].tcsr | XTC_CSR_ENABLE_TMR_MASK, now);
+            }
+        }
+        break;
+    case XTC_TLR_OFFSET:
+        c->tlr = value;
+        break;
+    default:
+        break;
+    }
+    SimTime due = dev->due;
+    updateTimer(dev);
+    if(dev->due < due) {
+        simKick();
+    }
+}
+
+static SimDevice timerDevice = {
+    .name = "timer",
+    .base = XPAR_TMRCTR_0_BASEADDR,
+    .size = 0x10000,
+    .read = timerRead,
+    .write = timerWrite,
+    .run = timerRun,
+    .due = SIM_NEVER,
+    .fd = -1,
+};
+
+void simInitTimer(void) {
+    simRegister(&timerDevice);
+}
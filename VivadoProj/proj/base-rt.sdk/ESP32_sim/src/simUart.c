@@ -0,0 +1,207 @@
+/*******************************************************************************
+    AXI UART Lite model
+
+    16 byte receive and transmit FIFOs and a transmit shifter that moves one
+    byte per 10 bit times, 8N1. The far end of the line is a callback that
+    gets each byte when its stop bit has gone out, and calls
+    simUartReceive when one of its bytes has arrived. With interrupts
+    enabled the interrupt line pulses when the receive FIFO goes from empty
+    to holding data and when the transmit FIFO runs empty.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "sim.h"
+#include "xuartlite_l.h"
+
+#define UART_FIFO_SIZE          16
+
+struct SimUart {
+    SimDevice dev;
+    u32 irq;
+    SimTime byteTime;
+    SimLineOut lineOut;
+    void * peer;
+
+    u8 rx[UART_FIFO_SIZE];
+    u32 rxHead;
+    u32 rxCount;
+    u8 tx[UART_FIFO_SIZE];
+    SimTime txWritten[UART_FIFO_SIZE];
+    u32 txHead;
+    u32 txCount;
+    int shifting;
+    u8 shiftByte;
+    SimTime shiftDone;
+    u32 ctrl;
+    u32 overrun;
+
+    u64 bytesSent;
+    u64 bytesReceived;
+    u64 overruns;
+    SimTime busyTime;
+};
+
+static void uartInterrupt(SimUart * uart) {
+    if(uart->ctrl & XUL_CR_ENABLE_INTR) {
+        simPulseIrq(uart->irq);
+    }
+}
+
+    // Moves the next byte from the FIFO to the shifter, starting no
+    // earlier than when it was written or the previous byte finished
+static void startShift(SimUart * uart, SimTime notBefore) {
+    SimTime start = uart->txWritten[uart->txHead];
+    if(start < notBefore) {
+        start = notBefore;
+    }
+    uart->shiftByte = uart->tx[uart->txHead];
+    uart->txHead = (uart->txHead + 1) % UART_FIFO_SIZE;
+    uart->txCount--;
+    uart->shifting = 1;
+    uart->shiftDone = start + uart->byteTime;
+    uart->busyTime += uart->byteTime;
+    uart->dev.due = uart->shiftDone;
+    if(uart->txCount == 0) {
+        uartInterrupt(uart);
+    }
+}
+
+static void uartRun(SimDevice * dev, SimTime now) {
+    SimUart * uart = (SimUart *)dev;
+    while(uart->shifting && uart->shiftDone <= now) {
+        SimTime done = uart->shiftDone;
+        uart->shifting = 0;
+        uart->bytesSent++;
+        if(uart->lineOut != NULL) {
+            uart->lineOut(uart->peer, uart->shiftByte, done);
+        }
+        if(uart->txCount > 0) {
+            startShift(uart, done);
+        }
+    }
+    if(!uart->shifting) {
+        dev->due = SIM_NEVER;
+    }
+}
+
+void simUartReceive(SimUart * uart, u8 byte, SimTime when) {
+    (void)when;
+    if(uart->rxCount == UART_FIFO_SIZE) {
+        uart->overrun = 1;
+        uart->overruns++;
+        return;
+    }
+    uart->rx[(uart->rxHead + uart->rxCount) % UART_FIFO_SIZE] = byte;
+    uart->rxCount++;
+    uart->bytesReceived++;
+    if(uart->rxCount == 1) {
+        uartInterrupt(uart);
+    }
+}
+
+static u32 uartRead(SimDevice * dev, u32 offset) {
+    SimUart * uart = (SimUart *)dev;
+    u32 value = 0;
+    switch(offset) {
+    case XUL_RX_FIFO_OFFSET:
+        if(uart->rxCount > 0) {
+            value = uart->rx[uart->rxHead];
+            uart->rxHead = (uart->rxHead + 1) % UART_FIFO_SIZE;
+            uart->rxCount--;
+        }
+        break;
+    case XUL_STATUS_REG_OFFSET:
+        if(uart->rxCount > 0) {
+            value |= XUL_SR_RX_FIFO_VALID_DATA;
+        }
+        if(uart->rxCount == UART_FIFO_SIZE) {
+            value |= XUL_SR_RX_FIFO_FULL;
+        }
+        if(uart->txCount == 0) {
+            value |= XUL_SR_TX_FIFO_EMPTY;
+        }
+        if(uart->txCount == UART_FIFO_SIZE) {
+            value |= XUL_SR_TX_FIFO_FULL;
+        }
+        if(uart->ctrl & XUL_CR_ENABLE_INTR) {
+            value |= XUL_SR_INTR_ENABLED;
+        }
+            // Error flags clear when read
+        if(uart->overrun) {
+            value |= XUL_SR_OVERRUN_ERROR;
+            uart->overrun = 0;
+        }
+        break;
+    default:
+        break;
+    }
+    return value;
+}
+
+static void uartWrite(SimDevice * dev, u32 offset, u32 value) {
+    SimUart * uart = (SimUart *)dev;
+    switch(offset) {
+    case XUL_TX_FIFO_OFFSET:
+        if(uart->txCount == UART_FIFO_SIZE) {
+            break;
+        }
+        {
+            u32 slot = (uart->txHead + uart->txCount) % UART_FIFO_SIZE;
+            uart->tx[slot] = (u8)value;
+            uart->txWritten[slot] = simNow();
+            uart->txCount++;
+        }
+        if(!uart->shifting) {
+            startShift(uart, 0);
+            simKick();
+        }
+        break;
+    case XUL_CONTROL_REG_OFFSET:
+        if(value & XUL_CR_FIFO_TX_RESET) {
+            uart->txCount = 0;
+        }
+        if(value & XUL_CR_FIFO_RX_RESET) {
+            uart->rxCount = 0;
+        }
+        uart->ctrl = value & XUL_CR_ENABLE_INTR;
+        break;
+    default:
+        break;
+    }
+}
+
+SimUart * simInitUart(const char * name, u32 base, u32 irq, u32 baud,
+        SimLineOut lineOut, void * peer) {
+    SimUart * uart = calloc(1, sizeof(SimUart));
+    if(uart == NULL) {
+        perror("sim: uart");
+        exit(1);
+    }
+    uart->dev.name = name;
+    uart->dev.base = base;
+    uart->dev.size = 0x10000;
+    uart->dev.read = uartRead;
+    uart->dev.write = uartWrite;
+    uart->dev.run = uartRun;
+    uart->dev.due = SIM_NEVER;
+    uart->dev.fd = -1;
+    uart->irq = irq;
+    uart->byteTime = (10 * SIM_NS_PER_SEC + baud / 2) / baud;
+    uart->lineOut = lineOut;
+    uart->peer = peer;
+    simRegister(&uart->dev);
+    return uart;
+}
+
+SimTime simUartByteTime(SimUart * uart) {
+    return uart->byteTime;
+}
+
+void simReportUart(SimUart * uart) {
+    double seconds = (double)simNow() / SIM_NS_PER_SEC;
+    printf("%s: sent %llu bytes (%.1f%% of the line), received %llu, overruns %llu\n",
+        uart->dev.name, (unsigned long long)uart->bytesSent,
+        seconds > 0 ? 100.0 * uart->busyTime / SIM_NS_PER_SEC / seconds : 0.0,
+        (unsigned long long)uart->bytesReceived, (unsigned long long)uart->overruns);
+}
@@ -0,0 +1,202 @@
+/*******************************************************************************
+    AXI XADC model
+
+    A register file with the parts the application relies on behaving:
+        Conversions run back to back at 26 ADCCLK cycles each, ADCCLK being
+        the AXI clock divided by the CFR2 divider. EOC is set per
+        conversion and EOS once per pass through the enabled sequence
+        channels. Restarting the sequencer restarts the count.
+        The temperature and supply channels read fixed values; each
+        auxiliary channel reads a sine of its own frequency.
+        IPISR is toggle on write and the interrupt line is level.
+    Alarm comparisons are not modelled, AOR always reads 0.
+*******************************************************************************/
+
+#include <math.h>
+#include "sim.h"
+#include "xparameters.h"
+#include "xsysmon_hw.h"
+
+#define XADC_REGS               (0x800 / 4)
+#define XADC_CYCLES_PER_CONV    26
+#define XADC_CFR2_RESET         0x0400
+
+    // 16 bit codes as read from the data registers
+#define XADC_TEMP_CODE          40071       // 35 degrees C
+#define XADC_VCCINT_CODE        21845       // 1.00 V
+#define XADC_VCCAUX_CODE        39321       // 1.80 V
+
+static u32 regs[XADC_REGS];
+static u32 ipisr;
+static u32 ipier;
+static u32 gier;
+static SimTime epoch;
+static u64 convsSeen;
+static u64 seqsSeen;
+
+#define REG(offset)             regs[(offset) / 4]
+
+static SimTime conversionTime(void) {
+    u32 div = (REG(XSM_CFR2_OFFSET) >> 8) & 0xFF;
+    if(div < 2) {
+        div = 2;
+    }
+    return (SimTime)XADC_CYCLES_PER_CONV * div * SIM_NS_PER_CYCLE;
+}
+
+static u32 sequenceLength(void) {
+    u32 mode = REG(XSM_CFR1_OFFSET) & XSM_CFR1_SEQ_VALID_MASK;
+    u32 length = __builtin_popcount(REG(XSM_SEQ00_OFFSET) & 0xFFFF) +
+        __builtin_popcount(REG(XSM_SEQ01_OFFSET) & 0xFFFF);
+    if(mode == XSM_CFR1_SEQ_SINGCHAN_MASK || mode == XSM_CFR1_SEQ_SAFEMODE_MASK ||
+            length == 0) {
+        return 1;
+    }
+    return length;
+}
+
+    // Latches EOC and EOS for the conversions finished by now
+static void advance(SimTime now) {
+    if(now < epoch) {
+        return;
+    }
+    u64 convs = (now - epoch) / conversionTime();
+    if(convs > convsSeen) {
+        ipisr |= XSM_IPIXR_EOC_MASK;
+        convsSeen = convs;
+    }
+    u64 seqs = convs / sequenceLength();
+    if(seqs > seqsSeen) {
+        ipisr |= XSM_IPIXR_EOS_MASK;
+        seqsSeen = seqs;
+    }
+}
+
+static void updateXadc(SimDevice * dev) {
+    int watching = (gier & XSM_GIER_GIE_MASK) &&
+        (ipier & (XSM_IPIXR_EOC_MASK | XSM_IPIXR_EOS_MASK));
+    simSetIrq(XPAR_INTC_0_SYSMON_0_VEC_ID, (gier & XSM_GIER_GIE_MASK) && (ipisr & ipier));
+    if(!watching) {
+        dev->due = SIM_NEVER;
+    } else if(ipier & XSM_IPIXR_EOC_MASK) {
+        dev->due = epoch + (convsSeen + 1) * conversionTime();
+    } else {
+        dev->due = epoch + (seqsSeen + 1) * sequenceLength() * conversionTime();
+    }
+}
+
+static void xadcRun(SimDevice * dev, SimTime now) {
+    advance(now);
+    updateXadc(dev);
+}
+
+static void restartSequencer(SimTime now) {
+    epoch = now;
+    convsSeen = 0;
+    seqsSeen = 0;
+}
+
+static u32 auxCode(u32 channel, SimTime now) {
+    double t = (double)now / SIM_NS_PER_SEC;
+    double volts = 0.5 + 0.4 * sin(2.0 * M_PI * 50.0 * (channel + 1) * t);
+    return (u32)(volts * 65535.0) & 0xFFF0;
+}
+
+static u32 xadcRead(SimDevice * dev, u32 offset) {
+    SimTime now = simNow();
+    (void)dev;
+    if(offset >= XSM_AUX00_OFFSET && offset <= XSM_AUX15_OFFSET) {
+        return auxCode((offset - XSM_AUX00_OFFSET) / 4, now);
+    }
+    switch(offset) {
+    case XSM_SR_OFFSET:
+        advance(now);
+        return ((ipisr & XSM_IPIXR_EOC_MASK) ? XSM_SR_EOC_MASK : 0) |
+            ((ipisr & XSM_IPIXR_EOS_MASK) ? XSM_SR_EOS_MASK : 0);
+    case XSM_AOR_OFFSET:
+        return 0;
+    case XSM_GIER_OFFSET:
+        return gier;
+    case XSM_IPISR_OFFSET:
+        advance(now);
+        return ipisr;
+    case XSM_IPIER_OFFSET:
+        return ipier;
+    case XSM_TEMP_OFFSET:
+    case XSM_MAX_TEMP_OFFSET:
+    case XSM_MIN_TEMP_OFFSET:
+        return XADC_TEMP_CODE;
+    case XSM_VCCINT_OFFSET:
+    case XSM_MAX_VCCINT_OFFSET:
+    case XSM_MIN_VCCINT_OFFSET:
+        return XADC_VCCINT_CODE;
+    case XSM_VCCAUX_OFFSET:
+    case XSM_MAX_VCCAUX_OFFSET:
+    case XSM_MIN_VCCAUX_OFFSET:
+        return XADC_VCCAUX_CODE;
+    default:
+        return offset < XADC_REGS * 4 ? REG(offset) : 0;
+    }
+}
+
+static void xadcReset(void) {
+    for(u32 i = 0; i < XADC_REGS; i++) {
+        regs[i] = 0;
+    }
+    REG(XSM_CFR2_OFFSET) = XADC_CFR2_RESET;
+    ipisr = 0;
+    ipier = 0;
+    gier = 0;
+}
+
+static void xadcWrite(SimDevice * dev, u32 offset, u32 value) {
+    SimTime now = simNow();
+    SimTime due = dev->due;
+    advance(now);
+    switch(offset) {
+    case XSM_SRR_OFFSET:
+        if(value == XSM_SRR_IPRST_MASK) {
+            xadcReset();
+            restartSequencer(now);
+        }
+        break;
+    case XSM_GIER_OFFSET:
+        gier = value & XSM_GIER_GIE_MASK;
+        break;
+    case XSM_IPISR_OFFSET:
+        ipisr ^= value & XSM_IPIXR_ALL_MASK;
+        break;
+    case XSM_IPIER_OFFSET:
+        ipier = value & XSM_IPIXR_ALL_MASK;
+        break;
+    default:
+        if(offset < XADC_REGS * 4) {
+            REG(offset) = value & 0xFFFF;
+        }
+            // The configuration registers restart the sequencer
+        if(offset == XSM_CFR0_OFFSET || offset == XSM_CFR1_OFFSET) {
+            restartSequencer(now);
+        }
+        break;
+    }
+    updateXadc(dev);
+    if(dev->due < due) {
+        simKick();
+    }
+}
+
+static SimDevice xadcDevice = {
+    .name = "xadc",
+    .base = XPAR_SYSMON_0_BASEADDR,
+    .size = 0x10000,
+    .read = xadcRead,
+    .write = xadcWrite,
+    .run = xadcRun,
+    .due = SIM_NEVER,
+    .fd = -1,
+};
+
+void simInitXadc(void) {
+    xadcReset();
+    simRegister(&xadcDevice);
+}
@@ -0,0 +1,549 @@
+/*******************************************************************************
+    Reference outputs of the decimation filters, written by
+    decimateRef.py; do not edit
+*******************************************************************************/
+
+#define DECIMATE_REF_SAMPLES    8192
+#define DECIMATE_REF_CHECKSUM   0xB5904050
+
+static const s32 cicRef2[2048] = {
+    -7096, -19551, -16043, -12104, -7831, -4807, -6183, -9803, -13373, -16581, -16777, -13109,
+    -8974, -3700, -589, -1820, -5238, -8392, -12504, -14497, -10365, -5263, -666, 3325,
+    4020, 1105, -3088, -6670, -9356, -7476, -2596, 2420, 6665, 8673, 5000, 1271,
+    -1699, -4754, -3270, 1268, 5210, 9461, 12736, 11038, 7276, 2914, -623, -914,
+    3742, 8456, 12598, 16393, 16210, 12607, 9085, 5007, 2935, 6365, 11195, 15556,
+    20492, 20361, 16722, 12986, 8570, 4961, 6753, 10146, 14807, 18542, 18849, 14726,
+    10700, 5589, 1768, 1789, 5079, 8121, 12137, 14373, 11673, 7068, 2071, -1633,
+    -2744, 342, 4344, 8082, 10634, 9174, 4229, -84, -4776, -7540, -5030, -969,
+    1991, 5951, 4994, 313, -3339, -7669, -11659, -10078, -6593, -2626, 1490, 2350,
+    -1454, -6500, -11088, -15440, -15578, -11331, -7269, -4025, -2772, -5091, -9786, -14425,
+    -18600, -19878, -17125, -13846, -9146, -5742, -7105, -10796, -14934, -18556, -20164, -16956,
+    -12877, -7931, -3287, -3114, -6152, -9523, -13488, -16259, -13641, -9425, -4415, 61,
+    1864, -1501, -4859, -8177, -12007, -10240, -5501, -750, 3490, 6145, 3667, -125,
+    -3822, -6782, -6670, -2394, 2073, 6996, 10530, 9803, 5693, 1610, -1813, -3358,
+    240, 4975, 9770, 13506, 14077, 10823, 7607, 3776, 1120, 2903, 7610, 12609,
+    17207, 18945, 16417, 12111, 8701, 5977, 6928, 10635, 15250, 19624, 21559, 18642,
+    13875, 9015, 4644, 3489, 6616, 10862, 14066, 17381, 15365, 10679, 5832, 1996,
+    -552, 1778, 5205, 8575, 11398, 11826, 7759, 3347, -1250, -4819, -3059, -106,
+    3887, 7667, 7818, 4037, -339, -4950, -8815, -8608, -5034, -1476, 2149, 5060,
+    1302, -3492, -8600, -12517, -13401, -10168, -6401, -2300, 416, -1583, -6530, -11498,
+    -15699, -18056, -16103, -12640, -8362, -4669, -5525, -9635, -13785, -18871, -22082, -20635,
+    -15845, -10689, -6226, -4662, -7921, -11269, -14904, -17984, -16205, -11867, -7862, -2629,
+    23, -2241, -5798, -9497, -12699, -13727, -9496, -4634, 307, 4199, 3019, -816,
+    -4934, -7986, -9089, -6209, -1528, 3653, 7891, 8186, 4006, 184, -3382, -5774,
+    -3615, 1693, 5984, 10453, 12612, 9540, 5799, 2339, -722, 788, 5055, 9392,
+    13816, 16440, 14642, 11075, 7136, 4244, 3753, 7331, 11913, 16423, 20969, 19916,
+    15777, 12469, 8340, 5466, 8469, 11785, 14965, 18860, 17861, 13183, 9112, 4738,
+    1687, 2889, 6694, 10478, 13865, 14363, 11101, 6662, 2193, -2104, -1872, 851,
+    4413, 8870, 11034, 7608, 2591, -1411, -5631, -6907, -3852, -464, 3831, 6435,
+    4130, -44, -4919, -9530, -11589, -8991, -4857, -1643, 1307, 803, -3085, -7345,
+    -12035, -14920, -13509, -10407, -7376, -3073, -1978, -6084, -10927, -15236, -19425, -18787,
+    -15582, -11326, -8418, -6447, -8539, -11644, -14893, -18539, -19673, -15165, -10266, -5936,
+    -2925, -4449, -7534, -11339, -14062, -15551, -12412, -8125, -3478, 564, 1367, -1484,
+    -5339, -9306, -11620, -9140, -4689, 153, 4712, 5753, 3498, -469, -3732, -7232,
+    -6181, -2360, 2517, 7811, 10728, 8436, 5049, 573, -2633, -2389, 1815, 5830,
+    10439, 14346, 13523, 10591, 6627, 2602, 576, 4040, 8442, 13543, 17885, 18255,
+    14941, 11109, 7136, 5497, 7854, 12157, 15551, 20240, 21639, 17380, 12601, 7612,
+    3945, 4089, 7653, 11931, 15503, 17161, 13894, 9570, 5402, 963, -9, 2982,
+    6123, 10189, 13208, 11598, 6781, 2014, -2739, -4926, -1888, 2152, 4778, 8622,
+    7839, 3232, -1301, -6234, -9748, -8018, -4185, -1086, 3593, 4283, 431, -4020,
+    -8797, -12894, -13237, -9671, -5605, -1252, 487, -2993, -7304, -11545, -16166, -17762,
+    -14574, -11252, -7411, -4033, -5821, -10105, -15271, -20092, -21972, -19268, -15167, -9486,
+    -5213, -4994, -8652, -12033, -15732, -18651, -16553, -11272, -15350, -31084, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -12293, 28657, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    12277, -28673, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+};
+static const u16 firRef2[1024] = {
+    32772, 32760, 32761, 32836, 32678, 32541, 34245, 23992, 14752, 25641, 27124, 18849,
+    15816, 24167, 32231, 28139, 19707, 21642, 32728, 37023, 29739, 23299, 29723, 40106,
+    38565, 30137, 29287, 38324, 45412, 40285, 31715, 35750, 46158, 49201, 41388, 35862,
+    43608, 53165, 50308, 40668, 38752, 47967, 51731, 43186, 34411, 37115, 45393, 45020,
+    34515, 29913, 37109, 43593, 37725, 27380, 27142, 35835, 37873, 29066, 21405, 25769,
+    34588, 31966, 20855, 17118, 25690, 30243, 23286, 13846, 14856, 24075, 26206, 17514,
+    12632, 19880, 29464, 27314, 18665, 18395, 28792, 34502, 27956, 20984, 26673, 36956,
+    37039, 28409, 26021, 35041, 43473, 38988, 30278, 32377, 43031, 46958, 40122, 33809,
+    39948, 50424, 49599, 40837, 39315, 48306, 54420, 46918, 37022, 38849, 47821, 48527,
+    38390, 32356, 37739, 44609, 41235, 30867, 28900, 37169, 40780, 32377, 23843, 27038,
+    35803, 34899, 23709, 19215, 26557, 33262, 26703, 16489, 16044, 24961, 27633, 18578,
+    10499, 16499, 27010, 25676, 17130, 16111, 25568, 32729, 27244, 19495, 22520, 33787,
+    36244, 27618, 23492, 31154, 40948, 37557, 28625, 28919, 39364, 45217, 38665, 32062,
+    37271, 47093, 47923, 39591, 36429, 44611, 53521, 49421, 40451, 40338, 48709, 50811,
+    41542, 34392, 39073, 46962, 44431, 34294, 30350, 37656, 43654, 35861, 26804, 28148,
+    37073, 37565, 27434, 21140, 27592, 34285, 30262, 20314, 18664, 26171, 30702, 21996,
+    13367, 16912, 25001, 24788, 17255, 13312, 22510, 29856, 25422, 18051, 19759, 29758,
+    34389, 27263, 21114, 27809, 37688, 36673, 28248, 26089, 35650, 43492, 37783, 29853,
+    33792, 43823, 46899, 39058, 33454, 41159, 50860, 48279, 39504, 40166, 49218, 54273,
+    45350, 36421, 40006, 48876, 47319, 37470, 32649, 39125, 46024, 40138, 29492, 30229,
+    38671, 40769, 31136, 23169, 27927, 36433, 34014, 23363, 19277, 27577, 33162, 25759,
+    16321, 17316, 26078, 27546, 17140, 10563, 17730, 27857, 24827, 15891, 17880, 15523,
+    0, 59, 134, 0, 0, 8, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 15, 25, 0,
+    198, 729, 0, 24883, 65535, 65102, 65222, 65535, 65513, 65499, 65532, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65533, 65504, 65494, 65535, 65321, 64790, 65535, 40636, 0, 417, 297, 0,
+    6, 20, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0,
+};
+
+static const s32 cicRef3[1024] = {
+    -5105, -15748, -10082, -6326, -11537, -15819, -10841, -2957, -3769, -10303, -11544, -3104,
+    2809, -1075, -7330, -4644, 4166, 6119, -130, -3063, 3203, 10355, 8824, 1654,
+    2039, 10412, 15377, 10786, 4910, 8897, 17463, 18091, 10794, 6732, 12519, 17713,
+    12589, 4320, 3811, 10028, 12168, 4682, -1340, 2424, 8708, 6345, -2236, -5432,
+    498, 4392, -1469, -8926, -8038, -957, -290, -8707, -14434, -9425, -4094, -7728,
+    -16093, -17932, -11481, -7311, -12856, -18506, -14699, -6206, -5076, -11431, -14077, -6888,
+    -18, -3174, -9457, -7497, 1108, 4100, -1870, -5822, -80, 8057, 7329, 216,
+    -774, 7247, 12918, 9143, 3150, 5658, 14500, 16925, 10604, 7256, 13026, 19680,
+    16015, 7292, 5728, 12347, 15373, 8362, 1493, 3622, 9619, 9187, 1154, -3124,
+    1994, 6797, 1745, -6280, -6402, 255, 2218, -5937, -12066, -8176, -1704, -4428,
+    -13272, -16352, -10472, -6072, -11832, -19660, -17777, -8907, -6906, -13053, -16168, -9753,
+    -2240, -4199, -10764, -10875, -2285, 2643, -2777, -7796, -3581, 5161, 5581, -1420,
+    -3732, 3734, 10590, 7621, 1430, 3274, 11390, 14767, 9190, 4807, 9739, 18000,
+    17564, 10459, 7741, 13447, 17289, 11185, 3909, 5114, 11761, 12115, 4445, -1111,
+    2849, 8966, 5027, -3180, -4797, 1585, 4435, -2536, -9658, -6847, -633, -1611,
+    -9518, -13466, -8741, -3577, -8531, -16712, -16732, -10158, -8128, -13336, -18087, -12738,
+    -5162, -6277, -12411, -13260, -5832, 104, -3551, -9657, -6619, 1957, 4000, -2042,
+    -5791, 263, 8321, 6469, -440, 184, 8121, 13079, 8472, 2525, 6446, 15122,
+    16073, 9396, 7418, 13902, 19821, 14899, 6420, 6387, 13389, 14780, 7472, 1406,
+    4687, 10989, 8795, -40, -2629, 3440, 7174, 925, -7159, -5931, 952, 1714,
+    -6364, -12108, -7540, -1362, -5243, -13525, -15553, -9325, -5885, -12755, -20092, -16845,
+    -8032, -7273, -13825, -16577, -15938, -29959, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -17412, 25585, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    17395, -25602, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768,
+};
+static const u16 firRef3[512] = {
+    32771, 32761, 32766, 32815, 32685, 32654, 33871, 25656, 21853, 21309, 22474, 28177,
+    22624, 34280, 26711, 35862, 33157, 36127, 40708, 35851, 46880, 39121, 49163, 44050,
+    45249, 45057, 37433, 43450, 32850, 40306, 31240, 32946, 31109, 25658, 31157, 19951,
+    27470, 17461, 20944, 19841, 18673, 26673, 20154, 31233, 24504, 33087, 31156, 33054,
+    39228, 33207, 44444, 37060, 46318, 43877, 46126, 48184, 39604, 46702, 35497, 41566,
+    34410, 34752, 34127, 27318, 33440, 22109, 29789, 20249, 22143, 20532, 15873, 24713,
+    17946, 29209, 22789, 29976, 30127, 29881, 37340, 30375, 41947, 35365, 43561, 42086,
+    43003, 49594, 41873, 48535, 37809, 43708, 37430, 36011, 37292, 29105, 35761, 24572,
+    31153, 23749, 24229, 23833, 16775, 23601, 16214, 26308, 20978, 26834, 28808, 26901,
+    35724, 28332, 39585, 33462, 40566, 40970, 39875, 47757, 41433, 51140, 40410, 45290,
+    40424, 37933, 40567, 31367, 38559, 26864, 32935, 26676, 25452, 27064, 18355, 25409,
+    13944, 23167, 21321, 12915, 0, 28, 63, 0, 0, 3, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 14, 25, 0, 170, 715, 0, 21175,
+    65535, 65335, 65190, 65535, 65524, 65498, 65530, 65521, 65520, 65520, 65520, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65532, 65505, 65494, 65535, 65349, 64804, 65535, 44344, 0, 184, 329, 0,
+    0, 21, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+static const s32 cicRef4[512] = {
+    -3883, -11115, -9936, -11809, -5165, -9052, -1688, -3381, -330, 2384, 1331, 7799,
+    3789, 11274, 8920, 12760, 13856, 10783, 13468, 5876, 9385, 3077, 4800, 1950,
+    -1581, 43, -6664, -2561, -9893, -7840, -11686, -13955, -11311, -14835, -7497, -11061,
+    -4746, -5676, -3066, 247, -1440, 5786, 1613, 8608, 6932, 10069, 13043, 11391,
+    15926, 8428, 12156, 6070, 6300, 4690, 570, 2667, -4506, -615, -7496, -5767,
+    -8895, -12477, -10481, -16631, -9783, -13040, -7043, -7251, -5950, -1311, -3968, 3403,
+    -768, 5857, 5127, 7524, 11008, 8853, 15861, 10701, 13892, 8461, 8331, 7541,
+    2328, 5206, -2165, 1341, -4874, -4214, -5936, -9965, -7722, -14878, -10616, -14392,
+    -9758, -9311, -8698, -3229, -6303, 1151, -2405, 3304, 3324, 4694, 9413, 6313,
+    13678, 10052, 15436, 11271, 10066, 10194, 4592, 8000, 529, 3767, -2182, -2547,
+    -3138, -8334, -5110, -12725, -9242, -15159, -12750, -10988, -17666, -29611, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -19716, 23794, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    19699, -23811, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+};
+static const u16 firRef4[256] = {
+    32770, 32765, 32763, 32803, 32731, 32631, 33525, 28166, 21070, 24792, 28784, 32345,
+    36063, 39526, 43452, 46005, 43750, 39473, 36437, 32512, 28912, 25429, 21242, 19360,
+    22328, 26178, 29844, 33683, 37328, 40876, 44925, 46006, 42368, 38577, 34977, 31104,
+    27583, 23788, 19698, 19956, 24169, 27691, 31433, 34800, 38704, 42319, 45904, 44698,
+    40876, 37234, 33437, 29656, 26285, 22460, 19595, 21722, 25330, 29256, 32780, 36453,
+    40098, 43741, 46203, 43283, 39689, 36156, 31999, 28470, 24852, 20473, 20910, 14459,
+    0, 0, 126, 0, 0, 7, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 13, 26, 0,
+    154, 706, 0, 19378, 65535, 65470, 65172, 65535, 65531, 65498, 65529, 65521,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65532, 65506, 65493, 65535, 65365, 64813, 65535, 46140, 0, 49, 347, 0,
+    0, 21, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0,
+};
+
+static const s32 cicRef5[256] = {
+    -2846, -9856, -8739, -5096, -1305, 2327, 5921, 9641, 12444, 11561, 7791, 4371,
+    744, -3001, -6483, -10303, -12790, -11171, -7574, -3840, -107, 3671, 7288, 10957,
+    12928, 10468, 6744, 3093, -695, -4326, -7995, -11800, -12846, -9661, -5995, -2298,
+    1224, 4964, 8697, 11982, 12263, 8976, 5393, 1599, -2122, -5661, -9234, -12324,
+    -11547, -8377, -4518, -845, 2772, 6495, 9930, 12677, 11205, 7803, 4243, 342,
+    -3447, -7024, -10771, -12994, -16040, -29697, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -20803, 22834, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    20786, -22851, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768,
+};
+static const u16 firRef5[128] = {
+    32770, 32764, 32763, 32801, 32723, 32649, 33496, 28741, 23448, 31384, 38982, 45162,
+    41071, 33467, 25957, 20099, 24850, 32680, 40414, 45495, 39802, 32145, 24289, 20058,
+    26629, 34007, 41865, 45015, 38222, 30716, 23071, 20975, 28141, 35551, 43177, 44345,
+    36911, 29111, 23012, 14198, 0, 0, 93, 0, 0, 5, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 12, 26, 0, 147, 701, 0, 18495,
+    65535, 65535, 65163, 65535, 65534, 65497, 65529, 65522, 65520, 65520, 65520, 65520,
+    65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520, 65520,
+    65531, 65507, 65493, 65535, 65372, 64818, 65535, 47024, 0, 0, 356, 0,
+    0, 22, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+static const s32 cicRef6[128] = {
+    -2299, -7966, -3202, 4135, 10467, 9359, 2517, -4751, -10867, -9108, -1968, 5466,
+    11176, 8457, 1202, -6182, -11449, -7764, -531, 6774, 11301, 7121, -230, -7391,
+    -11153, -6384, 970, 8090, 11172, 5961, -1512, -8729, -15947, -29526, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -21331, 22338, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752, 32752,
+    21314, -22355, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+};
+static const u16 firRef6[64] = {
+    32769, 32763, 32767, 32802, 32700, 32690, 33521, 28870, 28885, 43489, 36010, 21514,
+    30293, 44245, 34289, 21144, 32118, 44288, 32513, 21429, 33907, 43897, 32259, 14535,
+    0, 63, 71, 0, 0, 4, 0, 0, 0, 12, 26, 0,
+    143, 698, 0, 18056, 65535, 65535, 65159, 65535, 65535, 65497, 65529, 65522,
+    65531, 65507, 65493, 65535, 65376, 64821, 65535, 47462, 0, 0, 360, 0,
+    0, 22, 0, 0,
+};
+
+static const struct {
+    u32 rateShift;
+    const s32 * cic;
+    u32 cicCount;
+    const u16 * fir;
+    u32 firCount;
+    u32 clampedLow;             // FIR outputs clamped to 0
+    u32 clampedHigh;            // and to 0xFFFF
+} decimateRef[] = {
+    {2, cicRef2, 2048, firRef2, 1024, 12, 4},
+    {3, cicRef3, 1024, firRef3, 512, 13, 4},
+    {4, cicRef4, 512, firRef4, 256, 14, 4},
+    {5, cicRef5, 256, firRef5, 128, 15, 5},
+    {6, cicRef6, 128, firRef6, 64, 13, 6},
+};
@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""Reference outputs for the decimation filters in ESP32/src/decimate.c.
+
+Writes decimateRef.h, which testDecimate.c checks cicDecimate and
+firDecimate against. The filters are computed here the direct way, not
+as the integrator/comb and folded FIR recursions of decimate.c:
+
+    CIC     the input, mid-scale removed, convolved with a boxcar of
+            2^rateShift samples three times over, sampled after every
+            2^rateShift-th input and shifted down by 3 * rateShift - 4
+    FIR     the 31 Q15 taps over the last 31 CIC outputs, after every
+            second one, shifted down by 15, mid-scale added back and
+            clamped to 0..0xFFFF
+
+Both start from zero history, which is what a reset filter holds. Shifts
+round towards minus infinity, as an arithmetic shift does. Python
+integers do not wrap, so the CIC here also shows that the 32 bit
+integrators of decimate.c are wide enough.
+
+The input is made by the same integer-only generator as inputSample() in
+testDecimate.c, and its checksum is written alongside so the two cannot
+drift apart: tones and noise around mid-scale, then zero, full scale and
+zero again for 2048 samples each. The full scale steps ring past both
+ends of the range in the FIR, so every rate has clamped outputs.
+
+    python3 decimateRef.py > decimateRef.h
+"""
+
+SAMPLES = 8192
+RATE_SHIFTS = range(2, 7)
+CIC_ORDER = 3
+FIR_DECIMATION = 2
+XADC_MID_SCALE = 0x8000
+
+# decimate.c firCoefficients
+FIR = [
+       -7,     0,    15,     3,     4,    -7,  -110,    -8,
+      204,    57,   248,   -59, -2391,  -593, 10228, 17600,
+    10228,  -593, -2391,   -59,   248,    57,   204,    -8,
+     -110,    -7,     4,     3,    15,     0,    -7,
+]
+
+
+def triangle(n, period, amplitude):
+    u = 4 * amplitude * (n % period) // period
+    v = u if u <= 2 * amplitude else 4 * amplitude - u
+    return v - amplitude
+
+
+def inputSamples():
+    seed = 1
+    out = []
+    for n in range(SAMPLES):
+        seed = (seed * 1103515245 + 12345) & 0x7FFFFFFF
+        if n < 2048:
+            code = 2048 + triangle(n, 37, 600) + triangle(n, 500, 900) + (seed >> 16) % 201 - 100
+        elif 4096 <= n < 6144:
+            code = 0xFFF
+        else:
+            code = 0
+        out.append(code << 4)
+    return out
+
+
+def checksum(samples):
+    total = 0
+    for i, s in enumerate(samples):
+        total = (total + s * (i + 1)) & 0xFFFFFFFF
+    return total
+
+
+def cic(samples, rateShift):
+    rate = 1 << rateShift
+    h = [1] * rate
+    for _ in range(CIC_ORDER - 1):
+        g = [0] * (len(h) + rate - 1)
+        for i, a in enumerate(h):
+            for j in range(rate):
+                g[i + j] += a
+        h = g
+    x = [(s >> 4) - 2048 for s in samples]
+    out = []
+    for n in range(rate - 1, len(x), rate):
+        acc = sum(h[k] * x[n - k] for k in range(len(h)) if n - k >= 0)
+        out.append(acc >> (CIC_ORDER * rateShift - 4))
+    return out
+
+
+def fir(samples):
+    out = []
+    clamped = [0, 0]
+    taps = len(FIR)
+    for m in range(FIR_DECIMATION - 1, len(samples), FIR_DECIMATION):
+        acc = 0
+        for k in range(taps):
+            i = m - (taps - 1) + k
+            if i >= 0:
+                acc += FIR[k] * samples[i]
+        value = (acc >> 15) + XADC_MID_SCALE
+        if value < 0:
+            value = 0
+            clamped[0] += 1
+        elif value > 0xFFFF:
+            value = 0xFFFF
+            clamped[1] += 1
+        out.append(value)
+    return out, clamped
+
+
+def array(ctype, name, values):
+    lines = ["static const %s %s[%d] = {" % (ctype, name, len(values))]
+    for i in range(0, len(values), 12):
+        lines.append("    " + ", ".join(str(v) for v in values[i:i + 12]) + ",")
+    lines.append("};")
+    return "\n".join(lines)
+
+
+def main():
+    samples = inputSamples()
+    print("/" + "*" * 79)
+    print("    Reference outputs of the decimation filters, written by")
+    print("    decimateRef.py; do not edit")
+    print("*" * 79 + "/")
+    print()
+    print("#define DECIMATE_REF_SAMPLES    %d" % SAMPLES)
+    print("#define DECIMATE_REF_CHECKSUM   0x%08X" % checksum(samples))
+    rows = []
+    for r in RATE_SHIFTS:
+        c = cic(samples, r)
+        f, clamped = fir(c)
+        print()
+        print(array("s32", "cicRef%d" % r, c))
+        print(array("u16", "firRef%d" % r, f))
+        rows.append("    {%d, cicRef%d, %d, firRef%d, %d, %d, %d},"
+                    % (r, r, len(c), r, len(f), clamped[0], clamped[1]))
+    print()
+    print("static const struct {")
+    print("    u32 rateShift;")
+    print("    const s32 * cic;")
+    print("    u32 cicCount;")
+    print("    const u16 * fir;")
+    print("    u32 firCount;")
+    print("    u32 clampedLow;             // FIR outputs clamped to 0")
+    print("    u32 clampedHigh;            // and to 0xFFFF")
+    print("} decimateRef[] = {")
+    print("\n".join(rows))
+    print("};")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,54 @@
+/*******************************************************************************
+    Host unit tests of the ESP32 application and the BSP drivers
+
+    Each test is a program of its own, linked with the sources under test,
+    the device models it needs from src/ and testBus.c in place of
+    simCore.c. There is no hardware thread: a register access reaches its
+    model at once and moves virtual time on by TEST_NS_PER_ACCESS, so a
+    loop polling a model's busy time ends without a clock running.
+
+    Interrupts are SIGALRM: testStartIsr calls a function every period as
+    an interrupt would, and clearing IE in the simulated MSR, as
+    enter_critical does, blocks the signal until IE is set again.
+
+    CHECK counts each check and reports the ones that fail; testDone
+    prints the totals and returns the exit status for "make test".
+*******************************************************************************/
+
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+#include "sim.h"
+
+    // One AXI Lite access at 100 MHz, give or take
+#define TEST_NS_PER_ACCESS      100
+
+#define CHECK(cond)             testCheck((cond) != 0, #cond, __FILE__, __LINE__)
+
+    // Returns ok, reporting the check if it failed
+int testCheck(int ok, const char * expr, const char * file, int line);
+    // Prints the totals; returns 0 if every check passed, 1 otherwise
+int testDone(const char * name);
+
+    // Moves virtual time on without a register access
+void testAdvance(SimTime ns);
+    // Adds a random 0 to maxNs to every register access, and stallNs to
+    // one access in 64, as a cache miss or an interrupt would
+void testBusJitter(u32 maxNs, u32 stallNs);
+    // Maps a timer at base whose counter 0 reads the host's monotonic
+    // clock in 10 ns counts, for code that times itself with readCycles
+void testCycleCounter(u32 base);
+
+    // Calls isr every periodUs of real time, as an interrupt with IE
+    // cleared, until testStopIsr. Returns the number of calls so far
+void testStartIsr(void (*isr)(void), u32 periodUs);
+u64 testStopIsr(void);
+
+    // Level of each interrupt line the models have driven
+int testIrq(u32 line);
+
+    // Drops xil_printf output while set
+void testQuiet(int quiet);
+
+#endif  /* end of protection macro */
@@ -0,0 +1,258 @@
+/*******************************************************************************
+    Bus, MSR and interrupt stand-in for the unit tests, see test.h
+*******************************************************************************/
+
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include "test.h"
+#include "xil_io.h"
+#include "xil_exception.h"
+#include "mb_interface.h"
+#include "xtmrctr_l.h"
+
+SimOptions simOptions;
+pthread_mutex_t simLock = PTHREAD_MUTEX_INITIALIZER;
+
+static SimDevice * devices[SIM_MAX_DEVICES];
+static u32 numDevices;
+static SimTime now;
+static u32 jitterNs;
+static u32 stallNs;
+static unsigned int jitterSeed = 1;
+static u32 irqLevels;
+static u32 checks;
+static u32 failures;
+static int quiet;
+
+static volatile u32 msr = SIM_MSR_IE;
+static void (*isrFunction)(void);
+static volatile u64 isrCalls;
+
+int testCheck(int ok, const char * expr, const char * file, int line) {
+    checks++;
+    if(!ok) {
+        failures++;
+        printf("%s:%d: check failed: %s\n", file, line, expr);
+    }
+    return ok;
+}
+
+int testDone(const char * name) {
+    printf("%s: %u checks, %u failed\n", name, checks, failures);
+    return failures != 0;
+}
+
+void testQuiet(int q) {
+    quiet = q;
+}
+
+void outbyte(char c) {
+    if(!quiet) {
+        putchar(c);
+    }
+}
+
+/****************************** TIME AND DEVICES ******************************/
+
+SimTime simNow(void) {
+    return now;
+}
+
+void testAdvance(SimTime ns) {
+    now += ns;
+}
+
+void testBusJitter(u32 maxNs, u32 stall) {
+    jitterNs = maxNs;
+    stallNs = stall;
+}
+
+static void accessTime(void) {
+    now += TEST_NS_PER_ACCESS;
+    if(jitterNs != 0) {
+        u32 r = rand_r(&jitterSeed);
+        now += r % jitterNs;
+        if((r >> 16) % 64 == 0) {
+            now += stallNs;
+        }
+    }
+}
+
+static u32 readCounter(SimDevice * dev, u32 offset) {
+    struct timespec ts;
+    if(offset != XTC_TCR_OFFSET) {
+        return 0;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u32)(((u64)ts.tv_sec * SIM_NS_PER_SEC + ts.tv_nsec) / SIM_NS_PER_CYCLE);
+}
+
+static SimDevice counterDevice = {
+    .name = "cycles",
+    .size = 0x10000,
+    .read = readCounter,
+};
+
+void testCycleCounter(u32 base) {
+    counterDevice.base = base;
+    simRegister(&counterDevice);
+}
+
+void simRegister(SimDevice * dev) {
+    if(numDevices >= SIM_MAX_DEVICES) {
+        fprintf(stderr, "test: too many devices\n");
+        exit(1);
+    }
+    devices[numDevices++] = dev;
+}
+
+void simKick(void) {
+}
+
+void simSetIrq(u32 line, int level) {
+    if(level) {
+        irqLevels |= 1U << line;
+    } else {
+        irqLevels &= ~(1U << line);
+    }
+}
+
+void simPulseIrq(u32 line) {
+    (void)line;
+}
+
+void simCpuInterrupt(void) {
+}
+
+int testIrq(u32 line) {
+    return (irqLevels >> line) & 1;
+}
+
+static SimDevice * findDevice(u32 addr) {
+    for(u32 i = 0; i < numDevices; i++) {
+        if(addr - devices[i]->base < devices[i]->size) {
+            return devices[i];
+        }
+    }
+    fprintf(stderr, "test: access to unmapped address 0x%08x\n", addr);
+    exit(1);
+}
+
+static u32 busRead(u32 addr) {
+    SimDevice * dev = findDevice(addr);
+    accessTime();
+    return dev->read != NULL ? dev->read(dev, (addr - dev->base) & ~3U) : 0;
+}
+
+static void busWrite(u32 addr, u32 value) {
+    SimDevice * dev = findDevice(addr);
+    accessTime();
+    if(dev->write != NULL) {
+        dev->write(dev, (addr - dev->base) & ~3U, value);
+    }
+}
+
+u8 Xil_In8(UINTPTR Addr) {
+    return (u8)(busRead((u32)Addr) >> (8 * (Addr & 3)));
+}
+
+u16 Xil_In16(UINTPTR Addr) {
+    return (u16)(busRead((u32)Addr) >> (8 * (Addr & 2)));
+}
+
+u32 Xil_In32(UINTPTR Addr) {
+    return busRead((u32)Addr);
+}
+
+void Xil_Out8(UINTPTR Addr, u8 Value) {
+    busWrite((u32)Addr, Value);
+}
+
+void Xil_Out16(UINTPTR Addr, u16 Value) {
+    busWrite((u32)Addr, Value);
+}
+
+void Xil_Out32(UINTPTR Addr, u32 Value) {
+    busWrite((u32)Addr, Value);
+}
+
+/****************************** MSR AND INTERRUPTS ****************************/
+
+static void maskAlarm(int masked) {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGALRM);
+    sigprocmask(masked ? SIG_BLOCK : SIG_UNBLOCK, &set, NULL);
+}
+
+u32 simMfmsr(void) {
+    return msr;
+}
+
+void simMtmsr(u32 value) {
+    msr = value;
+    maskAlarm(!(value & SIM_MSR_IE));
+}
+
+void microblaze_enable_interrupts(void) {
+    simMtmsr(msr | SIM_MSR_IE);
+}
+
+void microblaze_disable_interrupts(void) {
+    simMtmsr(msr & ~SIM_MSR_IE);
+}
+
+void Xil_ExceptionInit(void) {
+}
+
+void Xil_ExceptionRegisterHandler(u32 Id, Xil_ExceptionHandler Handler, void * Data) {
+}
+
+void Xil_ExceptionRemoveHandler(u32 Id) {
+}
+
+void Xil_ExceptionEnable(void) {
+    microblaze_enable_interrupts();
+}
+
+void Xil_ExceptionDisable(void) {
+    microblaze_disable_interrupts();
+}
+
+    // The kernel blocks SIGALRM for the length of the handler and puts
+    // the mask back on return, as clearing IE and rtid do
+static void alarmSignal(int sig) {
+    u32 saved = msr;
+    (void)sig;
+    msr = saved & ~SIM_MSR_IE;
+    isrFunction();
+    isrCalls++;
+    msr = saved;
+}
+
+void testStartIsr(void (*isr)(void), u32 periodUs) {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = alarmSignal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGALRM, &action, NULL);
+    isrFunction = isr;
+    isrCalls = 0;
+
+    struct itimerval timer = {
+        { periodUs / 1000000, periodUs % 1000000 },
+        { periodUs / 1000000, periodUs % 1000000 },
+    };
+    setitimer(ITIMER_REAL, &timer, NULL);
+}
+
+u64 testStopIsr(void) {
+    struct itimerval timer;
+    memset(&timer, 0, sizeof(timer));
+    setitimer(ITIMER_REAL, &timer, NULL);
+    signal(SIGALRM, SIG_IGN);
+    return isrCalls;
+}
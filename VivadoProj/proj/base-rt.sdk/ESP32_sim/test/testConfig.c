@@ -0,0 +1,253 @@
+/*******************************************************************************
+    configStore.c: the record ring on the flash model
+
+    The store runs through spiFlash.c on the SPI and flash models, as on
+    the board. A reboot is initConfigStore again, which reads back only
+    what is in flash.
+
+    Saves go twice round the ring of CONFIG_NUM_SLOTS pages. Each record
+    must land in the slot after the last one, and each sector must be
+    erased once per pass, just before its first slot is written. No other
+    sector of the flash may be erased. A reboot must load the newest
+    record with its settings and erase count.
+
+    A save torn part way through its page, or a newest record with a bit
+    cleared, must leave the record before it in force at the next boot.
+    The save after that must be the one loaded at the boot after. This is
+    repeated all round the ring, so the damaged record also lands last in
+    a sector. The sequence is started a few saves short of 2^32: the
+    records after it wraps must still be taken as the newest.
+*******************************************************************************/
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test.h"
+#include "xparameters.h"
+#include "configStore.h"
+#include "command.h"
+#include "crc.h"
+#include "sysTimer.h"
+
+#define FLASH_SECTORS           (FLASH_SIZE / FLASH_SECTOR_SIZE)
+#define STORE_SECTOR            (CONFIG_BASE / FLASH_SECTOR_SIZE)
+#define RING_SAVES              (2 * CONFIG_NUM_SLOTS + 10)
+#define DAMAGE_ROUNDS           (CONFIG_NUM_SLOTS / 2 + 20)
+#define WRAP_START              0xFFFFFFF8U
+#define WRAP_SAVES              20
+
+    // configStore.c's record, to plant records in flash
+typedef struct {
+    u32 magic;
+    u32 sequence;
+    u32 erases;
+    BoardConfig config;
+    u32 crc;
+} Record;
+
+static XSpi spi;
+static u32 baseErases[FLASH_SECTORS];
+
+    // Stand-ins for command.c and sysTimer.c
+int addCommand(const char * name, CommandHandler handler) {
+    return XST_SUCCESS;
+}
+
+u32 getTickCount(void) {
+    return simNow() / (SIM_NS_PER_SEC / TICK_HZ);
+}
+
+static void reboot(void) {
+    testQuiet(1);
+    initConfigStore();
+    testQuiet(0);
+}
+
+    // Settings that differ from save to save
+static void configFor(u32 n, BoardConfig * c) {
+    memset(c, 0, sizeof(*c));
+    snprintf(c->ssid, sizeof(c->ssid), "net%u", n);
+    snprintf(c->pwd, sizeof(c->pwd), "key%u", n * 7);
+    snprintf(c->host, sizeof(c->host), "10.0.%u.%u", (n >> 8) & 0xFF, n & 0xFF);
+    c->port = 1000 + n % 60000;
+    c->keepAlive = n % 7200;
+}
+
+static int isConfig(u32 n) {
+    BoardConfig expect;
+    BoardConfig c;
+    configFor(n, &expect);
+    getConfig(&c);
+    return isConfigStored() && memcmp(&c, &expect, sizeof(c)) == 0;
+}
+
+static u8 * slotMemory(u32 slot) {
+    return simFlashMemory() + CONFIG_BASE + slot * CONFIG_SLOT_SIZE;
+}
+
+static u32 erasesSince(u32 sector) {
+    return simFlashErases(sector) - baseErases[sector];
+}
+
+static void testRing(void) {
+    ConfigStoreStats stats;
+    BoardConfig c;
+    u32 bad = 0;
+    u32 badBoots = 0;
+
+    reboot();
+    CHECK(!isConfigStored());
+    getConfigStoreStats(&stats);
+    CHECK(stats.sequence == 0 && stats.erases == 0);
+
+    for(u32 n = 1; n <= RING_SAVES; n++) {
+        configFor(n, &c);
+        int status = saveConfig(&c);
+        getConfigStoreStats(&stats);
+        u32 slot = (n - 1) % CONFIG_NUM_SLOTS;
+        if(status != XST_SUCCESS || stats.sequence != n || stats.slot != slot ||
+                stats.erases != (n - 1) / CONFIG_SLOTS_PER_SECTOR + 1 || !isConfig(n)) {
+            printf("save %u: status %d, record %u in slot %u, %u erases\n",
+                n, status, stats.sequence, stats.slot, stats.erases);
+            bad++;
+        }
+        if(n % 97 == 0 || n == RING_SAVES) {
+            ConfigStoreStats before = stats;
+            reboot();
+            getConfigStoreStats(&stats);
+            badBoots += stats.sequence != before.sequence || stats.slot != before.slot ||
+                stats.erases != before.erases || !isConfig(n);
+        }
+    }
+    CHECK(bad == 0);
+    CHECK(badBoots == 0);
+
+        // The record as this test lays it out
+    const Record * r = (const Record *)slotMemory(stats.slot);
+    CHECK(r->magic == CONFIG_MAGIC && r->sequence == RING_SAVES &&
+        r->crc == crc32(r, offsetof(Record, crc)));
+
+        // Sector 0 at saves 1, 513 and 1025, sector 1 at 257 and 769
+    u32 expect[CONFIG_NUM_SECTORS] = {0};
+    for(u32 n = 1; n <= RING_SAVES; n++) {
+        u32 slot = (n - 1) % CONFIG_NUM_SLOTS;
+        if(slot % CONFIG_SLOTS_PER_SECTOR == 0) {
+            expect[slot / CONFIG_SLOTS_PER_SECTOR]++;
+        }
+    }
+    u32 total = 0;
+    for(u32 s = 0; s < FLASH_SECTORS; s++) {
+        total += erasesSince(s);
+    }
+    for(u32 s = 0; s < CONFIG_NUM_SECTORS; s++) {
+        CHECK(erasesSince(STORE_SECTOR + s) == expect[s]);
+    }
+    CHECK(total == stats.erases);
+    printf("ring: %u saves, %u erases (sector 0 %u, sector 1 %u)\n",
+        RING_SAVES, total, erasesSince(STORE_SECTOR), erasesSince(STORE_SECTOR + 1));
+}
+
+    // A program cut short leaves the rest of its page erased
+static void tear(u32 slot, unsigned int * seed) {
+    u32 at = 8 + rand_r(seed) % (sizeof(Record) - 8);
+    memset(slotMemory(slot) + at, 0xFF, CONFIG_SLOT_SIZE - at);
+}
+
+    // A bit lost past the header
+static void corrupt(u32 slot, unsigned int * seed) {
+    u8 * page = slotMemory(slot);
+    u32 at;
+    do {
+        at = 8 + rand_r(seed) % (sizeof(Record) - 8);
+    } while(page[at] == 0);
+    page[at] &= ~(1U << (31 - __builtin_clz(page[at])));
+}
+
+static void testDamaged(void (*damage)(u32, unsigned int *), const char * name) {
+    ConfigStoreStats stats;
+    BoardConfig c;
+    unsigned int seed = 46;
+    u32 badFallbacks = 0;
+    u32 badSaves = 0;
+    u32 n = 1;
+
+    CHECK(clearConfig() == XST_SUCCESS);
+    configFor(n, &c);
+    CHECK(saveConfig(&c) == XST_SUCCESS);
+
+    for(u32 round = 0; round < DAMAGE_ROUNDS; round++) {
+        getConfigStoreStats(&stats);
+        u32 good = stats.sequence;
+        u32 goodN = n;
+
+        configFor(++n, &c);
+        CHECK(saveConfig(&c) == XST_SUCCESS);
+        getConfigStoreStats(&stats);
+        damage(stats.slot, &seed);
+        reboot();
+        getConfigStoreStats(&stats);
+        badFallbacks += stats.sequence != good || !isConfig(goodN);
+
+        configFor(++n, &c);
+        int status = saveConfig(&c);
+        reboot();
+        getConfigStoreStats(&stats);
+        badSaves += status != XST_SUCCESS || !isConfig(n);
+    }
+    CHECK(badFallbacks == 0);
+    CHECK(badSaves == 0);
+    printf("%s: %u damaged records, %u erases\n", name, DAMAGE_ROUNDS, stats.erases);
+}
+
+static void plant(u32 slot, u32 sequence, u32 n) {
+    Record r;
+    memset(&r, 0, sizeof(r));
+    r.magic = CONFIG_MAGIC;
+    r.sequence = sequence;
+    configFor(n, &r.config);
+    r.crc = crc32(&r, offsetof(Record, crc));
+    memset(slotMemory(slot), 0xFF, CONFIG_SLOT_SIZE);
+    memcpy(slotMemory(slot), &r, sizeof(r));
+}
+
+static void testSequenceWrap(void) {
+    ConfigStoreStats stats;
+    BoardConfig c;
+    u32 bad = 0;
+
+    CHECK(clearConfig() == XST_SUCCESS);
+    plant(0, WRAP_START, 0);
+    reboot();
+    getConfigStoreStats(&stats);
+    CHECK(stats.sequence == WRAP_START && isConfig(0));
+
+    u32 sequence = WRAP_START;
+    for(u32 n = 1; n <= WRAP_SAVES; n++) {
+        sequence = (sequence + 1 == 0) ? 1 : sequence + 1;
+        configFor(n, &c);
+        int status = saveConfig(&c);
+        reboot();
+        getConfigStoreStats(&stats);
+        if(status != XST_SUCCESS || stats.sequence != sequence || stats.slot != n || !isConfig(n)) {
+            printf("wrap save %u: record %u in slot %u, expected %u\n",
+                n, stats.sequence, stats.slot, sequence);
+            bad++;
+        }
+    }
+    CHECK(bad == 0);
+    printf("sequence wrap: %x to %u\n", WRAP_START, sequence);
+}
+
+int main(void) {
+    simInitSpi();
+    CHECK(initSpiFlash(&spi) == XST_SUCCESS);
+    for(u32 s = 0; s < FLASH_SECTORS; s++) {
+        baseErases[s] = simFlashErases(s);
+    }
+
+    testRing();
+    testDamaged(tear, "torn saves");
+    testDamaged(corrupt, "bad CRCs");
+    testSequenceWrap();
+    return testDone("testConfig");
+}
@@ -0,0 +1,152 @@
+/*******************************************************************************
+    decimate.c: cicDecimate and firDecimate against reference vectors
+
+    decimateRef.h holds the CIC and FIR outputs for rateShift 2 to 6,
+    computed by decimateRef.py as direct convolutions over the same input.
+    The kernels must match them exactly: both are integer arithmetic with
+    the same rounding, so any difference is a bug, not a tolerance.
+
+    Each rate is run in one call per filter, then again in blocks of
+    random size, from empty to a few times the rate, and in the firmware's
+    raw block size. The state carried between calls must make the output
+    independent of where the blocks split. The input steps to and from
+    full scale, which rings past both ends of the range in the FIR: the
+    reference has outputs clamped at 0 and 0xFFFF for every rate, and
+    the kernel must clamp them the same way.
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "test.h"
+#include "decimate.h"
+#include "auxAcq.h"
+#include "decimateRef.h"
+
+#define NUM_RATES               (sizeof(decimateRef) / sizeof(decimateRef[0]))
+#define SPLIT_RUNS              20
+
+static u16 input[DECIMATE_REF_SAMPLES];
+static s32 cicOut[DECIMATE_REF_SAMPLES];
+static u16 firOut[DECIMATE_REF_SAMPLES];
+
+    // decimateRef.py's input generator
+static s32 triangle(u32 n, u32 period, s32 amplitude) {
+    s32 u = 4 * amplitude * (s32)(n % period) / (s32)period;
+    s32 v = u <= 2 * amplitude ? u : 4 * amplitude - u;
+    return v - amplitude;
+}
+
+static void makeInput(void) {
+    u32 seed = 1;
+    u32 sum = 0;
+    for(u32 n = 0; n < DECIMATE_REF_SAMPLES; n++) {
+        s32 code;
+        seed = (seed * 1103515245U + 12345U) & 0x7FFFFFFF;
+        if(n < 2048) {
+            code = 2048 + triangle(n, 37, 600) + triangle(n, 500, 900) +
+                (s32)((seed >> 16) % 201) - 100;
+        } else if(n >= 4096 && n < 6144) {
+            code = 0xFFF;
+        } else {
+            code = 0;
+        }
+        input[n] = (u16)(code << 4);
+        sum += input[n] * (n + 1);
+    }
+    CHECK(sum == DECIMATE_REF_CHECKSUM);
+}
+
+    // Block sizes for a split run: random ones, or all of size fixed
+static u32 blockSize(unsigned int * seed, u32 rate, u32 fixed) {
+    return fixed ? fixed : (u32)rand_r(seed) % (3 * rate + 2);
+}
+
+    // Runs both filters over the input in blocks; returns 1 if the
+    // outputs match the reference
+static int runSplit(u32 r, unsigned int * seed, u32 fixed) {
+    CicState cic;
+    FirState fir;
+    u32 rate = 1U << decimateRef[r].rateShift;
+    u32 cicCount = 0;
+    u32 firCount = 0;
+
+    cicInit(&cic, decimateRef[r].rateShift);
+    for(u32 n = 0; n < DECIMATE_REF_SAMPLES;) {
+        u32 size = blockSize(seed, rate, fixed);
+        if(size > DECIMATE_REF_SAMPLES - n) {
+            size = DECIMATE_REF_SAMPLES - n;
+        }
+        cicCount += cicDecimate(&cic, input + n, size, cicOut + cicCount);
+        n += size;
+    }
+
+    firInit(&fir);
+    for(u32 n = 0; n < cicCount;) {
+        u32 size = blockSize(seed, FIR_DECIMATION, fixed > rate ? fixed / rate : fixed);
+        if(size > cicCount - n) {
+            size = cicCount - n;
+        }
+        firCount += firDecimate(&fir, cicOut + n, size, firOut + firCount);
+        n += size;
+    }
+
+    return cicCount == decimateRef[r].cicCount && firCount == decimateRef[r].firCount &&
+        memcmp(cicOut, decimateRef[r].cic, cicCount * sizeof(s32)) == 0 &&
+        memcmp(firOut, decimateRef[r].fir, firCount * sizeof(u16)) == 0;
+}
+
+static void testRate(u32 r) {
+    CicState cic;
+    FirState fir;
+    unsigned int seed = 38 + r;
+
+        // One call each
+    cicInit(&cic, decimateRef[r].rateShift);
+    u32 cicCount = cicDecimate(&cic, input, DECIMATE_REF_SAMPLES, cicOut);
+    CHECK(cicCount == decimateRef[r].cicCount);
+    u32 cicBad = 0;
+    for(u32 i = 0; i < cicCount; i++) {
+        cicBad += cicOut[i] != decimateRef[r].cic[i];
+    }
+    CHECK(cicBad == 0);
+
+    firInit(&fir);
+    u32 firCount = firDecimate(&fir, decimateRef[r].cic, decimateRef[r].cicCount, firOut);
+    CHECK(firCount == decimateRef[r].firCount);
+    u32 firBad = 0;
+    u32 low = 0;
+    u32 high = 0;
+    for(u32 i = 0; i < firCount; i++) {
+        firBad += firOut[i] != decimateRef[r].fir[i];
+        low += firOut[i] == 0;
+        high += firOut[i] == 0xFFFF;
+    }
+    CHECK(firBad == 0);
+        // Clamped outputs sit at the rails, along with any that land
+        // there exactly
+    CHECK(decimateRef[r].clampedLow > 0 && decimateRef[r].clampedHigh > 0);
+    CHECK(low >= decimateRef[r].clampedLow && high >= decimateRef[r].clampedHigh);
+
+        // Split into blocks
+    u32 splitBad = 0;
+    for(u32 run = 0; run < SPLIT_RUNS; run++) {
+        splitBad += !runSplit(r, &seed, 0);
+    }
+    splitBad += !runSplit(r, &seed, AUX_RAW_SAMPLES);
+    splitBad += !runSplit(r, &seed, 1);
+    CHECK(splitBad == 0);
+
+    printf("rateShift %u: %u CIC, %u FIR outputs, %u clamped low, %u high: %s\n",
+        decimateRef[r].rateShift, cicCount, firCount, decimateRef[r].clampedLow,
+        decimateRef[r].clampedHigh, cicBad + firBad + splitBad ? "FAILED" : "ok");
+}
+
+int main(void) {
+    makeInput();
+    for(u32 r = 0; r < NUM_RATES; r++) {
+        testRate(r);
+    }
+    CHECK(decimateRef[0].rateShift == CIC_MIN_RATE_SHIFT);
+    CHECK(decimateRef[NUM_RATES - 1].rateShift == CIC_MAX_RATE_SHIFT);
+    return testDone("testDecimate");
+}
@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+"""Duty cycling of the ESP32 radio against the emulator.
+
+Runs esp32_sim with every FORGET_AP-th wake from deep sleep coming up
+without an access point, and plays the collector itself. On the first
+connection the collector sets the ssid, switches duty cycling on with a
+PERIOD second period and starts the XADC aux stream, whose blocks wait in
+their ring while the radio sleeps. On every later connection, one per
+wake, it sends "duty status".
+
+Wake and rejoin:
+    the board wakes at least MIN_WAKES times with none failing, each wake
+    opens a new connection, the status on the k-th wake says k wakes, and
+    the board has rejoined the access point once for each wake the
+    emulator forgot it on.
+Samples:
+    each wake brings aux blocks, the sequence runs on across connections
+    with none missing or repeated, and the samples in the status on each
+    wake are AUX_BLOCK_SAMPLES for each aux block received before it.
+
+Virtual time runs at TIME_SCALE times real time.
+
+    python3 testDuty.py ./esp32_sim
+"""
+
+import os
+import re
+import select
+import socket
+import subprocess
+import sys
+import threading
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                '..', '..', '..', '..', '..'))
+import server
+
+# auxAcq.h
+AUX_BLOCK_SAMPLES = 256
+
+DURATION = 60
+TIME_SCALE = 1.0
+PERIOD = 8
+FORGET_AP = 2
+MIN_WAKES = 3
+
+DUTY_STATUS = re.compile(rb'OK period (\d+) wakes (\d+) last \d+ ms failed (\d+) rejoins (\d+) '
+                         rb'on \d+ ms off \d+ ms samples (\d+) on/sample (\d+) us')
+ESP_SLEEPS = re.compile(r'esp32: (\d+) deep sleeps, .*, (\d+) woke without an AP')
+
+checks = 0
+failures = 0
+
+
+def check(ok, what):
+    global checks, failures
+    checks += 1
+    if not ok:
+        failures += 1
+        print('testDuty: check failed: %s' % what)
+    return ok
+
+
+def read_output(pipe, lines):
+    for line in pipe:
+        lines.append(line.decode('ascii', 'replace').rstrip())
+
+
+def collect(sim, listener):
+    """Plays the collector until the board's run is over; returns the
+    messages received on each connection, in order"""
+    connections = []
+    framer = None
+    conn = None
+    while sim.poll() is None:
+        sockets = [listener] if conn is None else [listener, conn]
+        readable, _, _ = select.select(sockets, [], [], 0.05)
+        if listener in readable:
+            if conn is not None:
+                conn.close()
+            conn, _ = listener.accept()
+            framer = server.Framer()
+            connections.append([])
+            if len(connections) == 1:
+                commands = [b'config set ssid simnet\n', b'duty on %d\n' % PERIOD,
+                            b'aux start single 0 2\n']
+            else:
+                commands = [b'duty status\n']
+            for command in commands:
+                try:
+                    conn.sendall(command)
+                except OSError:
+                    pass
+        if conn is not None and conn in readable:
+            data = conn.recv(65536)
+            if not data:
+                conn.close()
+                conn = None
+                continue
+            connections[-1].extend(framer.feed(data))
+    if conn is not None:
+        conn.close()
+    return connections
+
+
+def check_connections(connections):
+    # The first connection is the one made at boot; the run may end while
+    # the last wake is still under way
+    wakes = len(connections) - 1
+    if not check(wakes >= MIN_WAKES, '%d wakes' % wakes):
+        return 0
+    aux = []
+    received = 0
+    rejoins = 0
+    for k, messages in enumerate(connections):
+        blocks = [server.AUX_HEADER.unpack_from(m)[1] for kind, m in messages if kind == server.AUX]
+        statuses = [DUTY_STATUS.search(m) for kind, m in messages if kind == server.TEXT]
+        statuses = [s for s in statuses if s]
+        if k > 0 and check(len(statuses) == 1, 'one duty status on wake %d' % k):
+            period, woken, failed, rejoins, samples, on = (int(v) for v in statuses[0].groups())
+            check(period == PERIOD, 'period %d s on wake %d' % (period, k))
+            check(woken == k and failed == 0, '%d wakes, %d failed on wake %d' % (woken, failed, k))
+            check(rejoins == k // FORGET_AP,
+                  '%d rejoins on wake %d, every %dth forgot the AP' % (rejoins, k, FORGET_AP))
+            check(samples == received * AUX_BLOCK_SAMPLES,
+                  '%d samples on wake %d after %d aux blocks' % (samples, k, received))
+            check(on > 0, 'radio on time per sample on wake %d' % k)
+        # The last wake may be cut short before its blocks go out
+        if 0 < k < wakes:
+            check(len(blocks) > 0, 'aux blocks on wake %d' % k)
+        aux.extend(blocks)
+        received += len(blocks)
+
+    if check(len(aux) > 0, 'aux blocks arrived'):
+        expected = list(range(min(aux), max(aux) + 1))
+        missing = sorted(set(expected) - set(aux))
+        check(not missing, 'aux blocks %s arrived' % missing[:8])
+        check(aux == sorted(set(aux)), 'each aux block arrived once, in order')
+    return rejoins
+
+
+def main():
+    sim_path = sys.argv[1] if len(sys.argv) > 1 else './esp32_sim'
+    listener = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    listener.bind(('127.0.0.1', 0))
+    listener.listen(1)
+    port = listener.getsockname()[1]
+
+    sim = subprocess.Popen(
+        [sim_path, '--server', '127.0.0.1:%d' % port, '--duration', str(DURATION),
+         '--time-scale', str(TIME_SCALE), '--forget-ap', str(FORGET_AP)],
+        stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    output = []
+    reader = threading.Thread(target=read_output, args=(sim.stdout, output))
+    reader.start()
+    connections = collect(sim, listener)
+    reader.join()
+    listener.close()
+
+    check(sim.returncode == 0, 'esp32_sim exit status %d' % sim.returncode)
+    rejoins = check_connections(connections)
+    found = [m for m in map(ESP_SLEEPS.search, output) if m]
+    if check(len(found) > 0, 'emulator reports deep sleeps'):
+        sleeps, forgets = int(found[-1].group(1)), int(found[-1].group(2))
+        check(sleeps >= len(connections) - 1, '%d deep sleeps for %d wakes' %
+              (sleeps, len(connections) - 1))
+        check(forgets > 0 and forgets >= rejoins,
+              'emulator forgot the AP %d times, board rejoined %d' % (forgets, rejoins))
+
+    print('testDuty: %d checks, %d failed' % (checks, failures))
+    return failures != 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,237 @@
+#!/usr/bin/env python3
+"""Flow control of the ESP32 link against the finite buffer emulator.
+
+Runs esp32_sim with a small --esp-buffer drained at --wifi-rate and every
+SEGMENT_FAIL-th AT+CIPSENDBUF segment answered SEND FAIL, and plays the
+collector itself. For the congested part of the run the collector
+switches the XADC aux stream on, which fills the send window, and
+sends "stats" every PROBE_INTERVAL seconds, whose replies do not always
+fit what is left of the buffer. After that it sends "sw", whose short
+replies let the gap come back down.
+
+Zero payload loss:
+    every aux block from the first to the last arrives once, the aux
+    stream being switched off early enough to drain; every profile
+    snapshot arrives as BEGIN, its frames, END; every status message
+    arrives whole; and the board drops, loses or times out no send.
+Recovery:
+    the emulator answers some CIPSENDs SEND FAIL, some segments SEND FAIL
+    and some commands "busy p...", and the board keeps sending after
+    each, to the end of the run.
+Gap:
+    between two "Link:" reports with k new SEND FAILs and no new SEND OK
+    the gap must have doubled k times, g -> 2g + ESP32_GAP_STEP_MS up to
+    ESP32_GAP_MAX_MS; with no new SEND FAIL it must not have grown and
+    with no new SEND OK not shrunk. It must have grown under the
+    congestion and be back to 0 by the end.
+
+Virtual time runs at TIME_SCALE times real time; the collector's schedule
+is in virtual seconds.
+
+    python3 testLink.py ./esp32_sim
+"""
+
+import os
+import re
+import select
+import socket
+import subprocess
+import sys
+import threading
+import time
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                '..', '..', '..', '..', '..'))
+import server
+
+# ESP32.h
+ESP32_GAP_STEP_MS = 5
+ESP32_GAP_MAX_MS = 1000
+
+DURATION = 60
+TIME_SCALE = 1.0
+ESP_BUFFER = 2048
+WIFI_RATE = 3000
+SEGMENT_FAIL = 7
+AUX_START = 5
+AUX_STOP = 30
+PROBE_INTERVAL = 0.25
+
+LINK_REPORT = re.compile(r'Link: (\d+) sends, \d+ bytes, (\d+) SEND FAIL, (\d+) busy, '
+                         r'(\d+) timeouts, (\d+) errors, (\d+) dropped, gap (\d+) ms')
+WINDOW_REPORT = re.compile(r'Window: \d+ segments, \d+ sent OK \(\d+ bytes\), (\d+) SEND FAIL, '
+                           r'\d+ resent, \d+ checked, (\d+) lost, (\d+) window full')
+ESP_BUSY = re.compile(r'esp32: \d+ commands, \d+ errors, (\d+) busy replies')
+ESP_SEGMENTS = re.compile(r'esp32: \d+ CIPSENDBUF segments, (\d+) answered SEND FAIL')
+ESP_FAILS = re.compile(r'esp32: (\d+) SEND FAIL, send buffer peak')
+
+checks = 0
+failures = 0
+
+
+def check(ok, what):
+    global checks, failures
+    checks += 1
+    if not ok:
+        failures += 1
+        print('testLink: check failed: %s' % what)
+    return ok
+
+
+def read_output(pipe, lines):
+    for line in pipe:
+        lines.append(line.decode('ascii', 'replace').rstrip())
+
+
+def collect(sim, listener):
+    """Plays the collector until the board's run is over; returns the
+    messages received, in order"""
+    framer = server.Framer()
+    messages = []
+    conn = None
+    start = time.monotonic()
+    next_probe = 0.0
+    aux_state = 'off'
+    while sim.poll() is None:
+        now = (time.monotonic() - start) * TIME_SCALE
+        sockets = [listener] if conn is None else [listener, conn]
+        readable, _, _ = select.select(sockets, [], [], 0.05)
+        if listener in readable:
+            if conn is not None:
+                conn.close()
+            conn, _ = listener.accept()
+            framer = server.Framer()
+        if conn is not None and conn in readable:
+            data = conn.recv(65536)
+            if not data:
+                conn.close()
+                conn = None
+                continue
+            messages.extend(framer.feed(data))
+        if conn is None:
+            continue
+        commands = []
+        if aux_state == 'off' and now >= AUX_START:
+            commands.append(b'aux start single 0 2\n')
+            aux_state = 'on'
+        elif aux_state == 'on' and now >= AUX_STOP:
+            commands.append(b'aux stop\n')
+            aux_state = 'stopped'
+        if now >= next_probe:
+            commands.append(b'stats\n' if aux_state == 'on' else b'sw\n')
+            next_probe = now + PROBE_INTERVAL
+        for command in commands:
+            try:
+                conn.sendall(command)
+            except OSError:
+                pass
+    if conn is not None:
+        conn.close()
+    return messages
+
+
+def check_payload(messages, reports):
+    aux = []
+    snapshots = {}
+    order_ok = True
+    led = sw = 0
+    for kind, message in messages:
+        if kind == server.AUX:
+            aux.append(server.AUX_HEADER.unpack_from(message)[1])
+        elif kind == server.PROF:
+            _, seq, frame, _, _ = server.PROF_HEADER.unpack_from(message)
+            frames = snapshots.setdefault(seq, [])
+            if frames and frames[-1] == server.PROF_FRAME_END:
+                order_ok = False
+            frames.append(frame)
+        elif kind == server.TEXT:
+            led += message.startswith(b'LED values')
+            sw += message.startswith(b'SW Values')
+
+    check(len(aux) > 0, 'aux blocks arrived')
+    if aux:
+        expected = list(range(min(aux), max(aux) + 1))
+        missing = sorted(set(expected) - set(aux))
+        check(not missing, 'aux blocks %s arrived' % missing[:8])
+        check(len(aux) == len(set(aux)), 'each aux block arrived once')
+    check(len(snapshots) >= 2, 'profile snapshots arrived')
+    check(order_ok, 'no profile frame came after its END')
+    whole = [s for s, f in snapshots.items()
+             if f[0] == server.PROF_FRAME_BEGIN and f[-1] == server.PROF_FRAME_END and
+             f.count(server.PROF_FRAME_BEGIN) == 1 and f.count(server.PROF_FRAME_END) == 1]
+    # The run may end in the middle of the last snapshot
+    check(len(whole) >= len(snapshots) - 1,
+          'profile snapshots whole, %d of %d' % (len(whole), len(snapshots)))
+    # A status message follows each report once the link is up
+    check(led == sw and led >= reports - 3,
+          'status messages whole: %d LED, %d SW lines, %d reports' % (led, sw, reports))
+
+
+def check_link(reports, windows):
+    # One report every two seconds, after some seconds of booting and
+    # joining the access point
+    if not check(len(reports) >= DURATION // 2 - 10, '%d link reports' % len(reports)):
+        return
+    sends, fails, busy, timeouts, errors, dropped, gap = reports[-1]
+    check(fails > 0, 'SEND FAIL answered to TCPsend')
+    check(busy > 0, 'busy answered to the board')
+    check(timeouts == 0 and errors == 0 and dropped == 0,
+          'no send timed out, failed or was dropped: %d, %d, %d' % (timeouts, errors, dropped))
+    check(sends > reports[-2][0], 'sends still going at the end')
+    if check(len(windows) > 0, 'window reports'):
+        segment_fails, lost, full = windows[-1]
+        check(segment_fails > 0, 'segments answered SEND FAIL')
+        check(lost == 0 and full == 0, 'no segment lost or refused: %d, %d' % (lost, full))
+
+    for before, after in zip(reports, reports[1:]):
+        g0, g1 = before[6], after[6]
+        new_sends, new_fails = after[0] - before[0], after[1] - before[1]
+        expect = g0
+        for _ in range(new_fails):
+            expect = min(2 * expect + ESP32_GAP_STEP_MS, ESP32_GAP_MAX_MS)
+        check(g1 <= ESP32_GAP_MAX_MS, 'gap %d ms within ESP32_GAP_MAX_MS' % g1)
+        check(g1 <= expect, 'gap %d ms to %d ms after %d SEND FAIL' % (g0, g1, new_fails))
+        if new_sends == 0:
+            check(g1 == expect, 'gap %d ms doubled %d times to %d ms' % (g0, new_fails, g1))
+        if new_fails == 0:
+            check(g1 <= g0, 'gap %d ms grew to %d ms without a SEND FAIL' % (g0, g1))
+    # One step, then doubled at least once
+    check(max(r[6] for r in reports) >= 3 * ESP32_GAP_STEP_MS, 'gap doubled under congestion')
+    check(gap == 0, 'gap back to 0 ms, not %d ms' % gap)
+
+
+def main():
+    sim_path = sys.argv[1] if len(sys.argv) > 1 else './esp32_sim'
+    listener = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    listener.bind(('127.0.0.1', 0))
+    listener.listen(1)
+    port = listener.getsockname()[1]
+
+    sim = subprocess.Popen(
+        [sim_path, '--server', '127.0.0.1:%d' % port, '--duration', str(DURATION),
+         '--time-scale', str(TIME_SCALE), '--esp-buffer', str(ESP_BUFFER),
+         '--wifi-rate', str(WIFI_RATE), '--segment-fail', str(SEGMENT_FAIL)],
+        stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    output = []
+    reader = threading.Thread(target=read_output, args=(sim.stdout, output))
+    reader.start()
+    messages = collect(sim, listener)
+    reader.join()
+    listener.close()
+
+    check(sim.returncode == 0, 'esp32_sim exit status %d' % sim.returncode)
+    reports = [tuple(int(v) for v in m.groups()) for m in map(LINK_REPORT.search, output) if m]
+    windows = [tuple(int(v) for v in m.groups()) for m in map(WINDOW_REPORT.search, output) if m]
+    check_payload(messages, len(reports))
+    check_link(reports, windows)
+    for pattern, what in ((ESP_FAILS, 'CIPSEND'), (ESP_SEGMENTS, 'segments'),
+                          (ESP_BUSY, 'busy')):
+        found = [m for m in map(pattern.search, output) if m]
+        check(found and int(found[-1].group(1)) > 0, 'emulator reports %s failures' % what)
+
+    print('testLink: %d checks, %d failed' % (checks, failures))
+    return failures != 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,294 @@
+/*******************************************************************************
+    profile_cg.c: mcount against the linear search it replaced
+
+    The mcount from before the arc hash, kept in profile_cg_old.c, is
+    built next to the current one as mcountOld. Both are
+    fed the same synthetic call streams, each into tables of its own, and
+    must leave identical froms and tos tables: same order, links and
+    counts, so gmon.out is unchanged.
+
+    The streams run from a few dozen arcs to thousands of call sites with
+    several callees each, most calls going to a few hot arcs. With the
+    hash arena of 2^PROFILE_CG_HASH_BITS slots, the larger ones fill the
+    arc table, and the largest the from table, past 3/4, so new entries
+    take the old search from there on. One stream runs with the froms/tos
+    limits profExport.c sets, and one past them, where the current mcount
+    drops the arcs that do not fit and the old one, without limits, is
+    given only the calls that did fit. A reset between streams must forget
+    every hashed arc.
+
+    The time per call of both is printed for each stream. These are host
+    figures at the build's optimisation: they show how each scales with
+    the number of arcs, not what a MicroBlaze call costs.
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "test.h"
+#include "profile.h"
+
+#define LOWPC                   0x00010000U
+#define HIGHPC                  0x00110000U
+#define MAX_FROMS               4096
+#define MAX_TOS                 8192
+#define MAX_ARCS                MAX_TOS
+#define MAX_CALLS               400000
+
+    // profExport.h
+#define BOARD_MAX_FROMS         1024
+#define BOARD_MAX_TOS           2048
+
+void mcountOld(u32 frompc, u32 selfpc);
+
+struct gmonparam * _gmonparam = GMONPARAM_UNSET;
+s32 n_gmon_sections = 1;
+
+typedef struct {
+    u32 frompc;
+    u32 selfpc;
+} Call;
+
+typedef struct {
+    const char * name;
+    u32 sites;                  // call sites, froms entries
+    u32 multiEvery;             // 1 in this many sites calls
+    u32 maxCallees;             // up to this many functions
+    u32 callsPerArc;
+    u32 maxFroms;               // profile_cg_max_froms, 0 for none
+    u32 maxTos;
+} Stream;
+
+static const Stream streams[] = {
+    {"small", 40, 4, 2, 200, 0, 0},
+    {"medium", 400, 4, 3, 100, 0, 0},
+    {"board limits", 950, 2, 5, 50, BOARD_MAX_FROMS, BOARD_MAX_TOS},
+    {"arcs past 3/4", 1300, 2, 5, 40, 0, 0},
+    {"froms past 3/4", 3000, 4, 4, 25, 0, 0},
+    {"past the limits", 1800, 2, 4, 40, BOARD_MAX_FROMS, BOARD_MAX_TOS},
+};
+#define NUM_STREAMS             (sizeof(streams) / sizeof(streams[0]))
+
+static Call arcs[MAX_ARCS];
+static Call calls[MAX_CALLS];
+static u16 callArc[MAX_CALLS];
+static Call fitting[MAX_CALLS];
+static struct fromstruct froms[2][MAX_FROMS];
+static struct tostruct tos[2][MAX_TOS];
+static struct gmonparam gmon[2];
+
+    // Distinct word aligned PCs in the section, call sites and function
+    // entries drawn from separate halves
+static u32 randomPc(unsigned int * seed, u32 half) {
+    u32 words = (HIGHPC - LOWPC) / 8;
+    return LOWPC + half * (HIGHPC - LOWPC) / 2 + 4 * ((u32)rand_r(seed) % words);
+}
+
+    // Whether arcs[0..numArcs) has the call site, or the arc if selfpc
+    // is not 0
+static int known(u32 numArcs, u32 frompc, u32 selfpc) {
+    for(u32 i = 0; i < numArcs; i++) {
+        if(arcs[i].frompc == frompc && (selfpc == 0 || arcs[i].selfpc == selfpc)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+    // Fills arcs and calls; returns the number of calls
+static u32 makeStream(const Stream * s, unsigned int * seed, u32 * numArcs) {
+    u32 n = 0;
+    for(u32 site = 0; site < s->sites; site++) {
+        u32 frompc;
+        do {
+            frompc = randomPc(seed, 0);
+        } while(known(n, frompc, 0));
+        u32 callees = rand_r(seed) % s->multiEvery == 0 ? 1 + rand_r(seed) % s->maxCallees : 1;
+        for(u32 c = 0; c < callees && n < MAX_ARCS; c++) {
+            u32 selfpc;
+            do {
+                selfpc = randomPc(seed, 1);
+            } while(known(n, frompc, selfpc));
+            arcs[n].frompc = frompc;
+            arcs[n].selfpc = selfpc;
+            n++;
+        }
+    }
+
+        // Shuffled, so call sites are first seen in no particular order
+    for(u32 i = n - 1; i > 0; i--) {
+        u32 j = rand_r(seed) % (i + 1);
+        Call t = arcs[i];
+        arcs[i] = arcs[j];
+        arcs[j] = t;
+    }
+
+        // Every arc once, in that order, then mostly the hot tenth
+    u32 count = n * s->callsPerArc;
+    if(count > MAX_CALLS) {
+        count = MAX_CALLS;
+    }
+    for(u32 k = 0; k < count; k++) {
+        u32 a;
+        if(k < n) {
+            a = k;
+        } else if(rand_r(seed) % 4 == 0) {
+            a = rand_r(seed) % n;
+        } else {
+            a = rand_r(seed) % (n / 10 + 1);
+        }
+        calls[k] = arcs[a];
+        callArc[k] = a;
+    }
+    *numArcs = n;
+    return count;
+}
+
+    // The calls whose arcs the current mcount records under the limits.
+    // Arcs are first seen in the order of arcs[], and one fits if there
+    // is room in tos then and its call site is known or there is room in
+    // froms
+static u32 fittingCalls(const Stream * s, u32 numArcs, u32 count) {
+    static u8 fits[MAX_ARCS];
+    u32 numFroms = 0;
+    u32 numTos = 0;
+    for(u32 a = 0; a < numArcs; a++) {
+        int fromKnown = 0;
+        for(u32 b = 0; b < a && !fromKnown; b++) {
+            fromKnown = fits[b] && arcs[b].frompc == arcs[a].frompc;
+        }
+        fits[a] = numTos < s->maxTos && (fromKnown || numFroms < s->maxFroms);
+        numTos += fits[a];
+        numFroms += fits[a] && !fromKnown;
+    }
+    u32 kept = 0;
+    for(u32 k = 0; k < count; k++) {
+        if(fits[callArc[k]]) {
+            fitting[kept++] = calls[k];
+        }
+    }
+    return kept;
+}
+
+static void resetTables(u32 b) {
+    memset(froms[b], 0, sizeof(froms[b]));
+    memset(tos[b], 0, sizeof(tos[b]));
+    memset(&gmon[b], 0, sizeof(gmon[b]));
+    gmon[b].state = GMON_PROF_ON;
+    gmon[b].froms = froms[b];
+    gmon[b].tos = &tos[b][MAX_TOS];
+    gmon[b].lowpc = LOWPC;
+    gmon[b].highpc = HIGHPC;
+    gmon[b].textsize = HIGHPC - LOWPC;
+}
+
+    // Returns nanoseconds per call
+static double runCalls(void (*fn)(u32, u32), u32 b, const Call * c, u32 count) {
+    struct timespec t0, t1;
+    _gmonparam = &gmon[b];
+    n_gmon_sections = 1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for(u32 k = 0; k < count; k++) {
+        fn(c[k].frompc, c[k].selfpc);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+    return count ? ns / count : 0;
+}
+
+static int sameTables(void) {
+    const struct gmonparam * a = &gmon[0];
+    const struct gmonparam * b = &gmon[1];
+    if(a->fromssize != b->fromssize || a->tossize != b->tossize) {
+        return 0;
+    }
+    for(u32 i = 0; i < a->fromssize; i++) {
+        if(a->froms[i].frompc != b->froms[i].frompc || a->froms[i].link != b->froms[i].link) {
+            return 0;
+        }
+    }
+    for(u32 i = 0; i < a->tossize; i++) {
+        if(a->tos[i].selfpc != b->tos[i].selfpc || a->tos[i].count != b->tos[i].count ||
+            a->tos[i].link != b->tos[i].link) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void testStream(const Stream * s, unsigned int * seed) {
+    u32 numArcs;
+    u32 count = makeStream(s, seed, &numArcs);
+    const Call * oldCalls = calls;
+    u32 oldCount = count;
+    if(s->maxTos != 0) {
+        oldCount = fittingCalls(s, numArcs, count);
+        oldCalls = fitting;
+    }
+
+    profile_cg_max_froms = s->maxFroms;
+    profile_cg_max_tos = s->maxTos;
+    resetTables(0);
+    resetTables(1);
+    profile_cg_reset();
+    u32 overflows = profile_cg_overflows;
+    u32 collisions = profile_cg_collisions;
+    double newNs = runCalls(mcount, 0, calls, count);
+    overflows = profile_cg_overflows - overflows;
+    collisions = profile_cg_collisions - collisions;
+    double oldNs = runCalls(mcountOld, 1, oldCalls, oldCount);
+
+    CHECK(sameTables());
+    if(s->maxTos != 0) {
+        CHECK(gmon[0].fromssize <= s->maxFroms && gmon[0].tossize <= s->maxTos);
+        CHECK(overflows >= count - oldCount);
+    }
+        // Past 3/4 of the arena, arcs are no longer hashed
+    if(gmon[0].tossize > PROFILE_CG_HASH_SIZE / 4 * 3) {
+        CHECK(overflows > 0);
+    }
+    printf("%-16s %5u froms %5u arcs %7u calls: old %7.1f ns/call, new %5.1f ns/call, "
+        "%u overflows, %.2f extra probes/call\n",
+        s->name, gmon[0].fromssize, gmon[0].tossize, count, oldNs, newNs, overflows,
+        (double)collisions / count);
+}
+
+    // Calls from outside every section are not recorded
+static void testOutside(void) {
+    resetTables(0);
+    profile_cg_reset();
+    _gmonparam = &gmon[0];
+    mcount(LOWPC - 4, LOWPC + 0x100);
+    mcount(HIGHPC, LOWPC + 0x100);
+    CHECK(gmon[0].fromssize == 0 && gmon[0].tossize == 0);
+}
+
+    // After a reset into emptied tables, as profExport.c does at each
+    // snapshot, nothing from before may be found in the hash
+static void testReset(unsigned int * seed) {
+    u32 numArcs;
+    u32 count = makeStream(&streams[1], seed, &numArcs);
+    profile_cg_max_froms = 0;
+    profile_cg_max_tos = 0;
+    resetTables(0);
+    profile_cg_reset();
+    runCalls(mcount, 0, calls, count);
+
+    resetTables(0);
+    resetTables(1);
+    profile_cg_reset();
+    runCalls(mcount, 0, calls, count);
+    runCalls(mcountOld, 1, calls, count);
+    CHECK(sameTables());
+}
+
+int main(void) {
+    unsigned int seed = 39;
+    profile_cg_pause_timer = 0;
+    testOutside();
+    for(u32 i = 0; i < NUM_STREAMS; i++) {
+        testStream(&streams[i], &seed);
+    }
+    testReset(&seed);
+    return testDone("testMcount");
+}
@@ -0,0 +1,225 @@
+/*******************************************************************************
+    xil_testmem.c: Xil_TestMemFast32 against Xil_TestMem32 over a RAM buffer
+
+    Clean buffer: both pass every subtest they share, and the subtests that
+    write the same pattern leave the same contents behind. The pass layout,
+    progress calls and D-cache calls of the fast test are checked with and
+    without XIL_TESTMEM_FAST_NOCACHE.
+
+    Single bit faults: a bit is flipped from the progress callback at the
+    end of every pass that writes, at the first word, the first word of
+    the second chunk and the last word. The fast test must fail and
+    report that word, that bit and the subtest of that pass.
+
+    Address faults: one page of the buffer is mapped a second time over a
+    later page, as a stuck address line would alias them. Both tests are
+    run on it and must agree on which subtests can see it.
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "test.h"
+#include "xil_testmem.h"
+
+    // Three chunks, the last a partial one that does not end on a line
+#define TEST_WORDS              (2 * XIL_TESTMEM_FAST_CHUNK + XIL_TESTMEM_FAST_CHUNK / 2 + 3)
+#define CHUNKS                  3
+#define FAST_PASSES             16
+#define WRITE_PASSES            9
+
+#define ALIAS_PAGES             64
+#define ALIAS_FROM              8
+#define ALIAS_TO                40
+
+#define NO_PASS                 0xFFFFFFFF
+
+static u32 * buf;
+static u32 words;
+
+static u32 progressCalls;
+static u32 passes;
+static u8 passSubtest[FAST_PASSES];
+static u32 lastDone;
+static int progressOk;
+static u32 injectPass;
+static u32 injectWord;
+static u32 injectBit;
+
+static u32 flushes;
+static u32 disables;
+static u32 enables;
+
+/****************************** BSP STUBS *************************************/
+
+void microblaze_flush_dcache(void) {
+    flushes++;
+}
+
+void microblaze_flush_cache_ext(void) {
+}
+
+void microblaze_invalidate_dcache(void) {
+}
+
+void microblaze_enable_dcache(void) {
+    enables++;
+}
+
+void microblaze_disable_dcache(void) {
+}
+
+void Xil_DCacheDisable(void) {
+    disables++;
+}
+
+/****************************** HELPERS ***************************************/
+
+static void progress(u8 subtest, u32 pass, u32 done, u32 total) {
+    progressCalls++;
+    if(pass < FAST_PASSES) {
+        passSubtest[pass] = subtest;
+    }
+    if(pass + 1 > passes) {
+        passes = pass + 1;
+        lastDone = 0;
+    }
+    if(total != words || done <= lastDone || done > total) {
+        progressOk = 0;
+    }
+    lastDone = done;
+    if(pass == injectPass && done == total) {
+        buf[injectWord] ^= 1U << injectBit;
+    }
+}
+
+static s32 runFast(u8 subtest, u32 options, XTestMemFault * fault) {
+    progressCalls = 0;
+    passes = 0;
+    lastDone = 0;
+    progressOk = 1;
+    flushes = 0;
+    disables = 0;
+    enables = 0;
+    return Xil_TestMemFast32(buf, words, 0, subtest, options, progress, fault);
+}
+
+/****************************** TESTS *****************************************/
+
+static void testClean(void) {
+    static u32 copy[TEST_WORDS];
+    XTestMemFault fault;
+    buf = malloc(TEST_WORDS * sizeof(u32));
+    words = TEST_WORDS;
+    injectPass = NO_PASS;
+
+    for(u8 subtest = 1; subtest <= XIL_TESTMEM_MAXTEST; subtest++) {
+        CHECK(runFast(subtest, 0, &fault) == 0);
+        CHECK(progressOk);
+        memcpy(copy, buf, sizeof(copy));
+        CHECK(Xil_TestMem32(buf, words, 0, subtest) == 0);
+            // Walking ones and zeros cover the whole region in the fast
+            // test and the first 32 words in the other
+        if(subtest != XIL_TESTMEM_WALKONES && subtest != XIL_TESTMEM_WALKZEROS) {
+            CHECK(memcmp(copy, buf, sizeof(copy)) == 0);
+        }
+    }
+    CHECK(Xil_TestMem32(buf, words, 0, XIL_TESTMEM_ALLMEMTESTS) == 0);
+    CHECK(runFast(XIL_TESTMEM_ADDRINADDR, 0, &fault) == 0);
+    CHECK(runFast(XIL_TESTMEM_MOVINV, 0, &fault) == 0);
+    CHECK(passes == 4);
+
+    CHECK(runFast(XIL_TESTMEM_ALLMEMTESTS, 0, &fault) == 0);
+    CHECK(progressOk);
+    CHECK(passes == FAST_PASSES);
+    CHECK(progressCalls == FAST_PASSES * CHUNKS);
+    CHECK(flushes == WRITE_PASSES);
+    CHECK(disables == 0 && enables == 0);
+
+    CHECK(runFast(XIL_TESTMEM_ALLMEMTESTS, XIL_TESTMEM_FAST_NOCACHE, &fault) == 0);
+    CHECK(flushes == 0);
+    CHECK(disables == 1 && enables == 1);
+}
+
+static void testBitFaults(void) {
+    const u32 at[] = {0, XIL_TESTMEM_FAST_CHUNK, TEST_WORDS - 1};
+    u8 subtests[FAST_PASSES];
+    XTestMemFault fault;
+    u32 writePasses = 0;
+
+    runFast(XIL_TESTMEM_ALLMEMTESTS, 0, &fault);
+    memcpy(subtests, passSubtest, sizeof(subtests));
+
+        // Every pass but the last of its subtest writes
+    for(u32 pass = 0; pass + 1 < FAST_PASSES; pass++) {
+        if(subtests[pass + 1] != subtests[pass]) {
+            continue;
+        }
+        writePasses++;
+        for(u32 i = 0; i < sizeof(at) / sizeof(at[0]); i++) {
+            injectPass = pass;
+            injectWord = at[i];
+            injectBit = (pass * 7 + i * 11) % 32;
+            memset(&fault, 0, sizeof(fault));
+            CHECK(runFast(XIL_TESTMEM_ALLMEMTESTS, 0, &fault) != 0);
+            CHECK(fault.Addr == &buf[injectWord]);
+            CHECK((fault.Actual ^ fault.Expected) == 1U << injectBit);
+            CHECK(fault.Subtest == subtests[pass]);
+        }
+    }
+    CHECK(writePasses == WRITE_PASSES);
+    injectPass = NO_PASS;
+    free(buf);
+}
+
+static void testAddressFault(void) {
+    u32 page = sysconf(_SC_PAGESIZE);
+    u32 pageWords = page / sizeof(u32);
+    int fd = memfd_create("testMem", 0);
+    CHECK(fd >= 0 && ftruncate(fd, ALIAS_PAGES * page) == 0);
+    u8 * region = mmap(NULL, ALIAS_PAGES * page, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    CHECK(region != MAP_FAILED);
+    CHECK(mmap(region + ALIAS_TO * page, page, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_FIXED, fd, ALIAS_FROM * page) != MAP_FAILED);
+    buf = (u32 *)region;
+    words = ALIAS_PAGES * pageWords;
+
+        // The alias holds the later page's pattern; walking bits and the
+        // fixed pattern repeat within a page, so neither test can see it
+    static const struct {
+        u8 subtest;
+        int seen;
+    } cases[] = {
+        {XIL_TESTMEM_INCREMENT, 1},
+        {XIL_TESTMEM_WALKONES, 0},
+        {XIL_TESTMEM_WALKZEROS, 0},
+        {XIL_TESTMEM_INVERSEADDR, 1},
+        {XIL_TESTMEM_FIXEDPATTERN, 0},
+    };
+    XTestMemFault fault;
+    for(u32 i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        int fast = runFast(cases[i].subtest, 0, &fault) != 0;
+        int slow = Xil_TestMem32(buf, words, 0, cases[i].subtest) != 0;
+        CHECK(fast == cases[i].seen);
+        CHECK(slow == cases[i].seen);
+        if(fast) {
+            CHECK(fault.Addr == &buf[ALIAS_FROM * pageWords]);
+        }
+    }
+    CHECK(runFast(XIL_TESTMEM_ADDRINADDR, 0, &fault) != 0);
+    CHECK(fault.Addr == &buf[ALIAS_FROM * pageWords]);
+    CHECK(fault.Actual == (u32)(UINTPTR)&buf[ALIAS_TO * pageWords]);
+    CHECK(runFast(XIL_TESTMEM_ALLMEMTESTS, 0, &fault) != 0);
+    CHECK(Xil_TestMem32(buf, words, 0, XIL_TESTMEM_ALLMEMTESTS) != 0);
+
+    munmap(region, ALIAS_PAGES * page);
+    close(fd);
+}
+
+int main(void) {
+    testClean();
+    testBitFaults();
+    testAddressFault();
+    return testDone("testMemTest");
+}
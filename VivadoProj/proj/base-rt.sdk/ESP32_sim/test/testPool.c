@@ -0,0 +1,265 @@
+/*******************************************************************************
+    pool.c: size classes, fall through, the three poolFree asserts, and a
+    fuzz of poolAlloc/poolFree from the main loop and a timer "ISR" at once
+
+    Every block held is stamped with its owner and a serial number at both
+    ends of the size asked for, and the stamps are checked before it is
+    freed, so a block handed to two owners at once shows up as a failed
+    check rather than as a corrupted free list later on.
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "test.h"
+#include "pool.h"
+#include "xil_assert.h"
+
+#define FUZZ_ITERATIONS         4000000
+#define FUZZ_ISR_PERIOD_US      20
+#define FUZZ_MIN_ISR_CALLS      1000
+#define FUZZ_MAIN_HELD          40
+#define FUZZ_ISR_HELD           16
+#define FUZZ_MAX_SIZE           (POOL_LARGE_SIZE + 64)
+
+typedef struct {
+    u32 * block;
+    u32 size;
+    u32 stamp;
+} Held;
+
+typedef struct {
+    Held held[FUZZ_MAIN_HELD];
+    u32 count;
+    u32 capacity;
+    u32 owner;
+    u32 serial;
+    unsigned int seed;
+    u32 allocs;
+    u32 nulls;
+    u32 badStamps;
+    u32 badNulls;
+} Owner;
+
+static Owner mainOwner;
+static Owner isrOwner;
+static volatile u32 assertCount;
+static volatile s32 assertLine;
+
+static void assertCallback(const char8 * file, s32 line) {
+    assertCount++;
+    assertLine = line;
+}
+
+static u32 classOf(u32 size) {
+    return size <= POOL_SMALL_SIZE ? 0 : size <= POOL_MEDIUM_SIZE ? 1 : 2;
+}
+
+static u32 inUse(u32 classIndex) {
+    PoolStats stats;
+    getPoolStats(classIndex, &stats);
+    return stats.inUse;
+}
+
+/****************************** FUZZ ******************************************/
+
+    // The tail stamp is the last whole or part word asked for, which is
+    // the head word itself for 4 bytes or less
+static void stamp(Held * h) {
+    h->block[(h->size - 1) / 4] = ~h->stamp;
+    h->block[0] = h->stamp;
+}
+
+static int stampIntact(const Held * h) {
+    u32 tail = (h->size - 1) / 4;
+    return h->block[0] == h->stamp && (tail == 0 || h->block[tail] == ~h->stamp);
+}
+
+static void fuzzStep(Owner * o) {
+    u32 r = rand_r(&o->seed);
+    if(o->count < o->capacity && (o->count == 0 || (r & 1))) {
+        u32 size = 1 + (r >> 1) % FUZZ_MAX_SIZE;
+        u32 * block = poolAlloc(size);
+        o->allocs++;
+        if(block == NULL) {
+            o->nulls++;
+            return;
+        }
+        if(size > POOL_LARGE_SIZE) {
+            o->badNulls++;
+        }
+        Held * h = &o->held[o->count++];
+        h->block = block;
+        h->size = size;
+        h->stamp = (o->owner << 24) | (o->serial++ & 0xFFFFFF);
+        stamp(h);
+    } else {
+        u32 i = (r >> 1) % o->count;
+        Held * h = &o->held[i];
+        if(!stampIntact(h)) {
+            o->badStamps++;
+        }
+        poolFree(h->block);
+        *h = o->held[--o->count];
+    }
+}
+
+static void fuzzIsr(void) {
+    fuzzStep(&isrOwner);
+}
+
+static void freeAll(Owner * o) {
+    while(o->count > 0) {
+        Held * h = &o->held[--o->count];
+        if(!stampIntact(h)) {
+            o->badStamps++;
+        }
+        poolFree(h->block);
+    }
+}
+
+static void initOwner(Owner * o, u32 owner, u32 capacity, unsigned int seed) {
+    memset(o, 0, sizeof(*o));
+    o->owner = owner;
+    o->capacity = capacity;
+    o->seed = seed;
+}
+
+static void testFuzz(void) {
+    initPool();
+    initOwner(&mainOwner, 0x4D, FUZZ_MAIN_HELD, 1);
+    initOwner(&isrOwner, 0x49, FUZZ_ISR_HELD, 2);
+    u32 asserts = assertCount;
+
+    testStartIsr(fuzzIsr, FUZZ_ISR_PERIOD_US);
+    for(u32 i = 0; i < FUZZ_ITERATIONS; i++) {
+        fuzzStep(&mainOwner);
+    }
+    u64 isrCalls = testStopIsr();
+    printf("fuzz: %u main and %u ISR allocations, %llu ISR calls\n",
+        mainOwner.allocs, isrOwner.allocs, (unsigned long long)isrCalls);
+
+    CHECK(isrCalls >= FUZZ_MIN_ISR_CALLS);
+    CHECK(mainOwner.nulls > 0);
+    freeAll(&mainOwner);
+    freeAll(&isrOwner);
+    CHECK(mainOwner.badStamps == 0);
+    CHECK(isrOwner.badStamps == 0);
+    CHECK(mainOwner.badNulls == 0);
+    CHECK(isrOwner.badNulls == 0);
+    CHECK(assertCount == asserts);
+    for(u32 i = 0; i < POOL_NUM_CLASSES; i++) {
+        CHECK(inUse(i) == 0);
+    }
+
+        // Every block is on its free list exactly once
+    void * all[POOL_SMALL_COUNT + POOL_MEDIUM_COUNT + POOL_LARGE_COUNT];
+    u32 n = 0;
+    void * block;
+    while((block = poolAlloc(1)) != NULL) {
+        all[n++] = block;
+        if(n == sizeof(all) / sizeof(all[0])) {
+            break;
+        }
+    }
+    CHECK(n == sizeof(all) / sizeof(all[0]));
+    CHECK(poolAlloc(1) == NULL);
+    int distinct = 1;
+    for(u32 i = 0; i < n; i++) {
+        for(u32 j = i + 1; j < n; j++) {
+            distinct &= all[i] != all[j];
+        }
+    }
+    CHECK(distinct);
+    for(u32 i = 0; i < n; i++) {
+        poolFree(all[i]);
+    }
+    CHECK(assertCount == asserts);
+}
+
+/****************************** CLASSES AND ASSERTS ***************************/
+
+static void testClasses(void) {
+    initPool();
+    CHECK(poolAlloc(POOL_LARGE_SIZE + 1) == NULL);
+
+    u8 * small[POOL_SMALL_COUNT];
+    for(u32 i = 0; i < POOL_SMALL_COUNT; i++) {
+        small[i] = poolAlloc(POOL_SMALL_SIZE);
+        CHECK(small[i] != NULL);
+    }
+    CHECK(inUse(0) == POOL_SMALL_COUNT);
+        // Lowest address first
+    CHECK(small[1] - small[0] == POOL_SMALL_SIZE);
+
+        // An exhausted class falls through to the next one; a failure is
+        // counted against the best fit only when no class has a block
+    PoolStats stats;
+    u8 * spill = poolAlloc(1);
+    CHECK(spill != NULL);
+    CHECK(inUse(1) == 1);
+    getPoolStats(0, &stats);
+    CHECK(stats.failures == 0);
+    CHECK(stats.highWater == POOL_SMALL_COUNT);
+
+    poolFree(spill);
+    for(u32 i = 0; i < POOL_SMALL_COUNT; i++) {
+        poolFree(small[i]);
+    }
+    CHECK(inUse(0) == 0 && inUse(1) == 0);
+    CHECK(getPoolStats(POOL_NUM_CLASSES, &stats) == XST_FAILURE);
+
+    poolFree(NULL);
+    CHECK(assertCount == 0);
+}
+
+static void testAsserts(void) {
+    static u32 foreign[16];
+    u32 local;
+    initPool();
+
+        // Double free
+    u8 * a = poolAlloc(10);
+    poolFree(a);
+    poolFree(a);
+    CHECK(assertCount == 1);
+    CHECK(inUse(0) == 0);
+    u8 * b = poolAlloc(10);
+    u8 * c = poolAlloc(10);
+    CHECK(b != c);
+    CHECK(inUse(0) == 2);
+    poolFree(b);
+    poolFree(c);
+
+        // Not the start of a block, in each class
+    for(u32 size = POOL_SMALL_SIZE; size <= POOL_LARGE_SIZE; size *= 4) {
+        u8 * block = poolAlloc(size);
+        u32 before = assertCount;
+        poolFree(block + 4);
+        poolFree(block + size - 1);
+        CHECK(assertCount == before + 2);
+        CHECK(inUse(classOf(size)) == 1);
+        poolFree(block);
+        CHECK(assertCount == before + 2);
+        CHECK(inUse(classOf(size)) == 0);
+    }
+
+        // Outside every class
+    u32 before = assertCount;
+    poolFree(foreign);
+    poolFree(&local);
+    CHECK(assertCount == before + 2);
+    for(u32 i = 0; i < POOL_NUM_CLASSES; i++) {
+        CHECK(inUse(i) == 0);
+    }
+    assertCount = 0;
+}
+
+int main(void) {
+    Xil_AssertWait = 0;
+    Xil_AssertSetCallback(assertCallback);
+
+    testClasses();
+    testAsserts();
+    testFuzz();
+    return testDone("testPool");
+}
@@ -0,0 +1,159 @@
+/*******************************************************************************
+    PWM.c: PWM_Update against the PWM model's register writes
+
+    An update that changes nothing must not write the core at all, in
+    either commit mode. Otherwise it must write the changed duty registers
+    in channel order, then the period if it changed, and nothing else;
+    with PWM_COMMIT_RESTART the writes are bracketed by CTRL 0 and CTRL 1.
+    Random updates of 1, 6 and 16 channel cores are checked write by write
+    against that sequence, and the registers must read back the values
+    asked for.
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "test.h"
+#include "xparameters.h"
+#include "PWM.h"
+
+#define BASE                    XPAR_PWM_0_PWM_AXI_BASEADDR
+#define MAX_WRITES              (PWM_MAX_CHANNELS + 3)
+#define RANDOM_UPDATES          3000
+
+static SimPwmWrite writes[MAX_WRITES + 1];
+
+    // The writes PWM_Update must make to go from the old values to the new
+static u32 expectedWrites(SimPwmWrite * expect, u32 channels, u32 oldPeriod, const u32 * oldDuty,
+    u32 period, const u32 * duty, u32 mode) {
+    u32 n = 0;
+    int changed = period != oldPeriod;
+    for(u32 i = 0; i < channels; i++) {
+        changed |= duty[i] != oldDuty[i];
+    }
+    if(!changed) {
+        return 0;
+    }
+    if(mode == PWM_COMMIT_RESTART) {
+        expect[n++] = (SimPwmWrite){PWM_AXI_CTRL_REG_OFFSET, 0};
+    }
+    for(u32 i = 0; i < channels; i++) {
+        if(duty[i] != oldDuty[i]) {
+            expect[n++] = (SimPwmWrite){PWM_AXI_DUTY_REG_OFFSET + 4 * i, duty[i]};
+        }
+    }
+    if(period != oldPeriod) {
+        expect[n++] = (SimPwmWrite){PWM_AXI_PERIOD_REG_OFFSET, period};
+    }
+    if(mode == PWM_COMMIT_RESTART) {
+        expect[n++] = (SimPwmWrite){PWM_AXI_CTRL_REG_OFFSET, 1};
+    }
+    return n;
+}
+
+static int sameWrites(const SimPwmWrite * a, const SimPwmWrite * b, u32 n) {
+    for(u32 i = 0; i < n; i++) {
+        if(a[i].offset != b[i].offset || a[i].value != b[i].value) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void testShadowInit(void) {
+    PWM_Shadow shadow;
+    CHECK(PWM_Shadow_Init(&shadow, BASE, 0) == XST_INVALID_PARAM);
+    CHECK(PWM_Shadow_Init(&shadow, BASE, PWM_MAX_CHANNELS + 1) == XST_INVALID_PARAM);
+
+    PWM_Set_Period(BASE, 5000);
+    for(u32 i = 0; i < PWM_MAX_CHANNELS; i++) {
+        PWM_Set_Duty(BASE, 100 * i, i);
+    }
+    simPwmTrace(writes, MAX_WRITES);
+    CHECK(PWM_Shadow_Init(&shadow, BASE, PWM_MAX_CHANNELS) == XST_SUCCESS);
+    CHECK(simPwmTraced() == 0);
+    CHECK(shadow.Period == 5000);
+    int same = 1;
+    for(u32 i = 0; i < PWM_MAX_CHANNELS; i++) {
+        same &= shadow.Duty[i] == 100 * i;
+    }
+    CHECK(same);
+}
+
+static void testNoChange(void) {
+    PWM_Shadow shadow;
+    u32 duty[PWM_MAX_CHANNELS];
+    CHECK(PWM_Shadow_Init(&shadow, BASE, 6) == XST_SUCCESS);
+    memcpy(duty, shadow.Duty, sizeof(duty));
+
+    simPwmTrace(writes, MAX_WRITES);
+    CHECK(PWM_Update(&shadow, shadow.Period, duty, PWM_COMMIT_BOUNDARY) == 0);
+    CHECK(PWM_Update(&shadow, shadow.Period, duty, PWM_COMMIT_RESTART) == 0);
+    CHECK(simPwmTraced() == 0);
+
+        // Channels past NumChannels are not the shadow's to compare
+    duty[6] = shadow.Duty[6] + 1;
+    CHECK(PWM_Update(&shadow, shadow.Period, duty, PWM_COMMIT_RESTART) == 0);
+    CHECK(simPwmTraced() == 0);
+}
+
+static void testRandom(void) {
+    static const u32 channelCounts[] = {1, 6, PWM_MAX_CHANNELS};
+    unsigned int seed = 36;
+    u32 bad = 0;
+    u32 unchanged = 0;
+
+    for(u32 c = 0; c < sizeof(channelCounts) / sizeof(channelCounts[0]); c++) {
+        u32 channels = channelCounts[c];
+        PWM_Shadow shadow;
+        CHECK(PWM_Shadow_Init(&shadow, BASE, channels) == XST_SUCCESS);
+
+        for(u32 u = 0; u < RANDOM_UPDATES; u++) {
+            u32 period = shadow.Period;
+            u32 duty[PWM_MAX_CHANNELS];
+            u32 oldDuty[PWM_MAX_CHANNELS];
+            u32 mode = rand_r(&seed) % 2 ? PWM_COMMIT_RESTART : PWM_COMMIT_BOUNDARY;
+            SimPwmWrite expect[MAX_WRITES];
+
+                // One update in eight changes nothing, the others some
+                // duty cycles, the period or both
+            memcpy(oldDuty, shadow.Duty, sizeof(oldDuty));
+            memcpy(duty, shadow.Duty, sizeof(duty));
+            u32 kind = rand_r(&seed) % 8;
+            if(kind == 1 || kind == 2) {
+                period = 1000 + rand_r(&seed) % 100000;
+            }
+            if(kind >= 2) {
+                u32 n = 1 + rand_r(&seed) % channels;
+                for(u32 i = 0; i < n; i++) {
+                    duty[rand_r(&seed) % channels] = rand_r(&seed) % (period + 1);
+                }
+            }
+            u32 n = expectedWrites(expect, channels, shadow.Period, oldDuty, period, duty, mode);
+            unchanged += n == 0;
+
+            simPwmTrace(writes, MAX_WRITES + 1);
+            u32 made = PWM_Update(&shadow, period, duty, mode);
+            int ok = simPwmTraced() == n && sameWrites(writes, expect, n);
+            ok &= made == (n == 0 ? 0 : mode == PWM_COMMIT_RESTART ? n - 2 : n);
+            ok &= PWM_Get_Period(BASE) == period;
+            for(u32 i = 0; i < channels; i++) {
+                ok &= PWM_Get_Duty(BASE, i) == duty[i] && shadow.Duty[i] == duty[i];
+            }
+            if(!ok) {
+                printf("%u channels, update %u: %u writes, expected %u\n",
+                    channels, u, simPwmTraced(), n);
+                bad++;
+            }
+        }
+    }
+    CHECK(bad == 0);
+    CHECK(unchanged > 0);
+}
+
+int main(void) {
+    simInitPwm();
+    testShadowInit();
+    testNoChange();
+    testRandom();
+    return testDone("testPwm");
+}
@@ -0,0 +1,426 @@
+/*******************************************************************************
+    xspi.c: XSpi_TransferPolled against the AXI Quad SPI model
+
+    Standard mode cores in loopback, 8, 16 and 32 bit wide, with no FIFOs
+    and with 16 and 256 deep ones. Each is run with transfers of 1 word up
+    to past twice the FIFO depth, with the model shifting at once, faster
+    than the driver can drain it and much slower, and with random bus
+    timing and stalls. Every word must come back, the Rx FIFO must never
+    overrun, the driver must not read an empty Rx FIFO, write a full Tx
+    FIFO or read occupancy registers a core without FIFOs lacks, and with
+    a 256 deep FIFO some run must fill it to the last word.
+
+    XSpi_TransferList is run the same way on random lists of segments,
+    some without a receive buffer, with XSpi_InterruptHandler called
+    whenever the model raises its interrupt line. Each list must call the
+    status handler once, with the total byte count and nothing else.
+
+    The board's core is in quad mode, where the loopback bit does nothing:
+    loopback transfers read ones. Reading the configuration flash, as
+    MemBench's SPI benchmark does there, must give the image's bytes
+    through both XSpi_Transfer and XSpi_TransferPolled. Lists read it as
+    command, address and data segments under manual slave select: with
+    KeepSelected the flash must be selected once per read and return the
+    data past one FIFO load, without it the read must break up.
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "test.h"
+#include "bench.h"
+#include "xspi.h"
+
+#define MAX_WORDS               700
+#define MAX_BYTES               (MAX_WORDS * 4)
+
+#define SPI_IRQ                 XPAR_INTC_0_SPI_0_VEC_ID
+#define MAX_SEGMENTS            6
+#define LISTS_PER_TIMING        40
+#define MAX_POLLS               10000000
+#define LATE_POLLS              256
+
+#define FLASH_READ_ADDRESS      0x1000
+#define FLASH_READ_SIZE         1024
+#define FLASH_CMD_READ          0x03
+
+typedef struct {
+    u32 nsPerWord;
+    u32 jitterNs;
+    u32 stallNs;
+} Timing;
+
+static const Timing timings[] = {
+    {0, 0, 0},                  // shifts at once
+    {150, 200, 60000},          // outruns the driver, with stalls
+    {5000, 400, 0},             // the driver waits on an empty Rx FIFO
+};
+#define NUM_TIMINGS             (sizeof(timings) / sizeof(timings[0]))
+
+static XSpi spi;
+static u8 txBuf[MAX_SEGMENTS * MAX_BYTES];
+static u8 rxBuf[MAX_SEGMENTS * MAX_BYTES];
+static u8 image[FLASH_READ_ADDRESS + 2 * FLASH_READ_SIZE];
+
+static u32 doneCalls;
+static u32 doneBytes;
+static u32 otherCalls;
+
+static void startCore(u32 width, u32 depth, const Timing * t) {
+    XSpi_Config cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.BaseAddress = XPAR_SPI_0_BASEADDR;
+    cfg.HasFifos = depth != 0;
+    cfg.NumSlaveBits = 1;
+    cfg.DataWidth = width;
+    cfg.SpiMode = XSP_STANDARD_MODE;
+    cfg.FifoDepth = depth;
+
+    simSpiConfigure(width, depth, XSP_STANDARD_MODE, t->nsPerWord);
+    testBusJitter(t->jitterNs, t->stallNs);
+    memset(&spi, 0, sizeof(spi));
+    XSpi_CfgInitialize(&spi, &cfg, cfg.BaseAddress);
+    XSpi_SetOptions(&spi, XSP_MASTER_OPTION | XSP_LOOPBACK_OPTION);
+    XSpi_Start(&spi);
+    XSpi_IntrGlobalDisable(&spi);
+}
+
+static void listStatus(void * ref, u32 event, unsigned int bytes) {
+    (void)ref;
+    if(event == XST_SPI_TRANSFER_DONE) {
+        doneCalls++;
+        doneBytes = bytes;
+    } else {
+        otherCalls++;
+    }
+}
+
+    // Calls the interrupt handler while the model's line is high until
+    // the driver is idle, then a while longer to catch a second
+    // completion. The status read stands in for the rest of the
+    // program's bus traffic, the model moves on at each access
+static void serviceList(void) {
+    for(u32 i = 0; spi.IsBusy && i < MAX_POLLS; i++) {
+        (void)XSpi_GetStatusReg(&spi);
+        if(testIrq(SPI_IRQ)) {
+            XSpi_InterruptHandler(&spi);
+        }
+    }
+    for(u32 i = 0; i < LATE_POLLS; i++) {
+        (void)XSpi_GetStatusReg(&spi);
+        if(testIrq(SPI_IRQ)) {
+            XSpi_InterruptHandler(&spi);
+        }
+    }
+}
+
+static int runList(XSpi_Segment * segments, u32 numSegments) {
+    doneCalls = 0;
+    doneBytes = 0;
+    otherCalls = 0;
+    int status = XSpi_TransferList(&spi, segments, numSegments);
+    if(status == XST_SUCCESS) {
+        serviceList();
+    }
+    return status;
+}
+
+    // Transfer lengths in words worth trying against a FIFO depth
+static u32 wordCounts(u32 depth, u32 * counts) {
+    u32 candidates[] = {1, 2, 3, depth - 1, depth, depth + 1, 2 * depth + 3, MAX_WORDS};
+    u32 n = 0;
+    for(u32 i = 0; i < sizeof(candidates) / sizeof(candidates[0]); i++) {
+        u32 c = candidates[i];
+        int seen = c == 0 || c > MAX_WORDS;
+        for(u32 j = 0; j < n; j++) {
+            seen |= counts[j] == c;
+        }
+        if(!seen) {
+            counts[n++] = c;
+        }
+    }
+    return n;
+}
+
+static void testLoopback(u32 width, u32 depth) {
+    u32 counts[8];
+    u32 numCounts = wordCounts(depth, counts);
+    u32 bytesPerWord = width / 8;
+    u32 failed = 0;
+    u32 highWater = 0;
+
+    for(u32 t = 0; t < NUM_TIMINGS; t++) {
+        startCore(width, depth, &timings[t]);
+        u32 expected = 0;
+        for(u32 c = 0; c < numCounts; c++) {
+            u32 bytes = counts[c] * bytesPerWord;
+            for(u32 i = 0; i < bytes; i++) {
+                txBuf[i] = (u8)(i * 13 + c + t * 5 + width);
+            }
+            memset(rxBuf, 0, bytes);
+            int status = XSpi_TransferPolled(&spi, txBuf, rxBuf, bytes);
+            expected += bytes;
+            if(status != XST_SUCCESS || memcmp(txBuf, rxBuf, bytes) != 0) {
+                printf("width %u depth %u timing %u: %u words failed\n",
+                    width, depth, t, counts[c]);
+                failed++;
+            }
+        }
+            // No receive buffer
+        CHECK(XSpi_TransferPolled(&spi, txBuf, NULL, counts[numCounts - 1] * bytesPerWord) == XST_SUCCESS);
+        expected += counts[numCounts - 1] * bytesPerWord;
+
+        SimSpiStats stats;
+        simSpiGetStats(&stats);
+        CHECK(stats.words * bytesPerWord == expected);
+        CHECK(stats.overruns == 0);
+        CHECK(stats.badAccesses == 0);
+        CHECK(stats.rxHighWater <= (depth ? depth : 1));
+        CHECK(spi.Stats.BytesTransferred == expected);
+        CHECK(spi.IsBusy == FALSE);
+            // Deselected and inhibited afterwards
+        CHECK(XSpi_GetSlaveSelectReg(&spi) == spi.SlaveSelectMask);
+        CHECK(XSpi_GetControlReg(&spi) & XSP_CR_TRANS_INHIBIT_MASK);
+        if(stats.rxHighWater > highWater) {
+            highWater = stats.rxHighWater;
+        }
+        XSpi_Stop(&spi);
+    }
+    CHECK(failed == 0);
+    CHECK(highWater == (depth ? depth : 1) || depth != 256);
+    printf("width %2u depth %3u: %u lengths, Rx FIFO high water %u\n",
+        width, depth, numCounts, highWater);
+}
+
+static void testList(u32 width, u32 depth) {
+    unsigned int seed = width * 1000 + depth;
+    u32 bytesPerWord = width / 8;
+    u32 maxWords = 2 * (depth ? depth : 1) + 5;
+    u32 failed = 0;
+
+    for(u32 t = 0; t < NUM_TIMINGS; t++) {
+        startCore(width, depth, &timings[t]);
+        XSpi_SetStatusHandler(&spi, NULL, listStatus);
+        CHECK(XSpi_TransferList(&spi, &(XSpi_Segment){txBuf, rxBuf, bytesPerWord, 0}, 1) == XST_NOT_INTERRUPT);
+        XSpi_IntrGlobalEnable(&spi);
+
+        u32 expected = 0;
+        for(u32 l = 0; l < LISTS_PER_TIMING; l++) {
+            XSpi_Segment segments[MAX_SEGMENTS];
+            u32 numSegments = 1 + rand_r(&seed) % MAX_SEGMENTS;
+            u32 bytes = 0;
+            for(u32 n = 0; n < numSegments; n++) {
+                u32 words = 1 + rand_r(&seed) % maxWords;
+                segments[n].SendBufPtr = txBuf + bytes;
+                segments[n].RecvBufPtr = rand_r(&seed) % 4 == 0 ? NULL : rxBuf + bytes;
+                segments[n].ByteCount = words * bytesPerWord;
+                segments[n].KeepSelected = rand_r(&seed) % 2;
+                bytes += words * bytesPerWord;
+            }
+            for(u32 i = 0; i < bytes; i++) {
+                txBuf[i] = (u8)rand_r(&seed);
+            }
+            memset(rxBuf, 0, bytes);
+
+            int ok = runList(segments, numSegments) == XST_SUCCESS;
+            ok &= doneCalls == 1 && doneBytes == bytes && otherCalls == 0 && !spi.IsBusy;
+            for(u32 n = 0; n < numSegments; n++) {
+                ok &= segments[n].RecvBufPtr == NULL ||
+                    memcmp(segments[n].RecvBufPtr, segments[n].SendBufPtr, segments[n].ByteCount) == 0;
+            }
+            if(!ok) {
+                printf("width %u depth %u timing %u: list %u of %u segments failed\n",
+                    width, depth, t, l, numSegments);
+                failed++;
+            }
+            expected += bytes;
+        }
+
+        SimSpiStats stats;
+        simSpiGetStats(&stats);
+        CHECK(stats.words * bytesPerWord == expected);
+        CHECK(stats.overruns == 0);
+        CHECK(stats.badAccesses == 0);
+        CHECK(spi.Stats.BytesTransferred == expected);
+        CHECK(XSpi_GetSlaveSelectReg(&spi) == spi.SlaveSelectMask);
+        CHECK(!testIrq(SPI_IRQ));
+        XSpi_Stop(&spi);
+    }
+    CHECK(failed == 0);
+    printf("width %2u depth %3u: %u lists\n", width, depth, NUM_TIMINGS * LISTS_PER_TIMING);
+}
+
+    // A flash read as command, address and data segments into rxBuf
+static void flashReadSegments(XSpi_Segment * segments, u8 * header, u32 address, u32 size,
+    u8 * data, int keepSelected) {
+    header[0] = FLASH_CMD_READ;
+    header[1] = (u8)(address >> 16);
+    header[2] = (u8)(address >> 8);
+    header[3] = (u8)address;
+    memset(data, 0, size);
+    segments[0] = (XSpi_Segment){header, NULL, 1, keepSelected};
+    segments[1] = (XSpi_Segment){header + 1, NULL, 3, keepSelected};
+    segments[2] = (XSpi_Segment){txBuf, data, size, 0};
+}
+
+    // The board's core, shifting at once and at about 12.5 Mbit/s
+static void testListFlash(void) {
+    static const u32 nsPerWord[] = {0, 640};
+    u8 headers[2][4];
+    XSpi_Segment segments[6];
+    SimSpiStats stats;
+
+    for(u32 t = 0; t < sizeof(nsPerWord) / sizeof(nsPerWord[0]); t++) {
+        testBusJitter(0, 0);
+        simSpiConfigure(XPAR_SPI_0_NUM_TRANSFER_BITS, XPAR_SPI_0_FIFO_DEPTH,
+            XPAR_SPI_0_SPI_MODE, nsPerWord[t]);
+        memset(&spi, 0, sizeof(spi));
+        CHECK(XSpi_Initialize(&spi, XPAR_SPI_0_DEVICE_ID) == XST_SUCCESS);
+        XSpi_SetOptions(&spi, XSP_MASTER_OPTION | XSP_CLK_ACTIVE_LOW_OPTION |
+            XSP_CLK_PHASE_1_OPTION | XSP_MANUAL_SSELECT_OPTION);
+        XSpi_SetSlaveSelect(&spi, 1);
+        XSpi_SetStatusHandler(&spi, NULL, listStatus);
+        XSpi_Start(&spi);
+        memset(txBuf, 0, FLASH_READ_SIZE);
+            // With the startup block XSpi_CfgInitialize reads back its
+            // dummy ID read at once, before a shifting core has it
+        simSpiGetStats(&stats);
+        u32 badAccesses = stats.badAccesses;
+
+            // After a polled transfer, which leaves Tx empty pending
+        XSpi_IntrGlobalDisable(&spi);
+        CHECK(XSpi_TransferPolled(&spi, txBuf, rxBuf, 8) == XST_SUCCESS);
+        XSpi_IntrGlobalEnable(&spi);
+
+            // One read held across its segments and four FIFO loads
+        simSpiGetStats(&stats);
+        u32 selects = stats.selects;
+        u8 * data = rxBuf;
+        flashReadSegments(segments, headers[0], FLASH_READ_ADDRESS, FLASH_READ_SIZE, data, 1);
+        CHECK(runList(segments, 3) == XST_SUCCESS);
+        CHECK(doneCalls == 1 && doneBytes == 4 + FLASH_READ_SIZE && otherCalls == 0);
+        CHECK(memcmp(data, image + FLASH_READ_ADDRESS, FLASH_READ_SIZE) == 0);
+        simSpiGetStats(&stats);
+        CHECK(stats.selects == selects + 1);
+
+            // A second list while the first is running is refused
+        doneCalls = 0;
+        CHECK(XSpi_TransferList(&spi, segments, 3) == XST_SUCCESS);
+        CHECK(XSpi_TransferList(&spi, segments, 3) == XST_DEVICE_BUSY);
+        serviceList();
+        CHECK(doneCalls == 1);
+
+            // Two reads in one list, deselected in between
+        simSpiGetStats(&stats);
+        selects = stats.selects;
+        flashReadSegments(segments, headers[0], FLASH_READ_ADDRESS, FLASH_READ_SIZE / 2, rxBuf, 1);
+        flashReadSegments(segments + 3, headers[1], FLASH_READ_ADDRESS + FLASH_READ_SIZE,
+            FLASH_READ_SIZE, rxBuf + FLASH_READ_SIZE, 1);
+        CHECK(runList(segments, 6) == XST_SUCCESS);
+        CHECK(doneCalls == 1 && doneBytes == 8 + FLASH_READ_SIZE / 2 + FLASH_READ_SIZE);
+        CHECK(memcmp(rxBuf, image + FLASH_READ_ADDRESS, FLASH_READ_SIZE / 2) == 0);
+        CHECK(memcmp(rxBuf + FLASH_READ_SIZE, image + FLASH_READ_ADDRESS + FLASH_READ_SIZE,
+            FLASH_READ_SIZE) == 0);
+        simSpiGetStats(&stats);
+        CHECK(stats.selects == selects + 2);
+
+            // Without KeepSelected each segment is a command of its own
+        selects = stats.selects;
+        flashReadSegments(segments, headers[0], FLASH_READ_ADDRESS, FLASH_READ_SIZE, rxBuf, 0);
+        CHECK(runList(segments, 3) == XST_SUCCESS);
+        CHECK(doneCalls == 1);
+        CHECK(memcmp(rxBuf, image + FLASH_READ_ADDRESS, FLASH_READ_SIZE) != 0);
+        simSpiGetStats(&stats);
+        CHECK(stats.selects == selects + 3);
+
+        CHECK(stats.overruns == 0 && stats.badAccesses == badAccesses);
+        CHECK(XSpi_GetSlaveSelectReg(&spi) == spi.SlaveSelectMask);
+        XSpi_Stop(&spi);
+    }
+    printf("flash lists: %u reads\n", 5 * (u32)(sizeof(nsPerWord) / sizeof(nsPerWord[0])));
+}
+
+    // axi_quad_spi_0 as built, through the XSpi_Config the BSP generated
+static void testBoardCore(void) {
+    const Timing instant = {0, 0, 0};
+    testBusJitter(instant.jitterNs, instant.stallNs);
+    simSpiConfigure(XPAR_SPI_0_NUM_TRANSFER_BITS, XPAR_SPI_0_FIFO_DEPTH, XPAR_SPI_0_SPI_MODE, 0);
+
+    memset(&spi, 0, sizeof(spi));
+    CHECK(XSpi_Initialize(&spi, XPAR_SPI_0_DEVICE_ID) == XST_SUCCESS);
+    CHECK(spi.SpiMode == XSP_QUAD_MODE);
+    CHECK(spi.FifoDepth == XPAR_SPI_0_FIFO_DEPTH);
+
+        // Loopback reads the floating data line
+    XSpi_SetOptions(&spi, XSP_MASTER_OPTION | XSP_LOOPBACK_OPTION);
+    XSpi_Start(&spi);
+    XSpi_IntrGlobalDisable(&spi);
+    for(u32 i = 0; i < 64; i++) {
+        txBuf[i] = (u8)i;
+    }
+    CHECK(XSpi_TransferPolled(&spi, txBuf, rxBuf, 64) == XST_SUCCESS);
+    int ones = 1;
+    for(u32 i = 0; i < 64; i++) {
+        ones &= rxBuf[i] == 0xFF;
+    }
+    CHECK(ones);
+    XSpi_Stop(&spi);
+
+        // MemBench's flash read, through both paths
+    XSpi_SetOptions(&spi, XSP_MASTER_OPTION | XSP_CLK_ACTIVE_LOW_OPTION |
+        XSP_CLK_PHASE_1_OPTION | XSP_MANUAL_SSELECT_OPTION);
+    XSpi_SetSlaveSelect(&spi, 1);
+    XSpi_Start(&spi);
+    XSpi_IntrGlobalDisable(&spi);
+    memset(txBuf, 0, 4 + FLASH_READ_SIZE);
+    txBuf[0] = 0x03;
+    txBuf[1] = (u8)(FLASH_READ_ADDRESS >> 16);
+    txBuf[2] = (u8)(FLASH_READ_ADDRESS >> 8);
+    txBuf[3] = (u8)FLASH_READ_ADDRESS;
+
+    memset(rxBuf, 0, sizeof(rxBuf));
+    CHECK(XSpi_Transfer(&spi, txBuf, rxBuf, 4 + FLASH_READ_SIZE) == XST_SUCCESS);
+    CHECK(memcmp(rxBuf + 4, image + FLASH_READ_ADDRESS, FLASH_READ_SIZE) == 0);
+    memset(rxBuf, 0, sizeof(rxBuf));
+    CHECK(XSpi_TransferPolled(&spi, txBuf, rxBuf, 4 + FLASH_READ_SIZE) == XST_SUCCESS);
+    CHECK(memcmp(rxBuf + 4, image + FLASH_READ_ADDRESS, FLASH_READ_SIZE) == 0);
+    XSpi_Stop(&spi);
+
+    SimSpiStats stats;
+    simSpiGetStats(&stats);
+    CHECK(stats.overruns == 0 && stats.badAccesses == 0);
+
+        // And the benchmark itself
+    testQuiet(1);
+    CHECK(runSpiBench() == XST_SUCCESS);
+    testQuiet(0);
+}
+
+int main(void) {
+    static const u32 widths[] = {8, 16, 32};
+    static const u32 depths[] = {0, 16, 256};
+    char path[] = "/tmp/testSpiXXXXXX";
+
+        // A flash image with something other than ones in it
+    for(u32 i = 0; i < sizeof(image); i++) {
+        image[i] = (u8)(i * 29 + (i >> 8));
+    }
+    int fd = mkstemp(path);
+    CHECK(fd >= 0 && write(fd, image, sizeof(image)) == (ssize_t)sizeof(image));
+    close(fd);
+    simOptions.flashImage = path;
+    simInitSpi();
+    testCycleCounter(TIMER_BASEADDR);
+
+    for(u32 w = 0; w < sizeof(widths) / sizeof(widths[0]); w++) {
+        for(u32 d = 0; d < sizeof(depths) / sizeof(depths[0]); d++) {
+            testLoopback(widths[w], depths[d]);
+            testList(widths[w], depths[d]);
+        }
+    }
+    testBoardCore();
+    testListFlash();
+
+    unlink(path);
+    return testDone("testSpi");
+}
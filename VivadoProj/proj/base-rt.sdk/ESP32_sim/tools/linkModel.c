@@ -0,0 +1,244 @@
+/*******************************************************************************
+    Capacity model of the axi_uartlite_1 link to the ESP32
+
+    Counts the bytes each way on the UART per telemetry sample, using the
+    command and reply text of atFormat.c that the driver itself sends, and
+    the time one send occupies the link. A byte is 10 bit times on the line
+    (8N1). Send modes:
+        fixed wait      TCPsend before its flow control: AT+CIPSEND, a
+                        fixed PROMPT_WAIT_US for the prompt, then the data.
+                        The next send must not start before SEND OK or it
+                        is answered busy
+        handshake       TCPsend as it is: AT+CIPSEND, the data as soon as
+                        "> " is in, the next send as soon as SEND OK is in
+        window          TCPsendBuffered: AT+CIPSENDBUF, the data as soon
+                        as "> " is in, the next segment as soon as "Recv"
+                        is in; SEND OK comes later and costs only rx bytes
+        passthrough     AT+CIPMODE=1 set up once; the data goes out raw
+    Samples go out binary, as capture blocks (header plus the raw ADC
+    frame per sample), or ASCII, one decimal line per sample. The batch is
+    the number of samples per send or per block.
+
+    The ESP32 echoes every command while ATE1 is on, the power on default;
+    the echo overlaps the command on the other half of the line. The Wi-Fi
+    side is reduced to the delay from "Recv" to SEND OK.
+*******************************************************************************/
+
+#include <getopt.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "xparameters.h"
+#include "atFormat.h"
+#include "capture.h"
+#include "sysTimer.h"
+
+#define MAX_BATCHES             16
+    // The fixed wait for the prompt TCPsend used to make
+#define PROMPT_WAIT_US          100000
+#define NS_PER_SEC              1e9
+
+#define MODE_FIXED_WAIT         0
+#define MODE_HANDSHAKE          1
+#define MODE_WINDOW             2
+#define MODE_PASSTHROUGH        3
+
+static const char * const modeNames[] = { "fixed wait", "handshake", "window", "passthrough" };
+
+    // Segment numbers as they look a while into a connection
+#define WINDOW_SEGMENT          1000
+
+static struct {
+    u32 baud;
+    u32 turnaroundUs;
+    u32 wifiLatencyUs;
+    u32 promptWaitUs;
+    int echo;
+    u32 sampleValue;
+    double rate;
+    double ipdPerSec;
+    u32 ipdBytes;
+    u32 batches[MAX_BATCHES];
+    u32 numBatches;
+} options = {
+    .baud = XPAR_UARTLITE_1_BAUDRATE,
+    .turnaroundUs = 1000,
+    .wifiLatencyUs = 5000,
+    .promptWaitUs = PROMPT_WAIT_US,
+    .echo = 1,
+    .sampleValue = 2048,
+    .rate = TICK_HZ,
+    .ipdBytes = 12,
+};
+
+static const u32 defaultBatches[] = { 1, 4, 16, 64, 256, CAPTURE_BLOCK_SAMPLES, 1016 };
+
+    // One send as seen from the FPGA
+typedef struct {
+    u32 payload;            // data bytes
+    u32 txBytes;            // FPGA to ESP32, data included
+    u32 rxBytes;            // ESP32 to FPGA
+    double cycleNs;         // start of this send to the earliest next one
+} SendCost;
+
+static double byteNs;
+
+static const char usage[] =
+    "usage: %s [options]\n"
+    "  --baud N                UART baud rate (%u)\n"
+    "  --turnaround-us N       ESP32 command processing time (1000)\n"
+    "  --wifi-latency-us N     Recv to SEND OK delay (5000)\n"
+    "  --prompt-wait-us N      fixed wait of TCPsend (%u)\n"
+    "  --no-echo               ATE0 in effect\n"
+    "  --sample-value N        value formatted for ASCII samples (2048)\n"
+    "  --rate HZ               target samples/s (%u)\n"
+    "  --ipd-per-s X           commands/s arriving from the collector (0)\n"
+    "  --ipd-bytes N           size of each such command (12)\n"
+    "  --batch N               batch to tabulate, repeatable\n";
+
+static u32 payloadBytes(int ascii, u32 batch) {
+    char line[16];
+    if(ascii) {
+        return batch * sprintf(line, "%u\r\n", options.sampleValue);
+    }
+    return offsetof(CaptureBlock, samples) + batch * CAPTURE_FRAME_BYTES;
+}
+
+static SendCost sendCost(int mode, u32 payload) {
+    char buf[AT_MAX_COMMAND];
+    SendCost cost = { .payload = payload, .txBytes = payload };
+    if(mode == MODE_PASSTHROUGH) {
+        cost.cycleNs = payload * byteNs;
+        return cost;
+    }
+
+    u32 command = formatTCPSend(buf, payload) + AT_EOL_BYTES;
+    u32 prompt = strlen(AT_SEND_PROMPT);
+    u32 recv = formatRecvBytes(buf, payload);
+    u32 sendOk = strlen(AT_SEND_OK);
+    if(mode == MODE_WINDOW) {
+        command = formatTCPSendBuffered(buf, payload) + AT_EOL_BYTES;
+        prompt += sprintf(buf, "%u,%u\r\n", WINDOW_SEGMENT, WINDOW_SEGMENT - 1);
+        sendOk = formatSegmentResult(buf, WINDOW_SEGMENT, 1);
+    }
+    cost.txBytes += command;
+    cost.rxBytes = (options.echo ? command : 0) + prompt + recv + sendOk;
+
+    double promptNs = mode == MODE_FIXED_WAIT ? options.promptWaitUs * 1000.0 :
+        options.turnaroundUs * 1000.0 + prompt * byteNs;
+    if(mode == MODE_WINDOW) {
+        cost.cycleNs = command * byteNs + promptNs + payload * byteNs +
+            options.turnaroundUs * 1000.0 + recv * byteNs;
+        return cost;
+    }
+
+        // From the last data byte until SEND OK is in
+    double tail = options.turnaroundUs * 1000.0 + recv * byteNs +
+        options.wifiLatencyUs * 1000.0 + sendOk * byteNs;
+    cost.cycleNs = command * byteNs + promptNs + payload * byteNs + tail;
+    return cost;
+}
+
+static void printRow(int mode, int ascii, u32 batch, double ipdLoad) {
+    u32 payload = payloadBytes(ascii, batch);
+    if(mode != MODE_PASSTHROUGH && payload > AT_SEND_MAX) {
+        return;
+    }
+    SendCost cost = sendCost(mode, payload);
+    double txPerSample = (double)cost.txBytes / batch;
+    double rxPerSample = (double)cost.rxBytes / batch;
+    double maxRate = batch * NS_PER_SEC / cost.cycleNs;
+    double txLoad = txPerSample * options.rate * byteNs / NS_PER_SEC * 100;
+    double rxLoad = (rxPerSample * options.rate + ipdLoad) * byteNs / NS_PER_SEC * 100;
+    double efficiency = 100.0 * batch * CAPTURE_FRAME_BYTES / cost.txBytes;
+    int fits = maxRate >= options.rate && txLoad <= 100 && rxLoad <= 100;
+
+    printf("%-12s %-6s %6u %7u %9.2f %9.2f %6.1f %10.3f %11.0f %7.1f %7.1f  %s\n",
+        modeNames[mode], ascii ? "ascii" : "binary", batch, payload,
+        txPerSample, rxPerSample, efficiency, cost.cycleNs / 1e6, maxRate,
+        txLoad, rxLoad, fits ? "yes" : "no");
+}
+
+static void parseOptions(int argc, char ** argv) {
+    static const struct option longOptions[] = {
+        { "baud", required_argument, NULL, 'b' },
+        { "turnaround-us", required_argument, NULL, 'a' },
+        { "wifi-latency-us", required_argument, NULL, 'w' },
+        { "prompt-wait-us", required_argument, NULL, 'p' },
+        { "no-echo", no_argument, NULL, 'e' },
+        { "sample-value", required_argument, NULL, 'v' },
+        { "rate", required_argument, NULL, 'r' },
+        { "ipd-per-s", required_argument, NULL, 'i' },
+        { "ipd-bytes", required_argument, NULL, 'n' },
+        { "batch", required_argument, NULL, 'B' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    int opt;
+    while((opt = getopt_long(argc, argv, "", longOptions, NULL)) != -1) {
+        switch(opt) {
+        case 'b': options.baud = strtoul(optarg, NULL, 10); break;
+        case 'a': options.turnaroundUs = strtoul(optarg, NULL, 10); break;
+        case 'w': options.wifiLatencyUs = strtoul(optarg, NULL, 10); break;
+        case 'p': options.promptWaitUs = strtoul(optarg, NULL, 10); break;
+        case 'e': options.echo = 0; break;
+        case 'v': options.sampleValue = strtoul(optarg, NULL, 10); break;
+        case 'r': options.rate = atof(optarg); break;
+        case 'i': options.ipdPerSec = atof(optarg); break;
+        case 'n': options.ipdBytes = strtoul(optarg, NULL, 10); break;
+        case 'B':
+            if(options.numBatches < MAX_BATCHES && atoi(optarg) > 0) {
+                options.batches[options.numBatches++] = atoi(optarg);
+                break;
+            }
+            /* fall through */
+        default:
+            fprintf(stderr, usage, argv[0], XPAR_UARTLITE_1_BAUDRATE,
+                PROMPT_WAIT_US, TICK_HZ);
+            exit(opt == 'h' ? 0 : 2);
+        }
+    }
+    if(optind != argc || options.baud == 0 || options.rate <= 0) {
+        fprintf(stderr, usage, argv[0], XPAR_UARTLITE_1_BAUDRATE,
+            PROMPT_WAIT_US, TICK_HZ);
+        exit(2);
+    }
+    if(options.numBatches == 0) {
+        memcpy(options.batches, defaultBatches, sizeof(defaultBatches));
+        options.numBatches = sizeof(defaultBatches) / sizeof(defaultBatches[0]);
+    }
+}
+
+int main(int argc, char ** argv) {
+    char header[32];
+    parseOptions(argc, argv);
+    byteNs = 10 * NS_PER_SEC / options.baud;
+
+        // Commands from the collector share the ESP32 to FPGA half
+    double ipdLoad = options.ipdPerSec *
+        (formatIPDHeader(header, options.ipdBytes) + options.ipdBytes);
+
+    printf("%u baud, %.2f us per byte, %.0f bytes/s each way\n",
+        options.baud, byteNs / 1000, NS_PER_SEC / byteNs);
+    printf("turnaround %u us, Recv to SEND OK %u us, fixed prompt wait %u us, echo %s\n",
+        options.turnaroundUs, options.wifiLatencyUs, options.promptWaitUs,
+        options.echo ? "on" : "off");
+    printf("target %.0f samples/s, %.1f collector commands/s of %u bytes\n\n",
+        options.rate, options.ipdPerSec, options.ipdBytes);
+
+    printf("%-12s %-6s %6s %7s %9s %9s %6s %10s %11s %7s %7s  %s\n",
+        "mode", "enc", "batch", "payload", "tx/sample", "rx/sample", "eff%",
+        "cycle ms", "max samp/s", "tx%", "rx%", "fits");
+    for(int mode = MODE_FIXED_WAIT; mode <= MODE_PASSTHROUGH; mode++) {
+        for(int ascii = 0; ascii <= 1; ascii++) {
+            for(u32 i = 0; i < options.numBatches; i++) {
+                printRow(mode, ascii, options.batches[i], ipdLoad);
+            }
+        }
+    }
+    printf("\ntx%% and rx%% are line use at the target rate; eff%% is raw ADC bytes\n"
+        "over bytes sent. Framed rows above AT_SEND_MAX (%d) bytes are left out\n",
+        AT_SEND_MAX);
+    return 0;
+}
@@ -0,0 +1,26 @@
+/*******************************************************************************
+    Shared pieces of the memory benchmarks, see bench.h
+*******************************************************************************/
+
+#include "bench.h"
+
+int initBenchTimer(XTmrCtr * timerPtr) {
+    int Status;
+    Status = XTmrCtr_Initialize(timerPtr, TIMER_DEVICE_ID);
+    if (Status != XST_SUCCESS) {
+        xil_printf("Could not initialize timer\n\r");
+        return XST_FAILURE;
+    }
+    XTmrCtr_SetOptions(timerPtr, CYCLE_COUNTER, XTC_AUTO_RELOAD_OPTION);
+    XTmrCtr_SetResetValue(timerPtr, CYCLE_COUNTER, 0);
+    XTmrCtr_Start(timerPtr, CYCLE_COUNTER);
+    return XST_SUCCESS;
+}
+
+u32 bytesToMBps(u32 bytes, u32 cycles) {
+    if(cycles == 0) {
+        return 0;
+    }
+        // bytes * (CPU_CLOCK_HZ / 1e6) / cycles without overflowing 32 bits
+    return (u32)(((u64)bytes * (CPU_CLOCK_HZ / 1000000)) / cycles);
+}
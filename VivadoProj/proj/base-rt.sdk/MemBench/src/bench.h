@@ -0,0 +1,79 @@
+/*******************************************************************************
+    Shared pieces of the memory benchmarks. Timing uses counter 0 of
+    axi_timer_0 as a free running cycle counter; the timer runs from the
+    same 100 MHz clock as the MicroBlaze, so one count is one CPU cycle.
+    Results are printed as CSV lines on the USB/UART port, each table
+    preceded by a header line and a '#' comment naming it.
+*******************************************************************************/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "xparameters.h"
+#include "xil_printf.h"
+#include "xil_types.h"
+#include "xstatus.h"
+#include "xtmrctr.h"
+#include "platform_config.h"
+
+/*************************** XILINX ARGUMENT MACROS ***************************/
+#define TIMER_DEVICE_ID         XPAR_TMRCTR_0_DEVICE_ID
+#define TIMER_BASEADDR          XPAR_TMRCTR_0_BASEADDR
+#define CYCLE_COUNTER           0
+
+#define CPU_CLOCK_HZ            XPAR_CPU_CORE_CLOCK_FREQ_HZ
+
+/**
+ * The application is built at -O0; the measured loops are compiled at -O2
+ * so that they time the memory system rather than stack spills
+ */
+#define BENCH_KERNEL            __attribute__((noinline, optimize("O2")))
+
+/**
+ * Reads the free running cycle counter. Differences are correct
+ * across a wrap as long as the interval is under 42 seconds
+ */
+#define readCycles() \
+    XTmrCtr_ReadReg(TIMER_BASEADDR, CYCLE_COUNTER, XTC_TCR_OFFSET)
+
+/**
+ * Starts the cycle counter
+ * returns XST_SUCCESS in case of success
+ * returns XST_FAILURE in case of failure
+ */
+int initBenchTimer(XTmrCtr * timerPtr);
+
+/**
+ * Converts bytes moved in cycles into MB/s at the CPU clock
+ */
+u32 bytesToMBps(u32 bytes, u32 cycles);
+
+/**
+ * Xil_MemCpy and Xil_MemSet against newlib memcpy/memset over a matrix
+ * of sizes and source/destination alignments
+ * returns XST_SUCCESS if every result matched
+ * returns XST_FAILURE otherwise
+ */
+int runCopyBench(void);
+
+/**
+ * Sequential read/write/copy bandwidth, strided reads and pointer chasing
+ * latency over DDR and LMB BRAM, with the D-cache enabled and disabled
+ */
+void runMemBench(void);
+
+/**
+ * XSpi_Transfer against XSpi_TransferPolled on axi_quad_spi_0, in loopback
+ * or, on a quad mode core, reading the configuration flash
+ * returns XST_SUCCESS if both paths received the expected data
+ * returns XST_FAILURE otherwise
+ */
+int runSpiBench(void);
+
+/**
+ * Fast destructive test of the DDR above the application image, with a
+ * progress line every few MB and the bandwidth of every pass
+ */
+int runMemTest(u32 options);
+
+#endif  /* end of protection macro */
@@ -0,0 +1,43 @@
+/*******************************************************************************
+    Memory benchmarks for the Arty S7 MicroBlaze system
+
+    Runs on the same hardware platform and BSP as the ESP32 application and
+    prints its results as CSV on the USB/UART port, so they can be captured
+    with any terminal program and loaded straight into a spreadsheet.
+*******************************************************************************/
+
+#include <stdio.h>
+#include "platform.h"
+#include "xil_printf.h"
+#include "bench.h"
+
+/************ Global Variables ************/
+XTmrCtr timer;
+
+int main() {
+    int status;
+    init_platform();
+
+    status = initBenchTimer(&timer);
+    if(status != XST_SUCCESS) {
+        xil_printf("Error setting up timer\n\r");
+        return XST_FAILURE;
+    }
+
+    xil_printf("# copy benchmark\n\r");
+    if(runCopyBench() != XST_SUCCESS) {
+        xil_printf("# copy benchmark FAILED\n\r");
+    }
+    xil_printf("# memory benchmark\n\r");
+    runMemBench();
+    xil_printf("# spi benchmark\n\r");
+    if(runSpiBench() != XST_SUCCESS) {
+        xil_printf("# spi benchmark FAILED\n\r");
+    }
+    xil_printf("# memory test\n\r");
+    runMemTest(0);
+    xil_printf("# done\n\r");
+
+    cleanup_platform();
+    return 0;
+}
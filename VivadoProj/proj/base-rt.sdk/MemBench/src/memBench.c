@@ -0,0 +1,161 @@
+/*******************************************************************************
+    DDR and LMB BRAM bandwidth and latency benchmark
+
+    For each memory, with the D-cache on and then off:
+      - seq_read, seq_write, copy: sequential bandwidth over the working set
+      - stride: one word read every 'param' bytes, which shows the cost of
+        each new cache line (the caches use 4-word, 16-byte lines)
+      - chase: dependent loads through a random cyclic permutation, which
+        defeats any prefetching and gives the load-to-use latency for a
+        working set of 'size' bytes
+
+    The DDR buffer is many times larger than the 8 KB D-cache so the larger
+    working sets always miss; the BRAM buffer sits in .fast_bss.
+*******************************************************************************/
+
+#include "bench.h"
+#include "xil_cache.h"
+#include "xil_mem.h"
+
+#define DDR_BUF_BYTES           (256 * 1024)
+#define BRAM_BUF_BYTES          (16 * 1024)
+#define CHASE_LOADS             65536
+
+static u32 ddrBuf[DDR_BUF_BYTES / 4] __attribute__((aligned(32)));
+static u32 bramBuf[BRAM_BUF_BYTES / 4] FAST_BSS __attribute__((aligned(32)));
+
+static const u32 workingSets[] = {1024, 4096, 8192, 16384, 65536, 262144};
+#define NUM_WORKING_SETS        (sizeof(workingSets) / sizeof(workingSets[0]))
+
+static const u32 strides[] = {4, 8, 16, 32, 64, 128};
+#define NUM_STRIDES             (sizeof(strides) / sizeof(strides[0]))
+
+static volatile u32 sink;
+static u32 rngState = 0x2545F491;
+
+static u32 nextRandom(void) {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+BENCH_KERNEL static u32 seqRead(const u32 * buf, u32 words) {
+    u32 sum = 0;
+    u32 i;
+    for(i = 0; i + 8 <= words; i += 8) {
+        sum += buf[i] + buf[i + 1] + buf[i + 2] + buf[i + 3] +
+               buf[i + 4] + buf[i + 5] + buf[i + 6] + buf[i + 7];
+    }
+    return sum;
+}
+
+BENCH_KERNEL static void seqWrite(u32 * buf, u32 words) {
+    u32 i;
+    for(i = 0; i + 8 <= words; i += 8) {
+        buf[i] = i;
+        buf[i + 1] = i;
+        buf[i + 2] = i;
+        buf[i + 3] = i;
+        buf[i + 4] = i;
+        buf[i + 5] = i;
+        buf[i + 6] = i;
+        buf[i + 7] = i;
+    }
+}
+
+BENCH_KERNEL static u32 stridedRead(const u32 * buf, u32 words, u32 strideWords) {
+    u32 sum = 0;
+    for(u32 i = 0; i < words; i += strideWords) {
+        sum += buf[i];
+    }
+    return sum;
+}
+
+BENCH_KERNEL static u32 chase(const u32 * buf, u32 loads) {
+    u32 index = 0;
+    while(loads--) {
+        index = buf[index];
+    }
+    return index;
+}
+
+    // Sattolo's algorithm: a random permutation that is a single cycle,
+    // so the chase visits every word of the working set
+static void buildChain(u32 * buf, u32 words) {
+    for(u32 i = 0; i < words; i++) {
+        buf[i] = i;
+    }
+    for(u32 i = words - 1; i > 0; i--) {
+        u32 j = nextRandom() % i;
+        u32 tmp = buf[i];
+        buf[i] = buf[j];
+        buf[j] = tmp;
+    }
+}
+
+static void benchMemory(const char * name, u32 * buf, u32 bufBytes, const char * dcache) {
+    u32 start, cycles;
+
+    for(u32 n = 0; n < NUM_WORKING_SETS; n++) {
+        u32 bytes = workingSets[n];
+        u32 words = bytes / 4;
+        if(bytes > bufBytes) {
+            break;
+        }
+
+            // Warm up once so the cached runs start from a steady state
+        sink = seqRead(buf, words);
+
+        start = readCycles();
+        sink = seqRead(buf, words);
+        cycles = readCycles() - start;
+        xil_printf("%s,%s,seq_read,%d,0,%d,%d\n\r", name, dcache, bytes, cycles,
+            bytesToMBps(bytes, cycles));
+
+        start = readCycles();
+        seqWrite(buf, words);
+        cycles = readCycles() - start;
+        xil_printf("%s,%s,seq_write,%d,0,%d,%d\n\r", name, dcache, bytes, cycles,
+            bytesToMBps(bytes, cycles));
+
+        start = readCycles();
+        Xil_MemCpy(buf + words / 2, buf, bytes / 2);
+        cycles = readCycles() - start;
+        xil_printf("%s,%s,copy,%d,0,%d,%d\n\r", name, dcache, bytes / 2, cycles,
+            bytesToMBps(bytes / 2, cycles));
+
+        for(u32 s = 0; s < NUM_STRIDES; s++) {
+            u32 strideWords = strides[s] / 4;
+            u32 accesses = words / strideWords;
+            start = readCycles();
+            sink = stridedRead(buf, words, strideWords);
+            cycles = readCycles() - start;
+            xil_printf("%s,%s,stride,%d,%d,%d,%d\n\r", name, dcache, bytes, strides[s],
+                cycles, cycles / accesses);
+        }
+
+        buildChain(buf, words);
+        start = readCycles();
+        sink = chase(buf, CHASE_LOADS);
+        cycles = readCycles() - start;
+        xil_printf("%s,%s,chase,%d,0,%d,%d\n\r", name, dcache, bytes, cycles,
+            cycles / CHASE_LOADS);
+    }
+}
+
+void runMemBench(void) {
+        // For bandwidth tests the last column is MB/s, for stride and
+        // chase it is cycles per access
+    xil_printf("memory,dcache,test,size,param,cycles,result\n\r");
+
+    Xil_DCacheEnable();
+    benchMemory("ddr", ddrBuf, DDR_BUF_BYTES, "on");
+    benchMemory("bram", bramBuf, BRAM_BUF_BYTES, "on");
+
+    Xil_DCacheDisable();
+    benchMemory("ddr", ddrBuf, DDR_BUF_BYTES, "off");
+    benchMemory("bram", bramBuf, BRAM_BUF_BYTES, "off");
+
+    Xil_DCacheEnable();
+}
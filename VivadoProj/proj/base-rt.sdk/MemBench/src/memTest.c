@@ -0,0 +1,83 @@
+/*******************************************************************************
+    Manufacturing screen of the DDR
+
+    Runs Xil_TestMemFast32 over everything between the end of the
+    application image (_end, past the heap and stack) and the top of the
+    mig_7series_0 region. After every pass a CSV line gives the bandwidth
+    achieved; the cycle counter is read at each progress call so passes
+    longer than one counter wrap are still timed correctly.
+*******************************************************************************/
+
+#include "bench.h"
+#include "xil_testmem.h"
+
+#define TEST_ALIGN              0x100000
+#define TEST_END                (XPAR_MIG_7SERIES_0_HIGHADDR + 1)
+#define PROGRESS_EVERY          (16 * 1024 * 1024 / 4)
+
+extern char _end[];
+
+static u8 curSubtest;
+static u32 firstPass;
+static u32 lastCycles;
+static u64 passCycles;
+static u64 totalCycles;
+static u64 totalBytes;
+
+static void testProgress(u8 subtest, u32 pass, u32 done, u32 words) {
+    u32 now = readCycles();
+    passCycles += (u32)(now - lastCycles);
+    lastCycles = now;
+
+    if(subtest != curSubtest) {
+        curSubtest = subtest;
+        firstPass = pass;
+    }
+
+    if(done == words) {
+            // The two MOVINV invert passes read and write every word
+        u32 bytes = words * 4;
+        u64 moved = (u64)bytes;
+        if(subtest == XIL_TESTMEM_MOVINV && (pass - firstPass == 1 || pass - firstPass == 2)) {
+            moved *= 2;
+        }
+        u32 mbps = (u32)((moved * (CPU_CLOCK_HZ / 1000000)) / passCycles);
+        xil_printf("%d,%d,%d,%d\n\r", subtest, pass, bytes, mbps);
+        totalCycles += passCycles;
+        totalBytes += moved;
+        passCycles = 0;
+    } else if(done % PROGRESS_EVERY == 0) {
+        xil_printf("# subtest %d pass %d: %d / %d MB\n\r", subtest, pass,
+            done / (1024 * 1024 / 4), words / (1024 * 1024 / 4));
+    }
+}
+
+int runMemTest(u32 options) {
+    u32 start = ((UINTPTR)_end + TEST_ALIGN - 1) & ~(TEST_ALIGN - 1);
+    u32 words = (TEST_END - start) / 4;
+    XTestMemFault fault;
+    s32 status;
+
+    xil_printf("# testing 0x%08x - 0x%08x, dcache %s\n\r", start, TEST_END - 1,
+        (options & XIL_TESTMEM_FAST_NOCACHE) ? "off" : "on");
+    xil_printf("subtest,pass,bytes,MBps\n\r");
+
+    curSubtest = 0;
+    passCycles = 0;
+    totalCycles = 0;
+    totalBytes = 0;
+    lastCycles = readCycles();
+    status = Xil_TestMemFast32((u32 *)(UINTPTR)start, words, 0, XIL_TESTMEM_ALLMEMTESTS,
+        options, testProgress, &fault);
+
+    if(status != 0) {
+        xil_printf("# FAIL subtest %d at 0x%08x: wrote 0x%08x read 0x%08x\n\r",
+            fault.Subtest, (UINTPTR)fault.Addr, fault.Expected, fault.Actual);
+        return XST_FAILURE;
+    }
+
+    xil_printf("# PASS in %d ms, %d MB/s overall\n\r",
+        (u32)(totalCycles / (CPU_CLOCK_HZ / 1000)),
+        (u32)((totalBytes * (CPU_CLOCK_HZ / 1000000)) / totalCycles));
+    return XST_SUCCESS;
+}
@@ -0,0 +1,13 @@
+#ifndef __PLATFORM_CONFIG_H_
+#define __PLATFORM_CONFIG_H_
+
+/**
+ * Buffers annotated with FAST_BSS are placed in the LMB BRAM, everything
+ * else in DDR. init_platform() zeroes .fast_bss and copies .fast_text and
+ * .fast_data from their load address in DDR
+ */
+#define FAST_CODE               __attribute__((section(".fast_text")))
+#define FAST_DATA               __attribute__((section(".fast_data")))
+#define FAST_BSS                __attribute__((section(".fast_bss")))
+
+#endif
@@ -0,0 +1,98 @@
+/*******************************************************************************
+    axi_quad_spi_0 bulk transfer benchmark
+
+    Each size is sent through the driver's interrupt-free XSpi_Transfer
+    mode and through XSpi_TransferPolled, and the received data is checked
+    so the CSV also shows whether both paths are correct. The MB/s figures
+    are bounded by the SCK rate of the core.
+
+    Local loopback only works with the core in standard SPI mode. The
+    board's core is built in quad mode for the configuration flash, where
+    the loopback bit has no effect and the data line reads ones. There the
+    benchmark reads the start of the flash instead, with the options
+    spiFlash.c uses, and checks that both paths read the same bytes. The
+    flash is only read.
+*******************************************************************************/
+
+#include <string.h>
+#include "bench.h"
+#include "xspi.h"
+
+#define SPI_DEVICE_ID           XPAR_SPI_0_DEVICE_ID
+#define MAX_SPI_TRANSFER        16384
+
+#define FLASH_OPTIONS           (XSP_MASTER_OPTION | XSP_CLK_ACTIVE_LOW_OPTION | \
+                                 XSP_CLK_PHASE_1_OPTION | XSP_MANUAL_SSELECT_OPTION)
+#define FLASH_CMD_READ          0x03
+#define FLASH_HEADER            4           // command and 24 bit address
+
+static const u32 spiSizes[] = {16, 256, 1024, 4096, MAX_SPI_TRANSFER};
+#define NUM_SPI_SIZES           (sizeof(spiSizes) / sizeof(spiSizes[0]))
+
+static XSpi spi;
+static u8 spiTx[MAX_SPI_TRANSFER];
+static u8 spiRx[MAX_SPI_TRANSFER];
+static u8 spiRxPolled[MAX_SPI_TRANSFER];
+
+int runSpiBench(void) {
+    int status;
+    u32 start, transferCycles, polledCycles;
+    int loopback;
+    int ok;
+    int result = XST_SUCCESS;
+
+    status = XSpi_Initialize(&spi, SPI_DEVICE_ID);
+    if(status != XST_SUCCESS) {
+        xil_printf("Could not initialize SPI\n\r");
+        return XST_FAILURE;
+    }
+    loopback = spi.SpiMode == XSP_STANDARD_MODE;
+    if(loopback) {
+        XSpi_SetOptions(&spi, XSP_MASTER_OPTION | XSP_LOOPBACK_OPTION);
+        for(u32 i = 0; i < MAX_SPI_TRANSFER; i++) {
+            spiTx[i] = (u8)(i * 7 + 3);
+        }
+        xil_printf("# loopback\n\r");
+    } else {
+        XSpi_SetOptions(&spi, FLASH_OPTIONS);
+        XSpi_SetSlaveSelect(&spi, 1);
+        memset(spiTx, 0, MAX_SPI_TRANSFER);
+        spiTx[0] = FLASH_CMD_READ;
+        xil_printf("# quad mode core, no loopback: reading the flash\n\r");
+    }
+    XSpi_Start(&spi);
+    XSpi_IntrGlobalDisable(&spi);
+
+    xil_printf("size,transfer_cycles,polled_cycles,transfer_MBps_x100,polled_MBps_x100,ok\n\r");
+    for(u32 n = 0; n < NUM_SPI_SIZES; n++) {
+        u32 size = spiSizes[n];
+
+        memset(spiRx, 0, size);
+        start = readCycles();
+        XSpi_Transfer(&spi, spiTx, spiRx, size);
+        transferCycles = readCycles() - start;
+
+        memset(spiRxPolled, 0, size);
+        start = readCycles();
+        XSpi_TransferPolled(&spi, spiTx, spiRxPolled, size);
+        polledCycles = readCycles() - start;
+
+        if(loopback) {
+            ok = memcmp(spiTx, spiRx, size) == 0 && memcmp(spiTx, spiRxPolled, size) == 0;
+        } else {
+            ok = memcmp(spiRx + FLASH_HEADER, spiRxPolled + FLASH_HEADER,
+                size - FLASH_HEADER) == 0;
+        }
+        if(!ok) {
+            result = XST_FAILURE;
+        }
+
+            // SPI rates are a few MB/s at most, so report hundredths
+        xil_printf("%d,%d,%d,%d,%d,%d\n\r", size, transferCycles, polledCycles,
+            bytesToMBps(size * 100, transferCycles),
+            bytesToMBps(size * 100, polledCycles), ok);
+    }
+
+    XSpi_Stop(&spi);
+    return result;
+}
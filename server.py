@@ -1,21 +1,455 @@
-#!/usr/bin/env python
+#!/usr/bin/env python3
+"""Collector for the Arty S7 boards.
 
-import socket
+Accepts TCP connections from any number of boards on one asyncio event
+loop. Each connection's byte stream is split into messages: text lines
+(status reports, alarms, command replies) and the binary blocks the
+firmware sends (capture blocks, XADC blocks and profile frames).
 
-TCP_IP = '192.168.1.105'
-TCP_PORT = 5005
-BUFFER_SIZE = 1024
+Messages are stored per board with --data-dir, see telemetry.py.
 
-s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
-s.bind((TCP_IP, TCP_PORT))
-s.listen(1)
+With --console, lines typed on stdin go to every connected board as
+commands ("help" lists them, see ESP32/src/command.h) and the replies are
+printed with their round trip. Lines typed while no board is connected,
+as while a duty-cycled board sleeps, go to the next board to connect.
+--probe sends one command to each board
+every --probe-interval seconds, one at a time, and the report adds the
+round trip from the send to the first OK or ERR line back.
 
-conn, addr = s.accept()
-print 'Connection address:', addr
-while 1:
-    data = conn.recv(BUFFER_SIZE)
-    if not data: break
-    print data
-    conn.send(data) #echo back
-conn.close()
+    python3 server.py --host 0.0.0.0 --port 5005 --data-dir data
+    python3 server.py --console
+    python3 server.py --probe sw --probe-interval 0.5 --quiet
+    python3 server.py --load-test 100 --duration 10
+"""
 
+import argparse
+import asyncio
+import re
+import struct
+import sys
+import time
+
+import telemetry
+
+DEFAULT_HOST = '0.0.0.0'
+DEFAULT_PORT = 5005
+READ_SIZE = 65536
+MAX_LINE = 4096
+
+# Binary blocks, see ESP32/src/capture.h, auxAcq.h and profExport.h.
+# The magics are u32 written little-endian, so they read backwards here
+CAPTURE_MAGIC = struct.pack('<I', 0x43415054)
+CAPTURE_BLOCK_SAMPLES = 512
+CAPTURE_HEADER = struct.Struct('<4sIIHH')
+CAPTURE_SIZE = CAPTURE_HEADER.size + 2 * CAPTURE_BLOCK_SAMPLES
+
+AUX_MAGIC = struct.pack('<I', 0x41555844)
+AUX_BLOCK_SAMPLES = 256
+AUX_HEADER = struct.Struct('<4sIIBBHHH')
+AUX_SIZE = AUX_HEADER.size + 2 * AUX_BLOCK_SAMPLES
+
+PROF_MAGIC = struct.pack('<I', 0x464F5250)
+PROF_HEADER = struct.Struct('<4sIHHI')
+PROF_MAX_PAYLOAD = 1024
+PROF_FRAME_BEGIN, PROF_FRAME_HIST, PROF_FRAME_ARCS, PROF_FRAME_END = range(4)
+PROF_BEGIN = struct.Struct('<IIIIIHH')
+PROF_HIST = struct.Struct('<IIII')
+PROF_ARC = struct.Struct('<III')
+
+# gmon.out layout as read by gprof, for a little-endian 32 bit target
+GMON_HEADER = b'gmon' + struct.pack('<I', 1) + b'\0' * 12
+GMON_TAG_TIME_HIST = b'\x00'
+GMON_TAG_CG_ARC = b'\x01'
+
+TEXT, CAPTURE, AUX, PROF = 'text', 'capture', 'aux', 'prof'
+KINDS = (TEXT, CAPTURE, AUX, PROF)
+STORED_KINDS = {TEXT: telemetry.KIND_TEXT, CAPTURE: telemetry.KIND_CAPTURE,
+                AUX: telemetry.KIND_AUX, PROF: telemetry.KIND_PROF}
+FLUSH_INTERVAL = 1.0
+# A command not answered in this long is counted lost and not waited on
+COMMAND_TIMEOUT = 5.0
+
+BOUNDARY = re.compile(b'\n|' + b'|'.join(re.escape(m) for m in
+                                          (CAPTURE_MAGIC, AUX_MAGIC, PROF_MAGIC)))
+
+
+class Framer(object):
+    """Splits one connection's byte stream into (kind, bytes) messages.
+
+    A message is a text line ending in a newline, or a binary block that
+    starts with one of the block magics. Bytes in front of a magic that
+    are not a whole line are passed on as text."""
+
+    def __init__(self):
+        self.buffer = bytearray()
+
+    def feed(self, data):
+        buf = self.buffer
+        buf += data
+        messages = []
+        pos = 0
+        while pos < len(buf):
+            head = bytes(buf[pos:pos + 4])
+            if len(head) < 4 and any(m.startswith(head) for m in
+                                     (CAPTURE_MAGIC, AUX_MAGIC, PROF_MAGIC)):
+                break
+            size = self.block_size(buf, pos, head)
+            if size is not None:
+                if size == 0 or len(buf) - pos < size:
+                    break
+                messages.append((self.block_kind(head), bytes(buf[pos:pos + size])))
+                pos += size
+                continue
+
+            match = BOUNDARY.search(buf, pos + 1 if head[:1] != b'\n' else pos)
+            if match is None:
+                if len(buf) - pos > MAX_LINE:
+                    messages.append((TEXT, bytes(buf[pos:])))
+                    pos = len(buf)
+                break
+            end = match.end() if match.group() == b'\n' else match.start()
+            messages.append((TEXT, bytes(buf[pos:end])))
+            pos = end
+        del buf[:pos]
+        return messages
+
+    @staticmethod
+    def block_kind(head):
+        if head == CAPTURE_MAGIC:
+            return CAPTURE
+        if head == AUX_MAGIC:
+            return AUX
+        return PROF
+
+    @staticmethod
+    def block_size(buf, pos, head):
+        """Bytes in the block at pos, 0 if its header is incomplete,
+        None if there is no block there"""
+        if head == CAPTURE_MAGIC:
+            return CAPTURE_SIZE
+        if head == AUX_MAGIC:
+            return AUX_SIZE
+        if head == PROF_MAGIC:
+            if len(buf) - pos < PROF_HEADER.size:
+                return 0
+            length = PROF_HEADER.unpack_from(buf, pos)[4]
+            if length > PROF_MAX_PAYLOAD:
+                return None
+            return PROF_HEADER.size + length
+        return None
+
+
+class GmonCollector(object):
+    """Reassembles the profile frames from one board into snapshots and
+    writes each complete snapshot to a gmon.out file for gprof"""
+
+    def __init__(self, prefix):
+        self.prefix = prefix
+        self.snapshot = None
+
+    def frame(self, block):
+        magic, seq, kind, section, length = PROF_HEADER.unpack_from(block)
+        payload = block[PROF_HEADER.size:]
+        if kind == PROF_FRAME_BEGIN:
+            rate, first, ticks, samples, outside, sections, graph = PROF_BEGIN.unpack(payload)
+            self.snapshot = {'seq': seq, 'rate': rate, 'ticks': ticks,
+                             'samples': samples, 'outside': outside,
+                             'hist': {}, 'arcs': []}
+            return None
+        snap = self.snapshot
+        if snap is None or snap['seq'] != seq:
+            # Started before we connected or lost part of it
+            return None
+        if kind == PROF_FRAME_HIST:
+            lowpc, highpc, total, first = PROF_HIST.unpack_from(payload)
+            if section not in snap['hist']:
+                snap['hist'][section] = (lowpc, highpc, [0] * total)
+            bins = snap['hist'][section][2]
+            count = (len(payload) - PROF_HIST.size) // 2
+            counts = struct.unpack_from('<%dH' % count, payload, PROF_HIST.size)
+            bins[first:first + count] = counts
+        elif kind == PROF_FRAME_ARCS:
+            snap['arcs'].extend(PROF_ARC.iter_unpack(payload))
+        elif kind == PROF_FRAME_END:
+            self.snapshot = None
+            return self.write(snap)
+        return None
+
+    def write(self, snap):
+        name = '%s-%d.out' % (self.prefix, snap['seq'])
+        with open(name, 'wb') as out:
+            out.write(GMON_HEADER)
+            for lowpc, highpc, bins in sorted(snap['hist'].values()):
+                out.write(GMON_TAG_TIME_HIST)
+                out.write(struct.pack('<IIII', lowpc, highpc, len(bins), snap['rate']))
+                out.write(b'seconds'.ljust(15, b'\0') + b's')
+                out.write(struct.pack('<%dH' % len(bins), *bins))
+            for arc in snap['arcs']:
+                out.write(GMON_TAG_CG_ARC)
+                out.write(PROF_ARC.pack(*arc))
+        return ('Wrote %s: %d samples over %d ticks, %d outside the text, %d arcs' %
+                (name, snap['samples'], snap['ticks'], snap['outside'], len(snap['arcs'])))
+
+
+class Collector(object):
+    """Serves board connections and keeps aggregate counters"""
+
+    def __init__(self, gmon_prefix='gmon', quiet=False, store=None):
+        self.gmon_prefix = gmon_prefix
+        self.quiet = quiet
+        self.store = store
+        self.boards = 0
+        self.bytes = 0
+        self.messages = dict((kind, 0) for kind in KINDS)
+        self.server = None
+        self.writers = {}
+        # Board to send time of its unanswered command
+        self.pending = {}
+        self.round_trips = []
+        self.commands_lost = 0
+        # Console lines waiting for a board to connect
+        self.held = []
+
+    def total_messages(self):
+        return sum(self.messages.values())
+
+    def log(self, board, text):
+        if not self.quiet:
+            print('[%s] %s' % (board, text))
+
+    async def start(self, host, port):
+        self.server = await asyncio.start_server(self.handle_board, host, port)
+        if self.store is not None:
+            self.flusher = asyncio.ensure_future(self.flush_store())
+        return self.server.sockets[0].getsockname()[1]
+
+    async def stop(self):
+        self.server.close()
+        await self.server.wait_closed()
+        if self.store is not None:
+            self.flusher.cancel()
+            self.store.close()
+
+    async def flush_store(self):
+        # Bounds what a crash can lose without a write per message
+        while True:
+            await asyncio.sleep(FLUSH_INTERVAL)
+            self.store.flush()
+
+    async def handle_board(self, reader, writer):
+        peer = writer.get_extra_info('peername')
+        board = '%s:%d' % (peer[0], peer[1])
+        framer = Framer()
+        profile = GmonCollector('%s-%s-%d' % (self.gmon_prefix, peer[0], peer[1]))
+        counts = self.messages
+        # Boards reconnect from a new port, so they are stored by address
+        board_log = self.store.log(peer[0]) if self.store is not None else None
+        self.boards += 1
+        self.writers[board] = writer
+        self.log(board, 'connected')
+        for line in self.held:
+            if not self.send_command(board, line):
+                writer.write(line.encode('ascii') + b'\n')
+        self.held = []
+        try:
+            while True:
+                data = await reader.read(READ_SIZE)
+                if not data:
+                    break
+                self.bytes += len(data)
+                ts = telemetry.now_us()
+                for kind, message in framer.feed(data):
+                    counts[kind] += 1
+                    if board_log is not None:
+                        board_log.append(STORED_KINDS[kind], message, ts)
+                    if kind == TEXT:
+                        if board in self.pending and message.startswith((b'OK', b'ERR')):
+                            self.answered(board)
+                        if not self.quiet:
+                            self.log(board, message.decode('ascii', 'replace').rstrip())
+                    elif kind == PROF:
+                        done = profile.frame(message)
+                        if done:
+                            self.log(board, done)
+        except ConnectionError:
+            pass
+        finally:
+            self.boards -= 1
+            del self.writers[board]
+            self.pending.pop(board, None)
+            if board_log is not None:
+                board_log.flush()
+            self.log(board, 'disconnected')
+            writer.close()
+
+    def send_command(self, board, command):
+        """Sends one command line; False while the last one is unanswered"""
+        sent = self.pending.get(board)
+        if sent is not None:
+            if time.monotonic() - sent < COMMAND_TIMEOUT:
+                return False
+            self.commands_lost += 1
+        self.writers[board].write(command.encode('ascii') + b'\n')
+        self.pending[board] = time.monotonic()
+        return True
+
+    def answered(self, board):
+        rtt = time.monotonic() - self.pending.pop(board)
+        self.round_trips.append(rtt)
+        self.log(board, 'round trip %.1f ms' % (rtt * 1e3))
+
+    async def probe(self, command, interval):
+        while True:
+            await asyncio.sleep(interval)
+            for board in list(self.writers):
+                self.send_command(board, command)
+
+    async def console(self):
+        loop = asyncio.get_running_loop()
+        while True:
+            line = await loop.run_in_executor(None, sys.stdin.readline)
+            if not line:
+                return
+            line = line.strip()
+            if not line:
+                continue
+            # Typed commands go out at once; only those sent with nothing
+            # outstanding are timed
+            for board in list(self.writers):
+                if not self.send_command(board, line):
+                    self.writers[board].write(line.encode('ascii') + b'\n')
+            if not self.writers:
+                self.held.append(line)
+                print('No boards connected, held for the next one')
+
+    async def report(self, interval):
+        last_messages, last_bytes, last = 0, 0, time.monotonic()
+        while True:
+            await asyncio.sleep(interval)
+            now = time.monotonic()
+            messages, received = self.total_messages(), self.bytes
+            print('%d boards, %.0f messages/s, %.2f MB/s' %
+                  (self.boards, (messages - last_messages) / (now - last),
+                   (received - last_bytes) / (now - last) / 1e6))
+            last_messages, last_bytes, last = messages, received, now
+            rtts, self.round_trips = self.round_trips, []
+            if rtts:
+                rtts.sort()
+                print('  %d replies, round trip ms min %.1f avg %.1f p95 %.1f max %.1f, %d lost' %
+                      (len(rtts), rtts[0] * 1e3, sum(rtts) / len(rtts) * 1e3,
+                       rtts[int(len(rtts) * 0.95)] * 1e3, rtts[-1] * 1e3,
+                       self.commands_lost))
+            elif self.commands_lost:
+                print('  no replies, %d lost' % self.commands_lost)
+
+
+def board_traffic(board, messages):
+    """One burst of what a board sends: status text, an alarm line,
+    capture and XADC blocks, in the firmware's layouts"""
+    status = (b'LED values --> LD2: 1\tLD3: 0\tLD4: 1\tLD5: 0\r\n'
+              b'BTN values --> BTN0: 0\tBTN1: 0\tBTN2: 0\tBTN3: 0\r\n'
+              b'SW Values  --> SW0: 1\tSW1: 0\tSW2: 0\tSW3: 1\r\n')
+    alarm = b'ALARM TEMP raised 85123 mC tick 1234 cycle 5678\r\n'
+    burst = []
+    count = 0
+    seq = 0
+    while count < messages:
+        burst.append(status)
+        burst.append(alarm)
+        burst.append(CAPTURE_HEADER.pack(CAPTURE_MAGIC, seq, seq * 512, 512, 0) +
+                     struct.pack('<512H', *[(board + i) & 0xFFF for i in range(512)]))
+        burst.append(AUX_HEADER.pack(AUX_MAGIC, seq, seq * 16, 1, 5, 256, 0, 0) +
+                     struct.pack('<256H', *[(board * 7 + i) & 0xFFF for i in range(256)]))
+        count += 6
+        seq += 1
+    return b''.join(burst), count
+
+
+async def simulated_board(port, board, deadline, sent):
+    reader, writer = await asyncio.open_connection('127.0.0.1', port)
+    burst, count = board_traffic(board, 60)
+    # Uneven write sizes so blocks straddle reads
+    cut = (board * 97) % len(burst)
+    while time.monotonic() < deadline:
+        writer.write(burst[:cut])
+        writer.write(burst[cut:])
+        await writer.drain()
+        sent[board] += count
+    writer.close()
+    await writer.wait_closed()
+
+
+async def load_test(boards, duration, data_dir):
+    store = telemetry.TelemetryStore(data_dir) if data_dir else None
+    collector = Collector(quiet=True, store=store)
+    port = await collector.start('127.0.0.1', 0)
+    sent = [0] * boards
+    start = time.monotonic()
+    await asyncio.gather(*[simulated_board(port, b, start + duration, sent)
+                           for b in range(boards)])
+    # Let the server drain what is still in flight
+    while collector.boards or collector.total_messages() < sum(sent):
+        await asyncio.sleep(0.05)
+        if time.monotonic() - start > duration + 10:
+            break
+    elapsed = time.monotonic() - start
+    await collector.stop()
+
+    received = collector.total_messages()
+    print('%d boards for %.1f s: %d messages, %.0f messages/s, %.2f MB/s' %
+          (boards, elapsed, received, received / elapsed, collector.bytes / elapsed / 1e6))
+    print('  %s' % ', '.join('%s %d' % (k, collector.messages[k]) for k in KINDS))
+    print('  per board sent min %d max %d' % (min(sent), max(sent)))
+    if received != sum(sent):
+        print('  MISMATCH: boards sent %d messages' % sum(sent))
+        return 1
+    return 0
+
+
+async def serve(host, port, interval, quiet, data_dir, console, probe, probe_interval):
+    store = telemetry.TelemetryStore(data_dir) if data_dir else None
+    collector = Collector(quiet=quiet, store=store)
+    port = await collector.start(host, port)
+    print('Listening on %s:%d' % (host, port))
+    if interval:
+        asyncio.ensure_future(collector.report(interval))
+    if console:
+        asyncio.ensure_future(collector.console())
+    if probe:
+        asyncio.ensure_future(collector.probe(probe, probe_interval))
+    await collector.server.serve_forever()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('--host', default=DEFAULT_HOST, help='address to bind')
+    parser.add_argument('--port', type=int, default=DEFAULT_PORT, help='port to bind')
+    parser.add_argument('--report', type=float, default=10.0, metavar='SECONDS',
+                        help='print aggregate rates this often, 0 for never')
+    parser.add_argument('--quiet', action='store_true', help='do not print text lines')
+    parser.add_argument('--data-dir', metavar='DIR',
+                        help='store every message in per-board logs under DIR')
+    parser.add_argument('--load-test', type=int, metavar='BOARDS',
+                        help='simulate this many boards on localhost and report messages/s')
+    parser.add_argument('--duration', type=float, default=10.0, metavar='SECONDS',
+                        help='length of the load test')
+    parser.add_argument('--console', action='store_true',
+                        help='send lines from stdin to the boards as commands')
+    parser.add_argument('--probe', metavar='COMMAND',
+                        help='send COMMAND to each board and time the replies')
+    parser.add_argument('--probe-interval', type=float, default=1.0, metavar='SECONDS',
+                        help='how often --probe sends')
+    args = parser.parse_args()
+
+    if args.load_test:
+        return asyncio.run(load_test(args.load_test, args.duration, args.data_dir))
+    try:
+        asyncio.run(serve(args.host, args.port, args.report, args.quiet, args.data_dir,
+                          args.console, args.probe, args.probe_interval))
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == '__main__':
+    raise SystemExit(main())
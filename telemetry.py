@@ -0,0 +1,308 @@
+#!/usr/bin/env python3
+"""Append-only telemetry log for the collector.
+
+Every board gets a directory of segment files. A segment holds records
+back to back in arrival order:
+
+    u64 timestamp (microseconds since the epoch), u8 kind, u16 length,
+    length bytes of payload
+
+all little-endian, behind a 16 byte segment header. Timestamps never go
+backwards within a board. Next to each segment, a .idx file holds a
+sparse index: a (timestamp, offset) pair for the first record after
+every INDEX_BYTES of data. Readers mmap a segment, bisect the index for
+the start of a time window and walk records from there, so a range
+query touches only the part of the file it returns.
+
+Segments are only ever appended to. A writer starts a new segment when
+it is opened and whenever the current one reaches its size limit, so a
+record cut short by a crash can only be at the end of a segment, where
+readers ignore it.
+
+    python3 telemetry.py bench
+    python3 telemetry.py replay DATA_DIR BOARD [START END]
+"""
+
+import bisect
+import mmap
+import os
+import struct
+import sys
+import time
+
+SEGMENT_MAGIC = b'ATLS'
+SEGMENT_VERSION = 1
+SEGMENT_HEADER = struct.Struct('<4sHHQ')    # magic, version, reserved, first timestamp
+RECORD_HEADER = struct.Struct('<QBH')       # timestamp, kind, length
+INDEX_ENTRY = struct.Struct('<QQ')          # timestamp, offset
+
+SEGMENT_BYTES = 64 << 20
+INDEX_BYTES = 64 << 10
+FLUSH_BYTES = 1 << 20
+MAX_PAYLOAD = 0xFFFF
+
+KIND_TEXT, KIND_CAPTURE, KIND_AUX, KIND_PROF = range(4)
+KIND_NAMES = ('text', 'capture', 'aux', 'prof')
+
+
+def now_us():
+    return time.time_ns() // 1000
+
+
+class BoardLog(object):
+    """Appends records for one board. Records are buffered and reach the
+    file on flush, or once FLUSH_BYTES are pending"""
+
+    def __init__(self, directory, segment_bytes=SEGMENT_BYTES, index_bytes=INDEX_BYTES):
+        self.directory = directory
+        self.segment_bytes = segment_bytes
+        self.index_bytes = index_bytes
+        os.makedirs(directory, exist_ok=True)
+        self.data = None
+        self.index = None
+        self.last_ts = 0
+        self.records = 0
+
+    def _open_segment(self, ts):
+        self._close_segment()
+        name = os.path.join(self.directory, '%016x' % ts)
+        # A restart within the same microsecond must not reopen a segment
+        while os.path.exists(name + '.seg'):
+            ts += 1
+            name = os.path.join(self.directory, '%016x' % ts)
+        self.data = open(name + '.seg', 'wb')
+        self.index = open(name + '.idx', 'wb')
+        self.pending = bytearray(SEGMENT_HEADER.pack(SEGMENT_MAGIC, SEGMENT_VERSION, 0, ts))
+        self.pending_index = bytearray()
+        self.size = len(self.pending)
+        self.next_index = self.size
+
+    def _close_segment(self):
+        if self.data is not None:
+            self.flush()
+            self.data.close()
+            self.index.close()
+            self.data = None
+
+    def append(self, kind, payload, ts=None):
+        """Adds one record. ts defaults to the current time and is raised
+        to the previous record's if the clock went backwards"""
+        if ts is None:
+            ts = now_us()
+        if ts < self.last_ts:
+            ts = self.last_ts
+        self.last_ts = ts
+        length = len(payload)
+        if length > MAX_PAYLOAD:
+            raise ValueError('record of %d bytes' % length)
+        if self.data is None or self.size + RECORD_HEADER.size + length > self.segment_bytes:
+            self._open_segment(ts)
+        if self.size >= self.next_index:
+            self.pending_index += INDEX_ENTRY.pack(ts, self.size)
+            self.next_index = self.size + self.index_bytes
+        self.pending += RECORD_HEADER.pack(ts, kind, length)
+        self.pending += payload
+        self.size += RECORD_HEADER.size + length
+        self.records += 1
+        if len(self.pending) >= FLUSH_BYTES:
+            self.flush()
+
+    def flush(self):
+        """Writes out pending records, then the index entries for them,
+        so the index never points past the data"""
+        if self.data is None:
+            return
+        if self.pending:
+            self.data.write(self.pending)
+            self.data.flush()
+            self.pending = bytearray()
+        if self.pending_index:
+            self.index.write(self.pending_index)
+            self.index.flush()
+            self.pending_index = bytearray()
+
+    def close(self):
+        self._close_segment()
+
+
+class Segment(object):
+    """Read-only view of one segment file and its index"""
+
+    def __init__(self, path):
+        self.path = path
+        self.first_ts = int(os.path.basename(path)[:-4], 16)
+
+    def _load_index(self):
+        try:
+            with open(self.path[:-4] + '.idx', 'rb') as f:
+                raw = f.read()
+        except FileNotFoundError:
+            raw = b''
+        raw = raw[:len(raw) - len(raw) % INDEX_ENTRY.size]
+        entries = list(INDEX_ENTRY.iter_unpack(raw))
+        return [e[0] for e in entries], [e[1] for e in entries]
+
+    def records(self, start=None, end=None):
+        """Yields (timestamp, kind, payload) for records with
+        start <= timestamp < end"""
+        with open(self.path, 'rb') as f:
+            size = os.fstat(f.fileno()).st_size
+            if size < SEGMENT_HEADER.size:
+                return
+            with mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) as m:
+                magic, version, _, first = SEGMENT_HEADER.unpack_from(m, 0)
+                if magic != SEGMENT_MAGIC or version != SEGMENT_VERSION:
+                    raise ValueError('%s is not a telemetry segment' % self.path)
+                pos = SEGMENT_HEADER.size
+                if start is not None:
+                    stamps, offsets = self._load_index()
+                    # Last indexed record strictly before start; records
+                    # with equal timestamps may begin before an entry
+                    i = bisect.bisect_left(stamps, start) - 1
+                    if i >= 0:
+                        pos = offsets[i]
+                unpack = RECORD_HEADER.unpack_from
+                header = RECORD_HEADER.size
+                while pos + header <= size:
+                    ts, kind, length = unpack(m, pos)
+                    body = pos + header
+                    if body + length > size:
+                        break
+                    if end is not None and ts >= end:
+                        break
+                    if start is None or ts >= start:
+                        yield ts, kind, m[body:body + length]
+                    pos = body + length
+
+
+class BoardReader(object):
+    """Replays the log of one board"""
+
+    def __init__(self, directory):
+        self.directory = directory
+
+    def segments(self):
+        names = sorted(n for n in os.listdir(self.directory) if n.endswith('.seg'))
+        return [Segment(os.path.join(self.directory, n)) for n in names]
+
+    def records(self, start=None, end=None):
+        """Yields (timestamp, kind, payload) in arrival order for records
+        with start <= timestamp < end, either bound optional"""
+        segments = self.segments()
+        for i, segment in enumerate(segments):
+            if end is not None and segment.first_ts >= end:
+                break
+            if (start is not None and i + 1 < len(segments) and
+                    segments[i + 1].first_ts < start):
+                continue
+            for record in segment.records(start, end):
+                yield record
+
+
+class TelemetryStore(object):
+    """Per-board logs under one root directory"""
+
+    def __init__(self, root, **options):
+        self.root = root
+        self.options = options
+        self.logs = {}
+
+    @staticmethod
+    def board_dir(board):
+        return ''.join(c if c.isalnum() or c in '-_' else '_' for c in board)
+
+    def log(self, board):
+        log = self.logs.get(board)
+        if log is None:
+            log = BoardLog(os.path.join(self.root, self.board_dir(board)), **self.options)
+            self.logs[board] = log
+        return log
+
+    def reader(self, board):
+        return BoardReader(os.path.join(self.root, self.board_dir(board)))
+
+    def flush(self):
+        for log in self.logs.values():
+            log.flush()
+
+    def close(self):
+        for log in self.logs.values():
+            log.close()
+        self.logs = {}
+
+
+def bench(records=1000000, boards=10):
+    """Ingests records shaped like the firmware's traffic into a
+    temporary store, then times a full replay and a 1% range query"""
+    import random
+    import shutil
+    import tempfile
+
+    rnd = random.Random(1)
+    text = b'LED values --> LD2: 1\tLD3: 0\tLD4: 1\tLD5: 0\r\n'
+    capture = bytes(rnd.getrandbits(8) for _ in range(1040))
+    aux = bytes(rnd.getrandbits(8) for _ in range(532))
+    mix = [(KIND_TEXT, text)] * 6 + [(KIND_CAPTURE, capture), (KIND_AUX, aux)] * 2
+    shape = [mix[rnd.randrange(len(mix))] for _ in range(1000)]
+
+    root = tempfile.mkdtemp(prefix='telemetry-bench-')
+    try:
+        store = TelemetryStore(root)
+        logs = [store.log('board%d' % b) for b in range(boards)]
+        base = now_us()
+        total = 0
+        t0 = time.perf_counter()
+        for i in range(records):
+            kind, payload = shape[i % len(shape)]
+            logs[i % boards].append(kind, payload, base + i)
+            total += len(payload)
+        store.close()
+        t1 = time.perf_counter()
+        print('ingest: %d records, %.1f MB in %.2f s: %.0f records/s, %.1f MB/s' %
+              (records, total / 1e6, t1 - t0, records / (t1 - t0), total / 1e6 / (t1 - t0)))
+
+        reader = store.reader('board0')
+        t0 = time.perf_counter()
+        count = sum(1 for _ in reader.records())
+        t1 = time.perf_counter()
+        print('replay: %d records of one board in %.3f s: %.0f records/s' %
+              (count, t1 - t0, count / (t1 - t0)))
+
+        # A window 1% long, in the middle of the run
+        start = base + records // 2
+        end = start + records // 100
+        t0 = time.perf_counter()
+        count = sum(1 for _ in reader.records(start, end))
+        t1 = time.perf_counter()
+        expected = len(range(start - base, end - base)) // boards
+        print('range:  %d records (expected %d) from a 1%% window in %.4f s' %
+              (count, expected, t1 - t0))
+    finally:
+        shutil.rmtree(root)
+
+
+def replay(root, board, start=None, end=None):
+    reader = TelemetryStore(root).reader(board)
+    for ts, kind, payload in reader.records(start, end):
+        name = KIND_NAMES[kind] if kind < len(KIND_NAMES) else str(kind)
+        if kind == KIND_TEXT:
+            detail = bytes(payload).decode('ascii', 'replace').rstrip()
+        else:
+            detail = '%d bytes' % len(payload)
+        print('%d %s %s' % (ts, name, detail))
+
+
+def main(argv):
+    if len(argv) >= 2 and argv[1] == 'bench':
+        bench(*[int(a) for a in argv[2:4]])
+        return 0
+    if len(argv) in (4, 6) and argv[1] == 'replay':
+        bounds = [int(a) for a in argv[4:6]] or [None, None]
+        replay(argv[2], argv[3], *bounds)
+        return 0
+    print(__doc__.strip().split('\n\n')[-1])
+    return 1
+
+
+if __name__ == '__main__':
+    raise SystemExit(main(sys.argv))